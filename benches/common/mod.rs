@@ -0,0 +1,232 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+//! Helpers shared by all benchmarks.
+
+#![allow(dead_code)]
+
+use routx::{earth_distance, FrozenGraph, Graph, Node};
+
+/// Path to the OSM fixture with the provided file name, used by unit tests.
+macro_rules! fixture {
+    ($name:literal) => {
+        concat!(
+            env!("CARGO_MANIFEST_DIR"),
+            "/src/osm/reader/test_fixtures/",
+            $name
+        )
+    };
+}
+pub(crate) use fixture;
+
+/// Deterministic xorshift generator, so that all runs use the same queries.
+pub struct Rng(pub u64);
+
+impl Default for Rng {
+    fn default() -> Self {
+        Self(0x2545_f491_4f6c_dd1d)
+    }
+}
+
+impl Rng {
+    pub fn next(&mut self) -> u64 {
+        self.0 ^= self.0 << 13;
+        self.0 ^= self.0 >> 7;
+        self.0 ^= self.0 << 17;
+        self.0
+    }
+
+    /// Returns a random number from the half-open range `[0, 1)`.
+    pub fn next_f32(&mut self) -> f32 {
+        (self.next() >> 40) as f32 / (1u64 << 24) as f32
+    }
+}
+
+pub fn load_osm(path: &str) -> Graph {
+    let mut g = Graph::new();
+    let options = routx::osm::Options {
+        profile: &routx::osm::CAR_PROFILE,
+        file_format: routx::osm::FileFormat::Unknown,
+        bbox: [0.0; 4],
+        threads: 0,
+    };
+    routx::osm::add_features_from_file(&mut g, &options, path).expect("failed to load OSM file");
+    g
+}
+
+/// Square grid with `n * n` nodes spaced ~100 m apart, and random bidirectional edge costs
+/// (in km) of 1 to 3 times the distance.
+pub fn grid(n: i64, rng: &mut Rng) -> Graph {
+    let mut g = Graph::new();
+    for y in 0..n {
+        for x in 0..n {
+            let id = y * n + x + 1;
+            g.set_node(Node {
+                id,
+                osm_id: id,
+                lat: y as f32 * 0.001,
+                lon: x as f32 * 0.001,
+            });
+        }
+    }
+    for y in 0..n {
+        for x in 0..n {
+            for (nx, ny) in [(x + 1, y), (x - 1, y), (x, y + 1), (x, y - 1)] {
+                if (0..n).contains(&nx) && (0..n).contains(&ny) {
+                    let cost = 0.12 * (1.0 + (rng.next() % 100) as f32 / 50.0);
+                    g.set_edge(
+                        y * n + x + 1,
+                        routx::Edge {
+                            to: ny * n + nx + 1,
+                            cost,
+                        },
+                    );
+                }
+            }
+        }
+    }
+    g
+}
+
+/// OSM XML document with a square grid of `n * n` nodes spaced ~100 m apart, connected by
+/// `highway=residential` ways of up to 10 nodes each, running along all rows and columns.
+pub fn grid_osm_xml(n: i64) -> Vec<u8> {
+    use std::fmt::Write as _;
+
+    let mut xml =
+        String::from("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<osm version=\"0.6\">\n");
+    for y in 0..n {
+        for x in 0..n {
+            let id = y * n + x + 1;
+            let (lat, lon) = (y as f32 * 0.001, x as f32 * 0.001);
+            writeln!(xml, "  <node id=\"{id}\" lat=\"{lat}\" lon=\"{lon}\"/>").unwrap();
+        }
+    }
+
+    let mut way_id = 1;
+    let mut add_way = |xml: &mut String, nodes: &mut dyn Iterator<Item = i64>| {
+        writeln!(xml, "  <way id=\"{way_id}\">").unwrap();
+        for node in nodes {
+            writeln!(xml, "    <nd ref=\"{node}\"/>").unwrap();
+        }
+        xml.push_str("    <tag k=\"highway\" v=\"residential\"/>\n  </way>\n");
+        way_id += 1;
+    };
+    for i in 0..n {
+        for start in (0..n - 1).step_by(9) {
+            let end = (start + 10).min(n);
+            add_way(&mut xml, &mut (start..end).map(|x| i * n + x + 1));
+            add_way(&mut xml, &mut (start..end).map(|y| y * n + i + 1));
+        }
+    }
+
+    xml.push_str("</osm>\n");
+    xml.into_bytes()
+}
+
+/// Returns a copy of the graph with node ids randomly permuted, like the ids of OSM nodes,
+/// which are assigned in the order of edits and thus barely correlate with node positions.
+pub fn shuffle_ids(g: &Graph, rng: &mut Rng) -> Graph {
+    let ids: Vec<i64> = g.iter().map(|n| n.id).collect();
+    let mut shuffled = ids.clone();
+    for i in (1..shuffled.len()).rev() {
+        shuffled.swap(i, rng.next() as usize % (i + 1));
+    }
+    let map: std::collections::HashMap<i64, i64> = ids.into_iter().zip(shuffled).collect();
+
+    // All nodes must be added first, as edges to missing nodes are ignored
+    let mut shuffled = Graph::new();
+    for n in g.iter() {
+        shuffled.set_node(Node {
+            id: map[&n.id],
+            ..*n
+        });
+    }
+    for n in g.iter() {
+        for e in g.get_edges(n.id) {
+            shuffled.set_edge(
+                map[&n.id],
+                routx::Edge {
+                    to: map[&e.to],
+                    cost: e.cost,
+                },
+            );
+        }
+    }
+    shuffled
+}
+
+pub fn random_pairs(g: &FrozenGraph, count: usize, rng: &mut Rng) -> Vec<(i64, i64)> {
+    let ids: Vec<i64> = g.iter().map(|n| n.id).collect();
+    (0..count)
+        .map(|_| {
+            (
+                ids[rng.next() as usize % ids.len()],
+                ids[rng.next() as usize % ids.len()],
+            )
+        })
+        .collect()
+}
+
+/// Returns up to `count` random pairs of nodes, whose crow-flies distance (in kilometers)
+/// is in the half-open range `[min, max)`. Gives up after `1000 * count` attempts,
+/// so fewer pairs may be returned for small graphs.
+pub fn random_pairs_at_distance(
+    g: &FrozenGraph,
+    min: f32,
+    max: f32,
+    count: usize,
+    rng: &mut Rng,
+) -> Vec<(i64, i64)> {
+    let nodes: Vec<Node> = g.iter().collect();
+    let mut pairs = Vec::with_capacity(count);
+    for _ in 0..count * 1000 {
+        if pairs.len() == count {
+            break;
+        }
+
+        let a = nodes[rng.next() as usize % nodes.len()];
+        let b = nodes[rng.next() as usize % nodes.len()];
+        let distance = earth_distance(a.lat, a.lon, b.lat, b.lon);
+        if (min..max).contains(&distance) {
+            pairs.push((a.id, b.id));
+        }
+    }
+    pairs
+}
+
+/// Returns `count` random points within the bounding box of all nodes.
+pub fn random_points(g: &FrozenGraph, count: usize, rng: &mut Rng) -> Vec<(f32, f32)> {
+    let (mut min_lat, mut min_lon) = (f32::INFINITY, f32::INFINITY);
+    let (mut max_lat, mut max_lon) = (f32::NEG_INFINITY, f32::NEG_INFINITY);
+    for n in g.iter() {
+        min_lat = min_lat.min(n.lat);
+        min_lon = min_lon.min(n.lon);
+        max_lat = max_lat.max(n.lat);
+        max_lon = max_lon.max(n.lon);
+    }
+
+    (0..count)
+        .map(|_| {
+            (
+                min_lat + (max_lat - min_lat) * rng.next_f32(),
+                min_lon + (max_lon - min_lon) * rng.next_f32(),
+            )
+        })
+        .collect()
+}
+
+/// Returns positional (non-flag) command line arguments. Skips the `--bench` flag
+/// passed by `cargo bench`, and values of the provided options.
+pub fn positional_args(options_with_values: &[&str]) -> Vec<String> {
+    let mut positional = Vec::default();
+    let mut args = std::env::args().skip(1);
+    while let Some(arg) = args.next() {
+        if options_with_values.contains(&arg.as_str()) {
+            args.next();
+        } else if !arg.starts_with('-') {
+            positional.push(arg);
+        }
+    }
+    positional
+}
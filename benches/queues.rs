@@ -0,0 +1,97 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+//! Compares [QueueKinds](routx::QueueKind) of [SearchContexts](routx::SearchContext)
+//! on the test corpus, synthetic grids and (optionally) an OSM file.
+//!
+//! Run with `cargo bench --bench queues [-- path/to/extract.osm]`.
+
+use std::time::{Duration, Instant};
+
+use routx::{FrozenGraph, QueueKind, SearchContext, DEFAULT_STEP_LIMIT};
+
+mod common;
+use common::{fixture, grid, load_osm, random_pairs, Rng};
+
+const KINDS: [QueueKind; 3] = [QueueKind::Binary, QueueKind::Quaternary, QueueKind::Radix];
+
+/// Number of measurements of every benchmark, out of which the fastest one is reported.
+const REPEATS: usize = 3;
+
+#[derive(Debug, Clone, Copy)]
+enum Search {
+    FindRoute,
+    WithoutTurnAround,
+
+    /// Full Dijkstra search from the start node, without a target.
+    Reachable,
+}
+
+fn run(ctx: &mut SearchContext, g: &FrozenGraph, pairs: &[(i64, i64)], s: Search) -> Duration {
+    let start = Instant::now();
+    for &(from, to) in pairs {
+        let result = match s {
+            Search::FindRoute => g
+                .find_route_with_context(ctx, from, to, DEFAULT_STEP_LIMIT)
+                .map(|r| r.len()),
+            Search::WithoutTurnAround => g
+                .find_route_without_turn_around_with_context(ctx, from, to, DEFAULT_STEP_LIMIT)
+                .map(|r| r.len()),
+            Search::Reachable => g.reachable(ctx, from, f32::INFINITY, usize::MAX, |_, _| {}),
+        };
+        std::hint::black_box(result.ok());
+    }
+    start.elapsed()
+}
+
+fn bench(name: &str, g: &FrozenGraph, pairs: &[(i64, i64)]) {
+    println!("{name}: {} nodes, {} queries", g.len(), pairs.len());
+    for search in [
+        Search::FindRoute,
+        Search::WithoutTurnAround,
+        Search::Reachable,
+    ] {
+        let mut baseline = Duration::ZERO;
+        for kind in KINDS {
+            let mut ctx = SearchContext::with_queue(kind);
+            run(&mut ctx, g, &pairs[..pairs.len().min(10)], search); // warm-up
+            let elapsed = (0..REPEATS)
+                .map(|_| run(&mut ctx, g, pairs, search))
+                .min()
+                .unwrap();
+            if kind == QueueKind::Binary {
+                baseline = elapsed;
+            }
+
+            println!(
+                "  {:<20} {:<10} {:>10.1} µs/query {:>6.2}x",
+                format!("{search:?}"),
+                format!("{kind:?}"),
+                elapsed.as_secs_f64() * 1e6 / pairs.len() as f64,
+                baseline.as_secs_f64() / elapsed.as_secs_f64(),
+            );
+        }
+    }
+}
+
+fn main() {
+    let mut rng = Rng::default();
+
+    let fixture = load_osm(fixture!("simple.osm")).freeze();
+    let pairs = random_pairs(&fixture, 10_000, &mut rng);
+    bench("simple.osm", &fixture, &pairs);
+
+    let g = grid(300, &mut rng).freeze();
+    let pairs = random_pairs(&g, 50, &mut rng);
+    bench("grid 300x300", &g, &pairs);
+
+    let g = grid(1000, &mut rng).freeze();
+    let pairs = random_pairs(&g, 5, &mut rng);
+    bench("grid 1000x1000", &g, &pairs);
+
+    if let Some(path) = common::positional_args(&[]).first() {
+        let g = load_osm(path).freeze();
+        let pairs = random_pairs(&g, 1000, &mut rng);
+        bench(path, &g, &pairs);
+    }
+}
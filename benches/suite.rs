@@ -0,0 +1,387 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+//! Benchmarks of OSM ingest, nearest node lookups and routing, with machine-readable results.
+//!
+//! Run with `cargo bench --bench suite [-- [--output results.json] [--filter name] [files...]]`.
+//!
+//! Human-readable results are printed to stderr, while a JSON document is written
+//! to stdout (or to the `--output` file):
+//!
+//! ```json
+//! {
+//!   "version": "1.0.3",
+//!   "results": [
+//!     {"name": "ingest/xml/simple.osm", "iterations": 2000, "ns_per_iter": 51234.5,
+//!      "bytes_per_iter": 5180},
+//!     {"name": "route/grid/1-5km/find_route", "iterations": 100, "ns_per_iter": 812345.0,
+//!      "bytes_per_iter": null}
+//!   ]
+//! }
+//! ```
+//!
+//! Every benchmark is calibrated to run for about [TARGET_TIME], and the fastest
+//! out of [REPEATS] measurements is reported. Extra OSM files (in any supported format)
+//! provided on the command line are benchmarked in addition to the test fixtures.
+//!
+//! On machines with multiple cores, ingest of a synthetic grid and of the extra files
+//! is also benchmarked with all available threads (`ingest/FORMAT/NAME/threads-N`).
+
+use std::fmt::Write as _;
+use std::io::{self, Write as _};
+use std::path::Path;
+use std::time::{Duration, Instant};
+
+use routx::{
+    CompactGraph, FrozenGraph, Graph, KDTree, NodeOrder, SearchContext, DEFAULT_COST_SCALE,
+    DEFAULT_STEP_LIMIT,
+};
+
+mod common;
+use common::{
+    fixture, grid, grid_osm_xml, random_pairs, random_pairs_at_distance, random_points,
+    shuffle_ids, Rng,
+};
+
+/// Number of measurements of every benchmark, out of which the fastest one is reported.
+const REPEATS: usize = 3;
+
+/// Approximate duration of a single measurement.
+const TARGET_TIME: Duration = Duration::from_millis(300);
+
+/// Buckets of crow-flies distances (in kilometers) between the ends of benchmarked routes.
+const DISTANCES: [(&str, f32, f32); 4] = [
+    ("0-1km", 0.0, 1.0),
+    ("1-5km", 1.0, 5.0),
+    ("5-20km", 5.0, 20.0),
+    ("20-100km", 20.0, 100.0),
+];
+
+/// Number of random queries of every nearest-node and routing benchmark.
+const QUERIES: usize = 1000;
+
+struct Measurement {
+    name: String,
+    iterations: usize,
+    elapsed: Duration,
+    bytes_per_iter: Option<u64>,
+}
+
+impl Measurement {
+    fn ns_per_iter(&self) -> f64 {
+        self.elapsed.as_secs_f64() * 1e9 / self.iterations as f64
+    }
+}
+
+#[derive(Default)]
+struct Suite {
+    filter: Option<String>,
+    results: Vec<Measurement>,
+}
+
+impl Suite {
+    /// Measures `f(i)` for consecutive `i`, starting from zero, with the number of iterations
+    /// calibrated to [TARGET_TIME] and capped at `max_iterations`.
+    fn measure<F: FnMut(usize)>(
+        &mut self,
+        name: String,
+        max_iterations: usize,
+        bytes_per_iter: Option<u64>,
+        mut f: F,
+    ) {
+        if self
+            .filter
+            .as_ref()
+            .is_some_and(|filter| !name.contains(filter))
+        {
+            return;
+        }
+
+        // Warm-up and calibration
+        let start = Instant::now();
+        f(0);
+        let once = start.elapsed().max(Duration::from_nanos(1));
+        let iterations = ((TARGET_TIME.as_secs_f64() / once.as_secs_f64()) as usize)
+            .clamp(1, max_iterations.max(1));
+
+        let elapsed = (0..REPEATS)
+            .map(|_| {
+                let start = Instant::now();
+                (0..iterations).for_each(&mut f);
+                start.elapsed()
+            })
+            .min()
+            .unwrap();
+
+        let m = Measurement {
+            name,
+            iterations,
+            elapsed,
+            bytes_per_iter,
+        };
+        eprint!(
+            "{:<64} {:>8} iter {:>14.1} ns/iter",
+            m.name,
+            m.iterations,
+            m.ns_per_iter(),
+        );
+        if let Some(bytes) = m.bytes_per_iter {
+            eprint!(" {:>8.1} MB/s", bytes as f64 / m.ns_per_iter() * 1e3);
+        }
+        eprintln!();
+        self.results.push(m);
+    }
+
+    fn ingest(&mut self, path: &str, threads: usize) {
+        let data = match std::fs::read(path) {
+            Ok(data) => data,
+            Err(e) => {
+                eprintln!("skipping {path}: {e}");
+                return;
+            }
+        };
+        let name = Path::new(path).file_name().unwrap().to_string_lossy();
+        self.ingest_data(&name, &data, threads);
+    }
+
+    /// Benchmarks loading OSM data with the provided number of threads. Results of
+    /// multi-threaded loads have a `/threads-N` suffix.
+    fn ingest_data(&mut self, name: &str, data: &[u8], threads: usize) {
+        let format = routx::osm::FileFormat::detect(data);
+        let format_name = match format {
+            routx::osm::FileFormat::Unknown => "unknown",
+            routx::osm::FileFormat::Xml => "xml",
+            routx::osm::FileFormat::XmlGz => "xml.gz",
+            routx::osm::FileFormat::XmlBz2 => "xml.bz2",
+            routx::osm::FileFormat::Pbf => "pbf",
+        };
+        let options = routx::osm::Options {
+            profile: &routx::osm::CAR_PROFILE,
+            file_format: format,
+            bbox: [0.0; 4],
+            threads,
+        };
+
+        let load = || {
+            let mut g = Graph::new();
+            routx::osm::add_features_from_io(&mut g, &options, io::Cursor::new(data)).map(|_| g)
+        };
+        if let Err(e) = load() {
+            eprintln!("skipping {name}: {e}");
+            return;
+        }
+
+        let name = match threads {
+            1 => format!("ingest/{format_name}/{name}"),
+            _ => format!("ingest/{format_name}/{name}/threads-{threads}"),
+        };
+        self.measure(name, usize::MAX, Some(data.len() as u64), |_| {
+            std::hint::black_box(load().ok());
+        });
+    }
+
+    fn nearest(&mut self, name: &str, g: &Graph, fg: &FrozenGraph, rng: &mut Rng) {
+        self.measure(format!("kdtree/build/{name}"), usize::MAX, None, |_| {
+            std::hint::black_box(KDTree::build_from_graph(g));
+        });
+
+        let Some(kd) = KDTree::build_from_graph(g) else {
+            return;
+        };
+        let points = random_points(fg, QUERIES, rng);
+        self.measure(format!("kdtree/nearest/{name}"), points.len(), None, |i| {
+            let (lat, lon) = points[i];
+            std::hint::black_box(kd.find_nearest_node(lat, lon));
+        });
+    }
+
+    fn routes(&mut self, name: &str, g: &Graph, fg: &FrozenGraph, rng: &mut Rng) {
+        let hg = fg.reordered(NodeOrder::Hilbert);
+        let cg = CompactGraph::from_frozen(&hg, DEFAULT_COST_SCALE);
+        let mut ctx = SearchContext::new();
+        for (bucket, min, max) in DISTANCES {
+            let pairs = random_pairs_at_distance(fg, min, max, QUERIES, rng);
+            if pairs.is_empty() {
+                continue;
+            }
+            let name = format!("{name}/{bucket}");
+            self.routes_between(&name, g, fg, &hg, &cg, &mut ctx, &pairs);
+        }
+    }
+
+    /// Measures routing between the provided pairs on the [Graph], the [FrozenGraph] (`fg`),
+    /// the frozen graph reordered along the Hilbert curve (`hg`) and its [CompactGraph] (`cg`).
+    #[allow(clippy::too_many_arguments)]
+    fn routes_between(
+        &mut self,
+        name: &str,
+        g: &Graph,
+        fg: &FrozenGraph,
+        hg: &FrozenGraph,
+        cg: &CompactGraph,
+        ctx: &mut SearchContext,
+        pairs: &[(i64, i64)],
+    ) {
+        let n = pairs.len();
+        self.measure(format!("route/{name}/find_route"), n, None, |i| {
+            let (from, to) = pairs[i];
+            std::hint::black_box(routx::find_route(g, from, to, DEFAULT_STEP_LIMIT).ok());
+        });
+        self.measure(
+            format!("route/{name}/find_route_without_turn_around"),
+            n,
+            None,
+            |i| {
+                let (from, to) = pairs[i];
+                std::hint::black_box(
+                    routx::find_route_without_turn_around(g, from, to, DEFAULT_STEP_LIMIT).ok(),
+                );
+            },
+        );
+        for (variant, fg) in [("frozen", fg), ("frozen-hilbert", hg)] {
+            self.measure(format!("route/{name}/{variant}/find_route"), n, None, |i| {
+                let (from, to) = pairs[i];
+                std::hint::black_box(
+                    fg.find_route_with_context(ctx, from, to, DEFAULT_STEP_LIMIT)
+                        .ok(),
+                );
+            });
+            self.measure(
+                format!("route/{name}/{variant}/find_route_without_turn_around"),
+                n,
+                None,
+                |i| {
+                    let (from, to) = pairs[i];
+                    std::hint::black_box(
+                        fg.find_route_without_turn_around_with_context(
+                            ctx,
+                            from,
+                            to,
+                            DEFAULT_STEP_LIMIT,
+                        )
+                        .ok(),
+                    );
+                },
+            );
+        }
+        self.measure(format!("route/{name}/compact/find_route"), n, None, |i| {
+            let (from, to) = pairs[i];
+            std::hint::black_box(
+                cg.find_route_with_context(ctx, from, to, DEFAULT_STEP_LIMIT)
+                    .ok(),
+            );
+        });
+    }
+
+    fn to_json(&self) -> String {
+        let mut json = String::default();
+        writeln!(json, "{{").unwrap();
+        writeln!(json, "  \"version\": {},", quote(env!("CARGO_PKG_VERSION"))).unwrap();
+        writeln!(json, "  \"results\": [").unwrap();
+        for (i, m) in self.results.iter().enumerate() {
+            let bytes = m
+                .bytes_per_iter
+                .map_or_else(|| "null".to_string(), |b| b.to_string());
+            writeln!(
+                json,
+                "    {{\"name\": {}, \"iterations\": {}, \"ns_per_iter\": {:.1}, \
+                 \"bytes_per_iter\": {}}}{}",
+                quote(&m.name),
+                m.iterations,
+                m.ns_per_iter(),
+                bytes,
+                if i + 1 < self.results.len() { "," } else { "" },
+            )
+            .unwrap();
+        }
+        writeln!(json, "  ]").unwrap();
+        writeln!(json, "}}").unwrap();
+        json
+    }
+}
+
+/// Formats a string as a JSON string literal.
+fn quote(s: &str) -> String {
+    let mut quoted = String::with_capacity(s.len() + 2);
+    quoted.push('"');
+    for c in s.chars() {
+        match c {
+            '"' => quoted.push_str("\\\""),
+            '\\' => quoted.push_str("\\\\"),
+            c if c.is_control() => write!(quoted, "\\u{:04x}", c as u32).unwrap(),
+            c => quoted.push(c),
+        }
+    }
+    quoted.push('"');
+    quoted
+}
+
+/// Returns the value of a command line option, e.g. `--output path`.
+fn option(name: &str) -> Option<String> {
+    let mut args = std::env::args().skip_while(|a| a != name);
+    args.next()?;
+    args.next()
+}
+
+fn main() {
+    let mut suite = Suite {
+        filter: option("--filter"),
+        ..Default::default()
+    };
+    let files = common::positional_args(&["--output", "--filter"]);
+    let mut rng = Rng::default();
+
+    // Multi-threaded ingest is only benchmarked on machines with multiple cores,
+    // as otherwise the results are the same as with one thread
+    let threads = std::thread::available_parallelism().map_or(1, |n| n.get());
+    let thread_counts: &[usize] = if threads > 1 { &[1, threads] } else { &[1] };
+
+    for path in [
+        fixture!("simple.osm"),
+        fixture!("simple.osm.gz"),
+        fixture!("simple.osm.bz2"),
+        fixture!("simple.osm.pbf"),
+    ] {
+        suite.ingest(path, 1);
+    }
+    let grid_xml = grid_osm_xml(500);
+    for &threads in thread_counts {
+        suite.ingest_data("grid-500.osm", &grid_xml, threads);
+        for path in &files {
+            suite.ingest(path, threads);
+        }
+    }
+    drop(grid_xml);
+
+    let g = common::load_osm(fixture!("simple.osm"));
+    let fg = g.freeze();
+    suite.nearest("simple.osm", &g, &fg, &mut rng);
+    let hg = fg.reordered(NodeOrder::Hilbert);
+    let cg = CompactGraph::from_frozen(&hg, DEFAULT_COST_SCALE);
+    let pairs = random_pairs(&fg, QUERIES, &mut rng);
+    let mut ctx = SearchContext::new();
+    suite.routes_between("simple.osm/all", &g, &fg, &hg, &cg, &mut ctx, &pairs);
+
+    let g = grid(300, &mut rng);
+    let fg = g.freeze();
+    suite.nearest("grid", &g, &fg, &mut rng);
+    suite.routes("grid", &g, &fg, &mut rng);
+
+    // Ids of OSM nodes barely correlate with their positions, unlike the ids of the grid
+    let g = shuffle_ids(&g, &mut rng);
+    suite.routes("grid-shuffled", &g, &g.freeze(), &mut rng);
+
+    for path in &files {
+        let g = common::load_osm(path);
+        let fg = g.freeze();
+        let name = Path::new(path).file_name().unwrap().to_string_lossy();
+        suite.nearest(&name, &g, &fg, &mut rng);
+        suite.routes(&name, &g, &fg, &mut rng);
+    }
+
+    let json = suite.to_json();
+    match option("--output") {
+        Some(path) => std::fs::write(&path, json).expect("failed to write results"),
+        None => io::stdout().write_all(json.as_bytes()).unwrap(),
+    }
+}
@@ -15,6 +15,22 @@ extern "C" {
 /// Recommended A* step limit for routx_find_route() and routx_find_route_without_turn_around().
 #define ROUTX_DEFAULT_STEP_LIMIT 1000000
 
+/// Recommended resolution of edge costs for routx_compact_graph_build() - a ten-thousandth
+/// of a cost unit (a decimetre of an unpenalized road, as costs are in kilometres).
+#define ROUTX_DEFAULT_COST_SCALE 1e-4f
+
+/// Maximum relative error of routx_earth_distance_many(), for distances between 1 m and 10 000 km.
+#define ROUTX_EARTH_DISTANCE_APPROX_MAX_ERROR 4e-6f
+
+/// Recommended size of @ref RoutxGridIndex cells for routx_grid_index_new(), in meters.
+#define ROUTX_DEFAULT_GRID_CELL_SIZE 100.0f
+
+/// Recommended quantum of @ref RoutxSnapCache keys for routx_snap_cache_new(), in meters.
+#define ROUTX_DEFAULT_SNAP_QUANTUM 1.0f
+
+/// Recommended size of @ref RoutxTiledGraph tiles for routx_tiled_graph_save(), in degrees.
+#define ROUTX_DEFAULT_TILE_SIZE 1.0f
+
 /**
  * Sets a logging handler for the library.
  *
@@ -91,6 +107,14 @@ typedef struct RoutxEdge {
 /**
  * OpenStreetMap-based network representation as a set of @ref RoutxNode "RoutxNodes"
  * and @ref RoutxEdge "RoutxEdges" between them.
+ *
+ * Thread safety: functions taking a `RoutxGraph const*` (node and edge lookups, routing,
+ * freezing and building a @ref RoutxKDTree) never modify the graph and take no locks, so any
+ * number of threads may call them concurrently on the same graph. Functions taking
+ * a `RoutxGraph*` modify the graph and must not run concurrently with any other call using
+ * that graph. The same contract applies to all other handles of this library; only
+ * @ref RoutxSearchContext "search contexts" and iterators must never be shared between threads.
+ * Use @ref RoutxSharedGraph to share a graph whose lifetime isn't bound to a single owner.
  */
 typedef struct RoutxGraph RoutxGraph;
 
@@ -174,6 +198,17 @@ bool routx_graph_set_node(RoutxGraph* graph, RoutxNode node);
  */
 bool routx_graph_delete_node(RoutxGraph* graph, int64_t id);
 
+/**
+ * Returns the epoch of the graph - a number assigned anew when the graph is created, and on
+ * every change made through routx_graph_set_node(), routx_graph_delete_node(),
+ * routx_graph_set_edge(), routx_graph_delete_edge() or when loading OSM data. Advancing the epoch
+ * drops all routes cached in a @ref RoutxRouteCache. Epochs are drawn from a process-wide counter,
+ * so different graphs (and cost overlays) never share an epoch.
+ *
+ * If the graph is NULL, returns 0.
+ */
+uint64_t routx_graph_epoch(RoutxGraph const* graph);
+
 /**
  * Finds the closest canonical (`id == osm_id`) @ref RoutxNode to the given position.
  *
@@ -539,6 +574,11 @@ typedef struct RoutxOsmOptions {
     /// Filter features by a specific bounding box. In order: left (min lon), bottom (min lat),
     /// right (max lon), top (max lat). Ignored if all values are set to zero.
     float bbox[4];
+
+    /// Number of threads used to decompress and decode @ref RoutxOsmFormatPbf files,
+    /// and to compute edges of ways (in files of any format).
+    /// Zero stands for the available parallelism, and one disables multi-threading.
+    unsigned int threads;
 } RoutxOsmOptions;
 
 /**
@@ -553,6 +593,24 @@ typedef struct RoutxOsmOptions {
 bool routx_graph_add_from_osm_file(RoutxGraph* graph, RoutxOsmOptions const* options,
                                    char const* filename);
 
+/**
+ * Parses OSM data from the provided file and adds it to the provided graph,
+ * reading the file twice to bound memory usage.
+ *
+ * The first pass collects the ids of nodes referenced by routable ways, and the second pass
+ * only keeps those nodes. Peak memory usage is thus proportional to the size of the routable
+ * network, instead of to the number of all nodes in the file, at the cost of reading the file
+ * twice. The resulting graph is the same as with routx_graph_add_from_osm_file().
+ *
+ * @param graph Graph to which the OSM data will be added. If NULL, this function does nothing and
+ * returns false.
+ * @param options Options for parsing the OSM data. Must not be NULL.
+ * @param filename Path to the OSM file to be parsed. Must not be NULL.
+ * @returns false if an error occurred, true otherwise
+ */
+bool routx_graph_add_from_osm_file_two_pass(RoutxGraph* graph, RoutxOsmOptions const* options,
+                                            char const* filename);
+
 /**
  * Parses OSM data from the provided buffer and adds it to the provided graph.
  *
@@ -567,6 +625,106 @@ bool routx_graph_add_from_osm_file(RoutxGraph* graph, RoutxOsmOptions const* opt
 bool routx_graph_add_from_osm_memory(RoutxGraph* graph, RoutxOsmOptions const* options,
                                      char const* content, size_t content_len);
 
+/**
+ * @ref RoutxOsmProfile with precomputed tag lookups, which can be reused across
+ * multiple loads of OSM data.
+ *
+ * Loading OSM data with a @ref RoutxOsmOptions converts and prepares its profile on every call.
+ * A compiled profile is prepared once, see routx_osm_profile_compile(), and used with
+ * routx_graph_add_from_osm_file_compiled() or routx_graph_add_from_osm_memory_compiled().
+ *
+ * Compiled profiles are never modified by those functions, so they can be shared
+ * across threads.
+ */
+typedef struct RoutxOsmCompiledProfile RoutxOsmCompiledProfile;
+
+/**
+ * Compiles a routing profile. The ROUTX_OSM_PROFILE_* macros are also accepted.
+ *
+ * The returned object owns copies of all strings of the profile, so the profile
+ * may be freed right after this call.
+ *
+ * @param profile Profile to compile. If NULL, returns NULL.
+ * @returns compiled profile, which must be freed with routx_osm_compiled_profile_delete().
+ */
+RoutxOsmCompiledProfile* routx_osm_profile_compile(RoutxOsmProfile const* profile);
+
+/**
+ * Deallocates a @ref RoutxOsmCompiledProfile. Does nothing if profile is NULL.
+ */
+void routx_osm_compiled_profile_delete(RoutxOsmCompiledProfile* profile);
+
+/**
+ * Parses OSM data from the provided file with a compiled profile
+ * and adds it to the provided graph.
+ *
+ * @param graph Graph to which the OSM data will be added. If NULL, this function does nothing and
+ * returns false.
+ * @param options Options for parsing the OSM data. Must not be NULL. `options->profile` is
+ * ignored.
+ * @param profile Compiled profile, see routx_osm_profile_compile(). Must not be NULL.
+ * @param filename Path to the OSM file to be parsed. Must not be NULL.
+ * @returns false if an error occurred, true otherwise
+ */
+bool routx_graph_add_from_osm_file_compiled(RoutxGraph* graph, RoutxOsmOptions const* options,
+                                            RoutxOsmCompiledProfile const* profile,
+                                            char const* filename);
+
+/**
+ * Parses OSM data from the provided buffer with a compiled profile
+ * and adds it to the provided graph.
+ *
+ * @param graph Graph to which the OSM data will be added. If NULL, this function does nothing and
+ * returns false.
+ * @param options Options for parsing the OSM data. Must not be NULL. `options->profile` is
+ * ignored.
+ * @param profile Compiled profile, see routx_osm_profile_compile(). Must not be NULL.
+ * @param content Pointer to the buffer containing OSM data. Must be not be NULL, even if
+ * content_len == 0.
+ * @param content_len Length of the buffer in bytes.
+ * @returns false if an error occurred, true otherwise
+ */
+bool routx_graph_add_from_osm_memory_compiled(RoutxGraph* graph, RoutxOsmOptions const* options,
+                                              RoutxOsmCompiledProfile const* profile,
+                                              char const* content, size_t content_len);
+
+/**
+ * Process-wide counters of all OSM data read so far, see routx_osm_ingest_stats().
+ *
+ * Counters only ever increase, so they can be directly exported as monotonic metrics.
+ */
+typedef struct RoutxOsmIngestStats {
+    /// Number of read OSM nodes, including the ones which were later ignored.
+    uint64_t nodes;
+
+    /// Number of read OSM ways, including the ones which were later ignored.
+    uint64_t ways;
+
+    /// Number of read OSM relations, including the ones which were later ignored.
+    uint64_t relations;
+
+    /// Number of turn restrictions applied to the graph.
+    uint64_t restrictions_applied;
+
+    /// Number of turn restrictions which were invalid or couldn't be applied to the graph,
+    /// for example because they reference features outside of the requested bounding box.
+    uint64_t restrictions_rejected;
+
+    /// Number of bytes produced by decompressing .osm.gz and .osm.bz2 files,
+    /// and compressed blobs of .osm.pbf files. Files read twice by a two-pass ingest
+    /// are only counted once.
+    uint64_t bytes_decompressed;
+} RoutxOsmIngestStats;
+
+/**
+ * Returns the process-wide counters of all OSM data read so far.
+ *
+ * Readers count features locally and only publish the totals once done with a file,
+ * so the counters don't slow down parsing, but they also don't include files
+ * which are still being read.
+ */
+RoutxOsmIngestStats routx_osm_ingest_stats(void);
+
 /**
  * High-level route search status, also used as the tag for the anonymous union in
  * @ref RoutxRouteResult.
@@ -584,6 +742,16 @@ typedef enum RoutxRouteResultType {
     /// denial-of-service.
     /// The step limit protects against resource exhaustion.
     RoutxRouteResultTypeStepLimitExceeded = 2,
+
+    /// Search was cancelled with routx_route_task_cancel().
+    RoutxRouteResultTypeCancelled = 3,
+
+    /// Search has run past the timeout given to routx_find_route_async().
+    RoutxRouteResultTypeDeadlineExceeded = 4,
+
+    /// A tile of a @ref RoutxTiledGraph needed by the search couldn't be loaded,
+    /// see logs in such case.
+    RoutxRouteResultTypeTileLoadFailed = 5,
 } RoutxRouteResultType;
 
 /**
@@ -630,6 +798,10 @@ typedef struct RoutxRouteResult {
      * nodes are really far apart, or no route exists. Concluding that no route exists requires
      * traversing the whole graph, which can result in a denial-of-service. The step limit protects
      * against resource exhaustion.
+     * - @ref RoutxRouteResultTypeCancelled or @ref RoutxRouteResultTypeDeadlineExceeded -
+     * an asynchronous search (see routx_find_route_async()) was stopped before finishing.
+     * - @ref RoutxRouteResultTypeTileLoadFailed - routx_tiled_graph_find_route() couldn't load
+     * a tile of the graph.
      */
     RoutxRouteResultType type;
 } RoutxRouteResult;
@@ -675,48 +847,1353 @@ RoutxRouteResult routx_find_route_without_turn_around(RoutxGraph const* graph, i
                                                       int64_t to, size_t step_limit);
 
 /**
- * Deallocates a @ref RoutxRouteResult created by routx_find_route() or
- * routx_find_route_without_turn_around().
+ * Deallocates a @ref RoutxRouteResult created by routx_find_route(),
+ * routx_find_route_without_turn_around() or their @ref RoutxFrozenGraph equivalents.
  */
 void routx_route_result_delete(RoutxRouteResult);
 
 /**
- * A [k-d tree data structure](https://en.wikipedia.org/wiki/K-d_tree) which can be used to
- * speed up nearest-neighbor search for large datasets.
+ * Immutable, compact snapshot of a @ref RoutxGraph, optimized for route finding.
  *
- * Practice shows that routx_graph_find_nearest_node() takes significantly more time than
- * routx_find_route() when generating multiple routes with routx. A k-d tree helps with that,
- * trading CPU time for memory usage.
+ * Nodes are renumbered to dense indices, their attributes are stored in separate arrays,
+ * and all edges are kept in a single
+ * [compressed sparse row](https://en.wikipedia.org/wiki/Sparse_matrix#Compressed_sparse_row_(CSR,_CRS_or_Yale_format))
+ * structure. This avoids tree lookups in the A* inner loop, and uses considerably less memory
+ * than a @ref RoutxGraph.
+ *
+ * A frozen graph is not affected by any changes made to the @ref RoutxGraph it was created from.
  */
-typedef struct RoutxKDTree RoutxKDTree;
+typedef struct RoutxFrozenGraph RoutxFrozenGraph;
 
 /**
- * Builds a @ref RoutxKDTree with all canonical (`id == osm_id`) @ref RoutxNode "RoutxNodes"
- * contained in the provided @ref RoutxGraph.
+ * Creates a @ref RoutxFrozenGraph snapshot of the provided @ref RoutxGraph.
  *
- * Must be deallocated with routx_kd_tree_delete().
+ * Must be deallocated with routx_frozen_graph_delete().
  *
- * Returns NULL if the graph has no nodes.
+ * Returns NULL if the graph is NULL.
  */
-RoutxKDTree* routx_kd_tree_new(RoutxGraph const*);
+RoutxFrozenGraph* routx_graph_freeze(RoutxGraph const* graph);
 
 /**
- * Deallocates a @ref RoutxKDTree created by routx_kd_tree_new(). The k-d tree may be NULL.
+ * Order of dense node indices of a @ref RoutxFrozenGraph, see routx_frozen_graph_reordered().
  */
-void routx_kd_tree_delete(RoutxKDTree*);
+typedef enum RoutxNodeOrder {
+    /// Ascending node id order, as created by routx_graph_freeze().
+    RoutxNodeOrderId = 0,
+
+    /// Order along a [Hilbert curve](https://en.wikipedia.org/wiki/Hilbert_curve) over the
+    /// bounding box of all nodes. Nodes close to each other are (almost always) close in memory,
+    /// so a search exploring a region touches considerably fewer cache lines and pages.
+    RoutxNodeOrderHilbert = 1,
+
+    /// Order along a [Z-order (Morton) curve](https://en.wikipedia.org/wiki/Z-order_curve)
+    /// over the bounding box of all nodes. Cheaper to compute than the Hilbert curve,
+    /// but with worse locality.
+    RoutxNodeOrderMorton = 2,
+} RoutxNodeOrder;
 
 /**
- * Finds the closest node to the provided position and returns it.
- * If there are no nodes or the k-d tree is NULL, returns a zero (`id == 0`) node.
+ * Creates a copy of a @ref RoutxFrozenGraph with nodes renumbered in the provided order,
+ * and edges reordered to match.
+ *
+ * All searches return the same routes as on the source graph, but renumbering along
+ * a space-filling curve improves the cache hit rate of searches on large graphs.
+ * Dense indices change, so landmarks and contraction hierarchies must be built
+ * for the returned graph. The order is preserved by routx_frozen_graph_save().
+ *
+ * Must be deallocated with routx_frozen_graph_delete().
+ *
+ * Returns NULL if the graph is NULL.
  */
-RoutxNode routx_kd_tree_find_nearest_node(RoutxKDTree const* kd_tree, float lat, float lon);
+RoutxFrozenGraph* routx_frozen_graph_reordered(RoutxFrozenGraph const* graph,
+                                               RoutxNodeOrder order);
 
 /**
- * Calculates the great-circle distance between two positions using the
- * [haversine formula](https://en.wikipedia.org/wiki/Haversine_formula).
- * Returns the result in kilometers.
+ * Deallocates a @ref RoutxFrozenGraph created by routx_graph_freeze(), routx_graph_open_mmap()
+ * or routx_frozen_graph_reordered(). The graph may be NULL.
  */
-float routx_earth_distance(float lat1, float lon1, float lat2, float lon2);
+void routx_frozen_graph_delete(RoutxFrozenGraph* graph);
+
+/**
+ * Saves a snapshot of a @ref RoutxGraph to a file, in the format of routx_frozen_graph_save().
+ *
+ * Returns false if saving has failed, see logs in such case.
+ * Returns false if the graph is NULL.
+ */
+bool routx_graph_save(RoutxGraph const* graph, char const* filename);
+
+/**
+ * Saves a @ref RoutxFrozenGraph to a file, in a versioned, little-endian binary format,
+ * which mirrors the in-memory layout of the graph. Such files can be opened
+ * with routx_graph_open_mmap().
+ *
+ * Returns false if saving has failed, see logs in such case.
+ * Returns false if the graph is NULL.
+ */
+bool routx_frozen_graph_save(RoutxFrozenGraph const* graph, char const* filename);
+
+/**
+ * Opens a graph saved with routx_graph_save() or routx_frozen_graph_save()
+ * by memory-mapping the file.
+ *
+ * All arrays are used in place, straight from the (shared, read-only) mapping,
+ * and multiple processes opening the same file share a single page-cache copy of the graph.
+ * Node ids, edge offsets and edge targets are still read once to validate them.
+ * The file must not be modified or truncated (by this or any other process) while the graph
+ * is alive - doing so results in undefined behavior or a SIGBUS crash. To replace a graph,
+ * write a new file and rename it over the old one.
+ *
+ * On non-unix or big-endian platforms, the whole file is read into memory instead.
+ *
+ * Must be deallocated with routx_frozen_graph_delete().
+ *
+ * Returns NULL if opening has failed, see logs in such case.
+ */
+RoutxFrozenGraph* routx_graph_open_mmap(char const* filename);
+
+/**
+ * Returns the number of @ref RoutxNode "RoutxNodes" in a frozen graph,
+ * or zero if the graph is NULL.
+ */
+size_t routx_frozen_graph_len(RoutxFrozenGraph const* graph);
+
+/**
+ * Returns the number of edges in a frozen graph, or zero if the graph is NULL.
+ */
+size_t routx_frozen_graph_edge_count(RoutxFrozenGraph const* graph);
+
+/**
+ * Finds a node with the provided id. If no such node was found, returns a zero (`id == 0`) node.
+ *
+ * If the graph is NULL, returns a zero node.
+ */
+RoutxNode routx_frozen_graph_get_node(RoutxFrozenGraph const* graph, int64_t id);
+
+/**
+ * Gets the cost of a @ref RoutxEdge from one node to another.
+ * Returns positive infinity when the provided edge can't be found, or when the graph is NULL.
+ */
+float routx_frozen_graph_get_edge(RoutxFrozenGraph const* graph, int64_t from_id, int64_t to_id);
+
+/**
+ * Equivalent of routx_find_route() operating on a @ref RoutxFrozenGraph.
+ *
+ * The returned result must be destroyed by calling routx_route_result_delete().
+ */
+RoutxRouteResult routx_frozen_graph_find_route(RoutxFrozenGraph const* graph, int64_t from,
+                                               int64_t to, size_t step_limit);
+
+/**
+ * Equivalent of routx_find_route_without_turn_around() operating on a @ref RoutxFrozenGraph.
+ *
+ * The returned result must be destroyed by calling routx_route_result_delete().
+ */
+RoutxRouteResult routx_frozen_graph_find_route_without_turn_around(RoutxFrozenGraph const* graph,
+                                                                   int64_t from, int64_t to,
+                                                                   size_t step_limit);
+
+/**
+ * Reusable workspace for route searches over a @ref RoutxFrozenGraph.
+ *
+ * A search context keeps its priority queue and per-node labels between searches, and resets
+ * them in constant time by bumping a generation counter. Once its storage has grown to fit
+ * the graph, searches don't allocate anything except for the returned route.
+ *
+ * The kind of the priority queue can be selected with routx_search_context_new_with_queue().
+ * Counters of the work done by the last search are available through
+ * routx_search_context_stats().
+ *
+ * A search context may be used with different graphs, but only by one search at a time.
+ * Multi-threaded applications should keep one context per thread.
+ */
+typedef struct RoutxSearchContext RoutxSearchContext;
+
+/**
+ * Priority queue implementation used by a @ref RoutxSearchContext.
+ *
+ * All kinds return the same routes, except for the order of popping items with equal scores,
+ * which may result in a different choice between multiple equally short routes.
+ */
+typedef enum RoutxQueueKind {
+    /// Binary heap with lazy deletion: improving the cost of a queued state pushes another
+    /// item, and outdated items are skipped when popped. The default.
+    RoutxQueueKindBinary = 0,
+
+    /// 4-ary heap indexed by dense state indices, with decrease-key. Every state is queued
+    /// at most once, and the heap is shallower than a binary one, at the cost of maintaining
+    /// the position of every queued state.
+    RoutxQueueKindQuaternary = 1,
+
+    /// Monotone [radix heap](https://en.wikipedia.org/wiki/Radix_heap) over the bit patterns
+    /// of scores, with amortized constant-time pushes. Scores lower than the last popped one
+    /// (e.g. due to rounding of the heuristic) are treated as equal to it.
+    /// Usually the fastest for large searches, settling hundreds of thousands of nodes.
+    RoutxQueueKindRadix = 2,
+} RoutxQueueKind;
+
+/**
+ * Creates a new, empty @ref RoutxSearchContext. Its storage is allocated lazily on first use.
+ *
+ * Must be deallocated with routx_search_context_delete().
+ */
+RoutxSearchContext* routx_search_context_new(void);
+
+/**
+ * Creates a new, empty @ref RoutxSearchContext with the provided kind of priority queue.
+ * Its storage is allocated lazily on first use.
+ *
+ * Must be deallocated with routx_search_context_delete().
+ */
+RoutxSearchContext* routx_search_context_new_with_queue(RoutxQueueKind kind);
+
+/**
+ * Deallocates a @ref RoutxSearchContext created by routx_search_context_new().
+ * The context may be NULL.
+ */
+void routx_search_context_delete(RoutxSearchContext* ctx);
+
+/**
+ * Counters of the work done by the last search (or the last batch of searches, like a
+ * cost matrix) with a @ref RoutxSearchContext, see routx_search_context_stats().
+ *
+ * Counters are updated by the searches themselves, which amounts to a few integer
+ * additions per settled node. If the library is built without the `stats` cargo feature
+ * (enabled by default), the updates are compiled out, and all counters except for
+ * @ref RoutxSearchStats::elapsed_ns stay at zero. Wall time is only measured if enabled with
+ * routx_search_context_set_timing().
+ */
+typedef struct RoutxSearchStats {
+    /// Number of settled (expanded) search states. Searches fail with
+    /// @ref RoutxRouteResultTypeStepLimitExceeded once this exceeds the step limit.
+    uint64_t settled;
+
+    /// Number of edges examined from settled states.
+    uint64_t relaxed;
+
+    /// Number of items pushed into the priority queues.
+    uint64_t pushes;
+
+    /// Number of items popped from the priority queues.
+    uint64_t pops;
+
+    /// Largest number of items in the priority queue. For bidirectional searches,
+    /// sum of the largest sizes of both queues.
+    uint64_t peak_queue_size;
+
+    /// Number of popped items which were skipped, as a cheaper way to their state
+    /// was already known.
+    uint64_t stale_pops;
+
+    /// Wall time of the search, in nanoseconds. Zero unless timing is enabled.
+    uint64_t elapsed_ns;
+} RoutxSearchStats;
+
+/**
+ * Returns the counters of the work done by the last search with the provided context.
+ * If the context is NULL, returns all zeros.
+ */
+RoutxSearchStats routx_search_context_stats(RoutxSearchContext const* ctx);
+
+/**
+ * Enables or disables measuring the wall time of searches with the provided context,
+ * see @ref RoutxSearchStats::elapsed_ns. Disabled by default. Does nothing if the context is NULL.
+ */
+void routx_search_context_set_timing(RoutxSearchContext* ctx, bool enabled);
+
+/**
+ * Equivalent of routx_frozen_graph_find_route(), reusing the storage of the provided
+ * @ref RoutxSearchContext.
+ *
+ * If the context is NULL, a temporary one is allocated for the search.
+ *
+ * The returned result must be destroyed by calling routx_route_result_delete().
+ */
+RoutxRouteResult routx_frozen_graph_find_route_with_context(RoutxFrozenGraph const* graph,
+                                                            RoutxSearchContext* ctx, int64_t from,
+                                                            int64_t to, size_t step_limit);
+
+/**
+ * Equivalent of routx_frozen_graph_find_route_without_turn_around(), reusing the storage of the
+ * provided @ref RoutxSearchContext.
+ *
+ * If the context is NULL, a temporary one is allocated for the search.
+ *
+ * The returned result must be destroyed by calling routx_route_result_delete().
+ */
+RoutxRouteResult routx_frozen_graph_find_route_without_turn_around_with_context(
+    RoutxFrozenGraph const* graph, RoutxSearchContext* ctx, int64_t from, int64_t to,
+    size_t step_limit);
+
+/**
+ * Equivalent of routx_find_route() operating on a @ref RoutxFrozenGraph, using a bidirectional
+ * A* search.
+ *
+ * A forward search from `from` and a backward search from `to` meet in the middle,
+ * which on medium and long queries expands roughly half the nodes of
+ * routx_frozen_graph_find_route(). `step_limit` limits the number of nodes expanded by both
+ * searches together. The reverse adjacency required by the backward search is derived
+ * on first use, and kept alongside the frozen graph.
+ *
+ * If the context is NULL, a temporary one is allocated for the search.
+ *
+ * The returned result must be destroyed by calling routx_route_result_delete().
+ */
+RoutxRouteResult routx_find_route_bidirectional(RoutxFrozenGraph const* graph,
+                                                RoutxSearchContext* ctx, int64_t from, int64_t to,
+                                                size_t step_limit);
+
+/**
+ * Calculates the costs of the shortest routes from every source to every target.
+ *
+ * `out_costs` must point to an array of `sources_len * targets_len` floats, which is filled
+ * in row-major order: the cost from `sources[i]` to `targets[j]` is written to
+ * `out_costs[i * targets_len + j]`.
+ *
+ * Runs a single Dijkstra search per source, which stops as soon as all targets are settled,
+ * instead of a separate A* search for every pair. Turn-around restrictions are not taken
+ * into account. `step_limit` applies to each search separately, see routx_find_route().
+ *
+ * Costs to targets which are unknown, unreachable or not settled within the `step_limit`
+ * are set to positive infinity. All costs from unknown sources, or if the graph is NULL,
+ * are set to positive infinity.
+ */
+void routx_cost_matrix(RoutxFrozenGraph const* graph, int64_t const* sources, size_t sources_len,
+                       int64_t const* targets, size_t targets_len, size_t step_limit,
+                       float* out_costs);
+
+/**
+ * A single route query for routx_find_routes_parallel().
+ */
+typedef struct RoutxRouteRequest {
+    /// Id of the start node.
+    int64_t from;
+
+    /// Id of the end node.
+    int64_t to;
+
+    /// Step limit of the search, see routx_find_route().
+    /// Recommended value is @ref ROUTX_DEFAULT_STEP_LIMIT.
+    size_t step_limit;
+
+    /// Use routx_find_route_without_turn_around() instead of routx_find_route().
+    bool without_turn_around;
+} RoutxRouteRequest;
+
+/**
+ * Answers a batch of route queries on multiple threads.
+ *
+ * Queries are spread over a work-stealing pool of `threads` threads, each with its own
+ * @ref RoutxSearchContext. Zero threads stands for the number of available CPU cores.
+ *
+ * `out_results` must point to an array of `requests_len` results, which is filled in the order
+ * of requests. Every result must be destroyed by calling routx_route_result_delete().
+ *
+ * If the graph is NULL, all results are @ref RoutxRouteResultTypeOk "ok results"
+ * with empty vectors.
+ */
+void routx_find_routes_parallel(RoutxFrozenGraph const* graph, RoutxRouteRequest const* requests,
+                                size_t requests_len, RoutxRouteResult* out_results,
+                                unsigned threads);
+
+/**
+ * Pool of worker threads answering route queries in the background, for callers which must not
+ * block for the duration of a search (like event loops or coroutine servers).
+ *
+ * Every worker keeps its own @ref RoutxSearchContext. Searches are started in the order of
+ * submission; cancelling long searches or giving them a timeout prevents them from delaying
+ * the searches queued behind them. The cancellation flag and the deadline are checked every few
+ * hundred settled nodes, alongside the step limit.
+ *
+ * All functions of a pool and its tasks may be called from any thread.
+ */
+typedef struct RoutxSearchPool RoutxSearchPool;
+
+/**
+ * Handle to a search submitted to a @ref RoutxSearchPool with routx_find_route_async().
+ */
+typedef struct RoutxRouteTask RoutxRouteTask;
+
+/**
+ * Callback of a finished @ref RoutxRouteTask, see routx_route_task_on_done().
+ */
+typedef void (*RoutxRouteTaskCallback)(void* arg);
+
+/**
+ * Starts a @ref RoutxSearchPool with `threads` worker threads.
+ * Zero threads stands for the number of available CPU cores.
+ *
+ * Must be deallocated with routx_search_pool_delete().
+ */
+RoutxSearchPool* routx_search_pool_new(unsigned threads);
+
+/**
+ * Deallocates a @ref RoutxSearchPool, after waiting for all submitted searches to finish.
+ * The pool may be NULL.
+ */
+void routx_search_pool_delete(RoutxSearchPool* pool);
+
+/**
+ * Queues a search on a @ref RoutxSearchPool and returns immediately.
+ *
+ * The graph is not modified, and all its arrays are shared with the search - so the graph may
+ * be deleted before the search finishes. If `timeout_us` is not zero, the search fails with
+ * @ref RoutxRouteResultTypeDeadlineExceeded once that many microseconds pass since
+ * the submission, including the time spent waiting in the queue.
+ *
+ * The returned task must be deallocated with either routx_route_task_wait() or
+ * routx_route_task_delete(). Returns NULL if the pool, the graph or the request is NULL.
+ */
+RoutxRouteTask* routx_find_route_async(RoutxSearchPool const* pool, RoutxFrozenGraph const* graph,
+                                       RoutxRouteRequest const* request, uint64_t timeout_us);
+
+/**
+ * Registers a callback invoked with `arg` (on a worker thread) once the search finishes,
+ * replacing any previously registered callback. The callback must not block for long,
+ * as it delays other searches; it may call any function of the task, including
+ * routx_route_task_wait(), which then returns immediately.
+ *
+ * Returns false if the search has already finished (or the task is NULL) - in this case
+ * the callback is not called.
+ */
+bool routx_route_task_on_done(RoutxRouteTask const* task, RoutxRouteTaskCallback callback,
+                              void* arg);
+
+/**
+ * Returns true if the search has finished, so that routx_route_task_wait() won't block.
+ * Returns true if the task is NULL.
+ */
+bool routx_route_task_is_done(RoutxRouteTask const* task);
+
+/**
+ * Asks the search to stop, so that it fails with @ref RoutxRouteResultTypeCancelled
+ * (unless it has already finished). Searches which haven't started yet are never started.
+ * Does nothing if the task is NULL.
+ */
+void routx_route_task_cancel(RoutxRouteTask const* task);
+
+/**
+ * Waits for the search to finish, deallocates the task and returns the result of the search,
+ * which must be destroyed by calling routx_route_result_delete().
+ *
+ * If the task is NULL, returns an @ref RoutxRouteResultTypeOk "ok result" with an empty vector.
+ */
+RoutxRouteResult routx_route_task_wait(RoutxRouteTask* task);
+
+/**
+ * Deallocates a task without waiting for its search, which continues in the background
+ * (call routx_route_task_cancel() first to stop it). Registered callbacks are still called.
+ * The task may be NULL.
+ */
+void routx_route_task_delete(RoutxRouteTask* task);
+
+/**
+ * Outcome of routx_frozen_graph_find_route_into() and routx_frozen_graph_find_route_borrowed(),
+ * which - unlike @ref RoutxRouteResult - doesn't own the nodes of the route.
+ */
+typedef struct RoutxRouteStatus {
+    /// Overall outcome of the search, see @ref RoutxRouteResult.type.
+    RoutxRouteResultType type;
+
+    /// ID of the non-existing node, valid if and only if `type` is set to
+    /// @ref RoutxRouteResultTypeInvalidReference.
+    int64_t invalid_node_id;
+
+    /// Number of nodes of the route. Zero if no route exists or `type` is not
+    /// @ref RoutxRouteResultTypeOk.
+    size_t len;
+} RoutxRouteStatus;
+
+/**
+ * Answers a single route query, writing the route directly into a caller-owned buffer `out`
+ * of `capacity` nodes, so that no memory crosses the library boundary.
+ *
+ * Returns the outcome of the search, including the number of nodes of the route. If it is larger
+ * than `capacity`, nothing is written to `out`, and the query must be repeated with a large
+ * enough buffer.
+ *
+ * The route is kept in the provided @ref RoutxSearchContext, so once the context
+ * has grown to fit the graph and the longest route, the search doesn't allocate anything.
+ * If the context is NULL, a temporary one is used.
+ *
+ * If the graph or the request is NULL, returns an @ref RoutxRouteResultTypeOk "ok status"
+ * with no nodes.
+ */
+RoutxRouteStatus routx_frozen_graph_find_route_into(RoutxFrozenGraph const* graph,
+                                                    RoutxSearchContext* ctx,
+                                                    RoutxRouteRequest const* request,
+                                                    int64_t* out, size_t capacity);
+
+/**
+ * Answers a single route query, see routx_frozen_graph_find_route_into(), lending the route
+ * stored in the provided @ref RoutxSearchContext to the caller.
+ *
+ * `*out_nodes` is set to the first of the returned `len` nodes, or to NULL if the route is empty.
+ * The nodes remain valid until the context is used by another search or deleted.
+ *
+ * If the graph, the context or the request is NULL, returns an
+ * @ref RoutxRouteResultTypeOk "ok status" with no nodes.
+ */
+RoutxRouteStatus routx_frozen_graph_find_route_borrowed(RoutxFrozenGraph const* graph,
+                                                        RoutxSearchContext* ctx,
+                                                        RoutxRouteRequest const* request,
+                                                        int64_t const** out_nodes);
+
+/**
+ * Caller-owned parallel arrays receiving a detailed route, see routx_find_route_detailed().
+ *
+ * All non-NULL arrays must have space for at least `capacity` elements.
+ * NULL arrays are not filled.
+ */
+typedef struct RoutxRouteDetailed {
+    /// Receives the ID of every node of the route.
+    int64_t* ids;
+
+    /// Receives the latitude of every node of the route.
+    float* lats;
+
+    /// Receives the longitude of every node of the route.
+    float* lons;
+
+    /// Receives the cumulative cost of reaching every node of the route from the start.
+    /// The first cost is always zero, and the last one is the cost of the whole route.
+    float* costs;
+
+    /// Number of elements of every non-NULL array.
+    size_t capacity;
+} RoutxRouteDetailed;
+
+/**
+ * Equivalent of routx_find_route(), additionally returning the position of every node
+ * of the route and the cumulative cost of reaching it, all in a single call.
+ *
+ * The route is written into the arrays of `out` (which may be NULL to only compute the length
+ * of the route). Returns the outcome of the search, including the number of nodes of the route.
+ * If it is larger than `out->capacity`, nothing is written, and the query must be repeated
+ * with larger arrays.
+ *
+ * If the graph is NULL, returns an @ref RoutxRouteResultTypeOk "ok status" with no nodes.
+ */
+RoutxRouteStatus routx_find_route_detailed(RoutxGraph const* graph, int64_t from, int64_t to,
+                                           size_t step_limit, RoutxRouteDetailed const* out);
+
+/**
+ * Equivalent of routx_find_route_detailed() operating on a @ref RoutxFrozenGraph, see
+ * routx_frozen_graph_find_route_into(). Positions and costs are read directly from the search,
+ * without any per-node lookups.
+ *
+ * If the context is NULL, a temporary one is used. If the graph or the request is NULL,
+ * returns an @ref RoutxRouteResultTypeOk "ok status" with no nodes.
+ */
+RoutxRouteStatus routx_frozen_graph_find_route_detailed(RoutxFrozenGraph const* graph,
+                                                        RoutxSearchContext* ctx,
+                                                        RoutxRouteRequest const* request,
+                                                        RoutxRouteDetailed const* out);
+
+/**
+ * Finds all nodes which can be reached from the `from` node with a total cost of at most
+ * `max_cost` (an isochrone), running a Dijkstra search bounded by the cost budget.
+ *
+ * `callback` (if not NULL) is called with `arg`, the ID and the cost of every reached node,
+ * in the order of increasing costs. The start node is always reached with a zero cost.
+ * Turn-around restrictions are not taken into account, and nodes created for turn restrictions
+ * are reported separately from the canonical ones.
+ *
+ * If `out_hull_len` is not NULL, the vertices of the convex hull of all reached nodes
+ * (in counter-clockwise order, treating longitudes and latitudes as planar coordinates)
+ * are also computed. `*out_hull_len` is set to the number of vertices, and if it doesn't exceed
+ * `hull_capacity`, they are written into `out_hull`.
+ *
+ * The storage of the provided @ref RoutxSearchContext is reused, so once it has grown to fit the
+ * graph, the search doesn't allocate anything. If the context is NULL, a temporary one is used.
+ *
+ * `step_limit` limits the number of reached nodes, see routx_find_route(). If it is exceeded,
+ * `callback` will have already been called on the first `step_limit` nodes.
+ *
+ * Returns the outcome of the search, with `len` set to the number of reached nodes.
+ * If the graph is NULL, returns an @ref RoutxRouteResultTypeOk "ok status" with no nodes.
+ */
+RoutxRouteStatus routx_reachable(RoutxFrozenGraph const* graph, RoutxSearchContext* ctx,
+                                 int64_t from, float max_cost, size_t step_limit,
+                                 void (*callback)(void* arg, int64_t node_id, float cost),
+                                 void* arg, RoutxNode* out_hull, size_t hull_capacity,
+                                 size_t* out_hull_len);
+
+/**
+ * [Contraction hierarchy](https://en.wikipedia.org/wiki/Contraction_hierarchies) built over
+ * a @ref RoutxGraph, for very fast route queries on large graphs.
+ *
+ * Preprocessing contracts nodes one-by-one, adding shortcut edges which preserve shortest
+ * paths between the remaining nodes. Queries run a bidirectional Dijkstra search which only
+ * follows edges towards more important nodes, settling a tiny fraction of the nodes A* would.
+ *
+ * Turn restrictions are respected, and returned routes are equivalent to those returned by
+ * routx_find_route(). Avoiding immediate turnarounds is not supported.
+ *
+ * A contraction hierarchy is not affected by any changes made to the @ref RoutxGraph
+ * it was created from.
+ */
+typedef struct RoutxCHGraph RoutxCHGraph;
+
+/**
+ * Builds a @ref RoutxCHGraph over the provided @ref RoutxGraph. This is a slow operation,
+ * meant to be done once after loading the graph.
+ *
+ * Must be deallocated with routx_ch_graph_delete().
+ *
+ * Returns NULL if the graph is NULL.
+ */
+RoutxCHGraph* routx_ch_build(RoutxGraph const* graph);
+
+/**
+ * Deallocates a @ref RoutxCHGraph created by routx_ch_build(). The graph may be NULL.
+ */
+void routx_ch_graph_delete(RoutxCHGraph* graph);
+
+/**
+ * Returns the number of @ref RoutxNode "RoutxNodes" in a contraction hierarchy,
+ * or zero if the graph is NULL.
+ */
+size_t routx_ch_graph_len(RoutxCHGraph const* graph);
+
+/**
+ * Finds the shortest route between two nodes using a contraction hierarchy.
+ *
+ * The semantics are the same as routx_find_route(), except that `step_limit` limits the number
+ * of nodes settled by both halves of the bidirectional search together.
+ *
+ * The returned result must be destroyed by calling routx_route_result_delete().
+ */
+RoutxRouteResult routx_ch_find_route(RoutxCHGraph const* graph, int64_t from, int64_t to,
+                                     size_t step_limit);
+
+/**
+ * Equivalent of routx_ch_find_route(), reusing the storage of the provided
+ * @ref RoutxSearchContext.
+ *
+ * If the context is NULL, a temporary one is allocated for the search.
+ *
+ * The returned result must be destroyed by calling routx_route_result_delete().
+ */
+RoutxRouteResult routx_ch_find_route_with_context(RoutxCHGraph const* graph,
+                                                  RoutxSearchContext* ctx, int64_t from,
+                                                  int64_t to, size_t step_limit);
+
+/**
+ * Compressed, read-only snapshot of a @ref RoutxFrozenGraph for graphs which don't fit in memory
+ * otherwise. Routing runs directly on the compressed form.
+ *
+ * Coordinates are stored as 32-bit fixed-point numbers with a resolution of 1e-7 degree
+ * (about 1 cm), OSM ids only for nodes where they differ from node ids, and every edge
+ * as two variable-length integers: the difference between the dense indices of its end and
+ * start nodes, followed by its cost as a multiple of `cost_scale`. On graphs reordered with
+ * routx_frozen_graph_reordered() most edges take 3 to 4 bytes instead of 8, and nodes take
+ * 20 bytes instead of 28.
+ *
+ * Edge costs are rounded up to a multiple of `cost_scale`. Routes are thus shortest routes
+ * given the rounded costs, and their cost exceeds the cost of the actual shortest route by less
+ * than `cost_scale` times its number of edges. Avoiding immediate turnarounds is not supported.
+ */
+typedef struct RoutxCompactGraph RoutxCompactGraph;
+
+/**
+ * Compresses a @ref RoutxFrozenGraph, keeping the order of its nodes and edges.
+ * Reorder the graph along the Hilbert curve first for the best compression.
+ * @ref ROUTX_DEFAULT_COST_SCALE is the recommended `cost_scale`.
+ *
+ * Must be deallocated with routx_compact_graph_delete().
+ *
+ * Returns NULL if the graph is NULL, or if `cost_scale` is not a positive, finite number.
+ */
+RoutxCompactGraph* routx_compact_graph_build(RoutxFrozenGraph const* graph, float cost_scale);
+
+/**
+ * Deallocates a @ref RoutxCompactGraph created by routx_compact_graph_build()
+ * or routx_compact_graph_open_mmap(). The graph may be NULL.
+ */
+void routx_compact_graph_delete(RoutxCompactGraph* graph);
+
+/**
+ * Saves a @ref RoutxCompactGraph to a file, in a versioned, little-endian binary format,
+ * which mirrors the in-memory layout of the graph. Such files can be opened
+ * with routx_compact_graph_open_mmap().
+ *
+ * Returns false if saving has failed, see logs in such case.
+ * Returns false if the graph is NULL.
+ */
+bool routx_compact_graph_save(RoutxCompactGraph const* graph, char const* filename);
+
+/**
+ * Opens a graph saved with routx_compact_graph_save() by memory-mapping the file,
+ * see routx_graph_open_mmap(). The file must not be modified or truncated while the graph
+ * is alive - doing so results in undefined behavior or a SIGBUS crash.
+ *
+ * Must be deallocated with routx_compact_graph_delete().
+ *
+ * Returns NULL if opening has failed, see logs in such case.
+ */
+RoutxCompactGraph* routx_compact_graph_open_mmap(char const* filename);
+
+/**
+ * Returns the number of @ref RoutxNode "RoutxNodes" in a compact graph,
+ * or zero if the graph is NULL.
+ */
+size_t routx_compact_graph_len(RoutxCompactGraph const* graph);
+
+/**
+ * Returns the number of edges in a compact graph, or zero if the graph is NULL.
+ */
+size_t routx_compact_graph_edge_count(RoutxCompactGraph const* graph);
+
+/**
+ * Finds a node with the provided id. If no such node was found, returns a zero (`id == 0`) node.
+ *
+ * If the graph is NULL, returns a zero node.
+ */
+RoutxNode routx_compact_graph_get_node(RoutxCompactGraph const* graph, int64_t id);
+
+/**
+ * Gets the rounded cost of an edge from one node to another.
+ * Returns positive infinity when the provided edge can't be found, or when the graph is NULL.
+ */
+float routx_compact_graph_get_edge(RoutxCompactGraph const* graph, int64_t from, int64_t to);
+
+/**
+ * Finds the shortest route between two nodes of a compact graph using the A* algorithm,
+ * see routx_frozen_graph_find_route_with_context().
+ *
+ * If the context is NULL, a temporary one is allocated for the search.
+ *
+ * The returned result must be destroyed by calling routx_route_result_delete().
+ */
+RoutxRouteResult routx_compact_graph_find_route_with_context(RoutxCompactGraph const* graph,
+                                                             RoutxSearchContext* ctx,
+                                                             int64_t from, int64_t to,
+                                                             size_t step_limit);
+
+/**
+ * Precomputed distances to and from a set of landmark nodes of a @ref RoutxFrozenGraph,
+ * used by the ALT (A*, landmarks, triangle inequality) heuristic.
+ *
+ * For any landmark `L`, the triangle inequality gives two lower bounds of the cost
+ * from `v` to `t`: `d(L, t) - d(L, v)` and `d(v, L) - d(t, L)`. Unlike the crow-flies
+ * distance, those bounds take edge costs (and thus profile penalties) into account,
+ * which can drastically reduce the number of nodes expanded by A*.
+ *
+ * Landmarks take `8 × count` bytes per node.
+ */
+typedef struct RoutxLandmarks RoutxLandmarks;
+
+/**
+ * Selects up to `count` landmarks of the provided graph, and computes distances to and
+ * from them. This requires 2 full Dijkstra searches per landmark.
+ *
+ * Must be deallocated with routx_landmarks_delete().
+ *
+ * Returns NULL if the graph is NULL.
+ */
+RoutxLandmarks* routx_landmarks_build(RoutxFrozenGraph const* graph, size_t count);
+
+/**
+ * Deallocates @ref RoutxLandmarks created by routx_landmarks_build() or routx_landmarks_load().
+ * The landmarks may be NULL.
+ */
+void routx_landmarks_delete(RoutxLandmarks* landmarks);
+
+/**
+ * Returns the number of landmarks, or zero if the landmarks are NULL.
+ */
+size_t routx_landmarks_len(RoutxLandmarks const* landmarks);
+
+/**
+ * Saves @ref RoutxLandmarks to a file, in a versioned, little-endian binary format.
+ *
+ * Returns false if saving has failed, see logs in such case.
+ * Returns false if the landmarks are NULL.
+ */
+bool routx_landmarks_save(RoutxLandmarks const* landmarks, char const* filename);
+
+/**
+ * Loads @ref RoutxLandmarks saved with routx_landmarks_save().
+ *
+ * Must be deallocated with routx_landmarks_delete().
+ *
+ * Returns NULL if loading has failed, see logs in such case.
+ */
+RoutxLandmarks* routx_landmarks_load(char const* filename);
+
+/**
+ * Equivalent of routx_frozen_graph_find_route_with_context(), using the ALT heuristic -
+ * the maximum of the crow-flies distance and the bounds given by the provided
+ * @ref RoutxLandmarks.
+ *
+ * If the landmarks are NULL, or were built for a different graph, falls back to the crow-flies
+ * heuristic. If the context is NULL, a temporary one is allocated for the search.
+ *
+ * The returned result must be destroyed by calling routx_route_result_delete().
+ */
+RoutxRouteResult routx_frozen_graph_find_route_with_landmarks(RoutxFrozenGraph const* graph,
+                                                              RoutxLandmarks const* landmarks,
+                                                              RoutxSearchContext* ctx,
+                                                              int64_t from, int64_t to,
+                                                              size_t step_limit);
+
+/**
+ * Equivalent of routx_frozen_graph_find_route_without_turn_around_with_context(), using
+ * the ALT heuristic, see routx_frozen_graph_find_route_with_landmarks().
+ *
+ * The returned result must be destroyed by calling routx_route_result_delete().
+ */
+RoutxRouteResult routx_frozen_graph_find_route_without_turn_around_with_landmarks(
+    RoutxFrozenGraph const* graph, RoutxLandmarks const* landmarks, RoutxSearchContext* ctx,
+    int64_t from, int64_t to, size_t step_limit);
+
+/**
+ * Epoch-based, copy-on-write overlay of edge costs over a @ref RoutxFrozenGraph,
+ * for live traffic updates while route queries are running.
+ *
+ * Writers publish new costs as multipliers ("factors") of the base costs of the graph.
+ * Every publication builds a new cost array, which shares all other arrays with the base graph,
+ * and atomically replaces the current snapshot, advancing the epoch. Readers take a snapshot
+ * with routx_cost_overlay_snapshot() and route on it without any further synchronization.
+ * Old snapshots stay valid until they are deleted.
+ *
+ * All functions are thread-safe. Concurrent writers are serialized.
+ *
+ * Published costs are never lower than the crow-flies distance between the edge's endpoints
+ * (or the base cost, if it already was lower), so that the A* heuristic remains admissible.
+ * @ref RoutxLandmarks built for the base graph remain valid as long as all factors are
+ * at least 1.
+ */
+typedef struct RoutxCostOverlay RoutxCostOverlay;
+
+/**
+ * Per-edge multiplier of the base cost, see routx_cost_overlay_update_factors().
+ */
+typedef struct RoutxEdgeFactor {
+    /// ID of the start of the edge.
+    int64_t from;
+
+    /// ID of the end of the edge.
+    int64_t to;
+
+    /// Multiplier of the base cost of the edge. Positive infinity closes the edge.
+    float factor;
+} RoutxEdgeFactor;
+
+/**
+ * Creates a cost overlay over a copy of the provided graph (which shares all arrays with it,
+ * see routx_cost_overlay_snapshot()), with the base costs published at a new epoch.
+ *
+ * Must be deallocated with routx_cost_overlay_delete().
+ *
+ * Returns NULL if the graph is NULL.
+ */
+RoutxCostOverlay* routx_cost_overlay_new(RoutxFrozenGraph const* graph);
+
+/**
+ * Deallocates a @ref RoutxCostOverlay created by routx_cost_overlay_new().
+ * Snapshots remain valid. The overlay may be NULL.
+ */
+void routx_cost_overlay_delete(RoutxCostOverlay* overlay);
+
+/**
+ * Returns the epoch of the most recently published snapshot. Epochs increase with every
+ * publication, and come from the same process-wide counter as routx_graph_epoch(), so they are
+ * never zero. Returns 0 if the overlay is NULL.
+ */
+uint64_t routx_cost_overlay_epoch(RoutxCostOverlay const* overlay);
+
+/**
+ * Returns the most recently published snapshot, and writes its epoch into `out_epoch`
+ * (if not NULL). The snapshot shares all arrays with the overlay, so this is cheap.
+ *
+ * Must be deallocated with routx_frozen_graph_delete().
+ *
+ * Returns NULL if the overlay is NULL.
+ */
+RoutxFrozenGraph* routx_cost_overlay_snapshot(RoutxCostOverlay const* overlay,
+                                              uint64_t* out_epoch);
+
+/**
+ * Publishes new factors of all edges, in the internal order of edges of the graph
+ * (outgoing edges of every node, with nodes in the order of the graph file).
+ *
+ * Returns the epoch of the new snapshot, or 0 if the overlay is NULL or `factors_len` is different
+ * than routx_frozen_graph_edge_count().
+ */
+uint64_t routx_cost_overlay_set_factors(RoutxCostOverlay const* overlay, float const* factors,
+                                        size_t factors_len);
+
+/**
+ * Publishes new factors of the provided edges, keeping the factors of all other edges.
+ * Factors of edges which don't exist are ignored. All edges between the same pair of nodes
+ * receive the same factor.
+ *
+ * Returns the epoch of the new snapshot, or 0 if the overlay is NULL.
+ */
+uint64_t routx_cost_overlay_update_factors(RoutxCostOverlay const* overlay,
+                                           RoutxEdgeFactor const* updates, size_t updates_len);
+
+/**
+ * A [k-d tree data structure](https://en.wikipedia.org/wiki/K-d_tree) which can be used to
+ * speed up nearest-neighbor search for large datasets.
+ *
+ * Practice shows that routx_graph_find_nearest_node() takes significantly more time than
+ * routx_find_route() when generating multiple routes with routx. A k-d tree helps with that,
+ * trading CPU time for memory usage.
+ */
+typedef struct RoutxKDTree RoutxKDTree;
+
+/**
+ * Builds a @ref RoutxKDTree with all canonical (`id == osm_id`) @ref RoutxNode "RoutxNodes"
+ * contained in the provided @ref RoutxGraph.
+ *
+ * Must be deallocated with routx_kd_tree_delete().
+ *
+ * Returns NULL if the graph has no nodes.
+ */
+RoutxKDTree* routx_kd_tree_new(RoutxGraph const*);
+
+/**
+ * Deallocates a @ref RoutxKDTree created by routx_kd_tree_new(). The k-d tree may be NULL.
+ */
+void routx_kd_tree_delete(RoutxKDTree*);
+
+/**
+ * Finds the closest node to the provided position and returns it.
+ * If there are no nodes or the k-d tree is NULL, returns a zero (`id == 0`) node.
+ */
+RoutxNode routx_kd_tree_find_nearest_node(RoutxKDTree const* kd_tree, float lat, float lon);
+
+/**
+ * Finds up to `k` closest nodes to the provided position, and writes them into `out`
+ * (which must have space for at least `k` nodes), ordered by increasing
+ * routx_earth_distance() from the position.
+ *
+ * Returns the number of written nodes, which is `k` unless the k-d tree has fewer nodes.
+ * If the k-d tree is NULL, returns 0.
+ */
+size_t routx_kd_tree_find_k_nearest(RoutxKDTree const* kd_tree, float lat, float lon, size_t k,
+                                    RoutxNode* out);
+
+/**
+ * Finds the closest node to every `(lats[i], lons[i])` position, for `i` in `0..n`,
+ * and writes it to `out[i]`. `lats`, `lons` and `out` must all have `n` elements.
+ *
+ * The queries are spread over `threads` threads, or over as many threads as available
+ * if `threads` is zero.
+ *
+ * If the k-d tree is NULL, all written nodes are zero (`id == 0`) nodes.
+ */
+void routx_kd_tree_find_nearest_nodes(RoutxKDTree const* kd_tree, float const* lats,
+                                      float const* lons, size_t n, RoutxNode* out,
+                                      unsigned int threads);
+
+/**
+ * A uniform grid of cells over all canonical (`id == osm_id`) nodes, for fast nearest-neighbor
+ * search with densely distributed data, like road networks.
+ *
+ * Nodes are stored contiguously per cell, and a search only has to visit the cell of the query
+ * position and its immediate neighbors (unless the area is sparse), which on average takes
+ * constant time - unlike a @ref RoutxKDTree search. Unlike a @ref RoutxKDTree, a grid index
+ * also handles data close to or crossing the antimeridian (180°/-180° longitude).
+ *
+ * Repeated lookups of the same positions can be sped up further with a @ref RoutxSnapCache.
+ */
+typedef struct RoutxGridIndex RoutxGridIndex;
+
+/**
+ * Builds a @ref RoutxGridIndex with all canonical (`id == osm_id`) @ref RoutxNode "RoutxNodes"
+ * contained in the provided @ref RoutxGraph, with cells of the provided size (in meters).
+ * @ref ROUTX_DEFAULT_GRID_CELL_SIZE is the recommended `cell_size`. If the cells would greatly
+ * outnumber the nodes, their size is increased to bound the memory usage.
+ *
+ * Must be deallocated with routx_grid_index_delete().
+ *
+ * Returns NULL if the graph is NULL or has no nodes,
+ * or if `cell_size` is not a positive, finite number.
+ */
+RoutxGridIndex* routx_grid_index_new(RoutxGraph const* graph, float cell_size);
+
+/**
+ * Deallocates a @ref RoutxGridIndex created by routx_grid_index_new(). The index may be NULL.
+ */
+void routx_grid_index_delete(RoutxGridIndex*);
+
+/**
+ * Finds the closest node to the provided position and returns it.
+ * If the index is NULL, returns a zero (`id == 0`) node.
+ */
+RoutxNode routx_grid_index_find_nearest_node(RoutxGridIndex const* index, float lat, float lon);
+
+/**
+ * Finds the closest node to every `(lats[i], lons[i])` position, for `i` in `0..n`,
+ * and writes it to `out[i]`. `lats`, `lons` and `out` must all have `n` elements.
+ *
+ * The queries are spread over `threads` threads, or over as many threads as available
+ * if `threads` is zero.
+ *
+ * If the index is NULL, all written nodes are zero (`id == 0`) nodes.
+ */
+void routx_grid_index_find_nearest_nodes(RoutxGridIndex const* index, float const* lats,
+                                         float const* lons, size_t n, RoutxNode* out,
+                                         unsigned int threads);
+
+/**
+ * Bounded, least-recently-used cache of nearest-node lookups,
+ * see routx_grid_index_find_nearest_node_cached().
+ *
+ * Positions are quantized to multiples of `quantum` meters, and all positions with the same
+ * quantized coordinates share a cache entry - the node of the first lookup is returned for all
+ * of them. Keep the quantum well below the distance between nodes.
+ */
+typedef struct RoutxSnapCache RoutxSnapCache;
+
+/**
+ * Same as routx_grid_index_find_nearest_node(), but first looks up the (quantized) position
+ * in the provided @ref RoutxSnapCache, and stores the result in the cache on a miss.
+ * The cache must only be used with a single index. If the cache is NULL, it is not used.
+ *
+ * A @ref RoutxSnapCache may only be used by one thread at a time.
+ */
+RoutxNode routx_grid_index_find_nearest_node_cached(RoutxGridIndex const* index,
+                                                    RoutxSnapCache* cache, float lat, float lon);
+
+/**
+ * Creates an empty @ref RoutxSnapCache of at most `capacity` entries, quantizing positions
+ * to multiples of `quantum` meters. @ref ROUTX_DEFAULT_SNAP_QUANTUM is the recommended
+ * `quantum`. A cache with zero capacity never stores anything.
+ *
+ * Must be deallocated with routx_snap_cache_delete().
+ *
+ * Returns NULL if `quantum` is not a positive, finite number.
+ */
+RoutxSnapCache* routx_snap_cache_new(size_t capacity, float quantum);
+
+/**
+ * Deallocates a @ref RoutxSnapCache created by routx_snap_cache_new(). The cache may be NULL.
+ */
+void routx_snap_cache_delete(RoutxSnapCache*);
+
+/**
+ * Removes all cached lookups, e.g. after switching to a different @ref RoutxGridIndex.
+ * Hit and miss counters are preserved. Does nothing if the cache is NULL.
+ */
+void routx_snap_cache_clear(RoutxSnapCache* cache);
+
+/**
+ * Returns the number of cached lookups, or 0 if the cache is NULL.
+ */
+size_t routx_snap_cache_len(RoutxSnapCache const* cache);
+
+/**
+ * Returns the number of lookups answered from the cache, or 0 if the cache is NULL.
+ */
+uint64_t routx_snap_cache_hits(RoutxSnapCache const* cache);
+
+/**
+ * Returns the number of lookups which weren't cached, or 0 if the cache is NULL.
+ */
+uint64_t routx_snap_cache_misses(RoutxSnapCache const* cache);
+
+/**
+ * Search used to find a route stored in a @ref RoutxRouteCache.
+ */
+typedef enum RoutxRouteKind {
+    /// routx_find_route()
+    RoutxRouteKindShortest = 0,
+
+    /// routx_find_route_without_turn_around()
+    RoutxRouteKindWithoutTurnAround = 1,
+} RoutxRouteKind;
+
+/**
+ * Thread-safe, bounded, least-recently-used cache of routes found over a single graph,
+ * for serving repeated queries (like routes from a depot to its common customers)
+ * without re-running the search.
+ *
+ * Routes are keyed by their start and end nodes, the @ref RoutxRouteKind and the epoch of the
+ * graph - routx_graph_epoch() for a @ref RoutxGraph, or routx_cost_overlay_epoch() for
+ * a @ref RoutxCostOverlay. As soon as a newer epoch is seen, all cached routes are dropped.
+ * Epochs are unique within the process, so routes are never returned for a graph other than
+ * the one they were found on - but the cache is only effective for one graph at a time.
+ *
+ * All functions may be called concurrently from multiple threads.
+ */
+typedef struct RoutxRouteCache RoutxRouteCache;
+
+/**
+ * Creates an empty @ref RoutxRouteCache of at most `capacity` routes.
+ * A cache with zero capacity never stores anything.
+ *
+ * Must be deallocated with routx_route_cache_delete().
+ */
+RoutxRouteCache* routx_route_cache_new(size_t capacity);
+
+/**
+ * Deallocates a @ref RoutxRouteCache created by routx_route_cache_new(). The cache may be NULL.
+ */
+void routx_route_cache_delete(RoutxRouteCache*);
+
+/**
+ * Removes all cached routes. Hit and miss counters are preserved.
+ * Does nothing if the cache is NULL.
+ */
+void routx_route_cache_clear(RoutxRouteCache const* cache);
+
+/**
+ * Returns the number of cached routes, or 0 if the cache is NULL.
+ */
+size_t routx_route_cache_len(RoutxRouteCache const* cache);
+
+/**
+ * Returns the number of queries answered from the cache, or 0 if the cache is NULL.
+ */
+uint64_t routx_route_cache_hits(RoutxRouteCache const* cache);
+
+/**
+ * Returns the number of queries which required a search, or 0 if the cache is NULL.
+ */
+uint64_t routx_route_cache_misses(RoutxRouteCache const* cache);
+
+/**
+ * Returns the cached route between two nodes of a @ref RoutxGraph at its current epoch,
+ * or finds (and caches) the route with routx_find_route() or
+ * routx_find_route_without_turn_around(), depending on the `kind`. Errors are never cached.
+ *
+ * On success, the cost of the whole route (or zero if there is no route) is written to
+ * `out_cost`, unless it is NULL. The returned route must be deallocated with
+ * routx_route_result_delete().
+ *
+ * If the cache is NULL, simply searches the route. If the graph is NULL,
+ * returns an empty @ref RoutxRouteResultTypeOk result.
+ */
+RoutxRouteResult routx_route_cache_find_route(RoutxRouteCache const* cache,
+                                              RoutxGraph const* graph, RoutxRouteKind kind,
+                                              int64_t from, int64_t to, size_t step_limit,
+                                              float* out_cost);
+
+/**
+ * Same as routx_route_cache_find_route(), but searches the most recently published snapshot
+ * of a @ref RoutxCostOverlay, keyed by its epoch. Routes are thus automatically invalidated
+ * by routx_cost_overlay_set_factors() and routx_cost_overlay_update_factors().
+ */
+RoutxRouteResult routx_route_cache_find_route_with_overlay(RoutxRouteCache const* cache,
+                                                           RoutxCostOverlay const* overlay,
+                                                           RoutxRouteKind kind, int64_t from,
+                                                           int64_t to, size_t step_limit,
+                                                           float* out_cost);
+
+/**
+ * Immutable, atomically reference-counted @ref RoutxGraph, which can be used from
+ * any number of threads concurrently.
+ *
+ * Every RoutxSharedGraph handle holds a reference to the graph, and the graph is deallocated
+ * once the last handle is deleted. routx_shared_graph_get() gives access to the graph
+ * for all read-only (`RoutxGraph const*`) functions.
+ */
+typedef struct RoutxSharedGraph RoutxSharedGraph;
+
+/**
+ * Holds a @ref RoutxSharedGraph which can be replaced while other threads are routing on it,
+ * e.g. to hot-swap a newly loaded network.
+ *
+ * routx_graph_slot_load() and routx_graph_slot_store() may be called concurrently from any
+ * number of threads. They only hold an internal lock while copying or replacing the reference,
+ * never while a graph is used or deallocated, so a store doesn't wait for routes being
+ * calculated on the previous graph - those routes finish on the previous graph,
+ * which is deallocated once the last @ref RoutxSharedGraph referring to it is deleted.
+ */
+typedef struct RoutxGraphSlot RoutxGraphSlot;
+
+/**
+ * Converts a @ref RoutxGraph into a @ref RoutxSharedGraph, taking ownership of the graph -
+ * the graph pointer must not be used (or deleted) afterwards.
+ *
+ * Must be deallocated with routx_shared_graph_delete(). Returns NULL if the graph is NULL.
+ */
+RoutxSharedGraph* routx_shared_graph_new(RoutxGraph* graph);
+
+/**
+ * Creates a new handle to the same graph, without copying it.
+ *
+ * Must be deallocated with routx_shared_graph_delete(). Returns NULL if the graph is NULL.
+ */
+RoutxSharedGraph* routx_shared_graph_clone(RoutxSharedGraph const* graph);
+
+/**
+ * Deallocates a @ref RoutxSharedGraph handle. The graph itself is deallocated once its last
+ * handle is deleted. The handle may be NULL.
+ */
+void routx_shared_graph_delete(RoutxSharedGraph* graph);
+
+/**
+ * Returns the shared graph, which may be used with all functions taking a `RoutxGraph const*`
+ * for as long as the provided handle exists. The returned pointer must not be deleted or cast
+ * to a non-const pointer.
+ *
+ * Returns NULL if the handle is NULL.
+ */
+RoutxGraph const* routx_shared_graph_get(RoutxSharedGraph const* graph);
+
+/**
+ * Returns the number of @ref RoutxSharedGraph handles (including ones loaded from
+ * @ref RoutxGraphSlot "RoutxGraphSlots") referring to the same graph, or 0 if the handle
+ * is NULL. The count may be changed concurrently by other threads.
+ */
+size_t routx_shared_graph_use_count(RoutxSharedGraph const* graph);
+
+/**
+ * Creates a @ref RoutxGraphSlot holding the provided graph. The graph handle is not consumed.
+ *
+ * Must be deallocated with routx_graph_slot_delete(). Returns NULL if the graph is NULL.
+ */
+RoutxGraphSlot* routx_graph_slot_new(RoutxSharedGraph const* graph);
+
+/**
+ * Deallocates a @ref RoutxGraphSlot. Handles loaded from the slot remain valid.
+ * The slot may be NULL.
+ */
+void routx_graph_slot_delete(RoutxGraphSlot* slot);
+
+/**
+ * Returns a new handle to the currently held graph.
+ *
+ * Must be deallocated with routx_shared_graph_delete(). Returns NULL if the slot is NULL.
+ */
+RoutxSharedGraph* routx_graph_slot_load(RoutxGraphSlot const* slot);
+
+/**
+ * Replaces the held graph with the provided one. The graph handle is not consumed.
+ * Handles previously loaded from the slot still refer to the previous graph.
+ *
+ * Returns false (and does nothing) if the slot or the graph is NULL.
+ */
+bool routx_graph_slot_store(RoutxGraphSlot const* slot, RoutxSharedGraph const* graph);
+
+/**
+ * Read-only graph split into square tiles (in degrees of latitude and longitude), stored
+ * in a directory as separate files, and loaded only when searches reach them.
+ *
+ * Every node belongs to the tile containing its position. Edges are stored with the tile
+ * of their start node; if an edge crosses into another tile, the tile also includes
+ * an edge-less copy of its target (a border node), which tells the search which tile
+ * to load next.
+ *
+ * Loaded tiles are memory-mapped and kept in a cache. Once the total size of files of cached
+ * tiles exceeds the memory budget, least recently used tiles are dropped - apart from
+ * the most recently used one.
+ *
+ * All functions taking a `RoutxTiledGraph const*` may be called concurrently
+ * from any number of threads.
+ */
+typedef struct RoutxTiledGraph RoutxTiledGraph;
+
+/**
+ * Counters of a @ref RoutxTiledGraph tile cache.
+ */
+typedef struct RoutxTileStats {
+    /// Number of tiles of the graph.
+    uint64_t tiles;
+
+    /// Number of tiles currently in the cache.
+    uint64_t loaded_tiles;
+
+    /// Total size of files of tiles currently in the cache, in bytes.
+    uint64_t resident_bytes;
+
+    /// Number of times a tile was loaded.
+    uint64_t loads;
+
+    /// Number of times a tile was dropped from the cache to stay within the memory budget.
+    uint64_t evictions;
+} RoutxTileStats;
+
+/**
+ * Splits a @ref RoutxFrozenGraph into tiles of `tile_size` degrees, and saves them
+ * along with an index of all nodes into the `dirname` directory, creating it if necessary.
+ * ::ROUTX_DEFAULT_TILE_SIZE is the recommended tile size.
+ *
+ * Returns false if saving has failed or if `tile_size` is not a positive number,
+ * see logs in such case. Returns false if the graph is NULL.
+ */
+bool routx_tiled_graph_save(RoutxFrozenGraph const* graph, char const* dirname, float tile_size);
+
+/**
+ * Opens a graph saved with routx_tiled_graph_save() in the `dirname` directory,
+ * only memory-mapping the index of all nodes. Tiles are loaded on demand, and dropped
+ * once the total size of their files exceeds `memory_budget` bytes.
+ *
+ * The files must not be modified or truncated (by this or any other process) while the graph
+ * is alive - doing so results in undefined behavior or a SIGBUS crash.
+ * Must be deallocated with routx_tiled_graph_delete().
+ *
+ * Returns NULL if opening has failed, see logs in such case.
+ */
+RoutxTiledGraph* routx_tiled_graph_open(char const* dirname, size_t memory_budget);
+
+/**
+ * Deallocates a @ref RoutxTiledGraph created by routx_tiled_graph_open().
+ * The graph may be NULL.
+ */
+void routx_tiled_graph_delete(RoutxTiledGraph* graph);
+
+/**
+ * Returns the number of nodes in a @ref RoutxTiledGraph, or zero if the graph is NULL.
+ */
+size_t routx_tiled_graph_len(RoutxTiledGraph const* graph);
+
+/**
+ * Returns the counters of the tile cache of a @ref RoutxTiledGraph,
+ * or all zeros if the graph is NULL.
+ */
+RoutxTileStats routx_tiled_graph_stats(RoutxTiledGraph const* graph);
+
+/**
+ * Finds a node with the provided id in a @ref RoutxTiledGraph, loading its tile if necessary.
+ *
+ * Returns a zero node (with `id == 0`) if the node doesn't exist, its tile couldn't
+ * be loaded (see logs in such case), or if the graph is NULL.
+ */
+RoutxNode routx_tiled_graph_get_node(RoutxTiledGraph const* graph, int64_t id);
+
+/**
+ * Finds the closest canonical (`id == osm_id`) node to the given position,
+ * searching (and loading) tiles in growing rings around it.
+ *
+ * Returns a zero node (with `id == 0`) if the graph has no canonical nodes,
+ * a tile couldn't be loaded (see logs in such case), or if the graph is NULL.
+ */
+RoutxNode routx_tiled_graph_find_nearest_node(RoutxTiledGraph const* graph, float lat,
+                                              float lon);
+
+/**
+ * Finds the shortest route between two nodes of a @ref RoutxTiledGraph, like
+ * routx_find_route(). Tiles are loaded as the search reaches them. If any of them can't be
+ * loaded, returns @ref RoutxRouteResultTypeTileLoadFailed.
+ *
+ * The returned route must be deallocated with routx_route_result_delete().
+ * If the graph is NULL, returns an empty @ref RoutxRouteResultTypeOk result.
+ */
+RoutxRouteResult routx_tiled_graph_find_route(RoutxTiledGraph const* graph, int64_t from,
+                                              int64_t to, size_t step_limit);
+
+/**
+ * Calculates the great-circle distance between two positions using the
+ * [haversine formula](https://en.wikipedia.org/wiki/Haversine_formula).
+ * Returns the result in kilometers.
+ */
+float routx_earth_distance(float lat1, float lon1, float lat2, float lon2);
+
+/**
+ * Calculates the great-circle distances from one position to `n` other positions
+ * (`lats[i]`, `lons[i]`), writing the results (in kilometers) into `out`.
+ *
+ * Uses a vectorized polynomial approximation of routx_earth_distance(). For distances between
+ * 1 m and 10 000 km, the relative error is below ::ROUTX_EARTH_DISTANCE_APPROX_MAX_ERROR.
+ */
+void routx_earth_distance_many(float lat, float lon, float const* lats, float const* lons,
+                               size_t n, float* out);
 
 #ifdef __cplusplus
 }  // extern "C"
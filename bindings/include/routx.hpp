@@ -6,20 +6,38 @@
 
 #include <routx.h>
 
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
 #include <cstddef>
 #include <cstdint>
+#include <exception>
 #include <iterator>
 #include <optional>
 #include <span>
 #include <stdexcept>
 #include <utility>
 #include <variant>
+#include <vector>
 
 namespace routx {
 
 /// Recommended A* step limit for Graph::find_route() and Graph::find_route_without_turn_around().
 constexpr size_t DEFAULT_STEP_LIMIT = ROUTX_DEFAULT_STEP_LIMIT;
 
+/// Recommended resolution of edge costs for FrozenGraph::compact() - a ten-thousandth
+/// of a cost unit (a decimetre of an unpenalized road, as costs are in kilometres).
+constexpr float DEFAULT_COST_SCALE = ROUTX_DEFAULT_COST_SCALE;
+
+/// Recommended size of @ref GridIndex cells for GridIndex::build(), in meters.
+constexpr float DEFAULT_GRID_CELL_SIZE = ROUTX_DEFAULT_GRID_CELL_SIZE;
+
+/// Recommended quantum of @ref SnapCache keys, in meters.
+constexpr float DEFAULT_SNAP_QUANTUM = ROUTX_DEFAULT_SNAP_QUANTUM;
+
+/// Recommended size of @ref TiledGraph tiles for TiledGraph::save(), in degrees.
+constexpr float DEFAULT_TILE_SIZE = ROUTX_DEFAULT_TILE_SIZE;
+
 /**
  * Sets a logging handler for the library.
  *
@@ -77,6 +95,21 @@ float earth_distance(float lat1, float lon1, float lat2, float lon2) {
     return routx_earth_distance(lat1, lon1, lat2, lon2);
 }
 
+/**
+ * Calculates the great-circle distances from one position to every position in `lats` and
+ * `lons` (extra elements of the longer span are ignored). Returns the results in kilometers.
+ *
+ * Uses a vectorized polynomial approximation of earth_distance(). For distances between
+ * 1 m and 10 000 km, the relative error is below ::ROUTX_EARTH_DISTANCE_APPROX_MAX_ERROR.
+ */
+inline std::vector<float> earth_distance_many(float lat, float lon, std::span<float const> lats,
+                                              std::span<float const> lons) {
+    std::vector<float> distances(std::min(lats.size(), lons.size()));
+    routx_earth_distance_many(lat, lon, lats.data(), lons.data(), distances.size(),
+                              distances.data());
+    return distances;
+}
+
 /**
  * An element of the @ref Graph.
  *
@@ -118,6 +151,19 @@ using Format = RoutxOsmFormat;
  */
 using Options = RoutxOsmOptions;
 
+/**
+ * Process-wide counters of all OSM data read so far, see @ref RoutxOsmIngestStats.
+ */
+using IngestStats = RoutxOsmIngestStats;
+
+/**
+ * Returns the process-wide counters of all OSM data read so far.
+ *
+ * Readers count features locally and only publish the totals once done with a file,
+ * so the counters don't include files which are still being read.
+ */
+inline IngestStats ingest_stats() { return routx_osm_ingest_stats(); }
+
 /**
  * Car routing profile.
  *
@@ -315,6 +361,48 @@ class LoadingFailed : std::runtime_error {
     LoadingFailed() : std::runtime_error("failed to load OSM data") {}
 };
 
+/**
+ * @ref Profile with precomputed tag lookups, which can be reused across
+ * multiple loads of OSM data, see @ref RoutxOsmCompiledProfile.
+ */
+class CompiledProfile {
+   public:
+    /**
+     * Compiles the provided profile. The Profile* constants are also accepted.
+     * The profile may be freed right after this call.
+     */
+    explicit CompiledProfile(Profile const* profile)
+        : m_impl(routx_osm_profile_compile(profile)) {}
+
+    /**
+     * Takes ownership of a C-style CompiledProfile handle.
+     */
+    explicit CompiledProfile(RoutxOsmCompiledProfile* profile) : m_impl(profile) {}
+
+    ~CompiledProfile() { routx_osm_compiled_profile_delete(m_impl); }
+
+    CompiledProfile(CompiledProfile const&) = delete;
+
+    CompiledProfile(CompiledProfile&& other) : m_impl(nullptr) {
+        std::swap(m_impl, other.m_impl);
+    }
+
+    CompiledProfile& operator=(CompiledProfile const&) = delete;
+
+    CompiledProfile& operator=(CompiledProfile&& other) noexcept {
+        std::swap(m_impl, other.m_impl);
+        return *this;
+    }
+
+    /**
+     * Returns the underlying C-style handle.
+     */
+    RoutxOsmCompiledProfile const* get() const { return m_impl; }
+
+   private:
+    RoutxOsmCompiledProfile* m_impl = nullptr;
+};
+
 }  // namespace osm
 
 /**
@@ -333,6 +421,13 @@ class Route : public std::span<int64_t> {
     Route(Route const&) = delete;
     Route& operator=(Route const&) = delete;
 
+    Route(Route&& other) noexcept : std::span<int64_t>(), m_capacity(0) { swap(other); }
+
+    Route& operator=(Route&& other) noexcept {
+        swap(other);
+        return *this;
+    }
+
     ~Route() {
         RoutxRouteResult raw = {
             .as_ok =
@@ -346,8 +441,31 @@ class Route : public std::span<int64_t> {
         routx_route_result_delete(raw);
     }
 
+    /**
+     * Takes ownership of the nodes from a @ref RoutxRouteResult.
+     *
+     * @throws @ref InvalidReference or @ref StepLimitExceeded if the result is not
+     * @ref RoutxRouteResultTypeOk "ok".
+     */
+    static Route from_result(RoutxRouteResult result);
+
+    /**
+     * Returns the number of nodes of a route from a @ref RoutxRouteStatus.
+     *
+     * @throws @ref InvalidReference or @ref StepLimitExceeded if the status is not
+     * @ref RoutxRouteResultTypeOk "ok".
+     */
+    static size_t len_from_status(RoutxRouteStatus status);
+
    private:
     uint32_t m_capacity;
+
+    void swap(Route& other) noexcept {
+        std::span<int64_t> tmp = *this;
+        static_cast<std::span<int64_t>&>(*this) = other;
+        static_cast<std::span<int64_t>&>(other) = tmp;
+        std::swap(m_capacity, other.m_capacity);
+    }
 };
 
 /**
@@ -374,364 +492,2233 @@ class StepLimitExceeded : public std::length_error {
 };
 
 /**
- * OpenStreetMap-based network representation as a set of @ref Node "Nodes"
- * and @ref Edge "Edges" between them.
+ * An asynchronous search was cancelled, see RouteTask::cancel().
  */
-class Graph {
-    friend class KDTree;
-    friend class Iterator;
+class Cancelled : public std::runtime_error {
+   public:
+    Cancelled() : std::runtime_error("search cancelled") {}
+};
 
+/**
+ * An asynchronous search has run past its timeout, see SearchPool::find_route().
+ */
+class DeadlineExceeded : public std::runtime_error {
    public:
-    /**
-     * Iterator over @ref Node "Nodes" contained in a @ref Graph.
-     *
-     * Note that this class can't fullfill the C++ definition of an "iterator",
-     * as it's not copyable.
-     *
-     * Usage:
-     *
-     * @code{.cpp}
-     * routx::Graph::Iterator it = graph.get_nodes();
-     * routx::Node node;
-     * while ((node = it.next()).id != 0) {
-     *     // Process node
-     * }
-     * @endcode
-     */
-    class Iterator {
-       public:
-        /**
-         * Takes ownership of a C-style iterator handle.
-         *
-         * The pointer maybe null, which creates a NULL iterator, for which all operations are a
-         * no-op.
-         */
-        explicit Iterator(RoutxGraphIterator* i) : m_impl(i) {}
+    DeadlineExceeded() : std::runtime_error("search deadline exceeded") {}
+};
 
-        ~Iterator() { routx_graph_iterator_delete(m_impl); }
+/**
+ * Thrown when the routx library has failed to save or load a file. See logs for details.
+ */
+class IoFailed : public std::runtime_error {
+   public:
+    IoFailed() : std::runtime_error("routx I/O operation failed") {}
+};
 
-        Iterator(Iterator const&) = delete;
+/**
+ * Outcome of a single route query from a batch, see FrozenGraph::find_routes_parallel().
+ */
+using RouteOrError = std::variant<Route, InvalidReference, StepLimitExceeded>;
 
-        Iterator(Iterator&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+inline Route Route::from_result(RoutxRouteResult result) {
+    switch (result.type) {
+        [[likely]] case RoutxRouteResultTypeOk:
+            return Route(result.as_ok.nodes, result.as_ok.len, result.as_ok.capacity);
 
-        Iterator& operator=(Iterator const&) = delete;
+        case RoutxRouteResultTypeInvalidReference:
+            throw InvalidReference(result.as_invalid_reference.invalid_node_id);
 
-        Iterator& operator=(Iterator&& other) {
-            std::swap(m_impl, other.m_impl);
-            return *this;
+        case RoutxRouteResultTypeStepLimitExceeded:
+            throw StepLimitExceeded();
+
+        case RoutxRouteResultTypeCancelled:
+            throw Cancelled();
+
+        case RoutxRouteResultTypeDeadlineExceeded:
+            throw DeadlineExceeded();
+
+        case RoutxRouteResultTypeTileLoadFailed:
+            throw IoFailed();
+
+        default:
+            std::abort();  // invalid RoutxRouteResultType
+    }
+}
+
+inline size_t Route::len_from_status(RoutxRouteStatus status) {
+    switch (status.type) {
+        [[likely]] case RoutxRouteResultTypeOk:
+            return status.len;
+
+        case RoutxRouteResultTypeInvalidReference:
+            throw InvalidReference(status.invalid_node_id);
+
+        case RoutxRouteResultTypeStepLimitExceeded:
+            throw StepLimitExceeded();
+
+        case RoutxRouteResultTypeCancelled:
+            throw Cancelled();
+
+        case RoutxRouteResultTypeDeadlineExceeded:
+            throw DeadlineExceeded();
+
+        case RoutxRouteResultTypeTileLoadFailed:
+            throw IoFailed();
+
+        default:
+            std::abort();  // invalid RoutxRouteResultType
+    }
+}
+
+/**
+ * Shortest route with the geometry and costs of its nodes, stored as parallel arrays.
+ * Returned by Graph::find_route_detailed() and FrozenGraph::find_route_detailed().
+ *
+ * Reusing a RouteDetailed for multiple queries reuses the storage of its vectors.
+ */
+struct RouteDetailed {
+    /// ID of every node of the route.
+    std::vector<int64_t> ids;
+
+    /// Latitude of every node of the route.
+    std::vector<float> lats;
+
+    /// Longitude of every node of the route.
+    std::vector<float> lons;
+
+    /// Cumulative cost of reaching every node of the route from the start.
+    /// The first cost is always zero, and the last one is the cost of the whole route.
+    std::vector<float> costs;
+
+    /// Returns the number of nodes of the route.
+    size_t size() const { return ids.size(); }
+
+    /// Returns true if the route has no nodes.
+    bool empty() const { return ids.empty(); }
+
+    /// Returns the cost of the whole route, or zero if it is empty.
+    float total_cost() const { return costs.empty() ? 0.0f : costs.back(); }
+
+    /**
+     * Fills the route by calling `find` with a @ref RoutxRouteDetailed pointing to the vectors,
+     * growing them and retrying if the route doesn't fit.
+     *
+     * @throws @ref InvalidReference or @ref StepLimitExceeded if the search has failed,
+     * in which case the route is left empty.
+     */
+    template <typename F>
+    void fill(F find) {
+        size_t capacity = std::max(ids.capacity(), size_t{64});
+        for (;;) {
+            ids.resize(capacity);
+            lats.resize(capacity);
+            lons.resize(capacity);
+            costs.resize(capacity);
+
+            RoutxRouteDetailed raw = {
+                .ids = ids.data(),
+                .lats = lats.data(),
+                .lons = lons.data(),
+                .costs = costs.data(),
+                .capacity = capacity,
+            };
+            RoutxRouteStatus status = find(&raw);
+            size_t len = status.type == RoutxRouteResultTypeOk ? status.len : 0;
+
+            if (len <= capacity) {
+                ids.resize(len);
+                lats.resize(len);
+                lons.resize(len);
+                costs.resize(len);
+                Route::len_from_status(status);
+                return;
+            }
+            capacity = len;
         }
+    }
+};
 
-        /**
-         * Advances the iterator and returns the next node.
-         * A zero node (`id == 0`) will be returned to mark the end of iteration.
-         *
-         * The iterator may be NULL, in which case this function returns a zero node.
-         */
-        Node next() { return routx_graph_iterator_next(m_impl); }
+/**
+ * Priority queue implementation used by a @ref SearchContext, see @ref RoutxQueueKind.
+ */
+using QueueKind = RoutxQueueKind;
 
-       private:
-        RoutxGraphIterator* m_impl = nullptr;
-    };
+/**
+ * Order of dense node indices of a @ref FrozenGraph, see @ref RoutxNodeOrder.
+ */
+using NodeOrder = RoutxNodeOrder;
+
+/**
+ * Counters of the work done by the last search with a @ref SearchContext,
+ * see @ref RoutxSearchStats.
+ */
+using SearchStats = RoutxSearchStats;
 
+/**
+ * Reusable workspace for route searches over a @ref FrozenGraph.
+ *
+ * A SearchContext keeps its priority queue and per-node labels between searches, and resets
+ * them in constant time by bumping a generation counter. Once its storage has grown to fit
+ * the graph, searches don't allocate anything except for the returned route.
+ *
+ * The kind of the priority queue can be selected with SearchContext(QueueKind).
+ * Counters of the work done by the last search are available through stats().
+ *
+ * A SearchContext may be used with different graphs, but only by one search at a time.
+ * Multi-threaded applications should keep one context per thread.
+ */
+class SearchContext {
+   public:
     /**
-     * Allocates a new Graph.
+     * Creates a new, empty SearchContext. Its storage is allocated lazily on first use.
      */
-    Graph() : m_impl(routx_graph_new()) {}
+    SearchContext() : m_impl(routx_search_context_new()) {}
 
     /**
-     * Takes ownership of a C-style Graph handle.
-     *
-     * The pointer maybe null, which creates a NULL Graph, for which all operations are a no-op.
+     * Creates a new, empty SearchContext with the provided kind of priority queue.
+     * Its storage is allocated lazily on first use.
+     */
+    explicit SearchContext(QueueKind kind) : m_impl(routx_search_context_new_with_queue(kind)) {}
+
+    /**
+     * Takes ownership of a C-style SearchContext handle.
      */
-    explicit Graph(RoutxGraph* g) : m_impl(g) {}
+    explicit SearchContext(RoutxSearchContext* ctx) : m_impl(ctx) {}
 
-    ~Graph() { routx_graph_delete(m_impl); }
+    ~SearchContext() { routx_search_context_delete(m_impl); }
 
-    Graph(Graph const&) = delete;
+    SearchContext(SearchContext const&) = delete;
 
-    Graph(Graph&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+    SearchContext(SearchContext&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
 
-    Graph& operator=(Graph const&) = delete;
+    SearchContext& operator=(SearchContext const&) = delete;
 
-    Graph& operator=(Graph&& other) noexcept {
+    SearchContext& operator=(SearchContext&& other) noexcept {
         std::swap(m_impl, other.m_impl);
         return *this;
     }
 
     /**
-     * Returns the number of @ref Node "Nodes" in the graph.
+     * Returns the counters of the work done by the last search (or the last batch of searches)
+     * with this context.
      */
-    size_t size() const { return routx_graph_get_nodes(m_impl, nullptr); }
+    SearchStats stats() const { return routx_search_context_stats(m_impl); }
 
     /**
-     * Returns true if there are no @ref Node "Nodes" in the graph.
+     * Enables or disables measuring the wall time of searches, see
+     * @ref RoutxSearchStats::elapsed_ns. Disabled by default.
      */
-    bool is_empty() const { return routx_graph_get_nodes(m_impl, nullptr) == 0; }
+    void set_timing(bool enabled) { routx_search_context_set_timing(m_impl, enabled); }
 
     /**
-     * Returns an @ref Iterator over all nodes in this graph.
-     * The graph must not be modified while iterating over its nodes.
-     *
-     * The returned object doesn't comply with standard C++ iterators,
-     * as it contains a non-copyable handle.
-     *
-     * Usage:
-     *
-     * @code{.cpp}
-     * routx::Graph::Iterator it = graph.get_nodes();
-     * routx::Node node;
-     * while ((node = it.next()).id != 0) {
-     *     // Process node
-     * }
-     * @endcode
+     * Returns the underlying C-style handle.
      */
-    Iterator get_nodes() const {
-        RoutxGraphIterator* it_impl = nullptr;
-        routx_graph_get_nodes(m_impl, &it_impl);
-        return Iterator(it_impl);
-    }
+    RoutxSearchContext* get() const { return m_impl; }
 
-    /**
-     * Finds a node with the provided id. If no such node was found, returns a zero (`id == 0`)
-     * node.
-     *
-     * If the graph is NULL, returns a zero node.
-     */
-    Node get_node(int64_t id) const { return routx_graph_get_node(m_impl, id); }
+   private:
+    RoutxSearchContext* m_impl = nullptr;
+};
 
+/**
+ * Precomputed distances to and from a set of landmark nodes of a @ref FrozenGraph,
+ * used by the ALT (A*, landmarks, triangle inequality) heuristic.
+ *
+ * Unlike the crow-flies distance, landmark bounds take edge costs (and thus profile penalties)
+ * into account, which can drastically reduce the number of nodes expanded by A*.
+ *
+ * Use FrozenGraph::build_landmarks() or Landmarks::load() to create Landmarks.
+ */
+class Landmarks {
+   public:
     /**
-     * Creates or updates a @ref Node with the provided id.
-     *
-     * All outgoing and incoming edges are preserved, thus updating a @ref Node position
-     * might result in violation of the @ref Edge invariant (and thus break route finding).
-     * It **is discouraged** to update nodes, and it is the caller's responsibility not to break
-     * this invariant.
+     * Takes ownership of a C-style Landmarks handle.
      *
-     * When called with a NULL graph, this function does nothing and returns false.
-     *
-     * @returns true if an existing node was updated/overwritten, false otherwise
+     * The pointer maybe null, which creates NULL Landmarks, for which all operations are a
+     * no-op.
      */
-    bool set_node(Node node) { return routx_graph_set_node(m_impl, node); }
+    explicit Landmarks(RoutxLandmarks* lm) : m_impl(lm) {}
 
-    /**
-     * Deletes a @ref Node with the provided id.
-     *
-     * Outgoing edges are removed, but incoming edges are preserved (for performance reasons).
-     * Thus, deleting a node and then reusing its id might result in violation of
-     * @ref Edge cost invariant (breaking route finding) and **is therefore discouraged**.
-     * It is the caller's responsibility not to break this invariant.
-     *
-     * When called with a NULL graph, this function does nothing and return false.
-     *
-     * @returns true if a node was actually deleted, false otherwise
-     */
-    bool delete_node(int64_t id) { return routx_graph_delete_node(m_impl, id); }
+    ~Landmarks() { routx_landmarks_delete(m_impl); }
+
+    Landmarks(Landmarks const&) = delete;
+
+    Landmarks(Landmarks&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+
+    Landmarks& operator=(Landmarks const&) = delete;
+
+    Landmarks& operator=(Landmarks&& other) noexcept {
+        std::swap(m_impl, other.m_impl);
+        return *this;
+    }
 
     /**
-     * Finds the closest canonical (`id == osm_id`) @ref Node to the given position.
-     *
-     * This function requires computing distance to every @ref Node in the graph,
-     * and is not suitable for large graphs or for multiple searches.
-     * Use @ref KDTree for faster NN finding.
+     * Loads landmarks saved with Landmarks::save().
      *
-     * If the graph is NULL or has no nodes, returns a zero (`id == 0`) node.
+     * @throws @ref IoFailed if loading has failed, see logs in such case
      */
-    Node find_nearest_node(float lat, float lon) {
-        return routx_graph_find_nearest_node(m_impl, lat, lon);
+    static Landmarks load(char const* filename) {
+        RoutxLandmarks* lm = routx_landmarks_load(filename);
+        if (!lm) [[unlikely]] {
+            throw IoFailed();
+        }
+        return Landmarks(lm);
     }
 
     /**
-     * Gets all outgoing @ref Edge "Edges" from a node with a given id.
+     * Saves the landmarks to a file, in a versioned, little-endian binary format.
      *
-     * The Graph must not be modified while using the return edge array, as it might be
-     * reallocated.
+     * @throws @ref IoFailed if saving has failed, see logs in such case
      */
-    std::span<Edge const> get_edges(int64_t from_id) const {
-        Edge const* data = nullptr;
-        size_t size = routx_graph_get_edges(m_impl, from_id, &data);
-        return std::span<Edge const>(data, size);
+    void save(char const* filename) const {
+        if (!routx_landmarks_save(m_impl, filename)) [[unlikely]] {
+            throw IoFailed();
+        }
     }
 
     /**
-     * Gets the cost of a @ref RoutxEdge from one node to another.
-     * Returns positive infinity when the provided edge can't be found, or when the graph is NULL.
+     * Returns the number of landmarks.
      */
-    float get_edge(int64_t from_id, int64_t to_id) const {
-        return routx_graph_get_edge(m_impl, from_id, to_id);
-    }
+    size_t size() const { return routx_landmarks_len(m_impl); }
 
     /**
-     * Creates or updates a @ref Edge from a node with a given id.
-     *
-     * The `cost` must not be smaller than the crow-flies distance between nodes,
-     * as this would violate the A* invariant and break route finding. It is the caller's
-     * responsibility to do so.
-     *
-     * When called with a NULL graph, this function does nothing and returns false.
+     * Returns the underlying C-style handle.
+     */
+    RoutxLandmarks const* get() const { return m_impl; }
+
+   private:
+    RoutxLandmarks* m_impl = nullptr;
+};
+
+/**
+ * Compressed, read-only snapshot of a @ref FrozenGraph for graphs which don't fit in memory
+ * otherwise, see @ref RoutxCompactGraph. Routing runs directly on the compressed form.
+ *
+ * Edge costs are rounded up to a multiple of the cost scale, so the cost of returned routes
+ * exceeds the cost of the shortest route by less than the cost scale times its number of edges.
+ *
+ * Use FrozenGraph::compact() to create a CompactGraph.
+ */
+class CompactGraph {
+   public:
+    /**
+     * Takes ownership of a C-style CompactGraph handle.
      *
-     * @returns true if an existing edge was updated, false otherwise
+     * The pointer maybe null, which creates a NULL CompactGraph, for which all operations are a
+     * no-op.
      */
-    bool set_edge(int64_t from_id, Edge edge) {
-        return routx_graph_set_edge(m_impl, from_id, edge);
+    explicit CompactGraph(RoutxCompactGraph* g) : m_impl(g) {}
+
+    ~CompactGraph() { routx_compact_graph_delete(m_impl); }
+
+    CompactGraph(CompactGraph const&) = delete;
+
+    CompactGraph(CompactGraph&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+
+    CompactGraph& operator=(CompactGraph const&) = delete;
+
+    CompactGraph& operator=(CompactGraph&& other) noexcept {
+        std::swap(m_impl, other.m_impl);
+        return *this;
     }
 
     /**
-     * Removes a @ref Edge from one node to another.
-     * If no such edge exists (or the graph is NULL), does nothing.
+     * Opens a graph saved with CompactGraph::save() by memory-mapping the file,
+     * see FrozenGraph::open_mmap(). The file must not be modified or truncated while the graph
+     * is alive - doing so results in undefined behavior or a SIGBUS crash.
      *
-     * @returns true if an edge was removed, false otherwise
+     * @throws @ref IoFailed if opening has failed, see logs in such case
      */
-    bool delete_edge(int64_t from_id, int64_t to_id) {
-        return routx_graph_delete_edge(m_impl, from_id, to_id);
+    static CompactGraph open_mmap(char const* filename) {
+        RoutxCompactGraph* g = routx_compact_graph_open_mmap(filename);
+        if (!g) [[unlikely]] {
+            throw IoFailed();
+        }
+        return CompactGraph(g);
     }
 
     /**
-     * Finds the shortest route between two nodes using the
-     * [A* algorithm](https://en.wikipedia.org/wiki/A*_search_algorithm) in the provided graph.
+     * Saves the graph to a file, in a versioned, little-endian binary format,
+     * which can be opened with CompactGraph::open_mmap().
      *
-     * Returns an empty @ref Route no route exists.
+     * @throws @ref IoFailed if saving has failed, see logs in such case
+     */
+    void save(char const* filename) const {
+        if (!routx_compact_graph_save(m_impl, filename)) [[unlikely]] {
+            throw IoFailed();
+        }
+    }
+
+    /**
+     * Returns the number of @ref Node "Nodes" in the graph.
+     */
+    size_t size() const { return routx_compact_graph_len(m_impl); }
+
+    /**
+     * Returns true if there are no @ref Node "Nodes" in the graph.
+     */
+    bool is_empty() const { return routx_compact_graph_len(m_impl) == 0; }
+
+    /**
+     * Returns the number of edges in the graph.
+     */
+    size_t edge_count() const { return routx_compact_graph_edge_count(m_impl); }
+
+    /**
+     * Finds a node with the provided id. If no such node was found, returns a zero (`id == 0`)
+     * node.
+     */
+    Node get_node(int64_t id) const { return routx_compact_graph_get_node(m_impl, id); }
+
+    /**
+     * Gets the rounded cost of an @ref Edge from one node to another.
+     * Returns positive infinity when the provided edge can't be found, or when the graph is NULL.
+     */
+    float get_edge(int64_t from_id, int64_t to_id) const {
+        return routx_compact_graph_get_edge(m_impl, from_id, to_id);
+    }
+
+    /**
+     * Finds the shortest route between two nodes using the A* algorithm,
+     * see FrozenGraph::find_route().
      *
-     * For graphs with turn restrictions, use find_route_without_turn_around(), as this
-     * implementation will generate unrealistic instructions with immediate turnarounds (A-B-A) to
-     * circumvent any restrictions.
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
+     */
+    Route find_route(int64_t from, int64_t to, size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        return Route::from_result(
+            routx_compact_graph_find_route_with_context(m_impl, nullptr, from, to, step_limit));
+    }
+
+    /**
+     * Equivalent of CompactGraph::find_route(), reusing the storage of the provided
+     * @ref SearchContext.
      *
-     * The `step_limit` parameter limits how many nodes can be expanded during search before
-     * throwing @ref StepLimitExceeded. Concluding that no
-     * route exists requires expanding all nodes accessible from the start, which is usually very
-     * time consuming, especially on large datasets. Recommended (and default) value is
-     * @ref DEFAULT_STEP_LIMIT.
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
+     */
+    Route find_route(SearchContext& ctx, int64_t from, int64_t to,
+                     size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        return Route::from_result(
+            routx_compact_graph_find_route_with_context(m_impl, ctx.get(), from, to, step_limit));
+    }
+
+   private:
+    RoutxCompactGraph* m_impl = nullptr;
+};
+
+/**
+ * Immutable, compact snapshot of a @ref Graph, optimized for route finding.
+ *
+ * Nodes are renumbered to dense indices, their attributes are stored in separate arrays,
+ * and all edges are kept in a single
+ * [compressed sparse row](https://en.wikipedia.org/wiki/Sparse_matrix#Compressed_sparse_row_(CSR,_CRS_or_Yale_format))
+ * structure. This avoids tree lookups in the A* inner loop, and uses considerably less memory
+ * than a @ref Graph.
+ *
+ * Use Graph::freeze() to create a FrozenGraph.
+ */
+class FrozenGraph {
+   public:
+    /**
+     * Takes ownership of a C-style FrozenGraph handle.
      *
-     * If `from` or `to` don't exist, throws @ref InvalidReference.
+     * The pointer maybe null, which creates a NULL FrozenGraph, for which all operations are a
+     * no-op.
      */
-    Route find_route(int64_t from, int64_t to, size_t step_limit = DEFAULT_STEP_LIMIT) const {
-        auto result = routx_find_route(m_impl, from, to, step_limit);
-        switch (result.type) {
-            [[likely]] case RoutxRouteResultTypeOk:
-                return Route(result.as_ok.nodes, result.as_ok.len, result.as_ok.capacity);
+    explicit FrozenGraph(RoutxFrozenGraph* g) : m_impl(g) {}
 
-            case RoutxRouteResultTypeInvalidReference:
-                throw InvalidReference(result.as_invalid_reference.invalid_node_id);
+    ~FrozenGraph() { routx_frozen_graph_delete(m_impl); }
 
-            case RoutxRouteResultTypeStepLimitExceeded:
-                throw StepLimitExceeded();
+    FrozenGraph(FrozenGraph const&) = delete;
+
+    FrozenGraph(FrozenGraph&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+
+    FrozenGraph& operator=(FrozenGraph const&) = delete;
+
+    FrozenGraph& operator=(FrozenGraph&& other) noexcept {
+        std::swap(m_impl, other.m_impl);
+        return *this;
+    }
 
-            default:
-                std::abort();  // invalid RoutxRouteResultType
+    /**
+     * Opens a graph saved with FrozenGraph::save() or Graph::save() by memory-mapping the file.
+     *
+     * All arrays are used in place, straight from the (shared, read-only) mapping,
+     * and multiple processes opening the same file share a single page-cache copy of the graph.
+     * Node ids, edge offsets and edge targets are still read once to validate them.
+     * The file must not be modified or truncated (by this or any other process) while the graph
+     * is alive - doing so results in undefined behavior or a SIGBUS crash. To replace a graph,
+     * write a new file and rename it over the old one.
+     *
+     * @throws @ref IoFailed if opening has failed, see logs in such case
+     */
+    static FrozenGraph open_mmap(char const* filename) {
+        RoutxFrozenGraph* g = routx_graph_open_mmap(filename);
+        if (!g) [[unlikely]] {
+            throw IoFailed();
         }
+        return FrozenGraph(g);
     }
 
     /**
-     * Finds the shortest route between two nodes using the
-     * [A* algorithm](https://en.wikipedia.org/wiki/A*_search_algorithm) in the provided graph.
+     * Returns a copy of the graph with nodes renumbered in the provided order,
+     * see routx_frozen_graph_reordered().
+     */
+    FrozenGraph reordered(NodeOrder order) const {
+        return FrozenGraph(routx_frozen_graph_reordered(m_impl, order));
+    }
+
+    /**
+     * Saves the graph to a file, in a versioned, little-endian binary format,
+     * which can be opened with FrozenGraph::open_mmap().
      *
-     * Returns an empty @ref Route no route exists.
+     * @throws @ref IoFailed if saving has failed, see logs in such case
+     */
+    void save(char const* filename) const {
+        if (!routx_frozen_graph_save(m_impl, filename)) [[unlikely]] {
+            throw IoFailed();
+        }
+    }
+
+    /**
+     * Returns the number of @ref Node "Nodes" in the graph.
+     */
+    size_t size() const { return routx_frozen_graph_len(m_impl); }
+
+    /**
+     * Returns true if there are no @ref Node "Nodes" in the graph.
+     */
+    bool is_empty() const { return routx_frozen_graph_len(m_impl) == 0; }
+
+    /**
+     * Returns the number of edges in the graph.
+     */
+    size_t edge_count() const { return routx_frozen_graph_edge_count(m_impl); }
+
+    /**
+     * Finds a node with the provided id. If no such node was found, returns a zero (`id == 0`)
+     * node.
      *
-     * For graphs without turn restrictions, use routx_find_route(), as it runs faster.
-     * This function has an extra dimension - it needs to not only consider the current node,
-     * but also what was the previous node to prevent immediate turnaround (A-B-A) instructions.
+     * If the graph is NULL, returns a zero node.
+     */
+    Node get_node(int64_t id) const { return routx_frozen_graph_get_node(m_impl, id); }
+
+    /**
+     * Gets the cost of a @ref RoutxEdge from one node to another.
+     * Returns positive infinity when the provided edge can't be found, or when the graph is NULL.
+     */
+    float get_edge(int64_t from_id, int64_t to_id) const {
+        return routx_frozen_graph_get_edge(m_impl, from_id, to_id);
+    }
+
+    /**
+     * Equivalent of Graph::find_route() operating on the frozen graph.
      *
-     * The `step_limit` parameter limits how many nodes can be expanded during search before
-     * throwing @ref StepLimitExceeded. Concluding that no
-     * route exists requires expanding all nodes accessible from the start, which is usually very
-     * time consuming, especially on large datasets. Recommended (and default) value is
-     * @ref DEFAULT_STEP_LIMIT.
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
+     */
+    Route find_route(int64_t from, int64_t to, size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        return Route::from_result(routx_frozen_graph_find_route(m_impl, from, to, step_limit));
+    }
+
+    /**
+     * Equivalent of Graph::find_route_without_turn_around() operating on the frozen graph.
      *
-     * If `from` or `to` don't exist, throws @ref InvalidReference.
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
      */
     Route find_route_without_turn_around(int64_t from, int64_t to,
                                          size_t step_limit = DEFAULT_STEP_LIMIT) const {
-        auto result = routx_find_route_without_turn_around(m_impl, from, to, step_limit);
-        switch (result.type) {
-            [[likely]] case RoutxRouteResultTypeOk:
-                return Route(result.as_ok.nodes, result.as_ok.len, result.as_ok.capacity);
+        return Route::from_result(
+            routx_frozen_graph_find_route_without_turn_around(m_impl, from, to, step_limit));
+    }
 
-            case RoutxRouteResultTypeInvalidReference:
-                throw InvalidReference(result.as_invalid_reference.invalid_node_id);
+    /**
+     * Equivalent of FrozenGraph::find_route(), reusing the storage of the provided
+     * @ref SearchContext.
+     *
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
+     */
+    Route find_route(SearchContext& ctx, int64_t from, int64_t to,
+                     size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        return Route::from_result(
+            routx_frozen_graph_find_route_with_context(m_impl, ctx.get(), from, to, step_limit));
+    }
 
-            case RoutxRouteResultTypeStepLimitExceeded:
-                throw StepLimitExceeded();
+    /**
+     * Equivalent of FrozenGraph::find_route_without_turn_around(), reusing the storage of the
+     * provided @ref SearchContext.
+     *
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
+     */
+    Route find_route_without_turn_around(SearchContext& ctx, int64_t from, int64_t to,
+                                         size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        return Route::from_result(routx_frozen_graph_find_route_without_turn_around_with_context(
+            m_impl, ctx.get(), from, to, step_limit));
+    }
 
-            default:
-                std::abort();  // invalid RoutxRouteResultType
-        }
+    /**
+     * Equivalent of FrozenGraph::find_route(SearchContext&, int64_t, int64_t, size_t) (or
+     * FrozenGraph::find_route_without_turn_around() if `without_turn_around` is set), writing the
+     * route directly into the caller-owned `out` buffer.
+     *
+     * Returns the number of nodes of the route. If it is larger than `out.size()`, nothing is
+     * written to `out`, and the query must be repeated with a large enough buffer. Once `ctx` has
+     * grown to fit the graph and the longest route, this function doesn't allocate anything.
+     *
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
+     */
+    size_t find_route_into(SearchContext& ctx, int64_t from, int64_t to, std::span<int64_t> out,
+                           size_t step_limit = DEFAULT_STEP_LIMIT,
+                           bool without_turn_around = false) const {
+        RoutxRouteRequest request = {
+            .from = from,
+            .to = to,
+            .step_limit = step_limit,
+            .without_turn_around = without_turn_around,
+        };
+        return Route::len_from_status(routx_frozen_graph_find_route_into(
+            m_impl, ctx.get(), &request, out.data(), out.size()));
     }
 
     /**
-     * Parses OSM data from the provided file and adds it to the graph.
+     * Equivalent of FrozenGraph::find_route_into(), copying the nodes of the route (borrowed from
+     * `ctx`) into the provided output iterator, e.g. a `std::back_inserter` of an arena-backed
+     * container. Returns the iterator past the last written node.
      *
-     * @param options Options for parsing the OSM data. Must not be NULL.
-     * @param filename Path to the OSM file to be parsed. Must not be NULL.
-     * @throws @ref osm::LoadingFailed if loading has failed, see logs in such case
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
      */
-    void add_from_osm_file(osm::Options const* options, char const* filename) {
-        if (!routx_graph_add_from_osm_file(m_impl, options, filename)) [[unlikely]] {
-            throw osm::LoadingFailed();
-        }
+    template <std::output_iterator<int64_t> OutputIt>
+    OutputIt find_route_to(SearchContext& ctx, int64_t from, int64_t to, OutputIt out,
+                           size_t step_limit = DEFAULT_STEP_LIMIT,
+                           bool without_turn_around = false) const {
+        RoutxRouteRequest request = {
+            .from = from,
+            .to = to,
+            .step_limit = step_limit,
+            .without_turn_around = without_turn_around,
+        };
+        int64_t const* nodes = nullptr;
+        size_t len = Route::len_from_status(
+            routx_frozen_graph_find_route_borrowed(m_impl, ctx.get(), &request, &nodes));
+        return std::copy(nodes, nodes + len, out);
     }
 
     /**
-     * Parses OSM data from the provided buffer and adds it to the graph.
+     * Equivalent of FrozenGraph::find_route(SearchContext&, int64_t, int64_t, size_t) (or
+     * FrozenGraph::find_route_without_turn_around() if `without_turn_around` is set), also
+     * filling the position and cumulative cost of every node of the route in a single call.
      *
-     * @param options Options for parsing the OSM data. Must not be NULL.
-     * @param content Pointer to the buffer containing OSM data. Must be not be NULL, even if
-     * content_len == 0.
-     * @param content_len Length of the buffer in bytes.
-     * @throws @ref osm::LoadingFailed if loading has failed, see logs in such case
+     * The route is written into `out`, reusing the storage of its vectors.
+     *
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
      */
-    void add_from_osm_memory(osm::Options const* options, char const* data, size_t len) {
-        if (!routx_graph_add_from_osm_memory(m_impl, options, data, len)) [[unlikely]] {
-            throw osm::LoadingFailed();
-        }
+    void find_route_detailed(SearchContext& ctx, int64_t from, int64_t to, RouteDetailed& out,
+                             size_t step_limit = DEFAULT_STEP_LIMIT,
+                             bool without_turn_around = false) const {
+        RoutxRouteRequest request = {
+            .from = from,
+            .to = to,
+            .step_limit = step_limit,
+            .without_turn_around = without_turn_around,
+        };
+        out.fill([&](RoutxRouteDetailed const* raw) {
+            return routx_frozen_graph_find_route_detailed(m_impl, ctx.get(), &request, raw);
+        });
     }
 
-   private:
-    RoutxGraph* m_impl = nullptr;
-};
+    /**
+     * Equivalent of FrozenGraph::find_route_detailed(SearchContext&, int64_t, int64_t,
+     * RouteDetailed&, size_t, bool) returning a new @ref RouteDetailed.
+     */
+    RouteDetailed find_route_detailed(SearchContext& ctx, int64_t from, int64_t to,
+                                      size_t step_limit = DEFAULT_STEP_LIMIT,
+                                      bool without_turn_around = false) const {
+        RouteDetailed route;
+        find_route_detailed(ctx, from, to, route, step_limit, without_turn_around);
+        return route;
+    }
 
-class KDTree {
-   public:
-    /// Empty constructor for KDTree is ambiguous, use KDTree::build or KDTree(nullptr) explicitly.
-    KDTree() = delete;
+    /**
+     * Finds all nodes which can be reached from the `from` node with a total cost of at most
+     * `max_cost` (an isochrone), calling `callback(node_id, cost)` on each of them, in the order
+     * of increasing costs. The start node is always reached with a zero cost.
+     *
+     * Runs a Dijkstra search bounded by the cost budget, reusing the storage of the provided
+     * @ref SearchContext. Turn-around restrictions are not taken into account, and nodes created
+     * for turn restrictions are reported separately from the canonical ones.
+     *
+     * If `callback` throws, no further nodes are reported, and the exception is rethrown
+     * once the search is done. Returns the number of reached nodes.
+     *
+     * @throws @ref InvalidReference if `from` doesn't exist
+     * @throws @ref StepLimitExceeded if more than `step_limit` nodes can be reached
+     */
+    template <typename F>
+    size_t reachable(SearchContext& ctx, int64_t from, float max_cost, F&& callback,
+                     size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        ReachableCallback<F> cb = {callback};
+        auto status = routx_reachable(m_impl, ctx.get(), from, max_cost, step_limit,
+                                      &ReachableCallback<F>::call, &cb, nullptr, 0, nullptr);
+        cb.rethrow();
+        return Route::len_from_status(status);
+    }
 
-    ~KDTree() { routx_kd_tree_delete(m_impl); }
+    /**
+     * Finds all nodes which can be reached from the `from` node with a total cost of at most
+     * `max_cost`, see FrozenGraph::reachable(), and returns the vertices of their convex hull
+     * (in counter-clockwise order, treating longitudes and latitudes as planar coordinates).
+     *
+     * @throws @ref InvalidReference if `from` doesn't exist
+     * @throws @ref StepLimitExceeded if more than `step_limit` nodes can be reached
+     */
+    std::vector<Node> reachable_hull(SearchContext& ctx, int64_t from, float max_cost,
+                                     size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        std::vector<Node> hull(64);
+        for (;;) {
+            size_t len = 0;
+            auto status = routx_reachable(m_impl, ctx.get(), from, max_cost, step_limit, nullptr,
+                                          nullptr, hull.data(), hull.size(), &len);
+            Route::len_from_status(status);
+            if (len <= hull.size()) {
+                hull.resize(len);
+                return hull;
+            }
+            hull.resize(len);
+        }
+    }
 
     /**
-     * Builds a k-d tree with all canonical (`id == osm_id`) @ref Node "Nodes"
-     * contained in the provided @ref Graph.
+     * Selects up to `count` landmarks of the graph, and computes distances to and from them
+     * for the ALT heuristic. This requires 2 full Dijkstra searches per landmark.
+     */
+    Landmarks build_landmarks(size_t count) const {
+        return Landmarks(routx_landmarks_build(m_impl, count));
+    }
+
+    /**
+     * Compresses the graph, keeping the order of its nodes and edges, see @ref CompactGraph.
+     * Reorder the graph with FrozenGraph::reordered(RoutxNodeOrderHilbert) first
+     * for the best compression.
      *
-     * If there are no nodes in the @ref Graph, creates a NULL k-d tree, for which all operations
-     * are a no-op.
+     * Returns a NULL CompactGraph if `cost_scale` is not a positive, finite number.
      */
-    static KDTree build(Graph const& graph) { return KDTree(routx_kd_tree_new(graph.m_impl)); }
+    CompactGraph compact(float cost_scale = DEFAULT_COST_SCALE) const {
+        return CompactGraph(routx_compact_graph_build(m_impl, cost_scale));
+    }
 
     /**
-     * Takes ownership of a C-style Graph handle.
+     * Equivalent of FrozenGraph::find_route(), using the ALT heuristic - the maximum of the
+     * crow-flies distance and the bounds given by the provided @ref Landmarks.
      *
-     * The pointer may be null, which creates a NULL Graph, for which all operations are a no-op.
+     * If the landmarks were built for a different graph, falls back to the crow-flies heuristic.
+     *
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
      */
-    explicit KDTree(RoutxKDTree* t) : m_impl(t) {}
+    Route find_route(SearchContext& ctx, Landmarks const& landmarks, int64_t from, int64_t to,
+                     size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        return Route::from_result(routx_frozen_graph_find_route_with_landmarks(
+            m_impl, landmarks.get(), ctx.get(), from, to, step_limit));
+    }
 
-    KDTree(KDTree const&) = delete;
+    /**
+     * Equivalent of FrozenGraph::find_route_without_turn_around(), using the ALT heuristic,
+     * see FrozenGraph::find_route(SearchContext&, Landmarks const&, int64_t, int64_t, size_t).
+     *
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
+     */
+    Route find_route_without_turn_around(SearchContext& ctx, Landmarks const& landmarks,
+                                         int64_t from, int64_t to,
+                                         size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        return Route::from_result(routx_frozen_graph_find_route_without_turn_around_with_landmarks(
+            m_impl, landmarks.get(), ctx.get(), from, to, step_limit));
+    }
 
-    KDTree(KDTree&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+    /**
+     * Equivalent of FrozenGraph::find_route() using a bidirectional A* search, which on medium
+     * and long queries expands roughly half the nodes. `step_limit` limits the number of nodes
+     * expanded by both halves of the search together.
+     *
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
+     */
+    Route find_route_bidirectional(int64_t from, int64_t to,
+                                   size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        return Route::from_result(
+            routx_find_route_bidirectional(m_impl, nullptr, from, to, step_limit));
+    }
 
-    KDTree& operator=(KDTree const&) = delete;
+    /**
+     * Equivalent of FrozenGraph::find_route_bidirectional(), reusing the storage of the provided
+     * @ref SearchContext.
+     *
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
+     */
+    Route find_route_bidirectional(SearchContext& ctx, int64_t from, int64_t to,
+                                   size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        return Route::from_result(
+            routx_find_route_bidirectional(m_impl, ctx.get(), from, to, step_limit));
+    }
 
-    KDTree& operator=(KDTree&& other) {
-        std::swap(m_impl, other.m_impl);
-        return *this;
+    /**
+     * Answers a batch of route queries between (from, to) pairs on multiple threads.
+     *
+     * Queries are spread over a work-stealing pool of `threads` threads, each with its own
+     * @ref SearchContext. Zero threads stands for the number of available CPU cores.
+     *
+     * Errors are not thrown, but returned for each query separately.
+     * Results are returned in the order of `pairs`.
+     */
+    std::vector<RouteOrError> find_routes_parallel(
+        std::span<std::pair<int64_t, int64_t> const> pairs,
+        size_t step_limit = DEFAULT_STEP_LIMIT, bool without_turn_around = false,
+        unsigned threads = 0) const {
+        std::vector<RoutxRouteRequest> requests;
+        requests.reserve(pairs.size());
+        for (auto [from, to] : pairs) {
+            requests.push_back(RoutxRouteRequest{
+                .from = from,
+                .to = to,
+                .step_limit = step_limit,
+                .without_turn_around = without_turn_around,
+            });
+        }
+
+        std::vector<RoutxRouteResult> raw_results(pairs.size());
+        routx_find_routes_parallel(m_impl, requests.data(), requests.size(), raw_results.data(),
+                                   threads);
+
+        std::vector<RouteOrError> results;
+        results.reserve(raw_results.size());
+        for (auto const& raw : raw_results) {
+            switch (raw.type) {
+                [[likely]] case RoutxRouteResultTypeOk:
+                    results.emplace_back(std::in_place_type<Route>, raw.as_ok.nodes,
+                                         raw.as_ok.len, raw.as_ok.capacity);
+                    break;
+
+                case RoutxRouteResultTypeInvalidReference:
+                    results.emplace_back(std::in_place_type<InvalidReference>,
+                                         raw.as_invalid_reference.invalid_node_id);
+                    break;
+
+                case RoutxRouteResultTypeStepLimitExceeded:
+                    results.emplace_back(std::in_place_type<StepLimitExceeded>);
+                    break;
+
+                default:
+                    std::abort();  // invalid RoutxRouteResultType
+            }
+        }
+        return results;
     }
 
     /**
-     * Finds the closest node to the provided position and returns it.
-     * If there are no nodes or the k-d tree is NULL, returns a zero (`id == 0`) node.
+     * Calculates the costs of the shortest routes from every source to every target.
+     *
+     * Returns a `sources.size() × targets.size()` matrix in row-major order: the cost from
+     * `sources[i]` to `targets[j]` is at `i * targets.size() + j`.
+     *
+     * Runs a single Dijkstra search per source, which stops as soon as all targets are settled.
+     * Turn-around restrictions are not taken into account. `step_limit` applies to each search
+     * separately.
+     *
+     * Costs to targets which are unknown, unreachable or not settled within the `step_limit`
+     * are set to positive infinity.
      */
-    Node find_nearest_node(float lat, float lon) {
-        return routx_kd_tree_find_nearest_node(m_impl, lat, lon);
+    std::vector<float> cost_matrix(std::span<int64_t const> sources,
+                                   std::span<int64_t const> targets,
+                                   size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        std::vector<float> costs(sources.size() * targets.size());
+        routx_cost_matrix(m_impl, sources.data(), sources.size(), targets.data(), targets.size(),
+                          step_limit, costs.data());
+        return costs;
     }
 
    private:
-    RoutxKDTree* m_impl = nullptr;
+    RoutxFrozenGraph* m_impl = nullptr;
+
+    friend class CostOverlay;
+    friend class SearchPool;
+    friend class TiledGraph;
+
+    template <typename F>
+    struct ReachableCallback {
+        F& callback;
+        std::exception_ptr error = nullptr;
+
+        static void call(void* arg, int64_t node_id, float cost) {
+            auto self = static_cast<ReachableCallback*>(arg);
+            if (self->error) return;
+            try {
+                self->callback(node_id, cost);
+            } catch (...) {
+                self->error = std::current_exception();
+            }
+        }
+
+        void rethrow() {
+            if (error) std::rethrow_exception(error);
+        }
+    };
+};
+
+/**
+ * Alias for @ref RoutxEdgeFactor - a per-edge multiplier of the base cost,
+ * see CostOverlay::update_factors().
+ */
+using EdgeFactor = RoutxEdgeFactor;
+
+/**
+ * Epoch-based, copy-on-write overlay of edge costs over a @ref FrozenGraph,
+ * for live traffic updates while route queries are running.
+ *
+ * Writers publish new costs as multipliers ("factors") of the base costs of the graph.
+ * Every publication builds a new cost array, which shares all other arrays with the base graph,
+ * and atomically replaces the current snapshot, advancing the epoch. Readers take a snapshot
+ * with CostOverlay::snapshot() and route on it without any further synchronization.
+ *
+ * All methods are thread-safe. Concurrent writers are serialized.
+ *
+ * Published costs are never lower than the crow-flies distance between the edge's endpoints
+ * (or the base cost, if it already was lower), so that the A* heuristic remains admissible.
+ * @ref Landmarks built for the base graph remain valid as long as all factors are at least 1.
+ */
+class CostOverlay {
+   public:
+    /**
+     * Takes ownership of a C-style CostOverlay handle.
+     *
+     * The pointer maybe null, which creates a NULL CostOverlay, for which all operations are a
+     * no-op.
+     */
+    explicit CostOverlay(RoutxCostOverlay* o) : m_impl(o) {}
+
+    /**
+     * Creates an overlay with the costs of the provided graph published at a new epoch.
+     * The graph is not modified, and all its arrays are shared with the overlay.
+     */
+    explicit CostOverlay(FrozenGraph const& g) : m_impl(routx_cost_overlay_new(g.m_impl)) {}
+
+    ~CostOverlay() { routx_cost_overlay_delete(m_impl); }
+
+    CostOverlay(CostOverlay const&) = delete;
+
+    CostOverlay(CostOverlay&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+
+    CostOverlay& operator=(CostOverlay const&) = delete;
+
+    CostOverlay& operator=(CostOverlay&& other) noexcept {
+        std::swap(m_impl, other.m_impl);
+        return *this;
+    }
+
+    /**
+     * Returns the epoch of the most recently published snapshot, see routx_cost_overlay_epoch().
+     */
+    uint64_t epoch() const { return routx_cost_overlay_epoch(m_impl); }
+
+    /**
+     * Returns the most recently published snapshot. The snapshot shares all arrays with
+     * the overlay, so this is cheap, and remains valid after further updates.
+     */
+    FrozenGraph snapshot() const {
+        return FrozenGraph(routx_cost_overlay_snapshot(m_impl, nullptr));
+    }
+
+    /**
+     * Publishes new factors of all edges, in the internal order of edges of the graph.
+     * `factors.size()` must be equal to FrozenGraph::edge_count().
+     *
+     * Returns the epoch of the new snapshot, or 0 if the number of factors didn't match.
+     */
+    uint64_t set_factors(std::span<float const> factors) const {
+        return routx_cost_overlay_set_factors(m_impl, factors.data(), factors.size());
+    }
+
+    /**
+     * Publishes new factors of the provided edges, keeping the factors of all other edges.
+     * Factors of edges which don't exist are ignored. All edges between the same pair of nodes
+     * receive the same factor.
+     *
+     * Returns the epoch of the new snapshot.
+     */
+    uint64_t update_factors(std::span<EdgeFactor const> updates) const {
+        return routx_cost_overlay_update_factors(m_impl, updates.data(), updates.size());
+    }
+
+    /**
+     * Returns the underlying C-style handle.
+     */
+    RoutxCostOverlay const* get() const { return m_impl; }
+
+   private:
+    RoutxCostOverlay* m_impl = nullptr;
+};
+
+/**
+ * Route search running on a @ref SearchPool, returned by SearchPool::find_route().
+ *
+ * A task can be polled with is_done(), waited for with wait(), or awaited in a C++20 coroutine.
+ * An awaiting coroutine is resumed on the worker thread which has finished the search,
+ * so it should quickly move itself back to its own executor:
+ *
+ * @code{.cpp}
+ * routx::Route route = co_await pool.find_route(graph, from, to);
+ * @endcode
+ *
+ * Destroying a task without calling wait() (or awaiting it) cancels the search.
+ */
+class RouteTask {
+   public:
+    /**
+     * Takes ownership of a C-style RouteTask handle.
+     *
+     * The pointer maybe null, which creates a NULL RouteTask, which is always done and
+     * whose route is empty.
+     */
+    explicit RouteTask(RoutxRouteTask* t) : m_impl(t) {}
+
+    ~RouteTask() {
+        routx_route_task_cancel(m_impl);
+        routx_route_task_delete(m_impl);
+    }
+
+    RouteTask(RouteTask const&) = delete;
+
+    RouteTask(RouteTask&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+
+    RouteTask& operator=(RouteTask const&) = delete;
+
+    RouteTask& operator=(RouteTask&& other) noexcept {
+        std::swap(m_impl, other.m_impl);
+        return *this;
+    }
+
+    /**
+     * Returns true if the search has finished, so that wait() won't block.
+     */
+    bool is_done() const { return routx_route_task_is_done(m_impl); }
+
+    /**
+     * Asks the search to stop, so that wait() throws @ref Cancelled (unless the search has
+     * already finished).
+     */
+    void cancel() const { routx_route_task_cancel(m_impl); }
+
+    /**
+     * Waits for the search to finish and returns the route, leaving a NULL task.
+     *
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its step limit
+     * @throws @ref Cancelled if the search was cancelled
+     * @throws @ref DeadlineExceeded if the search has run past its timeout
+     */
+    Route wait() {
+        return Route::from_result(routx_route_task_wait(std::exchange(m_impl, nullptr)));
+    }
+
+    /// Awaiter interface - a finished task doesn't suspend the coroutine.
+    bool await_ready() const { return is_done(); }
+
+    /// Awaiter interface - resumes the coroutine once the search finishes.
+    bool await_suspend(std::coroutine_handle<> caller) const {
+        auto resume = [](void* arg) { std::coroutine_handle<>::from_address(arg).resume(); };
+        return routx_route_task_on_done(m_impl, resume, caller.address());
+    }
+
+    /// Awaiter interface - returns the route, see wait().
+    Route await_resume() { return wait(); }
+
+    /**
+     * Returns the underlying C-style handle.
+     */
+    RoutxRouteTask const* get() const { return m_impl; }
+
+   private:
+    RoutxRouteTask* m_impl = nullptr;
+};
+
+/**
+ * Pool of worker threads answering route queries in the background, for callers which must not
+ * block for the duration of a search (like event loops or coroutine servers).
+ *
+ * Every worker keeps its own @ref SearchContext. Searches are started in the order of
+ * submission; cancelling long searches or giving them a timeout prevents them from delaying
+ * the searches queued behind them. All methods may be called from any thread.
+ *
+ * Destroying the pool waits for all submitted searches to finish.
+ */
+class SearchPool {
+   public:
+    /**
+     * Starts a pool with `threads` worker threads. Zero threads stands for the number of
+     * available CPU cores.
+     */
+    explicit SearchPool(unsigned threads = 0) : m_impl(routx_search_pool_new(threads)) {}
+
+    /**
+     * Takes ownership of a C-style SearchPool handle.
+     *
+     * The pointer maybe null, which creates a NULL SearchPool, which returns NULL tasks.
+     */
+    explicit SearchPool(RoutxSearchPool* p) : m_impl(p) {}
+
+    ~SearchPool() { routx_search_pool_delete(m_impl); }
+
+    SearchPool(SearchPool const&) = delete;
+
+    SearchPool(SearchPool&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+
+    SearchPool& operator=(SearchPool const&) = delete;
+
+    SearchPool& operator=(SearchPool&& other) noexcept {
+        std::swap(m_impl, other.m_impl);
+        return *this;
+    }
+
+    /**
+     * Queues a route search and returns immediately, see FrozenGraph::find_route().
+     *
+     * The graph may be destroyed before the search finishes, as all its arrays are shared with
+     * the search. If `timeout` is not zero, the search fails with @ref DeadlineExceeded once
+     * that time passes since the submission, including the time spent waiting in the queue.
+     */
+    RouteTask find_route(FrozenGraph const& g, int64_t from, int64_t to,
+                         size_t step_limit = DEFAULT_STEP_LIMIT,
+                         std::chrono::microseconds timeout = {},
+                         bool without_turn_around = false) const {
+        RoutxRouteRequest request = {
+            .from = from,
+            .to = to,
+            .step_limit = step_limit,
+            .without_turn_around = without_turn_around,
+        };
+        return RouteTask(routx_find_route_async(m_impl, g.m_impl, &request,
+                                                static_cast<uint64_t>(timeout.count())));
+    }
+
+    /**
+     * Returns the underlying C-style handle.
+     */
+    RoutxSearchPool const* get() const { return m_impl; }
+
+   private:
+    RoutxSearchPool* m_impl = nullptr;
+};
+
+/**
+ * [Contraction hierarchy](https://en.wikipedia.org/wiki/Contraction_hierarchies) built over
+ * a @ref Graph, for very fast route queries on large graphs.
+ *
+ * Turn restrictions are respected, and returned routes are equivalent to those returned by
+ * Graph::find_route(). Avoiding immediate turnarounds is not supported.
+ *
+ * Use Graph::build_ch() to create a CHGraph.
+ */
+class CHGraph {
+   public:
+    /**
+     * Takes ownership of a C-style CHGraph handle.
+     *
+     * The pointer maybe null, which creates a NULL CHGraph, for which all operations are a
+     * no-op.
+     */
+    explicit CHGraph(RoutxCHGraph* g) : m_impl(g) {}
+
+    ~CHGraph() { routx_ch_graph_delete(m_impl); }
+
+    CHGraph(CHGraph const&) = delete;
+
+    CHGraph(CHGraph&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+
+    CHGraph& operator=(CHGraph const&) = delete;
+
+    CHGraph& operator=(CHGraph&& other) noexcept {
+        std::swap(m_impl, other.m_impl);
+        return *this;
+    }
+
+    /**
+     * Returns the number of @ref Node "Nodes" in the hierarchy.
+     */
+    size_t size() const { return routx_ch_graph_len(m_impl); }
+
+    /**
+     * Returns true if there are no @ref Node "Nodes" in the hierarchy.
+     */
+    bool is_empty() const { return routx_ch_graph_len(m_impl) == 0; }
+
+    /**
+     * Finds the shortest route between two nodes using the contraction hierarchy.
+     *
+     * `step_limit` limits the number of nodes settled by both halves of the bidirectional
+     * search together.
+     *
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
+     */
+    Route find_route(int64_t from, int64_t to, size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        return Route::from_result(routx_ch_find_route(m_impl, from, to, step_limit));
+    }
+
+    /**
+     * Equivalent of CHGraph::find_route(), reusing the storage of the provided
+     * @ref SearchContext.
+     *
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
+     */
+    Route find_route(SearchContext& ctx, int64_t from, int64_t to,
+                     size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        return Route::from_result(
+            routx_ch_find_route_with_context(m_impl, ctx.get(), from, to, step_limit));
+    }
+
+   private:
+    RoutxCHGraph* m_impl = nullptr;
+};
+
+/**
+ * Non-owning, read-only view of a @ref Graph, with all of its read-only operations.
+ *
+ * A view doesn't keep the graph alive - it's valid only for as long as the viewed @ref Graph or
+ * @ref SharedGraph. Views are cheap to copy, and all their methods may be called from any
+ * number of threads concurrently, as long as the viewed graph isn't modified in the meantime.
+ * @ref Graph "Graphs" are views of themselves.
+ */
+class GraphView {
+   public:
+    /**
+     * Iterator over @ref Node "Nodes" contained in a @ref Graph.
+     *
+     * Note that this class can't fullfill the C++ definition of an "iterator",
+     * as it's not copyable.
+     *
+     * Usage:
+     *
+     * @code{.cpp}
+     * routx::Graph::Iterator it = graph.get_nodes();
+     * routx::Node node;
+     * while ((node = it.next()).id != 0) {
+     *     // Process node
+     * }
+     * @endcode
+     */
+    class Iterator {
+       public:
+        /**
+         * Takes ownership of a C-style iterator handle.
+         *
+         * The pointer maybe null, which creates a NULL iterator, for which all operations are a
+         * no-op.
+         */
+        explicit Iterator(RoutxGraphIterator* i) : m_impl(i) {}
+
+        ~Iterator() { routx_graph_iterator_delete(m_impl); }
+
+        Iterator(Iterator const&) = delete;
+
+        Iterator(Iterator&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+
+        Iterator& operator=(Iterator const&) = delete;
+
+        Iterator& operator=(Iterator&& other) {
+            std::swap(m_impl, other.m_impl);
+            return *this;
+        }
+
+        /**
+         * Advances the iterator and returns the next node.
+         * A zero node (`id == 0`) will be returned to mark the end of iteration.
+         *
+         * The iterator may be NULL, in which case this function returns a zero node.
+         */
+        Node next() { return routx_graph_iterator_next(m_impl); }
+
+       private:
+        RoutxGraphIterator* m_impl = nullptr;
+    };
+
+    /**
+     * Creates a view of a C-style Graph handle, without taking ownership of it.
+     *
+     * The pointer maybe null, which creates a NULL view, for which all operations are a no-op.
+     */
+    explicit GraphView(RoutxGraph const* g) : m_impl(g) {}
+
+    GraphView(GraphView const&) = default;
+
+    /**
+     * Views can't be reassigned: as a @ref Graph is a view of itself, assigning through
+     * a `GraphView&` referring to a @ref Graph would make it delete a handle it doesn't own.
+     */
+    GraphView& operator=(GraphView const&) = delete;
+
+    /**
+     * Returns the number of @ref Node "Nodes" in the graph.
+     */
+    size_t size() const { return routx_graph_get_nodes(m_impl, nullptr); }
+
+    /**
+     * Returns true if there are no @ref Node "Nodes" in the graph.
+     */
+    bool is_empty() const { return routx_graph_get_nodes(m_impl, nullptr) == 0; }
+
+    /**
+     * Returns an @ref Iterator over all nodes in this graph.
+     * The graph must not be modified while iterating over its nodes.
+     *
+     * The returned object doesn't comply with standard C++ iterators,
+     * as it contains a non-copyable handle.
+     *
+     * Usage:
+     *
+     * @code{.cpp}
+     * routx::Graph::Iterator it = graph.get_nodes();
+     * routx::Node node;
+     * while ((node = it.next()).id != 0) {
+     *     // Process node
+     * }
+     * @endcode
+     */
+    Iterator get_nodes() const {
+        RoutxGraphIterator* it_impl = nullptr;
+        routx_graph_get_nodes(m_impl, &it_impl);
+        return Iterator(it_impl);
+    }
+
+    /**
+     * Finds a node with the provided id. If no such node was found, returns a zero (`id == 0`)
+     * node.
+     *
+     * If the graph is NULL, returns a zero node.
+     */
+    Node get_node(int64_t id) const { return routx_graph_get_node(m_impl, id); }
+
+    /**
+     * Returns the epoch of the graph, advanced by every modification (of nodes or edges)
+     * and unique within the process, see routx_graph_epoch().
+     */
+    uint64_t epoch() const { return routx_graph_epoch(m_impl); }
+
+    /**
+     * Finds the closest canonical (`id == osm_id`) @ref Node to the given position.
+     *
+     * This function requires computing distance to every @ref Node in the graph,
+     * and is not suitable for large graphs or for multiple searches.
+     * Use @ref KDTree for faster NN finding.
+     *
+     * If the graph is NULL or has no nodes, returns a zero (`id == 0`) node.
+     */
+    Node find_nearest_node(float lat, float lon) const {
+        return routx_graph_find_nearest_node(m_impl, lat, lon);
+    }
+
+    /**
+     * Gets all outgoing @ref Edge "Edges" from a node with a given id.
+     *
+     * The Graph must not be modified while using the return edge array, as it might be
+     * reallocated.
+     */
+    std::span<Edge const> get_edges(int64_t from_id) const {
+        Edge const* data = nullptr;
+        size_t size = routx_graph_get_edges(m_impl, from_id, &data);
+        return std::span<Edge const>(data, size);
+    }
+
+    /**
+     * Gets the cost of a @ref RoutxEdge from one node to another.
+     * Returns positive infinity when the provided edge can't be found, or when the graph is NULL.
+     */
+    float get_edge(int64_t from_id, int64_t to_id) const {
+        return routx_graph_get_edge(m_impl, from_id, to_id);
+    }
+
+    /**
+     * Finds the shortest route between two nodes using the
+     * [A* algorithm](https://en.wikipedia.org/wiki/A*_search_algorithm) in the provided graph.
+     *
+     * Returns an empty @ref Route no route exists.
+     *
+     * For graphs with turn restrictions, use find_route_without_turn_around(), as this
+     * implementation will generate unrealistic instructions with immediate turnarounds (A-B-A) to
+     * circumvent any restrictions.
+     *
+     * The `step_limit` parameter limits how many nodes can be expanded during search before
+     * throwing @ref StepLimitExceeded. Concluding that no
+     * route exists requires expanding all nodes accessible from the start, which is usually very
+     * time consuming, especially on large datasets. Recommended (and default) value is
+     * @ref DEFAULT_STEP_LIMIT.
+     *
+     * If `from` or `to` don't exist, throws @ref InvalidReference.
+     */
+    Route find_route(int64_t from, int64_t to, size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        return Route::from_result(routx_find_route(m_impl, from, to, step_limit));
+    }
+
+    /**
+     * Equivalent of find_route(), also returning the position of every node of the route
+     * and the cumulative cost of reaching it, all in a single call.
+     *
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
+     */
+    RouteDetailed find_route_detailed(int64_t from, int64_t to,
+                                      size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        RouteDetailed route;
+        route.fill([&](RoutxRouteDetailed const* raw) {
+            return routx_find_route_detailed(m_impl, from, to, step_limit, raw);
+        });
+        return route;
+    }
+
+    /**
+     * Finds the shortest route between two nodes using the
+     * [A* algorithm](https://en.wikipedia.org/wiki/A*_search_algorithm) in the provided graph.
+     *
+     * Returns an empty @ref Route no route exists.
+     *
+     * For graphs without turn restrictions, use routx_find_route(), as it runs faster.
+     * This function has an extra dimension - it needs to not only consider the current node,
+     * but also what was the previous node to prevent immediate turnaround (A-B-A) instructions.
+     *
+     * The `step_limit` parameter limits how many nodes can be expanded during search before
+     * throwing @ref StepLimitExceeded. Concluding that no
+     * route exists requires expanding all nodes accessible from the start, which is usually very
+     * time consuming, especially on large datasets. Recommended (and default) value is
+     * @ref DEFAULT_STEP_LIMIT.
+     *
+     * If `from` or `to` don't exist, throws @ref InvalidReference.
+     */
+    Route find_route_without_turn_around(int64_t from, int64_t to,
+                                         size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        return Route::from_result(
+            routx_find_route_without_turn_around(m_impl, from, to, step_limit));
+    }
+
+    /**
+     * Creates an immutable @ref FrozenGraph snapshot of this graph, better suited for answering
+     * many route queries.
+     */
+    FrozenGraph freeze() const { return FrozenGraph(routx_graph_freeze(m_impl)); }
+
+    /**
+     * Saves a snapshot of this graph to a file, which can be opened with
+     * FrozenGraph::open_mmap(). See FrozenGraph::save().
+     *
+     * @throws @ref IoFailed if saving has failed, see logs in such case
+     */
+    void save(char const* filename) const {
+        if (!routx_graph_save(m_impl, filename)) [[unlikely]] {
+            throw IoFailed();
+        }
+    }
+
+    /**
+     * Builds a @ref CHGraph (contraction hierarchy) over this graph. This is a slow operation,
+     * meant to be done once after loading the graph.
+     */
+    CHGraph build_ch() const { return CHGraph(routx_ch_build(m_impl)); }
+
+    /**
+     * Calculates the costs of the shortest routes from every source to every target,
+     * see FrozenGraph::cost_matrix().
+     *
+     * This creates a temporary @ref FrozenGraph snapshot - call freeze() and reuse the
+     * @ref FrozenGraph when calculating many matrices over the same graph.
+     */
+    std::vector<float> cost_matrix(std::span<int64_t const> sources,
+                                   std::span<int64_t const> targets,
+                                   size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        return freeze().cost_matrix(sources, targets, step_limit);
+    }
+
+    /**
+     * Returns the underlying C-style handle.
+     */
+    RoutxGraph const* get() const { return m_impl; }
+
+   protected:
+    RoutxGraph const* m_impl = nullptr;
+};
+
+/**
+ * OpenStreetMap-based network representation as a set of @ref Node "Nodes"
+ * and @ref Edge "Edges" between them.
+ *
+ * All read-only operations are inherited from @ref GraphView, and may be called from any
+ * number of threads concurrently. Modifications must not run concurrently with any other
+ * operation on the same graph - convert the graph into a @ref SharedGraph to share
+ * an immutable graph between threads.
+ */
+class Graph : public GraphView {
+   public:
+    /**
+     * Allocates a new Graph.
+     */
+    Graph() : GraphView(routx_graph_new()) {}
+
+    /**
+     * Takes ownership of a C-style Graph handle.
+     *
+     * The pointer maybe null, which creates a NULL Graph, for which all operations are a no-op.
+     */
+    explicit Graph(RoutxGraph* g) : GraphView(g) {}
+
+    ~Graph() { routx_graph_delete(mut()); }
+
+    Graph(Graph const&) = delete;
+
+    Graph(Graph&& other) : GraphView(nullptr) { std::swap(m_impl, other.m_impl); }
+
+    Graph& operator=(Graph const&) = delete;
+
+    Graph& operator=(Graph&& other) noexcept {
+        std::swap(m_impl, other.m_impl);
+        return *this;
+    }
+
+    /**
+     * Creates or updates a @ref Node with the provided id.
+     *
+     * All outgoing and incoming edges are preserved, thus updating a @ref Node position
+     * might result in violation of the @ref Edge invariant (and thus break route finding).
+     * It **is discouraged** to update nodes, and it is the caller's responsibility not to break
+     * this invariant.
+     *
+     * When called with a NULL graph, this function does nothing and returns false.
+     *
+     * @returns true if an existing node was updated/overwritten, false otherwise
+     */
+    bool set_node(Node node) { return routx_graph_set_node(mut(), node); }
+
+    /**
+     * Deletes a @ref Node with the provided id.
+     *
+     * Outgoing edges are removed, but incoming edges are preserved (for performance reasons).
+     * Thus, deleting a node and then reusing its id might result in violation of
+     * @ref Edge cost invariant (breaking route finding) and **is therefore discouraged**.
+     * It is the caller's responsibility not to break this invariant.
+     *
+     * When called with a NULL graph, this function does nothing and return false.
+     *
+     * @returns true if a node was actually deleted, false otherwise
+     */
+    bool delete_node(int64_t id) { return routx_graph_delete_node(mut(), id); }
+
+    /**
+     * Creates or updates a @ref Edge from a node with a given id.
+     *
+     * The `cost` must not be smaller than the crow-flies distance between nodes,
+     * as this would violate the A* invariant and break route finding. It is the caller's
+     * responsibility to do so.
+     *
+     * When called with a NULL graph, this function does nothing and returns false.
+     *
+     * @returns true if an existing edge was updated, false otherwise
+     */
+    bool set_edge(int64_t from_id, Edge edge) {
+        return routx_graph_set_edge(mut(), from_id, edge);
+    }
+
+    /**
+     * Removes a @ref Edge from one node to another.
+     * If no such edge exists (or the graph is NULL), does nothing.
+     *
+     * @returns true if an edge was removed, false otherwise
+     */
+    bool delete_edge(int64_t from_id, int64_t to_id) {
+        return routx_graph_delete_edge(mut(), from_id, to_id);
+    }
+
+    /**
+     * Parses OSM data from the provided file and adds it to the graph.
+     *
+     * @param options Options for parsing the OSM data. Must not be NULL.
+     * @param filename Path to the OSM file to be parsed. Must not be NULL.
+     * @throws @ref osm::LoadingFailed if loading has failed, see logs in such case
+     */
+    void add_from_osm_file(osm::Options const* options, char const* filename) {
+        if (!routx_graph_add_from_osm_file(mut(), options, filename)) [[unlikely]] {
+            throw osm::LoadingFailed();
+        }
+    }
+
+    /**
+     * Parses OSM data from the provided file and adds it to the graph, reading the file twice
+     * to bound memory usage, see @ref routx_graph_add_from_osm_file_two_pass.
+     *
+     * @param options Options for parsing the OSM data. Must not be NULL.
+     * @param filename Path to the OSM file to be parsed. Must not be NULL.
+     * @throws @ref osm::LoadingFailed if loading has failed, see logs in such case
+     */
+    void add_from_osm_file_two_pass(osm::Options const* options, char const* filename) {
+        if (!routx_graph_add_from_osm_file_two_pass(mut(), options, filename)) [[unlikely]] {
+            throw osm::LoadingFailed();
+        }
+    }
+
+    /**
+     * Parses OSM data from the provided buffer and adds it to the graph.
+     *
+     * @param options Options for parsing the OSM data. Must not be NULL.
+     * @param content Pointer to the buffer containing OSM data. Must be not be NULL, even if
+     * content_len == 0.
+     * @param content_len Length of the buffer in bytes.
+     * @throws @ref osm::LoadingFailed if loading has failed, see logs in such case
+     */
+    void add_from_osm_memory(osm::Options const* options, char const* data, size_t len) {
+        if (!routx_graph_add_from_osm_memory(mut(), options, data, len)) [[unlikely]] {
+            throw osm::LoadingFailed();
+        }
+    }
+
+    /**
+     * Parses OSM data from the provided file with a compiled profile and adds it to the graph.
+     *
+     * @param options Options for parsing the OSM data. Must not be NULL. `options->profile`
+     * is ignored.
+     * @param profile Compiled profile used to interpret the OSM data.
+     * @param filename Path to the OSM file to be parsed. Must not be NULL.
+     * @throws @ref osm::LoadingFailed if loading has failed, see logs in such case
+     */
+    void add_from_osm_file(osm::Options const* options, osm::CompiledProfile const& profile,
+                           char const* filename) {
+        if (!routx_graph_add_from_osm_file_compiled(mut(), options, profile.get(), filename))
+            [[unlikely]] {
+            throw osm::LoadingFailed();
+        }
+    }
+
+    /**
+     * Parses OSM data from the provided buffer with a compiled profile and adds it to the graph.
+     *
+     * @param options Options for parsing the OSM data. Must not be NULL. `options->profile`
+     * is ignored.
+     * @param profile Compiled profile used to interpret the OSM data.
+     * @param content Pointer to the buffer containing OSM data. Must be not be NULL, even if
+     * content_len == 0.
+     * @param content_len Length of the buffer in bytes.
+     * @throws @ref osm::LoadingFailed if loading has failed, see logs in such case
+     */
+    void add_from_osm_memory(osm::Options const* options, osm::CompiledProfile const& profile,
+                             char const* data, size_t len) {
+        if (!routx_graph_add_from_osm_memory_compiled(mut(), options, profile.get(), data, len))
+            [[unlikely]] {
+            throw osm::LoadingFailed();
+        }
+    }
+
+    /**
+     * Releases ownership of the underlying C-style handle, leaving a NULL Graph.
+     * The caller becomes responsible for calling routx_graph_delete().
+     */
+    RoutxGraph* release() {
+        RoutxGraph* g = mut();
+        m_impl = nullptr;
+        return g;
+    }
+
+   private:
+    /// Owned graphs may be modified, unlike the ones behind other views.
+    RoutxGraph* mut() { return const_cast<RoutxGraph*>(m_impl); }
+};
+
+/**
+ * Immutable, reference-counted @ref Graph, which can be shared between threads - a counterpart
+ * of `std::shared_ptr<Graph const>`, backed by an atomically reference-counted Rust `Arc`.
+ *
+ * Copying a SharedGraph doesn't copy the graph, and the graph is deallocated once its last copy
+ * is destroyed. All read-only operations are available through view(), and may be called from
+ * any number of threads concurrently, without locking. Every thread must use its own
+ * @ref SearchContext.
+ *
+ * @code{.cpp}
+ * routx::SharedGraph g{std::move(graph)};
+ *
+ * // On every thread
+ * routx::Route route = g.view().find_route(from, to);
+ * @endcode
+ */
+class SharedGraph {
+   public:
+    /**
+     * Takes ownership of a C-style SharedGraph handle.
+     *
+     * The pointer maybe null, which creates a NULL SharedGraph, whose view() is a NULL view.
+     */
+    explicit SharedGraph(RoutxSharedGraph* g) : m_impl(g) {}
+
+    /**
+     * Converts a @ref Graph into a SharedGraph, without copying it. The provided graph is left
+     * as a NULL graph.
+     */
+    explicit SharedGraph(Graph&& g) : m_impl(routx_shared_graph_new(g.release())) {}
+
+    ~SharedGraph() { routx_shared_graph_delete(m_impl); }
+
+    SharedGraph(SharedGraph const& other) : m_impl(routx_shared_graph_clone(other.m_impl)) {}
+
+    SharedGraph(SharedGraph&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+
+    SharedGraph& operator=(SharedGraph const& other) {
+        SharedGraph copy(other);
+        std::swap(m_impl, copy.m_impl);
+        return *this;
+    }
+
+    SharedGraph& operator=(SharedGraph&& other) noexcept {
+        std::swap(m_impl, other.m_impl);
+        return *this;
+    }
+
+    /**
+     * Returns a view of the shared graph, valid for as long as this SharedGraph exists.
+     */
+    GraphView view() const { return GraphView(routx_shared_graph_get(m_impl)); }
+
+    /**
+     * Returns the number of SharedGraphs referring to the same graph, or 0 for a NULL
+     * SharedGraph. The count may be changed concurrently by other threads.
+     */
+    size_t use_count() const { return routx_shared_graph_use_count(m_impl); }
+
+    /**
+     * Returns the underlying C-style handle.
+     */
+    RoutxSharedGraph const* get() const { return m_impl; }
+
+   private:
+    RoutxSharedGraph* m_impl = nullptr;
+};
+
+/**
+ * Holds a @ref SharedGraph which can be replaced while other threads are routing on it,
+ * e.g. to hot-swap a newly loaded network.
+ *
+ * load() and store() may be called from any number of threads concurrently. Neither waits for
+ * queries running on previously loaded graphs - such queries finish on the graph they started
+ * with, which is deallocated once its last @ref SharedGraph is destroyed.
+ *
+ * @code{.cpp}
+ * routx::GraphSlot slot{routx::SharedGraph{std::move(graph)}};
+ *
+ * // Reader threads
+ * routx::SharedGraph g = slot.load();
+ * routx::Route route = g.view().find_route(from, to);
+ *
+ * // Writer thread
+ * slot.store(routx::SharedGraph{std::move(new_graph)});
+ * @endcode
+ */
+class GraphSlot {
+   public:
+    /**
+     * Takes ownership of a C-style GraphSlot handle.
+     *
+     * The pointer maybe null, which creates a NULL GraphSlot, for which all operations are a
+     * no-op.
+     */
+    explicit GraphSlot(RoutxGraphSlot* s) : m_impl(s) {}
+
+    /**
+     * Creates a slot holding the provided graph.
+     */
+    explicit GraphSlot(SharedGraph const& g) : m_impl(routx_graph_slot_new(g.get())) {}
+
+    ~GraphSlot() { routx_graph_slot_delete(m_impl); }
+
+    GraphSlot(GraphSlot const&) = delete;
+
+    GraphSlot(GraphSlot&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+
+    GraphSlot& operator=(GraphSlot const&) = delete;
+
+    GraphSlot& operator=(GraphSlot&& other) noexcept {
+        std::swap(m_impl, other.m_impl);
+        return *this;
+    }
+
+    /**
+     * Returns the currently held graph.
+     */
+    SharedGraph load() const { return SharedGraph(routx_graph_slot_load(m_impl)); }
+
+    /**
+     * Replaces the held graph. Previously loaded @ref SharedGraph "SharedGraphs" still refer
+     * to the previous graph.
+     *
+     * Returns false (and does nothing) if the slot or the graph is NULL.
+     */
+    bool store(SharedGraph const& g) const { return routx_graph_slot_store(m_impl, g.get()); }
+
+    /**
+     * Returns the underlying C-style handle.
+     */
+    RoutxGraphSlot const* get() const { return m_impl; }
+
+   private:
+    RoutxGraphSlot* m_impl = nullptr;
+};
+
+class KDTree {
+   public:
+    /// Empty constructor for KDTree is ambiguous, use KDTree::build or KDTree(nullptr) explicitly.
+    KDTree() = delete;
+
+    ~KDTree() { routx_kd_tree_delete(m_impl); }
+
+    /**
+     * Builds a k-d tree with all canonical (`id == osm_id`) @ref Node "Nodes"
+     * contained in the provided @ref Graph.
+     *
+     * If there are no nodes in the @ref Graph, creates a NULL k-d tree, for which all operations
+     * are a no-op.
+     */
+    static KDTree build(GraphView graph) { return KDTree(routx_kd_tree_new(graph.get())); }
+
+    /**
+     * Takes ownership of a C-style Graph handle.
+     *
+     * The pointer may be null, which creates a NULL Graph, for which all operations are a no-op.
+     */
+    explicit KDTree(RoutxKDTree* t) : m_impl(t) {}
+
+    KDTree(KDTree const&) = delete;
+
+    KDTree(KDTree&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+
+    KDTree& operator=(KDTree const&) = delete;
+
+    KDTree& operator=(KDTree&& other) {
+        std::swap(m_impl, other.m_impl);
+        return *this;
+    }
+
+    /**
+     * Finds the closest node to the provided position and returns it.
+     * If there are no nodes or the k-d tree is NULL, returns a zero (`id == 0`) node.
+     */
+    Node find_nearest_node(float lat, float lon) const {
+        return routx_kd_tree_find_nearest_node(m_impl, lat, lon);
+    }
+
+    /**
+     * Finds up to `k` closest nodes to the provided position, ordered by increasing
+     * earth_distance() from the position.
+     */
+    std::vector<Node> find_k_nearest(float lat, float lon, size_t k) const {
+        std::vector<Node> nodes(k);
+        nodes.resize(routx_kd_tree_find_k_nearest(m_impl, lat, lon, k, nodes.data()));
+        return nodes;
+    }
+
+    /**
+     * Finds the closest node to every `(lats[i], lons[i])` position, spreading the queries over
+     * `threads` threads (zero stands for the available parallelism). Positions beyond the
+     * shorter of the two spans are ignored.
+     *
+     * If the k-d tree is NULL, returns zero (`id == 0`) nodes.
+     */
+    std::vector<Node> find_nearest_nodes(std::span<float const> lats, std::span<float const> lons,
+                                         unsigned threads = 0) const {
+        size_t n = std::min(lats.size(), lons.size());
+        std::vector<Node> nodes(n);
+        routx_kd_tree_find_nearest_nodes(m_impl, lats.data(), lons.data(), n, nodes.data(),
+                                         threads);
+        return nodes;
+    }
+
+   private:
+    RoutxKDTree* m_impl = nullptr;
+};
+
+/**
+ * Bounded, least-recently-used cache of nearest-node lookups,
+ * see GridIndex::find_nearest_node(SnapCache&, float, float).
+ *
+ * Positions are quantized to multiples of `quantum` meters, and all positions with the same
+ * quantized coordinates share a cache entry - the node of the first lookup is returned for all
+ * of them. Keep the quantum well below the distance between nodes.
+ *
+ * A SnapCache may only be used by one thread at a time.
+ */
+class SnapCache {
+   public:
+    /**
+     * Creates an empty cache of at most `capacity` entries, quantizing positions
+     * to multiples of `quantum` meters. A cache with zero capacity never stores anything.
+     *
+     * If `quantum` is not a positive, finite number, creates a NULL cache, which is never used.
+     */
+    explicit SnapCache(size_t capacity, float quantum = DEFAULT_SNAP_QUANTUM)
+        : m_impl(routx_snap_cache_new(capacity, quantum)) {}
+
+    /**
+     * Takes ownership of a C-style SnapCache handle.
+     *
+     * The pointer may be null, which creates a NULL SnapCache, which is never used.
+     */
+    explicit SnapCache(RoutxSnapCache* c) : m_impl(c) {}
+
+    ~SnapCache() { routx_snap_cache_delete(m_impl); }
+
+    SnapCache(SnapCache const&) = delete;
+
+    SnapCache(SnapCache&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+
+    SnapCache& operator=(SnapCache const&) = delete;
+
+    SnapCache& operator=(SnapCache&& other) noexcept {
+        std::swap(m_impl, other.m_impl);
+        return *this;
+    }
+
+    /**
+     * Removes all cached lookups, e.g. after switching to a different @ref GridIndex.
+     * Hit and miss counters are preserved.
+     */
+    void clear() { routx_snap_cache_clear(m_impl); }
+
+    /**
+     * Returns the number of cached lookups.
+     */
+    size_t size() const { return routx_snap_cache_len(m_impl); }
+
+    /**
+     * Returns the number of lookups answered from the cache.
+     */
+    uint64_t hits() const { return routx_snap_cache_hits(m_impl); }
+
+    /**
+     * Returns the number of lookups which weren't cached.
+     */
+    uint64_t misses() const { return routx_snap_cache_misses(m_impl); }
+
+    /**
+     * Returns the underlying C-style handle.
+     */
+    RoutxSnapCache* get() { return m_impl; }
+
+   private:
+    RoutxSnapCache* m_impl = nullptr;
+};
+
+/**
+ * Alias for @ref RoutxRouteKind - the search used to find a route stored in a @ref RouteCache.
+ */
+using RouteKind = RoutxRouteKind;
+
+/**
+ * Route with its cost, returned by RouteCache::find_route().
+ */
+struct CachedRoute {
+    /// Nodes of the route. Empty if there is no route.
+    Route nodes;
+
+    /// Cost of the whole route, or zero if there is no route.
+    float cost;
+};
+
+/**
+ * Thread-safe, bounded, least-recently-used cache of routes found over a single graph,
+ * for serving repeated queries without re-running the search.
+ *
+ * Routes are keyed by their start and end nodes, the @ref RouteKind and the epoch of the graph -
+ * GraphView::epoch() for a @ref Graph, or CostOverlay::epoch() for a @ref CostOverlay.
+ * As soon as a newer epoch is seen, all cached routes are dropped. Epochs are unique within
+ * the process, so routes are never returned for a graph other than the one they were found on -
+ * but the cache is only effective for one graph at a time.
+ */
+class RouteCache {
+   public:
+    /**
+     * Creates an empty cache of at most `capacity` routes.
+     * A cache with zero capacity never stores anything.
+     */
+    explicit RouteCache(size_t capacity) : m_impl(routx_route_cache_new(capacity)) {}
+
+    /**
+     * Takes ownership of a C-style RouteCache handle.
+     *
+     * The pointer may be null, which creates a NULL RouteCache, which is never used.
+     */
+    explicit RouteCache(RoutxRouteCache* c) : m_impl(c) {}
+
+    ~RouteCache() { routx_route_cache_delete(m_impl); }
+
+    RouteCache(RouteCache const&) = delete;
+
+    RouteCache(RouteCache&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+
+    RouteCache& operator=(RouteCache const&) = delete;
+
+    RouteCache& operator=(RouteCache&& other) noexcept {
+        std::swap(m_impl, other.m_impl);
+        return *this;
+    }
+
+    /**
+     * Removes all cached routes. Hit and miss counters are preserved.
+     */
+    void clear() const { routx_route_cache_clear(m_impl); }
+
+    /**
+     * Returns the number of cached routes.
+     */
+    size_t size() const { return routx_route_cache_len(m_impl); }
+
+    /**
+     * Returns the number of queries answered from the cache.
+     */
+    uint64_t hits() const { return routx_route_cache_hits(m_impl); }
+
+    /**
+     * Returns the number of queries which required a search.
+     */
+    uint64_t misses() const { return routx_route_cache_misses(m_impl); }
+
+    /**
+     * Returns the cached route between two nodes of a @ref Graph at its current epoch,
+     * or finds (and caches) the route with Graph::find_route() or
+     * Graph::find_route_without_turn_around(), depending on the `kind`.
+     *
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
+     */
+    CachedRoute find_route(GraphView graph, int64_t from, int64_t to,
+                           RouteKind kind = RoutxRouteKindWithoutTurnAround,
+                           size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        float cost = 0.0f;
+        Route nodes = Route::from_result(routx_route_cache_find_route(
+            m_impl, graph.get(), kind, from, to, step_limit, &cost));
+        return CachedRoute{std::move(nodes), cost};
+    }
+
+    /**
+     * Same as RouteCache::find_route(GraphView, int64_t, int64_t, RouteKind, size_t), but
+     * searches the most recently published snapshot of a @ref CostOverlay, keyed by its epoch.
+     *
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
+     */
+    CachedRoute find_route(CostOverlay const& overlay, int64_t from, int64_t to,
+                           RouteKind kind = RoutxRouteKindWithoutTurnAround,
+                           size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        float cost = 0.0f;
+        Route nodes = Route::from_result(routx_route_cache_find_route_with_overlay(
+            m_impl, overlay.get(), kind, from, to, step_limit, &cost));
+        return CachedRoute{std::move(nodes), cost};
+    }
+
+    /**
+     * Returns the underlying C-style handle.
+     */
+    RoutxRouteCache const* get() const { return m_impl; }
+
+   private:
+    RoutxRouteCache* m_impl = nullptr;
+};
+
+/**
+ * A uniform grid of cells over all canonical (`id == osm_id`) nodes, for fast nearest-neighbor
+ * search with densely distributed data, like road networks. On average, searches take constant
+ * time, and unlike a @ref KDTree, data close to or crossing the antimeridian is handled correctly.
+ */
+class GridIndex {
+   public:
+    /// Empty constructor for GridIndex is ambiguous, use GridIndex::build or GridIndex(nullptr)
+    /// explicitly.
+    GridIndex() = delete;
+
+    ~GridIndex() { routx_grid_index_delete(m_impl); }
+
+    /**
+     * Builds a grid index with all canonical (`id == osm_id`) @ref Node "Nodes"
+     * contained in the provided @ref Graph, with cells of the provided size (in meters).
+     *
+     * If there are no nodes in the @ref Graph, or `cell_size` is not a positive, finite number,
+     * creates a NULL grid index, for which all operations are a no-op.
+     */
+    static GridIndex build(GraphView graph, float cell_size = DEFAULT_GRID_CELL_SIZE) {
+        return GridIndex(routx_grid_index_new(graph.get(), cell_size));
+    }
+
+    /**
+     * Takes ownership of a C-style GridIndex handle.
+     *
+     * The pointer may be null, which creates a NULL GridIndex, for which all operations
+     * are a no-op.
+     */
+    explicit GridIndex(RoutxGridIndex* i) : m_impl(i) {}
+
+    GridIndex(GridIndex const&) = delete;
+
+    GridIndex(GridIndex&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+
+    GridIndex& operator=(GridIndex const&) = delete;
+
+    GridIndex& operator=(GridIndex&& other) noexcept {
+        std::swap(m_impl, other.m_impl);
+        return *this;
+    }
+
+    /**
+     * Finds the closest node to the provided position and returns it.
+     * If the grid index is NULL, returns a zero (`id == 0`) node.
+     */
+    Node find_nearest_node(float lat, float lon) const {
+        return routx_grid_index_find_nearest_node(m_impl, lat, lon);
+    }
+
+    /**
+     * Same as GridIndex::find_nearest_node(float, float), but first looks up the (quantized)
+     * position in the provided @ref SnapCache, and stores the result in the cache on a miss.
+     * The cache must only be used with this index.
+     */
+    Node find_nearest_node(SnapCache& cache, float lat, float lon) const {
+        return routx_grid_index_find_nearest_node_cached(m_impl, cache.get(), lat, lon);
+    }
+
+    /**
+     * Finds the closest node to every `(lats[i], lons[i])` position, spreading the queries over
+     * `threads` threads (zero stands for the available parallelism). Positions beyond the
+     * shorter of the two spans are ignored.
+     *
+     * If the grid index is NULL, returns zero (`id == 0`) nodes.
+     */
+    std::vector<Node> find_nearest_nodes(std::span<float const> lats, std::span<float const> lons,
+                                         unsigned threads = 0) const {
+        size_t n = std::min(lats.size(), lons.size());
+        std::vector<Node> nodes(n);
+        routx_grid_index_find_nearest_nodes(m_impl, lats.data(), lons.data(), n, nodes.data(),
+                                            threads);
+        return nodes;
+    }
+
+   private:
+    RoutxGridIndex* m_impl = nullptr;
+};
+
+/**
+ * Counters of a @ref TiledGraph tile cache, see @ref RoutxTileStats.
+ */
+using TileStats = RoutxTileStats;
+
+/**
+ * Read-only graph split into square tiles (in degrees of latitude and longitude), stored
+ * in a directory as separate files, and loaded only when searches reach them.
+ * Cold tiles are dropped once the total size of files of loaded tiles exceeds a memory budget.
+ *
+ * All const methods may be called concurrently from any number of threads.
+ */
+class TiledGraph {
+   public:
+    /**
+     * Takes ownership of a C-style TiledGraph handle.
+     *
+     * The pointer may be null, which creates a NULL TiledGraph, for which all operations
+     * are a no-op.
+     */
+    explicit TiledGraph(RoutxTiledGraph* g) : m_impl(g) {}
+
+    ~TiledGraph() { routx_tiled_graph_delete(m_impl); }
+
+    TiledGraph(TiledGraph const&) = delete;
+
+    TiledGraph(TiledGraph&& other) : m_impl(nullptr) { std::swap(m_impl, other.m_impl); }
+
+    TiledGraph& operator=(TiledGraph const&) = delete;
+
+    TiledGraph& operator=(TiledGraph&& other) noexcept {
+        std::swap(m_impl, other.m_impl);
+        return *this;
+    }
+
+    /**
+     * Splits a @ref FrozenGraph into tiles of `tile_size` degrees, and saves them along with
+     * an index of all nodes into the `dirname` directory, creating it if necessary.
+     *
+     * @throws @ref IoFailed if saving has failed or `tile_size` is not a positive number,
+     * see logs in such case
+     */
+    static void save(FrozenGraph const& graph, char const* dirname,
+                     float tile_size = DEFAULT_TILE_SIZE) {
+        if (!routx_tiled_graph_save(graph.m_impl, dirname, tile_size)) [[unlikely]] {
+            throw IoFailed();
+        }
+    }
+
+    /**
+     * Opens a graph saved with TiledGraph::save() in the `dirname` directory, only
+     * memory-mapping the index of all nodes. Tiles are loaded on demand, and dropped once
+     * the total size of their files exceeds `memory_budget` bytes.
+     *
+     * The files must not be modified or truncated (by this or any other process) while the graph
+     * is alive - doing so results in undefined behavior or a SIGBUS crash.
+     *
+     * @throws @ref IoFailed if opening has failed, see logs in such case
+     */
+    static TiledGraph open(char const* dirname, size_t memory_budget) {
+        RoutxTiledGraph* g = routx_tiled_graph_open(dirname, memory_budget);
+        if (!g) [[unlikely]] {
+            throw IoFailed();
+        }
+        return TiledGraph(g);
+    }
+
+    /**
+     * Returns the number of @ref Node "Nodes" in the graph.
+     */
+    size_t size() const { return routx_tiled_graph_len(m_impl); }
+
+    /**
+     * Returns the counters of the tile cache.
+     */
+    TileStats stats() const { return routx_tiled_graph_stats(m_impl); }
+
+    /**
+     * Finds a node with the provided id, loading its tile if necessary.
+     * If no such node was found, or its tile couldn't be loaded, returns a zero (`id == 0`) node.
+     */
+    Node get_node(int64_t id) const { return routx_tiled_graph_get_node(m_impl, id); }
+
+    /**
+     * Finds the closest canonical (`id == osm_id`) node to the provided position, searching
+     * (and loading) tiles in growing rings around it. If there are no canonical nodes,
+     * or a tile couldn't be loaded, returns a zero (`id == 0`) node.
+     */
+    Node find_nearest_node(float lat, float lon) const {
+        return routx_tiled_graph_find_nearest_node(m_impl, lat, lon);
+    }
+
+    /**
+     * Equivalent of Graph::find_route() loading tiles as the search reaches them.
+     *
+     * @throws @ref InvalidReference if `from` or `to` don't exist
+     * @throws @ref StepLimitExceeded if the search has exceeded its `step_limit`
+     * @throws @ref IoFailed if a tile couldn't be loaded, see logs in such case
+     */
+    Route find_route(int64_t from, int64_t to, size_t step_limit = DEFAULT_STEP_LIMIT) const {
+        return Route::from_result(routx_tiled_graph_find_route(m_impl, from, to, step_limit));
+    }
+
+    /**
+     * Returns the underlying C-style handle.
+     */
+    RoutxTiledGraph const* get() const { return m_impl; }
+
+   private:
+    RoutxTiledGraph* m_impl = nullptr;
 };
 
 }  // namespace routx
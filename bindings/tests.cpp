@@ -3,13 +3,23 @@
 
 #include <gtest/gtest.h>
 
+#include <array>
+#include <chrono>
 #include <cmath>
+#include <coroutine>
 #include <cstdio>
 #include <filesystem>
 #include <fstream>
+#include <future>
+#include <optional>
 #include <routx.hpp>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
 
 static std::string_view osm_file_fixture =
     "<?xml version='1.0' encoding='UTF-8'?><osm version='0.6'>\n"
@@ -333,6 +343,654 @@ TEST(Graph, FindRouteInvalidReference) {
     ASSERT_THROW(g.find_route(1, 2), routx::InvalidReference);
 }
 
+TEST(FrozenGraph, Freeze) {
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.02, .lon = 0.01});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.03, .lon = 0.01});
+    g.set_edge(1, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 100.0});
+
+    auto f = g.freeze();
+
+    // Changes to the Graph must not affect the FrozenGraph
+    g.delete_node(3);
+
+    ASSERT_EQ(f.size(), 3);
+    ASSERT_FALSE(f.is_empty());
+
+    auto n = f.get_node(2);
+    ASSERT_EQ(n.id, 2);
+    ASSERT_EQ(n.osm_id, 2);
+    ASSERT_FLOAT_EQ(n.lat, 0.02);
+    ASSERT_FLOAT_EQ(n.lon, 0.01);
+    ASSERT_EQ(f.get_node(42).id, 0);
+
+    ASSERT_FLOAT_EQ(f.get_edge(1, 2), 200.0);
+    ASSERT_FLOAT_EQ(f.get_edge(2, 3), 100.0);
+    ASSERT_FLOAT_EQ(f.get_edge(2, 1), HUGE_VALF);
+}
+
+TEST(FrozenGraph, FindRouteWithTurnRestriction) {
+    // 1
+    // │
+    // │10
+    // │ 10
+    // 2─────4
+    // │     │
+    // │10   │100
+    // │ 10  │
+    // 3─────5
+    // mandatory 1-2-4
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.00, .lon = 0.02});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.00, .lon = 0.01});
+    g.set_node(routx::Node{.id = 20, .osm_id = 2, .lat = 0.00, .lon = 0.01});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.00, .lon = 0.00});
+    g.set_node(routx::Node{.id = 4, .osm_id = 4, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 5, .osm_id = 5, .lat = 0.01, .lon = 0.00});
+    g.set_edge(1, routx::Edge{.to = 20, .cost = 10.0});
+    g.set_edge(2, routx::Edge{.to = 1, .cost = 10.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 10.0});
+    g.set_edge(2, routx::Edge{.to = 4, .cost = 10.0});
+    g.set_edge(20, routx::Edge{.to = 4, .cost = 10.0});
+    g.set_edge(3, routx::Edge{.to = 2, .cost = 10.0});
+    g.set_edge(3, routx::Edge{.to = 5, .cost = 10.0});
+    g.set_edge(4, routx::Edge{.to = 2, .cost = 10.0});
+    g.set_edge(4, routx::Edge{.to = 5, .cost = 100.0});
+    g.set_edge(5, routx::Edge{.to = 3, .cost = 10.0});
+    g.set_edge(5, routx::Edge{.to = 4, .cost = 100.0});
+    auto f = g.freeze();
+
+    constexpr size_t step_limit = 100;
+
+    {
+        auto r = f.find_route(1, 3, step_limit);
+        ASSERT_EQ(r.size(), 5);
+        ASSERT_EQ(r[0], 1);
+        ASSERT_EQ(r[1], 20);
+        ASSERT_EQ(r[2], 4);
+        ASSERT_EQ(r[3], 2);
+        ASSERT_EQ(r[4], 3);
+    }
+
+    {
+        auto r = f.find_route_without_turn_around(1, 3, step_limit);
+        ASSERT_EQ(r.size(), 5);
+        ASSERT_EQ(r[0], 1);
+        ASSERT_EQ(r[1], 20);
+        ASSERT_EQ(r[2], 4);
+        ASSERT_EQ(r[3], 5);
+        ASSERT_EQ(r[4], 3);
+    }
+
+    {
+        routx::SearchContext ctx = {};
+        auto r = f.find_route_bidirectional(ctx, 1, 3, step_limit);
+        ASSERT_EQ(r.size(), 5);
+        ASSERT_EQ(r[0], 1);
+        ASSERT_EQ(r[1], 20);
+        ASSERT_EQ(r[2], 4);
+        ASSERT_EQ(r[3], 2);
+        ASSERT_EQ(r[4], 3);
+    }
+
+    ASSERT_THROW(f.find_route(1, 42), routx::InvalidReference);
+    ASSERT_THROW(f.find_route(1, 3, 1), routx::StepLimitExceeded);
+    ASSERT_THROW(f.find_route_bidirectional(42, 3), routx::InvalidReference);
+    ASSERT_THROW(f.find_route_bidirectional(1, 3, 1), routx::StepLimitExceeded);
+}
+
+TEST(FrozenGraph, FindRouteWithSearchContext) {
+    //   200   200   200
+    // 1─────2─────3─────4
+    //       └─────5─────┘
+    //         100    100
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.02, .lon = 0.01});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.03, .lon = 0.01});
+    g.set_node(routx::Node{.id = 4, .osm_id = 4, .lat = 0.04, .lon = 0.01});
+    g.set_node(routx::Node{.id = 5, .osm_id = 5, .lat = 0.03, .lon = 0.00});
+    g.set_edge(1, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 1, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 5, .cost = 100.0});
+    g.set_edge(3, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(3, routx::Edge{.to = 4, .cost = 200.0});
+    g.set_edge(4, routx::Edge{.to = 3, .cost = 200.0});
+    g.set_edge(4, routx::Edge{.to = 5, .cost = 100.0});
+    g.set_edge(5, routx::Edge{.to = 2, .cost = 100.0});
+    g.set_edge(5, routx::Edge{.to = 4, .cost = 100.0});
+    auto f = g.freeze();
+
+    for (auto kind : {RoutxQueueKindBinary, RoutxQueueKindQuaternary, RoutxQueueKindRadix}) {
+        routx::SearchContext ctx{kind};
+        for (int i = 0; i < 3; ++i) {
+            auto r = f.find_route(ctx, 1, 4);
+            ASSERT_EQ(r.size(), 4);
+            ASSERT_EQ(r[0], 1);
+            ASSERT_EQ(r[1], 2);
+            ASSERT_EQ(r[2], 5);
+            ASSERT_EQ(r[3], 4);
+
+            auto r2 = f.find_route_without_turn_around(ctx, 4, 1);
+            ASSERT_EQ(r2.size(), 4);
+            ASSERT_EQ(r2[0], 4);
+            ASSERT_EQ(r2[1], 5);
+            ASSERT_EQ(r2[2], 2);
+            ASSERT_EQ(r2[3], 1);
+
+            ASSERT_THROW(f.find_route(ctx, 1, 4, 2), routx::StepLimitExceeded);
+            EXPECT_EQ(ctx.stats().settled, 3);
+        }
+    }
+
+    routx::SearchContext ctx = {};
+    ctx.set_timing(true);
+    f.find_route(ctx, 1, 4);
+    auto stats = ctx.stats();
+    EXPECT_GT(stats.settled, 0);
+    EXPECT_GT(stats.relaxed, 0);
+    EXPECT_EQ(stats.pops, stats.settled + stats.stale_pops + 1);  // +1 for the target
+    EXPECT_GE(stats.pushes, stats.pops);
+    EXPECT_GT(stats.elapsed_ns, 0);
+}
+
+TEST(FrozenGraph, FindRouteInto) {
+    //   200   200
+    // 1─────2─────3
+    //       └─────4
+    //         100
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.02, .lon = 0.01});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.03, .lon = 0.01});
+    g.set_node(routx::Node{.id = 4, .osm_id = 4, .lat = 0.02, .lon = 0.00});
+    g.set_edge(1, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 1, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 4, .cost = 100.0});
+    g.set_edge(3, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(4, routx::Edge{.to = 2, .cost = 100.0});
+    auto f = g.freeze();
+    routx::SearchContext ctx = {};
+
+    std::array<int64_t, 2> small = {0, 0};
+    ASSERT_EQ(f.find_route_into(ctx, 1, 3, small), 3);
+    ASSERT_EQ(small[0], 0);
+
+    std::array<int64_t, 4> buffer = {0, 0, 0, 0};
+    ASSERT_EQ(f.find_route_into(ctx, 1, 3, buffer), 3);
+    ASSERT_EQ(buffer[0], 1);
+    ASSERT_EQ(buffer[1], 2);
+    ASSERT_EQ(buffer[2], 3);
+
+    ASSERT_THROW(f.find_route_into(ctx, 1, 42, buffer), routx::InvalidReference);
+    ASSERT_THROW(f.find_route_into(ctx, 1, 3, buffer, 1), routx::StepLimitExceeded);
+
+    std::vector<int64_t> nodes = {42};
+    f.find_route_to(ctx, 4, 1, std::back_inserter(nodes));
+    ASSERT_EQ(nodes.size(), 4);
+    ASSERT_EQ(nodes[0], 42);
+    ASSERT_EQ(nodes[1], 4);
+    ASSERT_EQ(nodes[2], 2);
+    ASSERT_EQ(nodes[3], 1);
+
+    nodes.clear();
+    f.find_route_to(ctx, 3, 3, std::back_inserter(nodes), routx::DEFAULT_STEP_LIMIT, true);
+    ASSERT_EQ(nodes.size(), 1);
+    ASSERT_EQ(nodes[0], 3);
+}
+
+TEST(FrozenGraph, FindRouteDetailed) {
+    //   200   200
+    // 1─────2─────3
+    //       └─────4
+    //         100
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.02, .lon = 0.01});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.03, .lon = 0.01});
+    g.set_node(routx::Node{.id = 4, .osm_id = 4, .lat = 0.02, .lon = 0.00});
+    g.set_edge(1, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 1, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 4, .cost = 100.0});
+    g.set_edge(3, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(4, routx::Edge{.to = 2, .cost = 100.0});
+
+    auto r = g.find_route_detailed(4, 3);
+    ASSERT_EQ(r.size(), 3);
+    EXPECT_EQ(r.ids, (std::vector<int64_t>{4, 2, 3}));
+    EXPECT_EQ(r.lats, (std::vector<float>{0.02f, 0.02f, 0.03f}));
+    EXPECT_EQ(r.lons, (std::vector<float>{0.00f, 0.01f, 0.01f}));
+    EXPECT_EQ(r.costs, (std::vector<float>{0.0f, 100.0f, 300.0f}));
+    EXPECT_EQ(r.total_cost(), 300.0f);
+    ASSERT_THROW(g.find_route_detailed(4, 42), routx::InvalidReference);
+
+    auto f = g.freeze();
+    routx::SearchContext ctx = {};
+    routx::RouteDetailed r2 = {};
+    f.find_route_detailed(ctx, 4, 3, r2);
+    EXPECT_EQ(r2.ids, r.ids);
+    EXPECT_EQ(r2.lats, r.lats);
+    EXPECT_EQ(r2.lons, r.lons);
+    EXPECT_EQ(r2.costs, r.costs);
+
+    ASSERT_THROW(f.find_route_detailed(ctx, 4, 3, r2, 1), routx::StepLimitExceeded);
+    EXPECT_TRUE(r2.empty());
+
+    auto r3 = f.find_route_detailed(ctx, 1, 3, routx::DEFAULT_STEP_LIMIT, true);
+    EXPECT_EQ(r3.ids, (std::vector<int64_t>{1, 2, 3}));
+    EXPECT_EQ(r3.total_cost(), 400.0f);
+}
+
+TEST(FrozenGraph, Reachable) {
+    //   200   200
+    // 1─────2─────3
+    //       └─────4
+    //         100
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.02, .lon = 0.01});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.03, .lon = 0.01});
+    g.set_node(routx::Node{.id = 4, .osm_id = 4, .lat = 0.02, .lon = 0.00});
+    g.set_edge(1, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 1, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 4, .cost = 100.0});
+    g.set_edge(3, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(4, routx::Edge{.to = 2, .cost = 100.0});
+    auto f = g.freeze();
+    routx::SearchContext ctx = {};
+
+    std::vector<std::pair<int64_t, float>> reached;
+    auto count = f.reachable(ctx, 1, 300.0,
+                             [&](int64_t id, float cost) { reached.emplace_back(id, cost); });
+    ASSERT_EQ(count, 3);
+    ASSERT_EQ(reached.size(), 3);
+    EXPECT_EQ(reached[0], std::make_pair(int64_t{1}, 0.0f));
+    EXPECT_EQ(reached[1], std::make_pair(int64_t{2}, 200.0f));
+    EXPECT_EQ(reached[2], std::make_pair(int64_t{4}, 300.0f));
+
+    ASSERT_THROW(f.reachable(ctx, 42, 300.0, [](int64_t, float) {}), routx::InvalidReference);
+    ASSERT_THROW(f.reachable(ctx, 1, 300.0, [](int64_t, float) {}, 2), routx::StepLimitExceeded);
+    ASSERT_THROW(f.reachable(ctx, 1, 300.0, [](int64_t, float) { throw std::runtime_error(""); }),
+                 std::runtime_error);
+
+    auto hull = f.reachable_hull(ctx, 1, 1000.0);
+    ASSERT_EQ(hull.size(), 3);
+    EXPECT_EQ(hull[0].id, 4);
+    EXPECT_EQ(hull[1].id, 1);
+    EXPECT_EQ(hull[2].id, 3);
+}
+
+TEST(FrozenGraph, CostOverlay) {
+    //   200   200
+    // 1─────2─────3
+    //  └────500────┘
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.01, .lon = 0.02});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.01, .lon = 0.03});
+    g.set_edge(1, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(1, routx::Edge{.to = 3, .cost = 500.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 200.0});
+    auto f = g.freeze();
+    ASSERT_EQ(f.edge_count(), 3);
+
+    routx::CostOverlay overlay{f};
+    auto base_epoch = overlay.epoch();
+    ASSERT_NE(base_epoch, 0);
+    auto before = overlay.snapshot();
+
+    routx::EdgeFactor const updates[] = {{.from = 2, .to = 3, .factor = 3.0}};
+    auto epoch = overlay.update_factors(updates);
+    ASSERT_GT(epoch, base_epoch);
+    ASSERT_EQ(overlay.epoch(), epoch);
+
+    auto after = overlay.snapshot();
+    EXPECT_FLOAT_EQ(after.get_edge(2, 3), 600.0);
+    EXPECT_FLOAT_EQ(before.get_edge(2, 3), 200.0);
+    EXPECT_FLOAT_EQ(f.get_edge(2, 3), 200.0);
+
+    auto route = after.find_route(1, 3);
+    ASSERT_EQ(route.size(), 2);
+    EXPECT_EQ(route[1], 3);
+
+    float const wrong_size[] = {1.0, 1.0};
+    EXPECT_EQ(overlay.set_factors(wrong_size), 0);
+    EXPECT_EQ(overlay.epoch(), epoch);
+}
+
+TEST(Graph, RouteCache) {
+    //   200   200
+    // 1─────2─────3
+    //  └────500────┘
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.01, .lon = 0.02});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.01, .lon = 0.03});
+    g.set_edge(1, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(1, routx::Edge{.to = 3, .cost = 500.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 200.0});
+
+    routx::RouteCache cache{16};
+    {
+        auto r = cache.find_route(g, 1, 3);
+        ASSERT_EQ(r.nodes.size(), 3);
+        EXPECT_EQ(r.nodes[1], 2);
+        EXPECT_FLOAT_EQ(r.cost, 400.0);
+    }
+    {
+        auto r = cache.find_route(g, 1, 3);
+        ASSERT_EQ(r.nodes.size(), 3);
+        EXPECT_FLOAT_EQ(r.cost, 400.0);
+    }
+    EXPECT_EQ(cache.hits(), 1);
+    EXPECT_EQ(cache.misses(), 1);
+    EXPECT_THROW(cache.find_route(g, 1, 42), routx::InvalidReference);
+
+    // Modifying the graph advances its epoch and drops cached routes
+    auto epoch = g.epoch();
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 400.0});
+    EXPECT_GT(g.epoch(), epoch);
+    {
+        auto r = cache.find_route(g, 1, 3);
+        ASSERT_EQ(r.nodes.size(), 2);
+        EXPECT_FLOAT_EQ(r.cost, 500.0);
+    }
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.hits(), 1);
+    EXPECT_EQ(cache.misses(), 3);
+}
+
+TEST(FrozenGraph, RouteCacheWithOverlay) {
+    //   200   200
+    // 1─────2─────3
+    //  └────500────┘
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.01, .lon = 0.02});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.01, .lon = 0.03});
+    g.set_edge(1, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(1, routx::Edge{.to = 3, .cost = 500.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 200.0});
+    routx::CostOverlay overlay{g.freeze()};
+
+    routx::RouteCache cache{16};
+    EXPECT_EQ(cache.find_route(overlay, 1, 3, RoutxRouteKindShortest).nodes.size(), 3);
+    EXPECT_EQ(cache.find_route(overlay, 1, 3, RoutxRouteKindShortest).nodes.size(), 3);
+    EXPECT_EQ(cache.hits(), 1);
+
+    routx::EdgeFactor const updates[] = {{.from = 2, .to = 3, .factor = 3.0}};
+    overlay.update_factors(updates);
+    auto r = cache.find_route(overlay, 1, 3, RoutxRouteKindShortest);
+    ASSERT_EQ(r.nodes.size(), 2);
+    EXPECT_FLOAT_EQ(r.cost, 500.0);
+    EXPECT_EQ(cache.hits(), 1);
+    EXPECT_EQ(cache.misses(), 2);
+}
+
+TEST(FrozenGraph, CostMatrix) {
+    //   200   200   200
+    // 1─────2─────3─────4
+    //       └─────5─────┘
+    //         100    100
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.02, .lon = 0.01});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.03, .lon = 0.01});
+    g.set_node(routx::Node{.id = 4, .osm_id = 4, .lat = 0.04, .lon = 0.01});
+    g.set_node(routx::Node{.id = 5, .osm_id = 5, .lat = 0.03, .lon = 0.00});
+    g.set_edge(1, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 1, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 5, .cost = 100.0});
+    g.set_edge(3, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(3, routx::Edge{.to = 4, .cost = 200.0});
+    g.set_edge(4, routx::Edge{.to = 3, .cost = 200.0});
+    g.set_edge(4, routx::Edge{.to = 5, .cost = 100.0});
+    g.set_edge(5, routx::Edge{.to = 2, .cost = 100.0});
+    g.set_edge(5, routx::Edge{.to = 4, .cost = 100.0});
+
+    int64_t const sources[] = {1, 4, 42};
+    int64_t const targets[] = {4, 1, 5};
+    auto costs = g.cost_matrix(sources, targets);
+
+    ASSERT_EQ(costs.size(), 9);
+    EXPECT_FLOAT_EQ(costs[0], 400.0);
+    EXPECT_FLOAT_EQ(costs[1], 0.0);
+    EXPECT_FLOAT_EQ(costs[2], 300.0);
+    EXPECT_FLOAT_EQ(costs[3], 0.0);
+    EXPECT_FLOAT_EQ(costs[4], 400.0);
+    EXPECT_FLOAT_EQ(costs[5], 100.0);
+    EXPECT_FLOAT_EQ(costs[6], HUGE_VALF);
+    EXPECT_FLOAT_EQ(costs[7], HUGE_VALF);
+    EXPECT_FLOAT_EQ(costs[8], HUGE_VALF);
+}
+
+TEST(FrozenGraph, FindRoutesParallel) {
+    //   200   200   200
+    // 1─────2─────3─────4
+    //       └─────5─────┘
+    //         100    100
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.02, .lon = 0.01});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.03, .lon = 0.01});
+    g.set_node(routx::Node{.id = 4, .osm_id = 4, .lat = 0.04, .lon = 0.01});
+    g.set_node(routx::Node{.id = 5, .osm_id = 5, .lat = 0.03, .lon = 0.00});
+    g.set_edge(1, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 1, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 5, .cost = 100.0});
+    g.set_edge(3, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(3, routx::Edge{.to = 4, .cost = 200.0});
+    g.set_edge(4, routx::Edge{.to = 3, .cost = 200.0});
+    g.set_edge(4, routx::Edge{.to = 5, .cost = 100.0});
+    g.set_edge(5, routx::Edge{.to = 2, .cost = 100.0});
+    g.set_edge(5, routx::Edge{.to = 4, .cost = 100.0});
+    auto f = g.freeze();
+
+    std::vector<std::pair<int64_t, int64_t>> pairs = {};
+    for (int i = 0; i < 64; ++i) pairs.emplace_back(i % 4 == 3 ? 42 : 1, 4);
+
+    auto results = f.find_routes_parallel(pairs, routx::DEFAULT_STEP_LIMIT, false, 4);
+    ASSERT_EQ(results.size(), pairs.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (i % 4 == 3) {
+            ASSERT_TRUE(std::holds_alternative<routx::InvalidReference>(results[i]));
+        } else {
+            ASSERT_TRUE(std::holds_alternative<routx::Route>(results[i]));
+            auto const& r = std::get<routx::Route>(results[i]);
+            ASSERT_EQ(r.size(), 4);
+            ASSERT_EQ(r[0], 1);
+            ASSERT_EQ(r[1], 2);
+            ASSERT_EQ(r[2], 5);
+            ASSERT_EQ(r[3], 4);
+        }
+    }
+
+    auto limited = f.find_routes_parallel(pairs, 1, true);
+    ASSERT_EQ(limited.size(), pairs.size());
+    ASSERT_TRUE(std::holds_alternative<routx::StepLimitExceeded>(limited[0]));
+}
+
+/// Coroutine type which starts immediately and runs to completion on its own.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+static Detached await_route_length(routx::SearchPool const& pool, routx::FrozenGraph const& g,
+                                   int64_t from, int64_t to, std::promise<size_t>& out) {
+    routx::Route route = co_await pool.find_route(g, from, to);
+    out.set_value(route.size());
+}
+
+TEST(FrozenGraph, FindRouteAsync) {
+    //   200   200   200
+    // 1─────2─────3─────4
+    //       └─────5─────┘
+    //         100    100
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.02, .lon = 0.01});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.03, .lon = 0.01});
+    g.set_node(routx::Node{.id = 4, .osm_id = 4, .lat = 0.04, .lon = 0.01});
+    g.set_node(routx::Node{.id = 5, .osm_id = 5, .lat = 0.03, .lon = 0.00});
+    g.set_edge(1, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 5, .cost = 100.0});
+    g.set_edge(3, routx::Edge{.to = 4, .cost = 200.0});
+    g.set_edge(5, routx::Edge{.to = 4, .cost = 100.0});
+    auto f = g.freeze();
+    routx::SearchPool pool{1};
+
+    auto task = pool.find_route(f, 1, 4);
+    auto route = task.wait();
+    ASSERT_EQ(route.size(), 4);
+    EXPECT_EQ(route[0], 1);
+    EXPECT_EQ(route[1], 2);
+    EXPECT_EQ(route[2], 5);
+    EXPECT_EQ(route[3], 4);
+    EXPECT_TRUE(task.is_done());
+
+    EXPECT_THROW(pool.find_route(f, 1, 42).wait(), routx::InvalidReference);
+
+    std::promise<size_t> awaited;
+    await_route_length(pool, f, 1, 4, awaited);
+    EXPECT_EQ(awaited.get_future().get(), 4);
+
+    // Keep the only worker busy, so that the following searches are queued
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    auto block = [](void* arg) { static_cast<std::shared_future<void>*>(arg)->wait(); };
+    routx::RouteTask blocker{nullptr};
+    do {
+        blocker = pool.find_route(f, 1, 2);
+    } while (!routx_route_task_on_done(blocker.get(), block, &released));
+
+    auto cancelled = pool.find_route(f, 1, 4);
+    cancelled.cancel();
+    auto late = pool.find_route(f, 1, 4, routx::DEFAULT_STEP_LIMIT, std::chrono::microseconds{1});
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    release.set_value();
+
+    EXPECT_THROW(cancelled.wait(), routx::Cancelled);
+    EXPECT_THROW(late.wait(), routx::DeadlineExceeded);
+    EXPECT_EQ(blocker.wait().size(), 2);
+}
+
+TEST(Graph, SharedGraph) {
+    // 1─────2─────3─────4─────5
+    //        200 (each)
+    auto line = [](int64_t len) {
+        routx::Graph g = {};
+        for (int64_t id = 1; id <= len; ++id) {
+            g.set_node(routx::Node{.id = id, .osm_id = id, .lat = 0.0, .lon = 0.001f * id});
+            if (id > 1) g.set_edge(id - 1, routx::Edge{.to = id, .cost = 200.0});
+        }
+        return g;
+    };
+
+    routx::Graph g = line(5);
+    routx::SharedGraph shared{std::move(g)};
+    ASSERT_EQ(g.get(), nullptr);
+    ASSERT_EQ(shared.use_count(), 1);
+    ASSERT_EQ(shared.view().size(), 5);
+
+    routx::GraphSlot slot{shared};
+    ASSERT_EQ(shared.use_count(), 2);
+
+    std::vector<std::thread> readers = {};
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&slot]() {
+            for (int j = 0; j < 100; ++j) {
+                routx::SharedGraph g = slot.load();
+                auto view = g.view();
+                auto len = static_cast<int64_t>(view.size());
+                auto route = view.find_route(1, len);
+                EXPECT_EQ(route.size(), len);
+                EXPECT_EQ(view.find_nearest_node(0.0, 0.00101).id, 1);
+                EXPECT_EQ(routx::KDTree::build(view).find_nearest_node(0.0, 0.00199).id, 2);
+            }
+        });
+    }
+    for (int64_t len = 2; len <= 20; ++len) {
+        ASSERT_TRUE(slot.store(routx::SharedGraph{line(len)}));
+    }
+    for (auto& reader : readers) reader.join();
+
+    // The first graph is only referenced by `shared` after being replaced in the slot
+    EXPECT_EQ(shared.use_count(), 1);
+    EXPECT_EQ(slot.load().view().size(), 20);
+
+    routx::SharedGraph copy = shared;
+    EXPECT_EQ(copy.use_count(), 2);
+    EXPECT_EQ(copy.view().get(), shared.view().get());
+
+    // Assigning to a view could replace the handle owned by a Graph
+    static_assert(std::is_copy_constructible_v<routx::GraphView>);
+    static_assert(!std::is_copy_assignable_v<routx::GraphView>);
+    static_assert(!std::is_move_assignable_v<routx::GraphView>);
+    static_assert(std::is_move_assignable_v<routx::Graph>);
+}
+
+TEST(CHGraph, FindRoute) {
+    // 1
+    // │
+    // │10
+    // │ 10
+    // 2─────4
+    // │     │
+    // │10   │100
+    // │ 10  │
+    // 3─────5
+    // mandatory 1-2-4
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.00, .lon = 0.02});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.00, .lon = 0.01});
+    g.set_node(routx::Node{.id = 20, .osm_id = 2, .lat = 0.00, .lon = 0.01});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.00, .lon = 0.00});
+    g.set_node(routx::Node{.id = 4, .osm_id = 4, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 5, .osm_id = 5, .lat = 0.01, .lon = 0.00});
+    g.set_edge(1, routx::Edge{.to = 20, .cost = 10.0});
+    g.set_edge(2, routx::Edge{.to = 1, .cost = 10.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 10.0});
+    g.set_edge(2, routx::Edge{.to = 4, .cost = 10.0});
+    g.set_edge(20, routx::Edge{.to = 4, .cost = 10.0});
+    g.set_edge(3, routx::Edge{.to = 2, .cost = 10.0});
+    g.set_edge(3, routx::Edge{.to = 5, .cost = 10.0});
+    g.set_edge(4, routx::Edge{.to = 2, .cost = 10.0});
+    g.set_edge(4, routx::Edge{.to = 5, .cost = 100.0});
+    g.set_edge(5, routx::Edge{.to = 3, .cost = 10.0});
+    g.set_edge(5, routx::Edge{.to = 4, .cost = 100.0});
+
+    auto ch = g.build_ch();
+    ASSERT_EQ(ch.size(), 6);
+
+    routx::SearchContext ctx = {};
+    for (int i = 0; i < 2; ++i) {
+        auto r = ch.find_route(ctx, 1, 3);
+        ASSERT_EQ(r.size(), 5);
+        ASSERT_EQ(r[0], 1);
+        ASSERT_EQ(r[1], 20);
+        ASSERT_EQ(r[2], 4);
+        ASSERT_EQ(r[3], 2);
+        ASSERT_EQ(r[4], 3);
+    }
+
+    ASSERT_THROW(ch.find_route(1, 42), routx::InvalidReference);
+}
+
 class TemporaryFile {
    public:
     TemporaryFile() : m_path(std::tmpnam(nullptr)) {}
@@ -350,6 +1008,193 @@ class TemporaryFile {
     std::string m_path;
 };
 
+TEST(Landmarks, FindRoute) {
+    // 1
+    // │
+    // │10
+    // │ 10
+    // 2─────4
+    // │     │
+    // │10   │100
+    // │ 10  │
+    // 3─────5
+    // mandatory 1-2-4
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.00, .lon = 0.02});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.00, .lon = 0.01});
+    g.set_node(routx::Node{.id = 20, .osm_id = 2, .lat = 0.00, .lon = 0.01});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.00, .lon = 0.00});
+    g.set_node(routx::Node{.id = 4, .osm_id = 4, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 5, .osm_id = 5, .lat = 0.01, .lon = 0.00});
+    g.set_edge(1, routx::Edge{.to = 20, .cost = 10.0});
+    g.set_edge(2, routx::Edge{.to = 1, .cost = 10.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 10.0});
+    g.set_edge(2, routx::Edge{.to = 4, .cost = 10.0});
+    g.set_edge(20, routx::Edge{.to = 4, .cost = 10.0});
+    g.set_edge(3, routx::Edge{.to = 2, .cost = 10.0});
+    g.set_edge(3, routx::Edge{.to = 5, .cost = 10.0});
+    g.set_edge(4, routx::Edge{.to = 2, .cost = 10.0});
+    g.set_edge(4, routx::Edge{.to = 5, .cost = 100.0});
+    g.set_edge(5, routx::Edge{.to = 3, .cost = 10.0});
+    g.set_edge(5, routx::Edge{.to = 4, .cost = 100.0});
+
+    auto fg = g.freeze();
+    auto built = fg.build_landmarks(2);
+    ASSERT_EQ(built.size(), 2);
+
+    TemporaryFile temp_file = {};
+    built.save(temp_file.path().c_str());
+    auto lm = routx::Landmarks::load(temp_file.path().c_str());
+    ASSERT_EQ(lm.size(), 2);
+
+    routx::SearchContext ctx = {};
+    {
+        auto r = fg.find_route(ctx, lm, 1, 3);
+        ASSERT_EQ(r.size(), 5);
+        ASSERT_EQ(r[0], 1);
+        ASSERT_EQ(r[1], 20);
+        ASSERT_EQ(r[2], 4);
+        ASSERT_EQ(r[3], 2);
+        ASSERT_EQ(r[4], 3);
+    }
+    {
+        auto r = fg.find_route_without_turn_around(ctx, lm, 1, 3);
+        ASSERT_EQ(r.size(), 5);
+        ASSERT_EQ(r[0], 1);
+        ASSERT_EQ(r[1], 20);
+        ASSERT_EQ(r[2], 4);
+        ASSERT_EQ(r[3], 5);
+        ASSERT_EQ(r[4], 3);
+    }
+
+    ASSERT_THROW(routx::Landmarks::load("/nonexistent/landmarks.bin"), routx::IoFailed);
+}
+
+TEST(FrozenGraph, SaveAndOpenMmap) {
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.02, .lon = 0.01});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.03, .lon = 0.01});
+    g.set_edge(1, routx::Edge{.to = 2, .cost = 200.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 150.0});
+
+    TemporaryFile temp_file = {};
+    g.save(temp_file.path().c_str());
+
+    auto f = routx::FrozenGraph::open_mmap(temp_file.path().c_str());
+    ASSERT_EQ(f.size(), 3);
+    EXPECT_EQ(f.get_node(2).lat, 0.02f);
+    EXPECT_EQ(f.get_edge(2, 3), 150.0f);
+
+    auto r = f.find_route(1, 3);
+    ASSERT_EQ(r.size(), 3);
+    EXPECT_EQ(r[0], 1);
+    EXPECT_EQ(r[1], 2);
+    EXPECT_EQ(r[2], 3);
+
+    ASSERT_THROW(routx::FrozenGraph::open_mmap("/nonexistent/graph.bin"), routx::IoFailed);
+}
+
+TEST(FrozenGraph, Compact) {
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.02, .lon = 0.01});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.03, .lon = 0.01});
+    g.set_node(routx::Node{.id = 30, .osm_id = 3, .lat = 0.03, .lon = 0.01});
+    g.set_edge(1, routx::Edge{.to = 2, .cost = 1.25004});
+    g.set_edge(2, routx::Edge{.to = 30, .cost = 1.5});
+
+    auto c = g.freeze().reordered(RoutxNodeOrderHilbert).compact(0.5);
+    ASSERT_EQ(c.size(), 4);
+    EXPECT_EQ(c.edge_count(), 2);
+    EXPECT_EQ(c.get_node(30).osm_id, 3);
+    EXPECT_NEAR(c.get_node(2).lat, 0.02, 1e-7);
+    EXPECT_FLOAT_EQ(c.get_edge(1, 2), 1.5);
+    EXPECT_FLOAT_EQ(c.get_edge(2, 30), 1.5);
+
+    auto fine = g.freeze().compact();
+    EXPECT_NEAR(fine.get_edge(1, 2), 1.25004, routx::DEFAULT_COST_SCALE);
+    EXPECT_GE(fine.get_edge(1, 2), 1.25004f);
+
+    TemporaryFile temp_file = {};
+    c.save(temp_file.path().c_str());
+    auto mapped = routx::CompactGraph::open_mmap(temp_file.path().c_str());
+
+    routx::SearchContext ctx = {};
+    auto r = mapped.find_route(ctx, 1, 30);
+    ASSERT_EQ(r.size(), 3);
+    EXPECT_EQ(r[0], 1);
+    EXPECT_EQ(r[1], 2);
+    EXPECT_EQ(r[2], 30);
+    ASSERT_THROW(mapped.find_route(1, 42), routx::InvalidReference);
+
+    EXPECT_TRUE(g.freeze().compact(0.0).is_empty());
+}
+
+TEST(FrozenGraph, Reordered) {
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.03, .lon = 0.01});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.02, .lon = 0.01});
+    g.set_edge(1, routx::Edge{.to = 3, .cost = 200.0});
+    g.set_edge(3, routx::Edge{.to = 2, .cost = 150.0});
+
+    auto f = g.freeze().reordered(RoutxNodeOrderHilbert);
+    ASSERT_EQ(f.size(), 3);
+    EXPECT_EQ(f.get_node(2).lat, 0.03f);
+    EXPECT_EQ(f.get_edge(3, 2), 150.0f);
+
+    TemporaryFile temp_file = {};
+    f.save(temp_file.path().c_str());
+    auto mapped = routx::FrozenGraph::open_mmap(temp_file.path().c_str());
+
+    auto r = mapped.find_route(1, 2);
+    ASSERT_EQ(r.size(), 3);
+    EXPECT_EQ(r[0], 1);
+    EXPECT_EQ(r[1], 3);
+    EXPECT_EQ(r[2], 2);
+}
+
+TEST(FrozenGraph, TiledGraph) {
+    // 1─────2─────3, every node in a different 1° tile
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.9, .lon = 0.9});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.9, .lon = 1.1});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 1.1, .lon = 1.1});
+    g.set_edge(1, routx::Edge{.to = 2, .cost = 30.0});
+    g.set_edge(2, routx::Edge{.to = 1, .cost = 30.0});
+    g.set_edge(2, routx::Edge{.to = 3, .cost = 30.0});
+    g.set_edge(3, routx::Edge{.to = 2, .cost = 30.0});
+
+    TemporaryFile temp_dir = {};
+    routx::TiledGraph::save(g.freeze(), temp_dir.path().c_str(), routx::DEFAULT_TILE_SIZE);
+
+    {
+        auto tiled = routx::TiledGraph::open(temp_dir.path().c_str(), 0);
+        ASSERT_EQ(tiled.size(), 3);
+        EXPECT_EQ(tiled.stats().tiles, 3);
+        EXPECT_EQ(tiled.stats().loads, 0);
+
+        auto r = tiled.find_route(1, 3);
+        ASSERT_EQ(r.size(), 3);
+        EXPECT_EQ(r[0], 1);
+        EXPECT_EQ(r[1], 2);
+        EXPECT_EQ(r[2], 3);
+        ASSERT_THROW(tiled.find_route(1, 42), routx::InvalidReference);
+
+        // With a zero budget, only the most recently used tile stays loaded
+        auto stats = tiled.stats();
+        EXPECT_EQ(stats.loaded_tiles, 1);
+        EXPECT_EQ(stats.evictions, stats.loads - 1);
+
+        EXPECT_EQ(tiled.get_node(3).lat, 1.1f);
+        EXPECT_EQ(tiled.find_nearest_node(1.02, 0.95).id, 1);
+    }
+
+    std::filesystem::remove_all(temp_dir.path());
+    ASSERT_THROW(routx::TiledGraph::open(temp_dir.path().c_str(), 0), routx::IoFailed);
+}
+
 TEST(Graph, AddFromOsmFile) {
     // Create a temporary file fixture and write its content
     TemporaryFile temp_file = {};
@@ -361,10 +1206,33 @@ TEST(Graph, AddFromOsmFile) {
         .profile = routx::osm::ProfileCar,
         .file_format = RoutxOsmFormatXml,
         .bbox = {0},
+        .threads = 0,
     };
+    auto before = routx::osm::ingest_stats();
     g.add_from_osm_file(&o, temp_file.path().c_str());
+    auto after = routx::osm::ingest_stats();
 
     EXPECT_EQ(g.size(), 6);
+    EXPECT_GT(after.nodes, before.nodes);
+    EXPECT_GT(after.ways, before.ways);
+}
+
+TEST(Graph, AddFromOsmFileTwoPass) {
+    TemporaryFile temp_file = {};
+    std::ofstream(temp_file.path()) << osm_file_fixture;
+
+    routx::Graph g = {};
+    routx::osm::Options o = {
+        .profile = routx::osm::ProfileCar,
+        .file_format = RoutxOsmFormatUnknown,
+        .bbox = {0},
+        .threads = 0,
+    };
+    g.add_from_osm_file_two_pass(&o, temp_file.path().c_str());
+
+    EXPECT_EQ(g.size(), 6);
+    EXPECT_THROW(g.add_from_osm_file_two_pass(&o, "non_existing_file.osm"),
+                 routx::osm::LoadingFailed);
 }
 
 TEST(Graph, AddFromOsmFileError) {
@@ -373,6 +1241,7 @@ TEST(Graph, AddFromOsmFileError) {
         .profile = routx::osm::ProfileCar,
         .file_format = RoutxOsmFormatUnknown,
         .bbox = {0},
+        .threads = 0,
     };
 
     EXPECT_THROW(g.add_from_osm_file(&o, "non_existing_file.osm"), routx::osm::LoadingFailed);
@@ -384,6 +1253,7 @@ TEST(Graph, AddFromOsmMemory) {
         .profile = routx::osm::ProfileCar,
         .file_format = RoutxOsmFormatXml,
         .bbox = {0},
+        .threads = 0,
     };
     g.add_from_osm_memory(&o, osm_file_fixture.data(), osm_file_fixture.size());
 
@@ -411,12 +1281,53 @@ TEST(Graph, AddFromOsmCustomProfile) {
         .profile = &p,
         .file_format = RoutxOsmFormatXml,
         .bbox = {0},
+        .threads = 0,
     };
     g.add_from_osm_memory(&o, osm_file_fixture.data(), osm_file_fixture.size());
 
     EXPECT_EQ(g.size(), 4);
 }
 
+TEST(Graph, AddFromOsmCompiledProfile) {
+    std::optional<routx::osm::CompiledProfile> compiled = {};
+    {
+        routx::osm::Penalty penalties[2] = {
+            {.key = "highway", .value = "tertiary", .penalty = 1.0},
+            {.key = "highway", .value = "residential", .penalty = 2.0},
+        };
+        char const* access[2] = {"access", "vehicle"};
+        routx::osm::Profile p = {
+            .name = "car",
+            .penalties = penalties,
+            .penalties_len = 2,
+            .access = access,
+            .access_len = 2,
+            .disallow_motorroad = false,
+            .disable_restrictions = true,
+        };
+        compiled.emplace(&p);
+    }
+
+    routx::osm::Options o = {
+        .profile = nullptr,
+        .file_format = RoutxOsmFormatXml,
+        .bbox = {0},
+        .threads = 0,
+    };
+
+    // The compiled profile outlives the original one, and can be reused
+    for (int i = 0; i < 2; ++i) {
+        routx::Graph g = {};
+        g.add_from_osm_memory(&o, *compiled, osm_file_fixture.data(), osm_file_fixture.size());
+        EXPECT_EQ(g.size(), 4);
+    }
+
+    routx::Graph g = {};
+    g.add_from_osm_memory(&o, routx::osm::CompiledProfile(routx::osm::ProfileCar),
+                          osm_file_fixture.data(), osm_file_fixture.size());
+    EXPECT_EQ(g.size(), 6);
+}
+
 TEST(Utility, EarthDistance) {
     float centrum_lat = 52.23024;
     float centrum_lon = 21.01062;
@@ -433,6 +1344,19 @@ TEST(Utility, EarthDistance) {
                 15.692483, 1e-6);
 }
 
+TEST(Utility, EarthDistanceMany) {
+    std::vector<float> lats = {52.23852, 52.16125, 52.23024};
+    std::vector<float> lons = {21.0446, 21.21147, 21.01062};
+
+    auto distances = routx::earth_distance_many(52.23024, 21.01062, lats, lons);
+    ASSERT_EQ(distances.size(), 3);
+    for (size_t i = 0; i < distances.size(); ++i) {
+        float exact = routx::earth_distance(52.23024, 21.01062, lats[i], lons[i]);
+        EXPECT_NEAR(distances[i], exact, exact * ROUTX_EARTH_DISTANCE_APPROX_MAX_ERROR + 1e-6);
+    }
+    EXPECT_EQ(distances[2], 0.0f);
+}
+
 TEST(Utility, KDTree) {
     routx::Graph g = {};
     g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
@@ -450,4 +1374,71 @@ TEST(Utility, KDTree) {
     EXPECT_EQ(kd.find_nearest_node(0.05, 0.03).id, 4);
     EXPECT_EQ(kd.find_nearest_node(0.05, 0.08).id, 5);
     EXPECT_EQ(kd.find_nearest_node(0.09, 0.06).id, 8);
+
+    auto nearest = kd.find_k_nearest(0.05, 0.03, 3);
+    ASSERT_EQ(nearest.size(), 3);
+    EXPECT_EQ(nearest[0].id, 4);
+    EXPECT_EQ(nearest[1].id, 6);
+    EXPECT_EQ(nearest[2].id, 7);
+
+    std::vector<float> lats = {0.02, 0.05, 0.05, 0.09};
+    std::vector<float> lons = {0.02, 0.03, 0.08, 0.06};
+    auto nodes = kd.find_nearest_nodes(lats, lons, 2);
+    ASSERT_EQ(nodes.size(), 4);
+    EXPECT_EQ(nodes[0].id, 1);
+    EXPECT_EQ(nodes[1].id, 4);
+    EXPECT_EQ(nodes[2].id, 5);
+    EXPECT_EQ(nodes[3].id, 8);
+}
+
+TEST(Utility, GridIndex) {
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = 0.01, .lon = 0.01});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = 0.01, .lon = 0.05});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = 0.03, .lon = 0.09});
+    g.set_node(routx::Node{.id = 4, .osm_id = 4, .lat = 0.04, .lon = 0.03});
+    g.set_node(routx::Node{.id = 5, .osm_id = 5, .lat = 0.04, .lon = 0.07});
+    g.set_node(routx::Node{.id = 6, .osm_id = 6, .lat = 0.07, .lon = 0.03});
+    g.set_node(routx::Node{.id = 7, .osm_id = 7, .lat = 0.07, .lon = 0.01});
+    g.set_node(routx::Node{.id = 8, .osm_id = 8, .lat = 0.08, .lon = 0.05});
+    g.set_node(routx::Node{.id = 9, .osm_id = 9, .lat = 0.08, .lon = 0.09});
+
+    auto index = routx::GridIndex::build(g, 1000.0f);
+    EXPECT_EQ(index.find_nearest_node(0.02, 0.02).id, 1);
+    EXPECT_EQ(index.find_nearest_node(0.05, 0.03).id, 4);
+    EXPECT_EQ(index.find_nearest_node(0.05, 0.08).id, 5);
+    EXPECT_EQ(index.find_nearest_node(0.09, 0.06).id, 8);
+
+    std::vector<float> lats = {0.02, 0.05, 0.05, 0.09};
+    std::vector<float> lons = {0.02, 0.03, 0.08, 0.06};
+    auto nodes = index.find_nearest_nodes(lats, lons, 2);
+    ASSERT_EQ(nodes.size(), 4);
+    EXPECT_EQ(nodes[0].id, 1);
+    EXPECT_EQ(nodes[1].id, 4);
+    EXPECT_EQ(nodes[2].id, 5);
+    EXPECT_EQ(nodes[3].id, 8);
+
+    routx::SnapCache cache(2);
+    EXPECT_EQ(index.find_nearest_node(cache, 0.02, 0.02).id, 1);
+    EXPECT_EQ(index.find_nearest_node(cache, 0.02, 0.02).id, 1);
+    EXPECT_EQ(index.find_nearest_node(cache, 0.05, 0.03).id, 4);
+    EXPECT_EQ(index.find_nearest_node(cache, 0.05, 0.08).id, 5);
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.hits(), 1);
+    EXPECT_EQ(cache.misses(), 3);
+
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(Utility, GridIndexAntimeridian) {
+    routx::Graph g = {};
+    g.set_node(routx::Node{.id = 1, .osm_id = 1, .lat = -17.0, .lon = 179.99});
+    g.set_node(routx::Node{.id = 2, .osm_id = 2, .lat = -17.0, .lon = -179.995});
+    g.set_node(routx::Node{.id = 3, .osm_id = 3, .lat = -17.0, .lon = 178.0});
+
+    auto index = routx::GridIndex::build(g);
+    EXPECT_EQ(index.find_nearest_node(-17.0, -179.999).id, 2);
+    EXPECT_EQ(index.find_nearest_node(-17.0, 179.998).id, 2);
+    EXPECT_EQ(index.find_nearest_node(-17.0, 179.5).id, 1);
 }
@@ -0,0 +1,150 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+//! Bidirectional A* over a [FrozenGraph].
+
+use super::context::{QueueItem, SearchContext};
+use super::frozen::{heuristic, resolve_endpoints};
+use super::stats::count;
+use crate::frozen::NO_INDEX;
+use crate::{AStarError, FrozenGraph};
+
+/// Bidirectional equivalent of [find_route](crate::find_route).
+///
+/// The forward search runs from the start node over outgoing edges, and the backward search
+/// runs from the end node over incoming edges. Both use the average potential
+/// `p(v) = (h(v, to) - h(from, v)) / 2` (and `-p(v)` for the backward search),
+/// which is consistent for both directions, so that the searches can stop as soon as
+/// the sum of their smallest queue keys reaches the cost of the best route found so far.
+///
+/// `step_limit` limits the number of nodes expanded by both searches together.
+pub(crate) fn find_route(
+    g: &FrozenGraph,
+    ctx: &mut SearchContext,
+    from_id: i64,
+    to_id: i64,
+    step_limit: usize,
+) -> Result<Vec<i64>, AStarError> {
+    let (from, to) = resolve_endpoints(g, from_id, to_id)?;
+    let incoming = g.incoming();
+    let potential = |v: u32| (heuristic(g, v, to) - heuristic(g, from, v)) * 0.5;
+
+    let mut best_cost = f32::INFINITY;
+    let mut meeting = NO_INDEX;
+    let mut steps: usize = 0;
+
+    ctx.reset_bidirectional(g.len());
+    ctx.forward.set(from, 0.0, NO_INDEX);
+    ctx.queue.push(QueueItem {
+        at: from,
+        cost: 0.0,
+        score: potential(from),
+    });
+    ctx.backward.set(to, 0.0, NO_INDEX);
+    ctx.backward_queue.push(QueueItem {
+        at: to,
+        cost: 0.0,
+        score: -potential(to),
+    });
+
+    if from == to {
+        best_cost = 0.0;
+        meeting = from;
+    }
+
+    loop {
+        let (Some(forward_top), Some(backward_top)) = (ctx.queue.peek(), ctx.backward_queue.peek())
+        else {
+            break;
+        };
+
+        if forward_top.score + backward_top.score >= best_cost {
+            break;
+        }
+
+        let forward = forward_top.score <= backward_top.score;
+        let item = if forward {
+            ctx.queue.pop().unwrap()
+        } else {
+            ctx.backward_queue.pop().unwrap()
+        };
+
+        // Contrary to the wikipedia definition, we might keep multiple items in the queue for the same node.
+        let labels = if forward { &ctx.forward } else { &ctx.backward };
+        if item.cost > labels.cost(item.at) {
+            count!(ctx.stats.stale_pops);
+            continue;
+        }
+
+        steps += 1;
+        count!(ctx.stats.settled);
+        if steps > step_limit {
+            return Err(AStarError::StepLimitExceeded);
+        }
+        ctx.check_interrupt(steps)?;
+
+        if forward {
+            count!(ctx.stats.relaxed, g.edge_range(item.at).len());
+            for (neighbor, edge_cost) in g.edges_at(item.at) {
+                let neighbor_cost = item.cost + edge_cost;
+                if neighbor_cost >= ctx.forward.cost(neighbor) {
+                    continue;
+                }
+
+                ctx.forward.set(neighbor, neighbor_cost, item.at);
+                ctx.queue.push(QueueItem {
+                    at: neighbor,
+                    cost: neighbor_cost,
+                    score: neighbor_cost + potential(neighbor),
+                });
+
+                let through_cost = neighbor_cost + ctx.backward.cost(neighbor);
+                if through_cost < best_cost {
+                    best_cost = through_cost;
+                    meeting = neighbor;
+                }
+            }
+        } else {
+            for (neighbor, edge_cost) in incoming.edges_at(item.at) {
+                count!(ctx.stats.relaxed);
+                let neighbor_cost = item.cost + edge_cost;
+                if neighbor_cost >= ctx.backward.cost(neighbor) {
+                    continue;
+                }
+
+                ctx.backward.set(neighbor, neighbor_cost, item.at);
+                ctx.backward_queue.push(QueueItem {
+                    at: neighbor,
+                    cost: neighbor_cost,
+                    score: neighbor_cost - potential(neighbor),
+                });
+
+                let through_cost = neighbor_cost + ctx.forward.cost(neighbor);
+                if through_cost < best_cost {
+                    best_cost = through_cost;
+                    meeting = neighbor;
+                }
+            }
+        }
+    }
+
+    if meeting == NO_INDEX {
+        return Ok(vec![]);
+    }
+
+    let mut path = vec![g.ids[meeting as usize]];
+    let mut last = ctx.forward.came_from(meeting);
+    while last != NO_INDEX {
+        path.push(g.ids[last as usize]);
+        last = ctx.forward.came_from(last);
+    }
+    path.reverse();
+
+    let mut last = ctx.backward.came_from(meeting);
+    while last != NO_INDEX {
+        path.push(g.ids[last as usize]);
+        last = ctx.backward.came_from(last);
+    }
+
+    Ok(path)
+}
@@ -0,0 +1,646 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::Arc;
+use std::time::Instant;
+
+use super::queue::{Queue, QueueKind};
+use super::{AStarError, RouteDetailed, SearchStats};
+use crate::frozen::NO_INDEX;
+use crate::Node;
+
+#[derive(Debug, Clone, Copy)]
+pub(crate) struct QueueItem {
+    pub(crate) at: u32,
+    pub(crate) cost: f32,
+    pub(crate) score: f32,
+}
+
+impl PartialEq for QueueItem {
+    fn eq(&self, other: &Self) -> bool {
+        self.score.eq(&other.score)
+    }
+}
+
+impl PartialOrd for QueueItem {
+    fn partial_cmp(&self, other: &Self) -> Option<std::cmp::Ordering> {
+        // NOTE: We revert the order of comparison,
+        // as lower scores are considered better ("higher"),
+        // and Rust's BinaryHeap is a max-heap.
+        other.score.partial_cmp(&self.score)
+    }
+
+    // NOTE: Comparison operators are used by the heap, and are overridden to avoid
+    //       going through Option<Ordering> in the hot loop.
+
+    #[inline]
+    fn lt(&self, other: &Self) -> bool {
+        other.score < self.score
+    }
+
+    #[inline]
+    fn le(&self, other: &Self) -> bool {
+        other.score <= self.score
+    }
+
+    #[inline]
+    fn gt(&self, other: &Self) -> bool {
+        other.score > self.score
+    }
+
+    #[inline]
+    fn ge(&self, other: &Self) -> bool {
+        other.score >= self.score
+    }
+}
+
+impl Eq for QueueItem {}
+
+impl Ord for QueueItem {
+    fn cmp(&self, other: &Self) -> std::cmp::Ordering {
+        other.partial_cmp(self).unwrap()
+    }
+}
+
+/// Number of settled states between checks of the [CancelToken] and the deadline
+/// of a [SearchContext].
+const INTERRUPT_INTERVAL: usize = 256;
+
+/// Shared flag which stops searches running on other threads,
+/// see [SearchContext::set_cancel_token].
+///
+/// Clones of a token share the same flag, and cancelling is permanent.
+#[derive(Debug, Default, Clone)]
+pub struct CancelToken(Arc<AtomicBool>);
+
+impl CancelToken {
+    /// Creates a new, not cancelled token.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Cancels all searches using this token (or any of its clones).
+    pub fn cancel(&self) {
+        self.0.store(true, Ordering::Relaxed);
+    }
+
+    /// Returns `true` if the token was cancelled.
+    pub fn is_cancelled(&self) -> bool {
+        self.0.load(Ordering::Relaxed)
+    }
+}
+
+/// Reusable workspace for route searches over a [FrozenGraph](crate::FrozenGraph).
+///
+/// A SearchContext keeps its priority queue and per-state labels (known cost and predecessor)
+/// between searches. Labels are stored in dense arrays stamped with a search generation -
+/// starting a new search only increments the generation, which invalidates all labels
+/// from the previous search in O(1). Once the arrays have grown to fit the graph,
+/// searches don't allocate anything except for the returned route.
+///
+/// The kind of the priority queue can be selected with [SearchContext::with_queue].
+/// Large searches (over hundreds of thousands of nodes) usually run faster
+/// with [QueueKind::Radix].
+///
+/// Counters of the work done by the last search are available through [SearchContext::stats].
+///
+/// Searches can be stopped from other threads with a [CancelToken], or limited in time
+/// with a deadline. Both are checked every few hundred settled states, alongside
+/// the step limit.
+///
+/// A SearchContext may be used with different graphs, but only by one search at a time.
+/// Multi-threaded applications should keep one context per thread.
+///
+/// # Example
+///
+/// ```no_run
+/// let g = routx::Graph::new().freeze();
+/// let mut ctx = routx::SearchContext::new();
+///
+/// for (from, to) in [(1, 2), (3, 4), (5, 6)] {
+///     let route = g.find_route_with_context(&mut ctx, from, to, routx::DEFAULT_STEP_LIMIT);
+///     // ...
+/// }
+/// ```
+#[derive(Debug, Default, Clone)]
+pub struct SearchContext {
+    /// Labels of a forward (or unidirectional) search.
+    pub(crate) forward: Labels,
+
+    /// Queue of a forward (or unidirectional) search.
+    pub(crate) queue: Queue,
+
+    /// Labels of the backward half of a bidirectional search.
+    pub(crate) backward: Labels,
+
+    /// Queue of the backward half of a bidirectional search.
+    pub(crate) backward_queue: Queue,
+
+    /// Route found by the last search of the C API, which lends it to the caller
+    /// instead of transferring ownership of a new vector.
+    pub(crate) route: Vec<i64>,
+
+    /// Same as [SearchContext::route], but for detailed routes.
+    pub(crate) route_detailed: RouteDetailed,
+
+    /// Nodes reached by the last reachability search, used to compute its hull.
+    pub(crate) reached: Vec<Node>,
+
+    /// Hull of the last reachability search of the C API.
+    pub(crate) hull: Vec<Node>,
+
+    /// Settled arrivals at nodes of a search over edge states.
+    pub(crate) arrivals: Arrivals,
+
+    /// Counters of the last search, except for the ones kept by the queues.
+    pub(crate) stats: SearchStats,
+
+    /// Whether the wall time of searches is measured.
+    timing: bool,
+
+    /// Token stopping searches with [AStarError::Cancelled].
+    cancel: Option<CancelToken>,
+
+    /// Instant after which searches fail with [AStarError::DeadlineExceeded].
+    deadline: Option<Instant>,
+}
+
+impl SearchContext {
+    /// Creates a new, empty SearchContext. Its storage is allocated lazily on first use.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Creates a new, empty SearchContext with the provided kind of priority queue.
+    /// Its storage is allocated lazily on first use.
+    pub fn with_queue(kind: QueueKind) -> Self {
+        Self {
+            queue: Queue::new(kind),
+            backward_queue: Queue::new(kind),
+            ..Self::default()
+        }
+    }
+
+    /// Returns the kind of priority queue used by searches with this context.
+    pub fn queue_kind(&self) -> QueueKind {
+        self.queue.kind()
+    }
+
+    /// Returns the counters of the work done by the last search (or the last batch of searches)
+    /// with this context.
+    pub fn stats(&self) -> SearchStats {
+        SearchStats {
+            pushes: self.queue.pushes + self.backward_queue.pushes,
+            pops: self.queue.pops + self.backward_queue.pops,
+            peak_queue_size: self.queue.peak_len + self.backward_queue.peak_len,
+            ..self.stats
+        }
+    }
+
+    /// Enables or disables measuring the wall time of searches,
+    /// see [SearchStats::elapsed_ns]. Disabled by default.
+    pub fn set_timing(&mut self, enabled: bool) {
+        self.timing = enabled;
+    }
+
+    /// Returns `true` if the wall time of searches is measured.
+    pub fn timing(&self) -> bool {
+        self.timing
+    }
+
+    /// Makes searches with this context fail with [AStarError::Cancelled] soon after
+    /// the provided token is cancelled. `None` (the default) disables cancellation.
+    pub fn set_cancel_token(&mut self, token: Option<CancelToken>) {
+        self.cancel = token;
+    }
+
+    /// Makes searches with this context fail with [AStarError::DeadlineExceeded] soon after
+    /// the provided instant. `None` (the default) disables the deadline.
+    ///
+    /// The deadline is checked only while searching, a search which finishes on time
+    /// is never interrupted.
+    pub fn set_deadline(&mut self, deadline: Option<Instant>) {
+        self.deadline = deadline;
+    }
+
+    /// Checks whether a running search should stop, after settling `steps` states.
+    /// The [CancelToken] and the deadline are checked after settling the first state,
+    /// so that an already interrupted search never succeeds, and then every
+    /// [INTERRUPT_INTERVAL] states.
+    #[inline]
+    pub(crate) fn check_interrupt(&self, steps: usize) -> Result<(), AStarError> {
+        if steps % INTERRUPT_INTERVAL == 1 {
+            self.interrupted()
+        } else {
+            Ok(())
+        }
+    }
+
+    /// Checks whether the [CancelToken] was cancelled, or the deadline has passed.
+    pub(crate) fn interrupted(&self) -> Result<(), AStarError> {
+        if self.cancel.as_ref().is_some_and(CancelToken::is_cancelled) {
+            Err(AStarError::Cancelled)
+        } else if self.deadline.is_some_and(|d| Instant::now() >= d) {
+            Err(AStarError::DeadlineExceeded)
+        } else {
+            Ok(())
+        }
+    }
+
+    /// Zeroes all [SearchStats] and runs a search (or a batch of searches)
+    /// of a public entry point, measuring its wall time if enabled.
+    pub(crate) fn measure<T, F: FnOnce(&mut Self) -> T>(&mut self, search: F) -> T {
+        self.stats = SearchStats::default();
+        self.queue.reset_counters();
+        self.backward_queue.reset_counters();
+
+        if !self.timing {
+            return search(self);
+        }
+
+        let start = Instant::now();
+        let result = search(self);
+        self.stats.elapsed_ns = start.elapsed().as_nanos() as u64;
+        result
+    }
+
+    /// Prepares the context for a new unidirectional search over `states` states,
+    /// invalidating all labels and clearing the queue.
+    pub(crate) fn reset(&mut self, states: usize) {
+        self.queue.reset(states);
+        self.forward.reset(states);
+    }
+
+    /// Prepares the context for a new bidirectional search over `states` states,
+    /// invalidating all labels and clearing both queues.
+    pub(crate) fn reset_bidirectional(&mut self, states: usize) {
+        self.queue.reset(states);
+        self.forward.reset(states);
+        self.backward_queue.reset(states);
+        self.backward.reset(states);
+    }
+
+    /// Returns the known cost of reaching a state in the current (forward) search,
+    /// see [Labels::cost].
+    #[inline]
+    pub(crate) fn cost(&self, state: u32) -> f32 {
+        self.forward.cost(state)
+    }
+
+    /// Returns the predecessor of a state in the current (forward) search,
+    /// see [Labels::came_from].
+    #[inline]
+    pub(crate) fn came_from(&self, state: u32) -> u32 {
+        self.forward.came_from(state)
+    }
+
+    /// Sets the known cost and predecessor of a state in the current (forward) search.
+    #[inline]
+    pub(crate) fn set(&mut self, state: u32, cost: f32, came_from: u32) {
+        self.forward.set(state, cost, came_from)
+    }
+}
+
+/// Generation-stamped known costs and predecessors of search states.
+#[derive(Debug, Default, Clone)]
+pub(crate) struct Labels {
+    generation: u32,
+    stamps: Vec<u32>,
+    costs: Vec<f32>,
+    came_from: Vec<u32>,
+}
+
+impl Labels {
+    /// Prepares the labels for a new search over `states` states, invalidating all of them.
+    pub(crate) fn reset(&mut self, states: usize) {
+        if self.stamps.len() < states {
+            // New entries are stamped with 0, which never matches an active generation
+            self.stamps.resize(states, 0);
+            self.costs.resize(states, f32::INFINITY);
+            self.came_from.resize(states, NO_INDEX);
+        }
+
+        self.generation = self.generation.wrapping_add(1);
+        if self.generation == 0 {
+            // Generation counter wrapped around - stale stamps could become valid again
+            self.stamps.fill(0);
+            self.generation = 1;
+        }
+    }
+
+    /// Returns the known cost of reaching a state in the current search,
+    /// or [f32::INFINITY] if the state wasn't reached yet.
+    #[inline]
+    pub(crate) fn cost(&self, state: u32) -> f32 {
+        let state = state as usize;
+        if self.stamps[state] == self.generation {
+            self.costs[state]
+        } else {
+            f32::INFINITY
+        }
+    }
+
+    /// Returns the predecessor of a state in the current search,
+    /// or [NO_INDEX] if the state wasn't reached yet (or is the start state).
+    #[inline]
+    pub(crate) fn came_from(&self, state: u32) -> u32 {
+        let state = state as usize;
+        if self.stamps[state] == self.generation {
+            self.came_from[state]
+        } else {
+            NO_INDEX
+        }
+    }
+
+    /// Sets the known cost and predecessor of a state in the current search.
+    #[inline]
+    pub(crate) fn set(&mut self, state: u32, cost: f32, came_from: u32) {
+        let state = state as usize;
+        self.stamps[state] = self.generation;
+        self.costs[state] = cost;
+        self.came_from[state] = came_from;
+    }
+}
+
+/// Arrival at a node, kept by [Arrivals].
+#[derive(Debug, Clone, Copy)]
+struct Arrival {
+    cost: f32,
+
+    /// Search state (incoming edge index) of the arrival.
+    state: u32,
+
+    /// Search state from which the arrival was made.
+    came_from: u32,
+    expanded: bool,
+
+    /// OSM ID of the node before this arrival, forbidden as the next node.
+    before_osm_id: i64,
+}
+
+const NO_ARRIVAL: Arrival = Arrival {
+    cost: f32::INFINITY,
+    state: NO_INDEX,
+    came_from: NO_INDEX,
+    expanded: false,
+    before_osm_id: 0,
+};
+
+/// Generation-stamped two cheapest arrivals at a node, kept together in a single cache line.
+#[derive(Debug, Clone, Copy)]
+struct NodeArrivals {
+    generation: u32,
+    best: [Arrival; 2],
+}
+
+/// Arrival expanded by [Arrivals::expand].
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(crate) struct Expansion {
+    /// OSM ID of the node before the arrival, forbidden as the next node.
+    pub(crate) before_osm_id: i64,
+
+    /// Set on the second expansion of a node to the OSM ID of the node before the first one.
+    /// All other continuations are cheaper from the first arrival, and can be skipped.
+    pub(crate) only_to_osm_id: Option<i64>,
+}
+
+/// Labels of searches over edge states, where immediate turnarounds are forbidden
+/// (see [find_route_without_turn_around](super::frozen::find_route_without_turn_around)).
+///
+/// An arrival at a node only restricts the next node to be different than the one before it.
+/// Given two arrivals from different previous nodes, every other, costlier arrival can be
+/// continued at a lower cost by one of them, no matter where it goes next. Thus only the two
+/// cheapest arrivals per node need to be kept (and expanded), which makes such searches
+/// almost as fast as searches over nodes. Arrivals are indexed by dense node indices.
+#[derive(Debug, Default, Clone)]
+pub(crate) struct Arrivals {
+    generation: u32,
+    nodes: Vec<NodeArrivals>,
+}
+
+impl Arrivals {
+    /// Prepares the arrivals for a new search over `nodes` nodes, invalidating all of them.
+    pub(crate) fn reset(&mut self, nodes: usize) {
+        if self.nodes.len() < nodes {
+            // New entries are stamped with 0, which never matches an active generation
+            self.nodes.resize(
+                nodes,
+                NodeArrivals {
+                    generation: 0,
+                    best: [NO_ARRIVAL; 2],
+                },
+            );
+        }
+
+        self.generation = self.generation.wrapping_add(1);
+        if self.generation == 0 {
+            // Generation counter wrapped around - stale stamps could become valid again
+            self.nodes.iter_mut().for_each(|n| n.generation = 0);
+            self.generation = 1;
+        }
+    }
+
+    #[inline]
+    fn best_mut(&mut self, node: u32) -> &mut [Arrival; 2] {
+        let n = &mut self.nodes[node as usize];
+        if n.generation != self.generation {
+            n.generation = self.generation;
+            n.best = [NO_ARRIVAL; 2];
+        }
+        &mut n.best
+    }
+
+    /// Records the start of the search at the provided state. As it is not restricted at all,
+    /// it dominates all other arrivals at the start node.
+    pub(crate) fn start(&mut self, node: u32, state: u32) {
+        let start = Arrival {
+            cost: 0.0,
+            state,
+            came_from: NO_INDEX,
+            expanded: false,
+            before_osm_id: 0,
+        };
+        let dominated = Arrival {
+            cost: 0.0,
+            ..NO_ARRIVAL
+        };
+        *self.best_mut(node) = [start, dominated];
+    }
+
+    /// Records an arrival at a node from a node with the provided OSM ID.
+    /// Returns `false` (and records nothing) if the arrival is dominated by known ones.
+    #[inline]
+    pub(crate) fn relax(
+        &mut self,
+        node: u32,
+        state: u32,
+        came_from: u32,
+        before_osm_id: i64,
+        cost: f32,
+    ) -> bool {
+        let arrival = Arrival {
+            cost,
+            state,
+            came_from,
+            expanded: false,
+            before_osm_id,
+        };
+        let [first, second] = self.best_mut(node);
+
+        // NOTE: Expanded arrivals are never replaced, as they might be a part of the route.
+        if before_osm_id == first.before_osm_id {
+            if cost >= first.cost || first.expanded {
+                return false;
+            }
+            *first = arrival;
+        } else if before_osm_id == second.before_osm_id {
+            if cost >= second.cost || second.expanded {
+                return false;
+            }
+            *second = arrival;
+            if second.cost < first.cost {
+                std::mem::swap(first, second);
+            }
+        } else if cost >= second.cost || second.expanded {
+            return false;
+        } else if cost < first.cost {
+            *second = std::mem::replace(first, arrival);
+        } else {
+            *second = arrival;
+        }
+        true
+    }
+
+    /// Checks whether a popped arrival (see [Arrivals::relax]) should be expanded,
+    /// returning `None` if it was replaced by cheaper ones.
+    ///
+    /// Arrivals must be expanded in the order of increasing costs.
+    #[inline]
+    pub(crate) fn expand(&mut self, node: u32, state: u32, cost: f32) -> Option<Expansion> {
+        let n = &mut self.nodes[node as usize];
+        if n.generation != self.generation {
+            return None;
+        }
+
+        let [first, second] = &mut n.best;
+        let (arrival, other) = if first.state == state && first.cost == cost {
+            (first, second)
+        } else if second.state == state && second.cost == cost {
+            (second, first)
+        } else {
+            return None;
+        };
+
+        if arrival.expanded {
+            return None;
+        }
+        arrival.expanded = true;
+        Some(Expansion {
+            before_osm_id: arrival.before_osm_id,
+            only_to_osm_id: if other.expanded {
+                Some(other.before_osm_id)
+            } else {
+                None
+            },
+        })
+    }
+
+    /// Returns the cost and predecessor of an expanded arrival at the provided state.
+    pub(crate) fn came_from(&self, node: u32, state: u32) -> (f32, u32) {
+        let n = &self.nodes[node as usize];
+        debug_assert_eq!(n.generation, self.generation);
+        let arrival = if n.best[0].state == state {
+            &n.best[0]
+        } else {
+            &n.best[1]
+        };
+        debug_assert_eq!(arrival.state, state);
+        (arrival.cost, arrival.came_from)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn reset() {
+        let mut ctx = SearchContext::new();
+        ctx.reset(4);
+        assert_eq!(ctx.cost(2), f32::INFINITY);
+        assert_eq!(ctx.came_from(2), NO_INDEX);
+
+        ctx.set(2, 10.0, 1);
+        assert_eq!(ctx.cost(2), 10.0);
+        assert_eq!(ctx.came_from(2), 1);
+
+        ctx.reset(8);
+        assert_eq!(ctx.cost(2), f32::INFINITY);
+        assert_eq!(ctx.came_from(2), NO_INDEX);
+        assert_eq!(ctx.cost(7), f32::INFINITY);
+    }
+
+    #[test]
+    fn reset_generation_wrap_around() {
+        let mut ctx = SearchContext::new();
+        ctx.reset(4);
+        ctx.set(1, 10.0, 0);
+
+        ctx.forward.generation = u32::MAX;
+        ctx.set(2, 20.0, 0);
+        ctx.reset(4);
+
+        assert_eq!(ctx.forward.generation, 1);
+        assert_eq!(ctx.cost(1), f32::INFINITY);
+        assert_eq!(ctx.cost(2), f32::INFINITY);
+    }
+
+    #[test]
+    fn arrivals() {
+        let mut a = Arrivals::default();
+        a.reset(3);
+        assert!(a.relax(0, 1, 100, 10, 5.0));
+        assert!(!a.relax(0, 1, 100, 10, 6.0));
+        assert!(a.relax(0, 1, 101, 10, 4.0));
+        assert!(a.relax(0, 2, 100, 11, 8.0));
+        assert!(a.relax(0, 3, 100, 12, 7.0));
+        assert!(!a.relax(0, 4, 100, 13, 7.5));
+        assert!(a.relax(0, 4, 100, 13, 3.0));
+
+        assert_eq!(a.expand(0, 3, 7.0), None);
+        assert_eq!(a.expand(0, 1, 5.0), None);
+        assert_eq!(
+            a.expand(0, 4, 3.0),
+            Some(Expansion {
+                before_osm_id: 13,
+                only_to_osm_id: None
+            })
+        );
+        assert_eq!(a.expand(0, 4, 3.0), None);
+        assert_eq!(
+            a.expand(0, 1, 4.0),
+            Some(Expansion {
+                before_osm_id: 10,
+                only_to_osm_id: Some(13)
+            })
+        );
+        assert_eq!(a.came_from(0, 1), (4.0, 101));
+        assert!(!a.relax(0, 5, 100, 14, 5.0));
+
+        a.start(1, 42);
+        assert!(!a.relax(1, 6, 100, 10, 1.0));
+        assert_eq!(
+            a.expand(1, 42, 0.0),
+            Some(Expansion {
+                before_osm_id: 0,
+                only_to_osm_id: None
+            })
+        );
+        assert_eq!(a.came_from(1, 42), (0.0, NO_INDEX));
+
+        a.reset(3);
+        assert_eq!(a.expand(0, 4, 3.0), None);
+        assert!(a.relax(0, 3, 100, 12, 7.0));
+    }
+}
@@ -20,6 +20,17 @@ pub enum AStarError {
     /// which can result in a denial-of-service. The step limit protects
     /// against resource exhaustion.
     StepLimitExceeded,
+
+    /// Route search was stopped by its [CancelToken](crate::CancelToken),
+    /// see [SearchContext::set_cancel_token](crate::SearchContext::set_cancel_token).
+    Cancelled,
+
+    /// Route search has run past its deadline,
+    /// see [SearchContext::set_deadline](crate::SearchContext::set_deadline).
+    DeadlineExceeded,
+
+    /// A tile of a [TiledGraph](crate::TiledGraph) needed by the search couldn't be loaded.
+    TileLoadFailed,
 }
 
 impl std::fmt::Display for AStarError {
@@ -27,6 +38,9 @@ impl std::fmt::Display for AStarError {
         match self {
             Self::InvalidReference(node_id) => write!(f, "invalid node: {}", node_id),
             Self::StepLimitExceeded => write!(f, "step limit exceeded"),
+            Self::Cancelled => write!(f, "search cancelled"),
+            Self::DeadlineExceeded => write!(f, "search deadline exceeded"),
+            Self::TileLoadFailed => write!(f, "failed to load a graph tile"),
         }
     }
 }
@@ -3,6 +3,7 @@
 
 use std::collections::{BinaryHeap, HashMap};
 
+use super::RouteDetailed;
 use crate::{earth_distance, AStarError, Edge, Graph};
 
 #[derive(Debug, Clone, Copy)]
@@ -51,6 +52,12 @@ fn reconstruct_flat_path(came_from: &HashMap<i64, i64>, mut last: i64) -> Vec<i6
     return path;
 }
 
+/// Known predecessors and costs of nodes after a [find_route] search.
+struct FlatLabels {
+    came_from: HashMap<i64, i64>,
+    known_costs: HashMap<i64, f32>,
+}
+
 /// Uses the [A* algorithm](https://en.wikipedia.org/wiki/A*_search_algorithm)
 /// to find the shortest route between two nodes in the provided graph.
 ///
@@ -71,6 +78,43 @@ pub fn find_route(
     to_id: i64,
     step_limit: usize,
 ) -> Result<Vec<i64>, AStarError> {
+    match search(g, from_id, to_id, step_limit)? {
+        Some(labels) => Ok(reconstruct_flat_path(&labels.came_from, to_id)),
+        None => Ok(vec![]),
+    }
+}
+
+/// Same as [find_route], but also returns the position of every node of the route
+/// and the cumulative cost of reaching it.
+///
+/// Costs are taken from the search itself, which avoids looking up every edge of the route
+/// with [Graph::get_edge] afterwards. Returns an empty [RouteDetailed] if there is no route
+/// between the two nodes.
+pub fn find_route_detailed(
+    g: &Graph,
+    from_id: i64,
+    to_id: i64,
+    step_limit: usize,
+) -> Result<RouteDetailed, AStarError> {
+    let mut route = RouteDetailed::default();
+    if let Some(labels) = search(g, from_id, to_id, step_limit)? {
+        for id in reconstruct_flat_path(&labels.came_from, to_id) {
+            let node = g
+                .get_node(id)
+                .expect("route should only contain existing nodes");
+            route.push(id, node.lat, node.lon, labels.known_costs[&id]);
+        }
+    }
+    Ok(route)
+}
+
+/// Runs the [find_route] search, returning its labels if `to_id` was reached.
+fn search(
+    g: &Graph,
+    from_id: i64,
+    to_id: i64,
+    step_limit: usize,
+) -> Result<Option<FlatLabels>, AStarError> {
     assert_ne!(from_id, 0);
     assert_ne!(to_id, 0);
 
@@ -101,7 +145,10 @@ pub fn find_route(
 
     while let Some(item) = queue.pop() {
         if item.at == to_id {
-            return Ok(reconstruct_flat_path(&came_from, to_id));
+            return Ok(Some(FlatLabels {
+                came_from,
+                known_costs,
+            }));
         }
 
         // Contrary to the wikipedia definition, we might keep multiple items in the queue for the same node.
@@ -147,5 +194,5 @@ pub fn find_route(
         }
     }
 
-    return Ok(vec![]);
+    return Ok(None);
 }
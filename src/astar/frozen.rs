@@ -0,0 +1,252 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+//! A* implementations operating over dense node indices of a [FrozenGraph].
+
+use super::context::{QueueItem, SearchContext};
+use super::route::RouteSink;
+use super::stats::count;
+use crate::frozen::NO_INDEX;
+use crate::{earth_distance, AStarError, FrozenGraph};
+
+/// Returns the dense indices of the start and end nodes of a search,
+/// or [AStarError::InvalidReference] if any of them doesn't exist.
+pub(crate) fn resolve_endpoints(
+    g: &FrozenGraph,
+    from_id: i64,
+    to_id: i64,
+) -> Result<(u32, u32), AStarError> {
+    assert_ne!(from_id, 0);
+    assert_ne!(to_id, 0);
+
+    let to = g
+        .index_of(to_id)
+        .ok_or(AStarError::InvalidReference(to_id))?;
+    let from = g
+        .index_of(from_id)
+        .ok_or(AStarError::InvalidReference(from_id))?;
+    Ok((from, to))
+}
+
+/// Crow-flies distance between nodes at the provided dense indices, used as the A* heuristic.
+///
+/// Uses the exact [earth_distance], like edge costs computed by the OSM reader, so that the
+/// heuristic is consistent by the triangle inequality (up to `f32` rounding). The relative
+/// error of [earth_distance_approx](crate::earth_distance_approx) is small, but its absolute
+/// error over long distances exceeds the length of short edges.
+#[inline]
+pub(crate) fn heuristic(g: &FrozenGraph, from: u32, to: u32) -> f32 {
+    earth_distance(
+        g.lats[from as usize],
+        g.lons[from as usize],
+        g.lats[to as usize],
+        g.lons[to as usize],
+    )
+}
+
+/// Dense-index equivalent of [find_route](crate::find_route).
+///
+/// Search states are nodes, so labels in the [SearchContext] are indexed by node indices.
+/// The route is pushed into `path`, which should be empty. Nothing is pushed if no route exists.
+pub(crate) fn find_route<S: RouteSink>(
+    g: &FrozenGraph,
+    ctx: &mut SearchContext,
+    from_id: i64,
+    to_id: i64,
+    step_limit: usize,
+    path: &mut S,
+) -> Result<(), AStarError> {
+    let (from, to) = resolve_endpoints(g, from_id, to_id)?;
+    find_route_between(g, ctx, from, to, step_limit, |v| heuristic(g, v, to), path)
+}
+
+/// [find_route] between two resolved dense indices, with a custom heuristic
+/// (lower bound of the cost from a node to `to`). The heuristic must be consistent.
+pub(crate) fn find_route_between<H: Fn(u32) -> f32, S: RouteSink>(
+    g: &FrozenGraph,
+    ctx: &mut SearchContext,
+    from: u32,
+    to: u32,
+    step_limit: usize,
+    heuristic: H,
+    path: &mut S,
+) -> Result<(), AStarError> {
+    let mut steps: usize = 0;
+
+    ctx.reset(g.len());
+    ctx.queue.push(QueueItem {
+        at: from,
+        cost: 0.0,
+        score: heuristic(from),
+    });
+    ctx.set(from, 0.0, NO_INDEX);
+
+    while let Some(item) = ctx.queue.pop() {
+        if item.at == to {
+            let mut last = to;
+            while last != NO_INDEX {
+                path.push_reversed(g, last, ctx.cost(last));
+                last = ctx.came_from(last);
+            }
+            path.finish();
+            return Ok(());
+        }
+
+        // Contrary to the wikipedia definition, we might keep multiple items in the queue for the same node.
+        if item.cost > ctx.cost(item.at) {
+            count!(ctx.stats.stale_pops);
+            continue;
+        }
+
+        steps += 1;
+        count!(ctx.stats.settled);
+        if steps > step_limit {
+            return Err(AStarError::StepLimitExceeded);
+        }
+        ctx.check_interrupt(steps)?;
+
+        count!(ctx.stats.relaxed, g.edge_range(item.at).len());
+        for (neighbor, edge_cost) in g.edges_at(item.at) {
+            // Check if this is the cheapest way to the neighbor
+            let neighbor_cost = item.cost + edge_cost;
+            if neighbor_cost > ctx.cost(neighbor) {
+                continue;
+            }
+
+            // Push the new item into the queue
+            ctx.set(neighbor, neighbor_cost, item.at);
+            ctx.queue.push(QueueItem {
+                at: neighbor,
+                cost: neighbor_cost,
+                score: neighbor_cost + heuristic(neighbor),
+            });
+        }
+    }
+
+    Ok(())
+}
+
+/// Dense-index equivalent of [find_route_without_turn_around](crate::find_route_without_turn_around).
+///
+/// Instead of (node, previous OSM node) pairs, search states are the edges used to arrive
+/// at a node, with an additional state with index `g.edge_count()` representing the start node.
+/// Only the two cheapest arrivals at every node can lead to the shortest route
+/// (see [Arrivals](super::context::Arrivals)), so their labels are kept in a dense array
+/// indexed by node indices. Every node is fully expanded at most once, as in [find_route].
+pub(crate) fn find_route_without_turn_around<S: RouteSink>(
+    g: &FrozenGraph,
+    ctx: &mut SearchContext,
+    from_id: i64,
+    to_id: i64,
+    step_limit: usize,
+    path: &mut S,
+) -> Result<(), AStarError> {
+    let (from, to) = resolve_endpoints(g, from_id, to_id)?;
+    find_route_without_turn_around_between(
+        g,
+        ctx,
+        from,
+        to,
+        step_limit,
+        |v| heuristic(g, v, to),
+        path,
+    )
+}
+
+/// [find_route_without_turn_around] between two resolved dense indices, with a custom
+/// heuristic, see [find_route_between].
+pub(crate) fn find_route_without_turn_around_between<H: Fn(u32) -> f32, S: RouteSink>(
+    g: &FrozenGraph,
+    ctx: &mut SearchContext,
+    from: u32,
+    to: u32,
+    step_limit: usize,
+    heuristic: H,
+    path: &mut S,
+) -> Result<(), AStarError> {
+    let start_state = g.edge_count() as u32;
+    let mut steps: usize = 0;
+
+    let node_of = |state: u32| -> u32 {
+        if state == start_state {
+            from
+        } else {
+            g.edge_targets[state as usize]
+        }
+    };
+
+    ctx.queue.reset(g.edge_count() + 1);
+    ctx.arrivals.reset(g.len());
+    ctx.arrivals.start(from, start_state);
+    ctx.queue.push(QueueItem {
+        at: start_state,
+        cost: 0.0,
+        score: heuristic(from),
+    });
+
+    while let Some(item) = ctx.queue.pop() {
+        let item_node = node_of(item.at);
+
+        // Contrary to the wikipedia definition, we might keep multiple items in the queue for the same node.
+        // Only the two cheapest arrivals at every node are expanded, see Arrivals.
+        let Some(expansion) = ctx.arrivals.expand(item_node, item.at, item.cost) else {
+            count!(ctx.stats.stale_pops);
+            continue;
+        };
+
+        if item_node == to {
+            let mut last = item.at;
+            while last != NO_INDEX {
+                let node = node_of(last);
+                let (cost, came_from) = ctx.arrivals.came_from(node, last);
+                path.push_reversed(g, node, cost);
+                last = came_from;
+            }
+            path.finish();
+            return Ok(());
+        }
+
+        steps += 1;
+        count!(ctx.stats.settled);
+        if steps > step_limit {
+            return Err(AStarError::StepLimitExceeded);
+        }
+        ctx.check_interrupt(steps)?;
+
+        let item_osm_id = g.osm_ids[item_node as usize];
+        count!(ctx.stats.relaxed, g.edge_range(item_node).len());
+        for edge in g.edge_range(item_node) {
+            let neighbor = g.edge_targets[edge];
+            let neighbor_osm_id = g.osm_ids[neighbor as usize];
+
+            // Forbid turnarounds (A-B-A), and skip continuations which are cheaper
+            // from the first arrival
+            if neighbor_osm_id == expansion.before_osm_id
+                || expansion
+                    .only_to_osm_id
+                    .is_some_and(|osm_id| osm_id != neighbor_osm_id)
+            {
+                continue;
+            }
+
+            // Check if this is one of the two cheapest ways to the neighbor
+            let neighbor_at = edge as u32;
+            let neighbor_cost = item.cost + g.edge_costs[edge];
+            if !ctx
+                .arrivals
+                .relax(neighbor, neighbor_at, item.at, item_osm_id, neighbor_cost)
+            {
+                continue;
+            }
+
+            // Push the new item into the queue
+            ctx.queue.push(QueueItem {
+                at: neighbor_at,
+                cost: neighbor_cost,
+                score: neighbor_cost + heuristic(neighbor),
+            });
+        }
+    }
+
+    Ok(())
+}
@@ -0,0 +1,125 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+//! One-to-many and many-to-many route costs over a [FrozenGraph].
+
+use std::collections::HashMap;
+
+use super::context::{QueueItem, SearchContext};
+use super::stats::count;
+use crate::frozen::NO_INDEX;
+use crate::FrozenGraph;
+
+/// Fills `out` with the costs of the shortest routes from every source to every target,
+/// in row-major order (`out[i * targets.len() + j]` is the cost from `sources[i]` to `targets[j]`).
+///
+/// Runs a single Dijkstra search per source, which stops as soon as all targets are settled,
+/// or after `step_limit` nodes have been expanded.
+/// Costs to unknown or unreachable targets, and to targets not settled within the step limit,
+/// are set to [f32::INFINITY]. Rows of unknown sources are filled with [f32::INFINITY].
+///
+/// Panics if `out.len() != sources.len() * targets.len()`.
+pub(crate) fn cost_matrix(
+    g: &FrozenGraph,
+    ctx: &mut SearchContext,
+    sources: &[i64],
+    targets: &[i64],
+    step_limit: usize,
+    out: &mut [f32],
+) {
+    assert_eq!(out.len(), sources.len() * targets.len());
+    out.fill(f32::INFINITY);
+    if targets.is_empty() {
+        return;
+    }
+
+    // Map every distinct target node to its slot, and every column of the matrix to a slot
+    let mut slot_of_node: HashMap<u32, usize> = HashMap::default();
+    let columns: Vec<usize> = targets
+        .iter()
+        .map(|&id| match g.index_of(id) {
+            Some(idx) => {
+                let next_slot = slot_of_node.len();
+                *slot_of_node.entry(idx).or_insert(next_slot)
+            }
+            None => usize::MAX,
+        })
+        .collect();
+
+    let mut slot_costs: Vec<f32> = vec![f32::INFINITY; slot_of_node.len()];
+
+    for (row, &source_id) in out.chunks_exact_mut(targets.len()).zip(sources) {
+        let Some(source) = g.index_of(source_id) else {
+            continue;
+        };
+        one_to_many(g, ctx, source, &slot_of_node, &mut slot_costs, step_limit);
+
+        for (cost, &slot) in row.iter_mut().zip(&columns) {
+            if slot != usize::MAX {
+                *cost = slot_costs[slot];
+            }
+        }
+    }
+}
+
+/// Runs a Dijkstra search from `source` until all nodes from `slot_of_node` are settled,
+/// writing their costs into `slot_costs`.
+fn one_to_many(
+    g: &FrozenGraph,
+    ctx: &mut SearchContext,
+    source: u32,
+    slot_of_node: &HashMap<u32, usize>,
+    slot_costs: &mut [f32],
+    step_limit: usize,
+) {
+    slot_costs.fill(f32::INFINITY);
+    let mut remaining = slot_costs.len();
+    let mut steps: usize = 0;
+
+    ctx.reset(g.len());
+    ctx.queue.push(QueueItem {
+        at: source,
+        cost: 0.0,
+        score: 0.0,
+    });
+    ctx.set(source, 0.0, NO_INDEX);
+
+    while let Some(item) = ctx.queue.pop() {
+        // The queue may contain multiple items for the same node
+        if item.cost > ctx.cost(item.at) {
+            count!(ctx.stats.stale_pops);
+            continue;
+        }
+
+        if let Some(&slot) = slot_of_node.get(&item.at) {
+            if slot_costs[slot] == f32::INFINITY {
+                slot_costs[slot] = item.cost;
+                remaining -= 1;
+                if remaining == 0 {
+                    return;
+                }
+            }
+        }
+
+        steps += 1;
+        count!(ctx.stats.settled);
+        if steps > step_limit {
+            return;
+        }
+
+        count!(ctx.stats.relaxed, g.edge_range(item.at).len());
+        for (neighbor, edge_cost) in g.edges_at(item.at) {
+            let neighbor_cost = item.cost + edge_cost;
+            if neighbor_cost >= ctx.cost(neighbor) {
+                continue;
+            }
+
+            ctx.set(neighbor, neighbor_cost, item.at);
+            ctx.queue.push(QueueItem {
+                at: neighbor,
+                cost: neighbor_cost,
+                score: neighbor_cost,
+            });
+        }
+    }
+}
@@ -1,18 +1,30 @@
 // (c) Copyright 2025 Mikołaj Kuranowski
 // SPDX-License-Identifier: MIT
 
+pub(crate) mod bidirectional;
+pub(crate) mod context;
 mod error;
 mod flat;
+pub(crate) mod frozen;
+pub(crate) mod matrix;
+pub(crate) mod queue;
+pub(crate) mod reachable;
+pub(crate) mod route;
+pub(crate) mod stats;
 mod without_turn_around;
 
+pub use context::{CancelToken, SearchContext};
 pub use error::{AStarError, DEFAULT_STEP_LIMIT};
-pub use flat::find_route;
+pub use flat::{find_route, find_route_detailed};
+pub use queue::QueueKind;
+pub use route::RouteDetailed;
+pub use stats::SearchStats;
 pub use without_turn_around::find_route_without_turn_around;
 
 #[cfg(test)]
 mod tests {
     use super::*;
-    use crate::{Graph, Node};
+    use crate::{Graph, Node, RouteRequest};
 
     #[inline]
     fn simple_graph_fixture() -> Graph {
@@ -74,6 +86,21 @@ mod tests {
         assert_eq!(find_route(&g, 1, 4, 100), Ok(vec![1_i64, 2, 5, 4]));
     }
 
+    #[test]
+    fn simple_detailed() {
+        let g = simple_graph_fixture();
+        let route = find_route_detailed(&g, 1, 4, 100).unwrap();
+        assert_eq!(route.ids, vec![1_i64, 2, 5, 4]);
+        assert_eq!(route.lats, vec![0.01, 0.02, 0.03, 0.04]);
+        assert_eq!(route.lons, vec![0.01, 0.01, 0.00, 0.01]);
+        assert_eq!(route.costs, vec![0.0, 200.0, 300.0, 400.0]);
+
+        assert_eq!(
+            find_route_detailed(&g, 1, 42, 100),
+            Err(AStarError::InvalidReference(42))
+        );
+    }
+
     #[test]
     fn simple_without_turn_around() {
         let g = simple_graph_fixture();
@@ -83,6 +110,21 @@ mod tests {
         );
     }
 
+    #[test]
+    fn simple_frozen() {
+        let g = simple_graph_fixture().freeze();
+        assert_eq!(g.find_route(1, 4, 100), Ok(vec![1_i64, 2, 5, 4]));
+    }
+
+    #[test]
+    fn simple_frozen_without_turn_around() {
+        let g = simple_graph_fixture().freeze();
+        assert_eq!(
+            g.find_route_without_turn_around(1, 4, 100),
+            Ok(vec![1_i64, 2, 5, 4])
+        );
+    }
+
     #[test]
     fn step_limit() {
         let g = simple_graph_fixture();
@@ -98,6 +140,103 @@ mod tests {
         );
     }
 
+    #[test]
+    fn step_limit_frozen() {
+        let g = simple_graph_fixture().freeze();
+        assert_eq!(g.find_route(1, 4, 2), Err(AStarError::StepLimitExceeded));
+        assert_eq!(
+            g.find_route_without_turn_around(1, 4, 2),
+            Err(AStarError::StepLimitExceeded)
+        );
+    }
+
+    #[test]
+    fn invalid_reference_frozen() {
+        let g = simple_graph_fixture().freeze();
+        assert_eq!(
+            g.find_route(1, 42, 100),
+            Err(AStarError::InvalidReference(42))
+        );
+        assert_eq!(
+            g.find_route_without_turn_around(42, 1, 100),
+            Err(AStarError::InvalidReference(42))
+        );
+    }
+
+    #[test]
+    fn reused_search_context() {
+        let simple = simple_graph_fixture().freeze();
+        let shortest_not_optimal = shortest_not_optimal_fixture().freeze();
+        let mut ctx = SearchContext::new();
+
+        for _ in 0..3 {
+            assert_eq!(
+                simple.find_route_with_context(&mut ctx, 1, 4, 100),
+                Ok(vec![1, 2, 5, 4]),
+            );
+            assert_eq!(
+                shortest_not_optimal
+                    .find_route_without_turn_around_with_context(&mut ctx, 1, 8, 100),
+                Ok(vec![1, 2, 3, 6, 9, 8]),
+            );
+            assert_eq!(
+                simple.find_route_with_context(&mut ctx, 1, 4, 2),
+                Err(AStarError::StepLimitExceeded),
+            );
+            assert_eq!(
+                simple.find_route_without_turn_around_with_context(&mut ctx, 1, 4, 100),
+                Ok(vec![1, 2, 5, 4]),
+            );
+        }
+    }
+
+    #[test]
+    fn cost_matrix() {
+        let g = simple_graph_fixture().freeze();
+        let inf = f32::INFINITY;
+        assert_eq!(
+            g.cost_matrix(&[1, 4, 42], &[4, 1, 1, 5, 42], 100),
+            vec![
+                400.0, 0.0, 0.0, 300.0, inf, // from 1
+                0.0, 400.0, 400.0, 100.0, inf, // from 4
+                inf, inf, inf, inf, inf, // from 42
+            ],
+        );
+    }
+
+    #[test]
+    fn cost_matrix_step_limit() {
+        let g = simple_graph_fixture().freeze();
+        let inf = f32::INFINITY;
+        assert_eq!(g.cost_matrix(&[1], &[2, 4], 2), vec![200.0, inf],);
+        assert_eq!(g.cost_matrix(&[1], &[], 100), vec![]);
+    }
+
+    #[test]
+    fn find_routes_parallel() {
+        let g = simple_graph_fixture().freeze();
+        let requests: Vec<RouteRequest> = (0..100)
+            .map(|i| RouteRequest {
+                from: if i % 3 == 2 { 42 } else { 1 },
+                to: 4,
+                step_limit: 100,
+                without_turn_around: i % 2 == 0,
+            })
+            .collect();
+
+        for threads in [1, 4] {
+            let results = g.find_routes_parallel(&requests, threads);
+            assert_eq!(results.len(), requests.len());
+            for (i, result) in results.into_iter().enumerate() {
+                if i % 3 == 2 {
+                    assert_eq!(result, Err(AStarError::InvalidReference(42)));
+                } else {
+                    assert_eq!(result, Ok(vec![1, 2, 5, 4]));
+                }
+            }
+        }
+    }
+
     #[inline]
     fn shortest_not_optimal_fixture() -> Graph {
         //    500   100
@@ -211,6 +350,21 @@ mod tests {
         );
     }
 
+    #[test]
+    fn shortest_not_optimal_frozen() {
+        let g = shortest_not_optimal_fixture().freeze();
+        assert_eq!(g.find_route(1, 8, 100), Ok(vec![1_i64, 2, 3, 6, 9, 8]));
+    }
+
+    #[test]
+    fn shortest_not_optimal_frozen_without_turn_around() {
+        let g = shortest_not_optimal_fixture().freeze();
+        assert_eq!(
+            g.find_route_without_turn_around(1, 8, 100),
+            Ok(vec![1_i64, 2, 3, 6, 9, 8])
+        );
+    }
+
     #[inline]
     fn turn_restriction_fixture() -> Graph {
         // 1
@@ -292,4 +446,123 @@ mod tests {
             Ok(vec![1_i64, 20, 4, 5, 3])
         );
     }
+
+    #[test]
+    fn turn_restriction_frozen() {
+        let g = turn_restriction_fixture().freeze();
+        assert_eq!(g.find_route(1, 3, 100), Ok(vec![1_i64, 20, 4, 2, 3]));
+    }
+
+    #[test]
+    fn turn_restriction_frozen_without_turn_around() {
+        let g = turn_restriction_fixture().freeze();
+        assert_eq!(
+            g.find_route_without_turn_around(1, 3, 100),
+            Ok(vec![1_i64, 20, 4, 5, 3])
+        );
+    }
+    #[test]
+    fn simple_bidirectional() {
+        let g = simple_graph_fixture().freeze();
+        assert_eq!(
+            g.find_route_bidirectional(1, 4, 100),
+            Ok(vec![1_i64, 2, 5, 4])
+        );
+        assert_eq!(g.find_route_bidirectional(1, 1, 100), Ok(vec![1_i64]));
+        assert_eq!(
+            g.find_route_bidirectional(1, 42, 100),
+            Err(AStarError::InvalidReference(42))
+        );
+        assert_eq!(
+            g.find_route_bidirectional(1, 4, 1),
+            Err(AStarError::StepLimitExceeded)
+        );
+    }
+
+    #[test]
+    fn shortest_not_optimal_bidirectional() {
+        let g = shortest_not_optimal_fixture().freeze();
+        assert_eq!(
+            g.find_route_bidirectional(1, 8, 100),
+            Ok(vec![1_i64, 2, 3, 6, 9, 8])
+        );
+    }
+
+    #[test]
+    fn turn_restriction_bidirectional() {
+        let g = turn_restriction_fixture().freeze();
+        assert_eq!(
+            g.find_route_bidirectional(1, 3, 100),
+            Ok(vec![1_i64, 20, 4, 2, 3])
+        );
+    }
+
+    #[test]
+    fn bidirectional_same_costs_as_unidirectional() {
+        let g = shortest_not_optimal_fixture();
+        let f = g.freeze();
+        let mut ctx = SearchContext::new();
+        let cost =
+            |route: &[i64]| -> f32 { route.windows(2).map(|w| g.get_edge(w[0], w[1])).sum() };
+
+        for from in 1..=9 {
+            for to in 1..=9 {
+                let expected = f.find_route_with_context(&mut ctx, from, to, 100).unwrap();
+                let got = f
+                    .find_route_bidirectional_with_context(&mut ctx, from, to, 100)
+                    .unwrap();
+                assert_eq!(got.first(), Some(&from));
+                assert_eq!(got.last(), Some(&to));
+                assert_eq!(cost(&expected), cost(&got), "{} -> {}", from, to);
+            }
+        }
+    }
+
+    #[test]
+    fn landmarks() {
+        let g = shortest_not_optimal_fixture();
+        let f = g.freeze();
+        let lm = crate::Landmarks::build(&f, 3);
+        let mut ctx = SearchContext::new();
+        let cost =
+            |route: &[i64]| -> f32 { route.windows(2).map(|w| g.get_edge(w[0], w[1])).sum() };
+
+        assert_eq!(
+            f.find_route_with_landmarks(&mut ctx, &lm, 1, 8, 100),
+            Ok(vec![1_i64, 2, 3, 6, 9, 8])
+        );
+
+        for from in 1..=9 {
+            for to in 1..=9 {
+                let expected = f.find_route_with_context(&mut ctx, from, to, 100).unwrap();
+                let got = f
+                    .find_route_with_landmarks(&mut ctx, &lm, from, to, 100)
+                    .unwrap();
+                assert_eq!(cost(&expected), cost(&got), "{} -> {}", from, to);
+
+                let expected = f
+                    .find_route_without_turn_around_with_context(&mut ctx, from, to, 100)
+                    .unwrap();
+                let got = f
+                    .find_route_without_turn_around_with_landmarks(&mut ctx, &lm, from, to, 100)
+                    .unwrap();
+                assert_eq!(cost(&expected), cost(&got), "{} -> {}", from, to);
+            }
+        }
+    }
+
+    #[test]
+    fn landmarks_turn_restriction() {
+        let f = turn_restriction_fixture().freeze();
+        let lm = crate::Landmarks::build(&f, 2);
+        let mut ctx = SearchContext::new();
+        assert_eq!(
+            f.find_route_with_landmarks(&mut ctx, &lm, 1, 3, 100),
+            Ok(vec![1_i64, 20, 4, 2, 3])
+        );
+        assert_eq!(
+            f.find_route_without_turn_around_with_landmarks(&mut ctx, &lm, 1, 3, 100),
+            Ok(vec![1_i64, 20, 4, 5, 3])
+        );
+    }
 }
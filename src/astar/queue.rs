@@ -0,0 +1,538 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+//! Priority queues of search states over a [FrozenGraph](crate::FrozenGraph).
+
+use std::collections::BinaryHeap;
+
+use super::context::QueueItem;
+use super::stats::count;
+
+/// Priority queue implementation used by a [SearchContext](crate::SearchContext),
+/// see [SearchContext::with_queue](crate::SearchContext::with_queue).
+///
+/// All kinds return the same routes, except for the order of popping items with equal scores,
+/// which may result in a different choice between multiple equally short routes.
+///
+/// See `benches/queues.rs` for a comparison. In short, the default binary heap is the fastest
+/// for small and medium searches, as the frontier fits in the cache; the radix heap
+/// becomes faster once searches settle hundreds of thousands of nodes.
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum QueueKind {
+    /// Binary heap with lazy deletion: improving the cost of a queued state pushes another
+    /// item, and outdated items are skipped when popped.
+    #[default]
+    Binary,
+
+    /// 4-ary heap indexed by dense state indices, with decrease-key. Every state is queued
+    /// at most once, and the heap is shallower than a binary one, at the cost of maintaining
+    /// the position of every queued state.
+    Quaternary,
+
+    /// Monotone [radix heap](https://en.wikipedia.org/wiki/Radix_heap) over the bit patterns
+    /// of scores, with amortized constant-time pushes and logarithmic pops in the number
+    /// of score bits. Relies on popped scores never decreasing, which holds for Dijkstra
+    /// and A* with a consistent heuristic; scores lower than the last popped one
+    /// (e.g. due to rounding) are treated as equal to it.
+    Radix,
+}
+
+/// Priority queue of [QueueItems](QueueItem), returning items with the lowest scores first,
+/// dispatching to the implementation selected by a [QueueKind].
+///
+/// Also counts pushed and popped items (with the `stats` feature),
+/// see [SearchStats](super::SearchStats).
+#[derive(Debug, Clone)]
+pub(crate) struct Queue {
+    heap: Heap,
+    pub(crate) pushes: u64,
+    pub(crate) pops: u64,
+    pub(crate) peak_len: u64,
+}
+
+#[derive(Debug, Clone)]
+enum Heap {
+    Binary(BinaryHeap<QueueItem>),
+    Quaternary(QuaternaryHeap),
+    Radix(RadixHeap),
+}
+
+impl Default for Queue {
+    fn default() -> Self {
+        Self::new(QueueKind::default())
+    }
+}
+
+impl Queue {
+    pub(crate) fn new(kind: QueueKind) -> Self {
+        let heap = match kind {
+            QueueKind::Binary => Heap::Binary(BinaryHeap::default()),
+            QueueKind::Quaternary => Heap::Quaternary(QuaternaryHeap::default()),
+            QueueKind::Radix => Heap::Radix(RadixHeap::default()),
+        };
+        Self {
+            heap,
+            pushes: 0,
+            pops: 0,
+            peak_len: 0,
+        }
+    }
+
+    pub(crate) fn kind(&self) -> QueueKind {
+        match self.heap {
+            Heap::Binary(_) => QueueKind::Binary,
+            Heap::Quaternary(_) => QueueKind::Quaternary,
+            Heap::Radix(_) => QueueKind::Radix,
+        }
+    }
+
+    /// Removes all items and prepares the queue for items with `at < states`.
+    /// Counters are kept.
+    pub(crate) fn reset(&mut self, states: usize) {
+        match &mut self.heap {
+            Heap::Binary(q) => q.clear(),
+            Heap::Quaternary(q) => q.reset(states),
+            Heap::Radix(q) => q.clear(),
+        }
+    }
+
+    /// Zeroes the counters of pushed and popped items.
+    pub(crate) fn reset_counters(&mut self) {
+        self.pushes = 0;
+        self.pops = 0;
+        self.peak_len = 0;
+    }
+
+    /// Pushes an item into the queue. Items pushed for an already queued state
+    /// may either replace it, or be queued alongside it.
+    #[inline]
+    pub(crate) fn push(&mut self, item: QueueItem) {
+        match &mut self.heap {
+            Heap::Binary(q) => q.push(item),
+            Heap::Quaternary(q) => q.push(item),
+            Heap::Radix(q) => q.push(item),
+        }
+        count!(self.pushes);
+        #[cfg(feature = "stats")]
+        {
+            self.peak_len = self.peak_len.max(self.len() as u64);
+        }
+    }
+
+    /// Removes and returns the item with the lowest score.
+    #[inline]
+    pub(crate) fn pop(&mut self) -> Option<QueueItem> {
+        let item = match &mut self.heap {
+            Heap::Binary(q) => q.pop(),
+            Heap::Quaternary(q) => q.pop(),
+            Heap::Radix(q) => q.pop(),
+        }?;
+        count!(self.pops);
+        Some(item)
+    }
+
+    /// Returns the number of queued items.
+    #[cfg(feature = "stats")]
+    #[inline]
+    fn len(&self) -> usize {
+        match &self.heap {
+            Heap::Binary(q) => q.len(),
+            Heap::Quaternary(q) => q.items.len(),
+            Heap::Radix(q) => q.len,
+        }
+    }
+
+    /// Returns the item with the lowest score, without removing it.
+    #[inline]
+    pub(crate) fn peek(&mut self) -> Option<QueueItem> {
+        match &mut self.heap {
+            Heap::Binary(q) => q.peek().cloned(),
+            Heap::Quaternary(q) => q.items.first().cloned(),
+            Heap::Radix(q) => q.peek(),
+        }
+    }
+}
+
+const NOT_QUEUED: u32 = u32::MAX;
+
+/// 4-ary min-heap of [QueueItems](QueueItem) with at most one item per state,
+/// see [QueueKind::Quaternary].
+#[derive(Debug, Default, Clone)]
+pub(crate) struct QuaternaryHeap {
+    items: Vec<QueueItem>,
+
+    /// Position of every state in `items`, or [NOT_QUEUED].
+    positions: Vec<u32>,
+}
+
+impl QuaternaryHeap {
+    fn reset(&mut self, states: usize) {
+        for item in self.items.drain(..) {
+            self.positions[item.at as usize] = NOT_QUEUED;
+        }
+        if self.positions.len() < states {
+            self.positions.resize(states, NOT_QUEUED);
+        }
+    }
+
+    /// Pushes an item, replacing the queued item for the same state (if any).
+    #[inline]
+    fn push(&mut self, item: QueueItem) {
+        let at = item.at as usize;
+        if at >= self.positions.len() {
+            self.positions.resize(at + 1, NOT_QUEUED);
+        }
+
+        match self.positions[at] {
+            NOT_QUEUED => {
+                self.items.push(item);
+                self.sift_up(self.items.len() - 1);
+            }
+            position => {
+                let position = position as usize;
+                let old_score = self.items[position].score;
+                self.items[position] = item;
+                if item.score < old_score {
+                    self.sift_up(position);
+                } else {
+                    self.sift_down(position);
+                }
+            }
+        }
+    }
+
+    #[inline]
+    fn pop(&mut self) -> Option<QueueItem> {
+        let last = self.items.pop()?;
+        let top = if self.items.is_empty() {
+            last
+        } else {
+            let top = std::mem::replace(&mut self.items[0], last);
+            self.sift_down(0);
+            top
+        };
+        self.positions[top.at as usize] = NOT_QUEUED;
+        Some(top)
+    }
+
+    fn sift_up(&mut self, mut i: usize) {
+        let item = self.items[i];
+        while i > 0 {
+            let parent = (i - 1) / 4;
+            if self.items[parent].score <= item.score {
+                break;
+            }
+            self.place(i, self.items[parent]);
+            i = parent;
+        }
+        self.place(i, item);
+    }
+
+    fn sift_down(&mut self, mut i: usize) {
+        let item = self.items[i];
+        let len = self.items.len();
+        loop {
+            let first_child = 4 * i + 1;
+            if first_child >= len {
+                break;
+            }
+
+            let mut best = first_child;
+            for child in first_child + 1..(first_child + 4).min(len) {
+                if self.items[child].score < self.items[best].score {
+                    best = child;
+                }
+            }
+
+            if item.score <= self.items[best].score {
+                break;
+            }
+            self.place(i, self.items[best]);
+            i = best;
+        }
+        self.place(i, item);
+    }
+
+    #[inline]
+    fn place(&mut self, i: usize, item: QueueItem) {
+        self.items[i] = item;
+        self.positions[item.at as usize] = i as u32;
+    }
+}
+
+/// Number of buckets of a [RadixHeap] - one for keys equal to the last popped key,
+/// and one for every possible highest differing bit.
+const RADIX_BUCKETS: usize = 33;
+
+/// Monotone radix heap of [QueueItems](QueueItem), see [QueueKind::Radix].
+///
+/// Bucket `i > 0` contains items whose key differs from the last popped key
+/// at the `i - 1`-th bit at the highest, and bucket 0 contains items with keys
+/// equal to the last popped key.
+#[derive(Debug, Clone)]
+pub(crate) struct RadixHeap {
+    last: u32,
+    len: usize,
+
+    /// Bit `i` is set if bucket `i` is not empty.
+    occupied: u64,
+    buckets: [Vec<(u32, QueueItem)>; RADIX_BUCKETS],
+}
+
+impl Default for RadixHeap {
+    fn default() -> Self {
+        Self {
+            last: 0,
+            len: 0,
+            occupied: 0,
+            buckets: std::array::from_fn(|_| Vec::default()),
+        }
+    }
+}
+
+impl RadixHeap {
+    /// Maps a score to a key, such that keys have the same order as scores.
+    #[inline]
+    fn key(score: f32) -> u32 {
+        let bits = score.to_bits();
+        if bits & 0x8000_0000 != 0 {
+            !bits
+        } else {
+            bits | 0x8000_0000
+        }
+    }
+
+    #[inline]
+    fn insert(&mut self, key: u32, item: QueueItem) {
+        let bucket = (u32::BITS - (key ^ self.last).leading_zeros()) as usize;
+        self.buckets[bucket].push((key, item));
+        self.occupied |= 1 << bucket;
+    }
+
+    fn clear(&mut self) {
+        self.last = 0;
+        self.len = 0;
+        self.occupied = 0;
+        self.buckets.iter_mut().for_each(Vec::clear);
+    }
+
+    #[inline]
+    fn push(&mut self, item: QueueItem) {
+        self.insert(Self::key(item.score).max(self.last), item);
+        self.len += 1;
+    }
+
+    #[inline]
+    fn pop(&mut self) -> Option<QueueItem> {
+        self.refill();
+        let (_, item) = self.buckets[0].pop()?;
+        self.len -= 1;
+        if self.buckets[0].is_empty() {
+            self.occupied &= !1;
+        }
+        Some(item)
+    }
+
+    #[inline]
+    fn peek(&mut self) -> Option<QueueItem> {
+        self.refill();
+        self.buckets[0].last().map(|&(_, item)| item)
+    }
+
+    /// Ensures that the item with the lowest key is in bucket 0, by redistributing
+    /// the first non-empty bucket with respect to its lowest key.
+    #[inline]
+    fn refill(&mut self) {
+        if self.occupied & 1 != 0 || self.occupied == 0 {
+            return;
+        }
+
+        let i = self.occupied.trailing_zeros() as usize;
+        self.occupied &= !(1 << i);
+        let mut bucket = std::mem::take(&mut self.buckets[i]);
+        self.last = bucket.iter().map(|&(key, _)| key).min().unwrap();
+        for (key, item) in bucket.drain(..) {
+            // All items move to lower buckets, as they share the bits above i-1 with the new last
+            self.insert(key, item);
+        }
+
+        // Keep the allocation of the emptied bucket
+        self.buckets[i] = bucket;
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{FrozenGraph, Graph, Node, RouteRequest, SearchContext};
+
+    fn item(at: u32, score: f32) -> QueueItem {
+        QueueItem {
+            at,
+            cost: score,
+            score,
+        }
+    }
+
+    fn drain(q: &mut Queue) -> Vec<(u32, f32)> {
+        std::iter::from_fn(|| q.pop())
+            .map(|i| (i.at, i.score))
+            .collect()
+    }
+
+    #[test]
+    fn order() {
+        for kind in [QueueKind::Binary, QueueKind::Quaternary, QueueKind::Radix] {
+            let mut q = Queue::new(kind);
+            assert_eq!(q.kind(), kind);
+            q.reset(16);
+
+            for (at, score) in [
+                (1, 5.0),
+                (2, -1.0),
+                (3, 3.5),
+                (4, 100.0),
+                (5, 0.0),
+                (6, 7.25),
+            ] {
+                q.push(item(at, score));
+            }
+            assert_eq!(q.peek().map(|i| i.at), Some(2));
+            assert_eq!(q.pop().map(|i| i.at), Some(2));
+
+            // Monotone push after pop
+            q.push(item(7, 4.0));
+            assert_eq!(
+                drain(&mut q),
+                vec![
+                    (5, 0.0),
+                    (3, 3.5),
+                    (7, 4.0),
+                    (1, 5.0),
+                    (6, 7.25),
+                    (4, 100.0)
+                ],
+                "{kind:?}",
+            );
+            assert_eq!(q.peek(), None);
+
+            // Reuse after reset
+            q.push(item(1, 2.0));
+            q.reset(16);
+            assert_eq!(q.pop(), None);
+        }
+    }
+
+    #[test]
+    fn quaternary_decrease_key() {
+        let mut q = Queue::new(QueueKind::Quaternary);
+        q.reset(8);
+        for at in 0..8 {
+            q.push(item(at, at as f32 * 10.0));
+        }
+        q.push(item(6, 5.0));
+        q.push(item(1, 45.0));
+
+        assert_eq!(
+            drain(&mut q),
+            vec![
+                (0, 0.0),
+                (6, 5.0),
+                (2, 20.0),
+                (3, 30.0),
+                (4, 40.0),
+                (1, 45.0),
+                (5, 50.0),
+                (7, 70.0)
+            ],
+        );
+    }
+
+    #[test]
+    fn radix_clamps_non_monotone_pushes() {
+        let mut q = Queue::new(QueueKind::Radix);
+        q.push(item(1, 10.0));
+        q.push(item(2, 20.0));
+        assert_eq!(q.pop().map(|i| i.at), Some(1));
+
+        q.push(item(3, 9.999));
+        assert_eq!(drain(&mut q), vec![(3, 9.999), (2, 20.0)]);
+    }
+
+    /// 8x8 grid of nodes, with pseudo-random costs no lower than the crow-flies distance.
+    fn grid() -> FrozenGraph {
+        let n = 8;
+        let mut seed: u32 = 1;
+        let mut g = Graph::new();
+        for id in 1..=n * n {
+            g.set_node(Node {
+                id,
+                osm_id: id,
+                lat: ((id - 1) / n) as f32 * 0.001,
+                lon: ((id - 1) % n) as f32 * 0.001,
+            });
+        }
+        for id in 1..=n * n {
+            let (x, y) = ((id - 1) % n, (id - 1) / n);
+            for (nx, ny) in [(x + 1, y), (x - 1, y), (x, y + 1), (x, y - 1)] {
+                if (0..n).contains(&nx) && (0..n).contains(&ny) {
+                    seed = seed.wrapping_mul(1_103_515_245).wrapping_add(12345);
+                    let cost = 120.0 + (seed >> 16) as f32 % 100.0;
+                    g.set_edge(
+                        id,
+                        crate::Edge {
+                            to: ny * n + nx + 1,
+                            cost,
+                        },
+                    );
+                }
+            }
+        }
+        g.freeze()
+    }
+
+    #[test]
+    fn same_costs_for_all_kinds() {
+        let g = grid();
+        let route_cost =
+            |route: &[i64]| -> f32 { route.windows(2).map(|w| g.get_edge(w[0], w[1])).sum() };
+
+        let mut expected = Vec::default();
+        for (i, kind) in [QueueKind::Binary, QueueKind::Quaternary, QueueKind::Radix]
+            .into_iter()
+            .enumerate()
+        {
+            let mut ctx = SearchContext::with_queue(kind);
+            assert_eq!(ctx.queue_kind(), kind);
+
+            let mut costs = Vec::default();
+            for (from, to) in [(1, 64), (8, 57), (20, 45), (33, 3)] {
+                for without_turn_around in [false, true] {
+                    let r = RouteRequest {
+                        from,
+                        to,
+                        step_limit: 1000,
+                        without_turn_around,
+                    };
+                    costs.push(g.find_route_detailed(&mut ctx, &r).unwrap().total_cost());
+                }
+                let route = g
+                    .find_route_bidirectional_with_context(&mut ctx, from, to, 1000)
+                    .unwrap();
+                costs.push(route_cost(&route));
+            }
+
+            let mut matrix = vec![0.0; 4];
+            g.cost_matrix_into(&mut ctx, &[1, 20], &[64, 45], 1000, &mut matrix);
+            costs.extend(matrix);
+
+            if i == 0 {
+                expected = costs;
+            } else {
+                for (a, b) in costs.iter().zip(&expected) {
+                    assert!((a - b).abs() < 1e-2, "{kind:?}: {costs:?} != {expected:?}");
+                }
+            }
+        }
+    }
+}
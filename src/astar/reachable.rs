@@ -0,0 +1,157 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+//! Cost-bounded reachability searches (isochrones) over a [FrozenGraph].
+
+use super::context::{QueueItem, SearchContext};
+use super::stats::count;
+use crate::frozen::NO_INDEX;
+use crate::{AStarError, FrozenGraph, Node};
+
+/// Runs a Dijkstra search from `from`, calling `settled(node, cost)` on every node
+/// which can be reached with a total cost of at most `max_cost`, in the order of increasing costs.
+///
+/// `step_limit` limits the number of settled nodes. Returns the number of settled nodes.
+pub(crate) fn reachable<F: FnMut(u32, f32)>(
+    g: &FrozenGraph,
+    ctx: &mut SearchContext,
+    from: u32,
+    max_cost: f32,
+    step_limit: usize,
+    mut settled: F,
+) -> Result<usize, AStarError> {
+    let mut steps: usize = 0;
+
+    ctx.reset(g.len());
+    ctx.set(from, 0.0, NO_INDEX);
+    ctx.queue.push(QueueItem {
+        at: from,
+        cost: 0.0,
+        score: 0.0,
+    });
+
+    while let Some(item) = ctx.queue.pop() {
+        if item.cost > ctx.cost(item.at) {
+            count!(ctx.stats.stale_pops);
+            continue;
+        }
+
+        steps += 1;
+        count!(ctx.stats.settled);
+        if steps > step_limit {
+            return Err(AStarError::StepLimitExceeded);
+        }
+        ctx.check_interrupt(steps)?;
+        settled(item.at, item.cost);
+
+        count!(ctx.stats.relaxed, g.edge_range(item.at).len());
+        for (neighbor, edge_cost) in g.edges_at(item.at) {
+            let neighbor_cost = item.cost + edge_cost;
+            if neighbor_cost > max_cost || neighbor_cost >= ctx.cost(neighbor) {
+                continue;
+            }
+
+            ctx.set(neighbor, neighbor_cost, item.at);
+            ctx.queue.push(QueueItem {
+                at: neighbor,
+                cost: neighbor_cost,
+                score: neighbor_cost,
+            });
+        }
+    }
+
+    Ok(steps)
+}
+
+/// Computes the convex hull of the provided nodes (treating longitudes and latitudes
+/// as planar coordinates) with [Andrew's monotone chain](https://en.wikibooks.org/wiki/Algorithm_Implementation/Geometry/Convex_hull/Monotone_chain)
+/// algorithm, writing its vertices in counter-clockwise order into `hull`.
+///
+/// `points` are reordered in the process. Collinear and duplicate points are omitted,
+/// so the hull of less than 3 distinct points has less than 3 vertices.
+pub(crate) fn convex_hull(points: &mut [Node], hull: &mut Vec<Node>) {
+    hull.clear();
+    if points.len() < 2 {
+        hull.extend_from_slice(points);
+        return;
+    }
+    points.sort_unstable_by(|a, b| a.lon.total_cmp(&b.lon).then(a.lat.total_cmp(&b.lat)));
+
+    let cross = |o: &Node, a: &Node, b: &Node| -> f64 {
+        (a.lon as f64 - o.lon as f64) * (b.lat as f64 - o.lat as f64)
+            - (a.lat as f64 - o.lat as f64) * (b.lon as f64 - o.lon as f64)
+    };
+
+    // Lower hull
+    for p in points.iter() {
+        while hull.len() >= 2 && cross(&hull[hull.len() - 2], &hull[hull.len() - 1], p) <= 0.0 {
+            hull.pop();
+        }
+        hull.push(*p);
+    }
+
+    // Upper hull
+    let lower_len = hull.len() + 1;
+    for p in points.iter().rev().skip(1) {
+        while hull.len() >= lower_len
+            && cross(&hull[hull.len() - 2], &hull[hull.len() - 1], p) <= 0.0
+        {
+            hull.pop();
+        }
+        hull.push(*p);
+    }
+
+    // The last vertex is the same as the first one
+    hull.pop();
+    if hull.len() == 2 && hull[0].lat == hull[1].lat && hull[0].lon == hull[1].lon {
+        hull.pop();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn node(id: i64, lat: f32, lon: f32) -> Node {
+        Node {
+            id,
+            osm_id: id,
+            lat,
+            lon,
+        }
+    }
+
+    #[test]
+    fn convex_hull_square() {
+        let mut points = vec![
+            node(1, 0.0, 0.0),
+            node(2, 1.0, 1.0),
+            node(3, 0.5, 0.5), // inside
+            node(4, 0.0, 1.0),
+            node(5, 1.0, 0.0),
+            node(6, 0.0, 0.5), // collinear
+        ];
+        let mut hull = Vec::default();
+        convex_hull(&mut points, &mut hull);
+        assert_eq!(
+            hull.iter().map(|n| n.id).collect::<Vec<_>>(),
+            vec![1, 4, 2, 5]
+        );
+    }
+
+    #[test]
+    fn convex_hull_degenerate() {
+        let mut hull = Vec::default();
+        convex_hull(&mut [], &mut hull);
+        assert!(hull.is_empty());
+
+        convex_hull(&mut [node(1, 0.0, 0.0)], &mut hull);
+        assert_eq!(hull, vec![node(1, 0.0, 0.0)]);
+
+        convex_hull(&mut [node(1, 0.0, 0.0), node(2, 0.0, 0.0)], &mut hull);
+        assert_eq!(hull.len(), 1);
+
+        convex_hull(&mut [node(1, 0.0, 0.0), node(2, 1.0, 1.0)], &mut hull);
+        assert_eq!(hull.len(), 2);
+    }
+}
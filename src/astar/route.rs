@@ -0,0 +1,100 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+use crate::FrozenGraph;
+
+/// Shortest route with the geometry and costs of its nodes,
+/// returned by [find_route_detailed](crate::find_route_detailed).
+///
+/// All vectors have the same length, and describe the consecutive nodes of the route
+/// as parallel arrays. Empty if no route exists.
+#[derive(Debug, Default, Clone, PartialEq)]
+pub struct RouteDetailed {
+    /// [Node::id](crate::Node::id) of every node of the route.
+    pub ids: Vec<i64>,
+
+    /// [Node::lat](crate::Node::lat) of every node of the route.
+    pub lats: Vec<f32>,
+
+    /// [Node::lon](crate::Node::lon) of every node of the route.
+    pub lons: Vec<f32>,
+
+    /// Cumulative cost of reaching every node of the route from the start.
+    /// The first cost is always zero, and the last one is the cost of the whole route.
+    pub costs: Vec<f32>,
+}
+
+impl RouteDetailed {
+    /// Returns the number of nodes of the route.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.ids.len()
+    }
+
+    /// Returns `true` if the route has no nodes.
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.ids.is_empty()
+    }
+
+    /// Returns the cost of the whole route, or zero if it is empty.
+    #[inline]
+    pub fn total_cost(&self) -> f32 {
+        self.costs.last().cloned().unwrap_or(0.0)
+    }
+
+    /// Removes all nodes, keeping the allocated storage.
+    pub fn clear(&mut self) {
+        self.ids.clear();
+        self.lats.clear();
+        self.lons.clear();
+        self.costs.clear();
+    }
+
+    pub(crate) fn push(&mut self, id: i64, lat: f32, lon: f32, cost: f32) {
+        self.ids.push(id);
+        self.lats.push(lat);
+        self.lons.push(lon);
+        self.costs.push(cost);
+    }
+
+    fn reverse(&mut self) {
+        self.ids.reverse();
+        self.lats.reverse();
+        self.lons.reverse();
+        self.costs.reverse();
+    }
+}
+
+/// Receiver of the nodes of a route found over a [FrozenGraph].
+pub(crate) trait RouteSink {
+    /// Receives a node (by its dense index) of the route, together with the cost
+    /// of reaching it. Nodes are pushed from the end to the start of the route.
+    fn push_reversed(&mut self, g: &FrozenGraph, node: u32, cost: f32);
+
+    /// Called after all nodes were pushed.
+    fn finish(&mut self);
+}
+
+impl RouteSink for Vec<i64> {
+    #[inline]
+    fn push_reversed(&mut self, g: &FrozenGraph, node: u32, _: f32) {
+        self.push(g.ids[node as usize]);
+    }
+
+    fn finish(&mut self) {
+        self.reverse();
+    }
+}
+
+impl RouteSink for RouteDetailed {
+    #[inline]
+    fn push_reversed(&mut self, g: &FrozenGraph, node: u32, cost: f32) {
+        let i = node as usize;
+        self.push(g.ids[i], g.lats[i], g.lons[i], cost);
+    }
+
+    fn finish(&mut self) {
+        self.reverse();
+    }
+}
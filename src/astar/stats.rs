@@ -0,0 +1,61 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+/// Counters of the work done by the last search (or the last batch of searches,
+/// like a [cost matrix](crate::FrozenGraph::cost_matrix)) with a [SearchContext](crate::SearchContext),
+/// see [SearchContext::stats](crate::SearchContext::stats).
+///
+/// Counters are updated by the searches themselves, which amounts to a few integer
+/// additions per settled state. Without the `stats` cargo feature (enabled by default)
+/// the updates are compiled out, and all counters except for [SearchStats::elapsed_ns]
+/// stay at zero. Wall time is only measured if enabled with
+/// [SearchContext::set_timing](crate::SearchContext::set_timing).
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+#[repr(C)]
+pub struct SearchStats {
+    /// Number of settled (expanded) search states. Searches fail with
+    /// [AStarError::StepLimitExceeded](crate::AStarError::StepLimitExceeded)
+    /// once this exceeds the step limit.
+    pub settled: u64,
+
+    /// Number of edges examined from settled states.
+    pub relaxed: u64,
+
+    /// Number of items pushed into the priority queues.
+    pub pushes: u64,
+
+    /// Number of items popped from the priority queues.
+    pub pops: u64,
+
+    /// Largest number of items in the priority queue. For bidirectional searches,
+    /// sum of the largest sizes of both queues.
+    pub peak_queue_size: u64,
+
+    /// Number of popped items which were skipped, as a cheaper way to their state
+    /// was already known.
+    pub stale_pops: u64,
+
+    /// Wall time of the search, in nanoseconds. Zero unless
+    /// [timing is enabled](crate::SearchContext::set_timing).
+    pub elapsed_ns: u64,
+}
+
+/// Adds `n` (1 by default) to a [SearchStats] counter. Compiles to nothing (not even evaluating
+/// `n`) without the `stats` feature.
+macro_rules! count {
+    ($counter:expr) => {
+        count!($counter, 1)
+    };
+    ($counter:expr, $n:expr) => {
+        #[cfg(feature = "stats")]
+        {
+            $counter += $n as u64;
+        }
+        #[cfg(not(feature = "stats"))]
+        {
+            let _ = &$counter;
+        }
+    };
+}
+
+pub(crate) use count;
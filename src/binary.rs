@@ -0,0 +1,112 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+//! Little-endian encoding of scalars and arrays, used by on-disk formats.
+
+use std::io::{self, Read, Write};
+
+/// Number of elements encoded or decoded at once by [write_slice] and [read_vec].
+const CHUNK: usize = 4096;
+
+/// Fixed-size scalar with a little-endian binary representation.
+pub(crate) trait Scalar: Copy + Default {
+    const SIZE: usize;
+    fn write_le(self, out: &mut [u8]);
+    fn read_le(b: &[u8]) -> Self;
+}
+
+macro_rules! impl_scalar {
+    ($($t:ty),*) => {
+        $(
+            impl Scalar for $t {
+                const SIZE: usize = std::mem::size_of::<$t>();
+
+                #[inline]
+                fn write_le(self, out: &mut [u8]) {
+                    out.copy_from_slice(&self.to_le_bytes())
+                }
+
+                #[inline]
+                fn read_le(b: &[u8]) -> Self {
+                    <$t>::from_le_bytes(b.try_into().unwrap())
+                }
+            }
+        )*
+    };
+}
+
+impl_scalar!(u8, u32, u64, i32, i64, f32);
+
+/// Returns an [io::ErrorKind::InvalidData] error with the provided message.
+pub(crate) fn invalid_data(msg: &str) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, msg.to_string())
+}
+
+/// Writes a single little-endian scalar.
+pub(crate) fn write<W: Write, T: Scalar>(w: &mut W, value: T) -> io::Result<()> {
+    let mut buf = [0_u8; 8];
+    value.write_le(&mut buf[..T::SIZE]);
+    w.write_all(&buf[..T::SIZE])
+}
+
+/// Writes all elements of a slice as little-endian scalars, without any length prefix.
+pub(crate) fn write_slice<W: Write, T: Scalar>(w: &mut W, values: &[T]) -> io::Result<()> {
+    let mut buf = vec![0_u8; CHUNK * T::SIZE];
+    for chunk in values.chunks(CHUNK) {
+        for (v, out) in chunk.iter().zip(buf.chunks_exact_mut(T::SIZE)) {
+            v.write_le(out);
+        }
+        w.write_all(&buf[..chunk.len() * T::SIZE])?;
+    }
+    Ok(())
+}
+
+/// Reads a single little-endian scalar.
+pub(crate) fn read<R: Read, T: Scalar>(r: &mut R) -> io::Result<T> {
+    let mut buf = [0_u8; 8];
+    r.read_exact(&mut buf[..T::SIZE])?;
+    Ok(T::read_le(&buf[..T::SIZE]))
+}
+
+/// Reads `len` little-endian scalars.
+///
+/// Memory is allocated as data is read, so that a corrupted length results in an
+/// [io::ErrorKind::UnexpectedEof] error, rather than an attempt to allocate a huge buffer.
+pub(crate) fn read_vec<R: Read, T: Scalar>(r: &mut R, len: usize) -> io::Result<Vec<T>> {
+    let mut values = Vec::with_capacity(len.min(CHUNK));
+    let mut buf = vec![0_u8; CHUNK * T::SIZE];
+    while values.len() < len {
+        let chunk_len = (len - values.len()).min(CHUNK);
+        let bytes = &mut buf[..chunk_len * T::SIZE];
+        r.read_exact(bytes)?;
+        values.extend(bytes.chunks_exact(T::SIZE).map(T::read_le));
+    }
+    Ok(values)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn round_trip() {
+        let mut buf: Vec<u8> = Vec::default();
+        write(&mut buf, 0x0102_0304_u32).unwrap();
+        write_slice(&mut buf, &[1.5_f32, -2.0]).unwrap();
+        write_slice(&mut buf, &(0..10_000_i64).collect::<Vec<_>>()).unwrap();
+        assert_eq!(&buf[..4], &[4, 3, 2, 1]);
+        assert_eq!(buf.len(), 4 + 2 * 4 + 10_000 * 8);
+
+        let mut r = buf.as_slice();
+        assert_eq!(read::<_, u32>(&mut r).unwrap(), 0x0102_0304);
+        assert_eq!(read_vec::<_, f32>(&mut r, 2).unwrap(), vec![1.5, -2.0]);
+        assert_eq!(
+            read_vec::<_, i64>(&mut r, 10_000).unwrap(),
+            (0..10_000).collect::<Vec<_>>()
+        );
+        assert_eq!(
+            read::<_, u8>(&mut r).unwrap_err().kind(),
+            io::ErrorKind::UnexpectedEof
+        );
+    }
+}
@@ -10,10 +10,12 @@ use super::*;
 
 use std::borrow::Cow;
 use std::collections::btree_map;
-use std::ffi::{c_char, c_int, c_void, CStr, CString};
+use std::ffi::{c_char, c_int, c_uint, c_void, CStr, CString};
 use std::mem::{forget, ManuallyDrop};
 use std::ptr::null_mut;
 use std::slice;
+use std::sync::Arc;
+use std::time::Duration;
 
 type CGraphIterator<'a> = btree_map::Values<'a, i64, (Node, Vec<Edge>)>;
 
@@ -133,7 +135,7 @@ pub unsafe extern "C" fn routx_graph_get_nodes(
 ) -> usize {
     if let Some(graph) = graph.as_ref() {
         if !iterator_ptr.is_null() {
-            *iterator_ptr = Box::into_raw(Box::new(graph.0.values()));
+            *iterator_ptr = Box::into_raw(Box::new(graph.nodes().values()));
         }
 
         graph.len()
@@ -190,6 +192,11 @@ pub unsafe extern "C" fn routx_graph_delete_node(graph: *mut Graph, id: i64) ->
     }
 }
 
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_graph_epoch(graph: *const Graph) -> u64 {
+    graph.as_ref().map(Graph::epoch).unwrap_or(0)
+}
+
 #[unsafe(no_mangle)]
 pub unsafe extern "C" fn routx_graph_find_nearest_node(
     graph: *const Graph,
@@ -383,6 +390,7 @@ pub struct COsmOptions {
     pub profile: *const COsmProfile,
     pub format: COsmFormat,
     pub bbox: [f32; 4],
+    pub threads: c_uint,
 }
 
 impl COsmOptions {
@@ -391,6 +399,7 @@ impl COsmOptions {
             profile,
             file_format: self.format.into(),
             bbox: self.bbox,
+            threads: self.threads as usize,
         }
     }
 }
@@ -402,9 +411,17 @@ unsafe fn with_parsed_options<F: FnOnce(&osm::Options<'_>) -> R, R>(
     let c_options = c_options
         .as_ref()
         .expect("RoutxOsmOptions must not be NULL");
+    with_profile(c_options.profile, |profile| {
+        f(&c_options.parsed_with_profile(profile))
+    })
+}
 
+unsafe fn with_profile<F: FnOnce(&osm::Profile<'_>) -> R, R>(
+    c_profile: *const COsmProfile,
+    f: F,
+) -> R {
     // Special profile values to profile reallocation
-    let predefined_profile = match c_options.profile as usize {
+    let predefined_profile = match c_profile as usize {
         1 => Some(&osm::CAR_PROFILE),
         2 => Some(&osm::BUS_PROFILE),
         3 => Some(&osm::BICYCLE_PROFILE),
@@ -416,22 +433,33 @@ unsafe fn with_parsed_options<F: FnOnce(&osm::Options<'_>) -> R, R>(
     };
 
     if let Some(profile) = predefined_profile {
-        let options = c_options.parsed_with_profile(profile);
-        f(&options)
+        f(profile)
     } else {
-        let c_profile = c_options
-            .profile
+        let c_profile = c_profile
             .as_ref()
             .expect("RoutxOsmOptions.profile must not be NULL");
         let profile_strings = c_profile.build_string_table();
         let profile_penalties = c_profile.penalties_as_rust(&profile_strings);
         let profile_access = c_profile.access_as_rust(&profile_strings);
         let profile = c_profile.as_rust(&profile_strings[0], &profile_penalties, &profile_access);
-        let options = c_options.parsed_with_profile(&profile);
-        f(&options)
+        f(&profile)
     }
 }
 
+/// Same as [with_parsed_options], but with [COsmOptions::profile] ignored.
+unsafe fn with_parsed_options_without_profile<F: FnOnce(&osm::Options<'_>) -> R, R>(
+    c_options: *const COsmOptions,
+    f: F,
+) -> R {
+    let c_options = c_options
+        .as_ref()
+        .expect("RoutxOsmOptions must not be NULL");
+
+    // NOTE: Functions taking a compiled profile never look at Options::profile,
+    //       so any profile can be used here.
+    f(&c_options.parsed_with_profile(&osm::CAR_PROFILE))
+}
+
 #[unsafe(no_mangle)]
 pub unsafe extern "C" fn routx_graph_add_from_osm_file(
     graph: *mut Graph,
@@ -461,6 +489,29 @@ pub unsafe extern "C" fn routx_graph_add_from_osm_file(
     }
 }
 
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_graph_add_from_osm_file_two_pass(
+    graph: *mut Graph,
+    c_options: *const COsmOptions,
+    c_filename: *const c_char,
+) -> bool {
+    if let (Some(graph), c_filename) = (graph.as_mut(), CStr::from_ptr(c_filename)) {
+        let filename = str::from_utf8_unchecked(c_filename.to_bytes());
+        let result = with_parsed_options(c_options, |options| {
+            osm::add_features_from_file_two_pass(graph, options, filename)
+        });
+        match result {
+            Ok(_) => true,
+            Err(e) => {
+                log::error!(target: "routx", "{}: {}", filename, e);
+                false
+            }
+        }
+    } else {
+        true
+    }
+}
+
 #[unsafe(no_mangle)]
 pub unsafe extern "C" fn routx_graph_add_from_osm_memory(
     graph: *mut Graph,
@@ -490,11 +541,99 @@ pub unsafe extern "C" fn routx_graph_add_from_osm_memory(
     }
 }
 
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_osm_profile_compile(
+    c_profile: *const COsmProfile,
+) -> *mut osm::CompiledProfile {
+    if c_profile.is_null() {
+        null_mut()
+    } else {
+        with_profile(c_profile, |profile| {
+            Box::into_raw(Box::new(profile.compile()))
+        })
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_osm_compiled_profile_delete(ptr: *mut osm::CompiledProfile) {
+    if !ptr.is_null() {
+        drop(Box::from_raw(ptr));
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_graph_add_from_osm_file_compiled(
+    graph: *mut Graph,
+    c_options: *const COsmOptions,
+    profile: *const osm::CompiledProfile,
+    c_filename: *const c_char,
+) -> bool {
+    if let (Some(graph), profile, c_filename) = (
+        graph.as_mut(),
+        profile
+            .as_ref()
+            .expect("RoutxOsmCompiledProfile must not be NULL"),
+        CStr::from_ptr(c_filename),
+    ) {
+        let filename = str::from_utf8_unchecked(c_filename.to_bytes());
+        let result = with_parsed_options_without_profile(c_options, |options| {
+            osm::add_features_from_file_compiled(graph, options, profile, filename)
+        });
+        match result {
+            Ok(_) => true,
+            Err(e) => {
+                log::error!(target: "routx", "{}: {}", filename, e);
+                false
+            }
+        }
+    } else {
+        true
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_graph_add_from_osm_memory_compiled(
+    graph: *mut Graph,
+    c_options: *const COsmOptions,
+    profile: *const osm::CompiledProfile,
+    content: *const u8,
+    content_len: usize,
+) -> bool {
+    if let (Some(graph), profile) = (
+        graph.as_mut(),
+        profile
+            .as_ref()
+            .expect("RoutxOsmCompiledProfile must not be NULL"),
+    ) {
+        let content = std::slice::from_raw_parts(content, content_len);
+        let result = with_parsed_options_without_profile(c_options, |options| {
+            osm::add_features_from_buffer_compiled(graph, options, profile, content)
+        });
+        match result {
+            Ok(_) => true,
+            Err(e) => {
+                log::error!(target: "routx", "<memory>: {}", e);
+                false
+            }
+        }
+    } else {
+        true
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_osm_ingest_stats() -> osm::IngestStats {
+    osm::ingest_stats()
+}
+
 #[repr(C)]
 pub enum CRouteResultType {
     Ok = 0,
     InvalidReference = 1,
     StepLimitExceeded = 2,
+    Cancelled = 3,
+    DeadlineExceeded = 4,
+    TileLoadFailed = 5,
 }
 
 #[repr(C)]
@@ -555,28 +694,15 @@ impl CRouteResult {
         }
     }
 
-    fn empty() -> Self {
+    fn empty(type_: CRouteResultType) -> Self {
         CRouteResult {
             inner: CRouteResultInner { empty: () },
-            type_: CRouteResultType::StepLimitExceeded,
+            type_,
         }
     }
-}
 
-#[unsafe(no_mangle)]
-pub unsafe extern "C" fn routx_find_route(
-    graph: *const Graph,
-    from_id: i64,
-    to_id: i64,
-    max_steps: usize,
-) -> CRouteResult {
-    if let Some(graph) = graph.as_ref() {
-        match find_route(graph, from_id, to_id, max_steps) {
-            Ok(nodes) => CRouteResult::ok(nodes),
-            Err(astar::AStarError::InvalidReference(ref_)) => CRouteResult::invalid_reference(ref_),
-            Err(astar::AStarError::StepLimitExceeded) => CRouteResult::empty(),
-        }
-    } else {
+    /// Ok result with no nodes, returned when a NULL graph is provided.
+    fn null() -> Self {
         CRouteResult {
             inner: CRouteResultInner {
                 ok: ManuallyDrop::new(CRouteResultOk {
@@ -588,6 +714,110 @@ pub unsafe extern "C" fn routx_find_route(
             type_: CRouteResultType::Ok,
         }
     }
+
+    /// Converts a [RouteCache] result, writing the cost of the route to `out_cost`
+    /// (unless it is NULL) on success.
+    unsafe fn from_cached(
+        result: Result<Arc<CachedRoute>, AStarError>,
+        out_cost: *mut f32,
+    ) -> Self {
+        let result = result.map(|route| {
+            if !out_cost.is_null() {
+                out_cost.write(route.cost);
+            }
+            route.nodes.to_vec()
+        });
+        result.into()
+    }
+}
+
+impl From<Result<Vec<i64>, AStarError>> for CRouteResult {
+    fn from(result: Result<Vec<i64>, AStarError>) -> Self {
+        match result {
+            Ok(nodes) => CRouteResult::ok(nodes),
+            Err(AStarError::InvalidReference(ref_)) => CRouteResult::invalid_reference(ref_),
+            Err(e) => CRouteResult::empty(e.into()),
+        }
+    }
+}
+
+impl From<AStarError> for CRouteResultType {
+    fn from(e: AStarError) -> Self {
+        match e {
+            AStarError::InvalidReference(_) => CRouteResultType::InvalidReference,
+            AStarError::StepLimitExceeded => CRouteResultType::StepLimitExceeded,
+            AStarError::Cancelled => CRouteResultType::Cancelled,
+            AStarError::DeadlineExceeded => CRouteResultType::DeadlineExceeded,
+            AStarError::TileLoadFailed => CRouteResultType::TileLoadFailed,
+        }
+    }
+}
+
+/// Outcome of a route search which doesn't transfer ownership of the route.
+#[repr(C)]
+pub struct CRouteStatus {
+    pub type_: CRouteResultType,
+    pub invalid_node_id: i64,
+    pub len: usize,
+}
+
+impl CRouteStatus {
+    /// Ok status with no nodes, returned when a NULL graph is provided.
+    fn null() -> Self {
+        CRouteStatus {
+            type_: CRouteResultType::Ok,
+            invalid_node_id: 0,
+            len: 0,
+        }
+    }
+}
+
+impl From<Result<usize, AStarError>> for CRouteStatus {
+    fn from(result: Result<usize, AStarError>) -> Self {
+        match result {
+            Ok(len) => CRouteStatus {
+                len,
+                ..CRouteStatus::null()
+            },
+            Err(AStarError::InvalidReference(invalid_node_id)) => CRouteStatus {
+                type_: CRouteResultType::InvalidReference,
+                invalid_node_id,
+                len: 0,
+            },
+            Err(e) => CRouteStatus {
+                type_: e.into(),
+                invalid_node_id: 0,
+                len: 0,
+            },
+        }
+    }
+}
+
+/// Answers a route request, leaving the route in [SearchContext::route].
+fn find_route_in_context(
+    graph: &FrozenGraph,
+    ctx: &mut SearchContext,
+    request: &RouteRequest,
+) -> CRouteStatus {
+    let mut route = std::mem::take(&mut ctx.route);
+    let result = graph.find_route_with_request_into(ctx, request, &mut route);
+    let len = route.len();
+    ctx.route = route;
+    result.map(|()| len).into()
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_find_route(
+    graph: *const Graph,
+    from_id: i64,
+    to_id: i64,
+    max_steps: usize,
+) -> CRouteResult {
+    if let Some(graph) = graph.as_ref() {
+        find_route(graph, from_id, to_id, max_steps).into()
+    } else {
+        CRouteResult::null()
+    }
 }
 
 #[unsafe(no_mangle)]
@@ -598,80 +828,1419 @@ pub unsafe extern "C" fn routx_find_route_without_turn_around(
     max_steps: usize,
 ) -> CRouteResult {
     if let Some(graph) = graph.as_ref() {
-        match find_route_without_turn_around(graph, from_id, to_id, max_steps) {
-            Ok(nodes) => CRouteResult::ok(nodes),
-            Err(astar::AStarError::InvalidReference(ref_)) => CRouteResult::invalid_reference(ref_),
-            Err(astar::AStarError::StepLimitExceeded) => CRouteResult::empty(),
-        }
+        find_route_without_turn_around(graph, from_id, to_id, max_steps).into()
     } else {
-        CRouteResult {
-            inner: CRouteResultInner {
-                ok: ManuallyDrop::new(CRouteResultOk {
-                    nodes: null_mut(),
-                    len: 0,
-                    capacity: 0,
-                }),
-            },
-            type_: CRouteResultType::Ok,
-        }
+        CRouteResult::null()
     }
 }
 
 #[unsafe(no_mangle)]
-pub unsafe extern "C" fn routx_route_result_delete(result: CRouteResult) {
-    match result.type_ {
-        CRouteResultType::Ok => {
-            let ok = ManuallyDrop::into_inner(result.inner.ok);
-            if !ok.nodes.is_null() {
-                drop(Vec::from_raw_parts(
-                    ok.nodes,
-                    ok.len as usize,
-                    ok.capacity as usize,
-                ));
-            }
-        }
+pub unsafe extern "C" fn routx_graph_freeze(graph: *const Graph) -> *mut FrozenGraph {
+    if let Some(graph) = graph.as_ref() {
+        Box::into_raw(Box::new(graph.freeze()))
+    } else {
+        null_mut()
+    }
+}
 
-        CRouteResultType::InvalidReference => {
-            // Nothing to free
-        }
+#[derive(Copy, Clone)]
+#[repr(C)]
+pub enum CNodeOrder {
+    Id = 0,
+    Hilbert = 1,
+    Morton = 2,
+}
 
-        CRouteResultType::StepLimitExceeded => {
-            // Nothing to free
+impl From<CNodeOrder> for NodeOrder {
+    fn from(value: CNodeOrder) -> Self {
+        match value {
+            CNodeOrder::Id => NodeOrder::Id,
+            CNodeOrder::Hilbert => NodeOrder::Hilbert,
+            CNodeOrder::Morton => NodeOrder::Morton,
         }
     }
 }
 
 #[unsafe(no_mangle)]
-pub unsafe extern "C" fn routx_kd_tree_new(graph: *const Graph) -> *mut KDTree {
+pub unsafe extern "C" fn routx_frozen_graph_reordered(
+    graph: *const FrozenGraph,
+    order: CNodeOrder,
+) -> *mut FrozenGraph {
     if let Some(graph) = graph.as_ref() {
-        if let Some(kd) = KDTree::build_from_graph(graph) {
-            return Box::into_raw(Box::new(kd));
-        }
+        Box::into_raw(Box::new(graph.reordered(order.into())))
+    } else {
+        null_mut()
     }
-
-    null_mut()
 }
 
 #[unsafe(no_mangle)]
-pub unsafe extern "C" fn routx_kd_tree_delete(ptr: *mut KDTree) {
+pub unsafe extern "C" fn routx_frozen_graph_delete(ptr: *mut FrozenGraph) {
     if !ptr.is_null() {
         drop(Box::from_raw(ptr));
     }
 }
 
 #[unsafe(no_mangle)]
-pub unsafe extern "C" fn routx_kd_tree_find_nearest_node(
-    kd_tree: *const KDTree,
-    lat: f32,
-    lon: f32,
-) -> Node {
-    kd_tree
+pub unsafe extern "C" fn routx_graph_save(graph: *const Graph, c_filename: *const c_char) -> bool {
+    if let Some(graph) = graph.as_ref() {
+        routx_frozen_graph_save(&graph.freeze(), c_filename)
+    } else {
+        false
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_frozen_graph_save(
+    graph: *const FrozenGraph,
+    c_filename: *const c_char,
+) -> bool {
+    if let Some(graph) = graph.as_ref() {
+        let filename = str::from_utf8_unchecked(CStr::from_ptr(c_filename).to_bytes());
+        match graph.save(filename) {
+            Ok(_) => true,
+            Err(e) => {
+                log::error!(target: "routx", "{}: {}", filename, e);
+                false
+            }
+        }
+    } else {
+        false
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_graph_open_mmap(c_filename: *const c_char) -> *mut FrozenGraph {
+    let filename = str::from_utf8_unchecked(CStr::from_ptr(c_filename).to_bytes());
+    match FrozenGraph::open_mmap(filename) {
+        Ok(graph) => Box::into_raw(Box::new(graph)),
+        Err(e) => {
+            log::error!(target: "routx", "{}: {}", filename, e);
+            null_mut()
+        }
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_frozen_graph_len(graph: *const FrozenGraph) -> usize {
+    graph.as_ref().map(|g| g.len()).unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_frozen_graph_edge_count(graph: *const FrozenGraph) -> usize {
+    graph.as_ref().map(|g| g.edge_count()).unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_frozen_graph_get_node(graph: *const FrozenGraph, id: i64) -> Node {
+    graph
         .as_ref()
-        .and_then(|kd| Some(kd.find_nearest_node(lat, lon)))
+        .and_then(|g| g.get_node(id))
         .unwrap_or(Node::ZERO)
 }
 
 #[unsafe(no_mangle)]
-pub unsafe extern "C" fn routx_earth_distance(lat1: f32, lon1: f32, lat2: f32, lon2: f32) -> f32 {
-    earth_distance(lat1, lon1, lat2, lon2)
+pub unsafe extern "C" fn routx_frozen_graph_get_edge(
+    graph: *const FrozenGraph,
+    from_id: i64,
+    to_id: i64,
+) -> f32 {
+    graph
+        .as_ref()
+        .map(|g| g.get_edge(from_id, to_id))
+        .unwrap_or(f32::INFINITY)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_frozen_graph_find_route(
+    graph: *const FrozenGraph,
+    from_id: i64,
+    to_id: i64,
+    max_steps: usize,
+) -> CRouteResult {
+    if let Some(graph) = graph.as_ref() {
+        graph.find_route(from_id, to_id, max_steps).into()
+    } else {
+        CRouteResult::null()
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_frozen_graph_find_route_without_turn_around(
+    graph: *const FrozenGraph,
+    from_id: i64,
+    to_id: i64,
+    max_steps: usize,
+) -> CRouteResult {
+    if let Some(graph) = graph.as_ref() {
+        graph
+            .find_route_without_turn_around(from_id, to_id, max_steps)
+            .into()
+    } else {
+        CRouteResult::null()
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_search_context_new() -> *mut SearchContext {
+    Box::into_raw(Box::new(SearchContext::new()))
+}
+
+#[derive(Copy, Clone)]
+#[repr(C)]
+pub enum CQueueKind {
+    Binary = 0,
+    Quaternary = 1,
+    Radix = 2,
+}
+
+impl From<CQueueKind> for QueueKind {
+    fn from(value: CQueueKind) -> Self {
+        match value {
+            CQueueKind::Binary => QueueKind::Binary,
+            CQueueKind::Quaternary => QueueKind::Quaternary,
+            CQueueKind::Radix => QueueKind::Radix,
+        }
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_search_context_new_with_queue(
+    kind: CQueueKind,
+) -> *mut SearchContext {
+    Box::into_raw(Box::new(SearchContext::with_queue(kind.into())))
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_search_context_delete(ptr: *mut SearchContext) {
+    if !ptr.is_null() {
+        drop(Box::from_raw(ptr));
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_search_context_stats(ctx: *const SearchContext) -> SearchStats {
+    ctx.as_ref().map(SearchContext::stats).unwrap_or_default()
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_search_context_set_timing(ctx: *mut SearchContext, enabled: bool) {
+    if let Some(ctx) = ctx.as_mut() {
+        ctx.set_timing(enabled);
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_frozen_graph_find_route_with_context(
+    graph: *const FrozenGraph,
+    ctx: *mut SearchContext,
+    from_id: i64,
+    to_id: i64,
+    max_steps: usize,
+) -> CRouteResult {
+    match (graph.as_ref(), ctx.as_mut()) {
+        (Some(graph), Some(ctx)) => graph
+            .find_route_with_context(ctx, from_id, to_id, max_steps)
+            .into(),
+        (Some(graph), None) => graph.find_route(from_id, to_id, max_steps).into(),
+        (None, _) => CRouteResult::null(),
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_frozen_graph_find_route_without_turn_around_with_context(
+    graph: *const FrozenGraph,
+    ctx: *mut SearchContext,
+    from_id: i64,
+    to_id: i64,
+    max_steps: usize,
+) -> CRouteResult {
+    match (graph.as_ref(), ctx.as_mut()) {
+        (Some(graph), Some(ctx)) => graph
+            .find_route_without_turn_around_with_context(ctx, from_id, to_id, max_steps)
+            .into(),
+        (Some(graph), None) => graph
+            .find_route_without_turn_around(from_id, to_id, max_steps)
+            .into(),
+        (None, _) => CRouteResult::null(),
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_frozen_graph_find_route_into(
+    graph: *const FrozenGraph,
+    ctx: *mut SearchContext,
+    request: *const RouteRequest,
+    out: *mut i64,
+    capacity: usize,
+) -> CRouteStatus {
+    let (Some(graph), Some(request)) = (graph.as_ref(), request.as_ref()) else {
+        return CRouteStatus::null();
+    };
+
+    let mut temporary_ctx = SearchContext::new();
+    let ctx = ctx.as_mut().unwrap_or(&mut temporary_ctx);
+    let status = find_route_in_context(graph, ctx, request);
+    if status.len > 0 && status.len <= capacity {
+        slice::from_raw_parts_mut(out, status.len).copy_from_slice(&ctx.route);
+    }
+    status
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_frozen_graph_find_route_borrowed(
+    graph: *const FrozenGraph,
+    ctx: *mut SearchContext,
+    request: *const RouteRequest,
+    out_nodes: *mut *const i64,
+) -> CRouteStatus {
+    if !out_nodes.is_null() {
+        out_nodes.write(std::ptr::null());
+    }
+    let (Some(graph), Some(ctx), Some(request)) = (graph.as_ref(), ctx.as_mut(), request.as_ref())
+    else {
+        return CRouteStatus::null();
+    };
+
+    let status = find_route_in_context(graph, ctx, request);
+    if !out_nodes.is_null() && status.len > 0 {
+        out_nodes.write(ctx.route.as_ptr());
+    }
+    status
+}
+
+/// Caller-owned parallel arrays for a [RouteDetailed].
+#[repr(C)]
+pub struct CRouteDetailed {
+    pub ids: *mut i64,
+    pub lats: *mut f32,
+    pub lons: *mut f32,
+    pub costs: *mut f32,
+    pub capacity: usize,
+}
+
+impl CRouteDetailed {
+    /// Copies the route into the non-NULL arrays, if it fits in them.
+    unsafe fn write(&self, route: &RouteDetailed) {
+        let len = route.len();
+        if len == 0 || len > self.capacity {
+            return;
+        }
+        if !self.ids.is_null() {
+            slice::from_raw_parts_mut(self.ids, len).copy_from_slice(&route.ids);
+        }
+        if !self.lats.is_null() {
+            slice::from_raw_parts_mut(self.lats, len).copy_from_slice(&route.lats);
+        }
+        if !self.lons.is_null() {
+            slice::from_raw_parts_mut(self.lons, len).copy_from_slice(&route.lons);
+        }
+        if !self.costs.is_null() {
+            slice::from_raw_parts_mut(self.costs, len).copy_from_slice(&route.costs);
+        }
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_find_route_detailed(
+    graph: *const Graph,
+    from_id: i64,
+    to_id: i64,
+    max_steps: usize,
+    out: *const CRouteDetailed,
+) -> CRouteStatus {
+    let Some(graph) = graph.as_ref() else {
+        return CRouteStatus::null();
+    };
+
+    let result = find_route_detailed(graph, from_id, to_id, max_steps);
+    if let (Ok(route), Some(out)) = (&result, out.as_ref()) {
+        out.write(route);
+    }
+    result.map(|route| route.len()).into()
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_frozen_graph_find_route_detailed(
+    graph: *const FrozenGraph,
+    ctx: *mut SearchContext,
+    request: *const RouteRequest,
+    out: *const CRouteDetailed,
+) -> CRouteStatus {
+    let (Some(graph), Some(request)) = (graph.as_ref(), request.as_ref()) else {
+        return CRouteStatus::null();
+    };
+
+    let mut temporary_ctx = SearchContext::new();
+    let ctx = ctx.as_mut().unwrap_or(&mut temporary_ctx);
+    let mut route = std::mem::take(&mut ctx.route_detailed);
+    let result = graph.find_route_detailed_into(ctx, request, &mut route);
+    if let (Ok(()), Some(out)) = (&result, out.as_ref()) {
+        out.write(&route);
+    }
+    let len = route.len();
+    ctx.route_detailed = route;
+    result.map(|()| len).into()
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_reachable(
+    graph: *const FrozenGraph,
+    ctx: *mut SearchContext,
+    from_id: i64,
+    max_cost: f32,
+    max_steps: usize,
+    callback: Option<unsafe extern "C" fn(*mut c_void, i64, f32)>,
+    arg: *mut c_void,
+    out_hull: *mut Node,
+    hull_capacity: usize,
+    out_hull_len: *mut usize,
+) -> CRouteStatus {
+    if !out_hull_len.is_null() {
+        out_hull_len.write(0);
+    }
+    let Some(graph) = graph.as_ref() else {
+        return CRouteStatus::null();
+    };
+
+    let mut temporary_ctx = SearchContext::new();
+    let ctx = ctx.as_mut().unwrap_or(&mut temporary_ctx);
+    let report = |id: i64, cost: f32| {
+        if let Some(callback) = callback {
+            callback(arg, id, cost);
+        }
+    };
+
+    if out_hull_len.is_null() {
+        return graph
+            .reachable(ctx, from_id, max_cost, max_steps, report)
+            .into();
+    }
+
+    let mut hull = std::mem::take(&mut ctx.hull);
+    let result = graph.reachable_with_hull(ctx, from_id, max_cost, max_steps, &mut hull, report);
+    out_hull_len.write(hull.len());
+    if !hull.is_empty() && hull.len() <= hull_capacity {
+        slice::from_raw_parts_mut(out_hull, hull.len()).copy_from_slice(&hull);
+    }
+    ctx.hull = hull;
+    result.into()
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_find_route_bidirectional(
+    graph: *const FrozenGraph,
+    ctx: *mut SearchContext,
+    from_id: i64,
+    to_id: i64,
+    max_steps: usize,
+) -> CRouteResult {
+    match (graph.as_ref(), ctx.as_mut()) {
+        (Some(graph), Some(ctx)) => graph
+            .find_route_bidirectional_with_context(ctx, from_id, to_id, max_steps)
+            .into(),
+        (Some(graph), None) => graph
+            .find_route_bidirectional(from_id, to_id, max_steps)
+            .into(),
+        (None, _) => CRouteResult::null(),
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_cost_matrix(
+    graph: *const FrozenGraph,
+    sources: *const i64,
+    sources_len: usize,
+    targets: *const i64,
+    targets_len: usize,
+    max_steps: usize,
+    out_costs: *mut f32,
+) {
+    if sources_len == 0 || targets_len == 0 {
+        return;
+    }
+
+    let sources = slice::from_raw_parts(sources, sources_len);
+    let targets = slice::from_raw_parts(targets, targets_len);
+    let out = slice::from_raw_parts_mut(out_costs, sources_len * targets_len);
+
+    if let Some(graph) = graph.as_ref() {
+        graph.cost_matrix_into(&mut SearchContext::new(), sources, targets, max_steps, out);
+    } else {
+        out.fill(f32::INFINITY);
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_find_routes_parallel(
+    graph: *const FrozenGraph,
+    requests: *const RouteRequest,
+    requests_len: usize,
+    out_results: *mut CRouteResult,
+    threads: c_uint,
+) {
+    if requests_len == 0 {
+        return;
+    }
+
+    let out = slice::from_raw_parts_mut(out_results, requests_len);
+    if let Some(graph) = graph.as_ref() {
+        let requests = slice::from_raw_parts(requests, requests_len);
+        let results = graph.find_routes_parallel(requests, threads as usize);
+        for (out, result) in out.iter_mut().zip(results) {
+            (out as *mut CRouteResult).write(result.into());
+        }
+    } else {
+        for out in out {
+            (out as *mut CRouteResult).write(CRouteResult::null());
+        }
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_search_pool_new(threads: c_uint) -> *mut SearchPool {
+    Box::into_raw(Box::new(SearchPool::new(threads as usize)))
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_search_pool_delete(ptr: *mut SearchPool) {
+    if !ptr.is_null() {
+        drop(Box::from_raw(ptr));
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_find_route_async(
+    pool: *const SearchPool,
+    graph: *const FrozenGraph,
+    request: *const RouteRequest,
+    timeout_us: u64,
+) -> *mut RouteTask {
+    match (pool.as_ref(), graph.as_ref(), request.as_ref()) {
+        (Some(pool), Some(graph), Some(request)) => {
+            let timeout = (timeout_us != 0).then(|| Duration::from_micros(timeout_us));
+            Box::into_raw(Box::new(pool.submit(graph, *request, timeout)))
+        }
+        _ => null_mut(),
+    }
+}
+
+type CTaskCallback = unsafe extern "C" fn(arg: *mut c_void);
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_route_task_on_done(
+    task: *const RouteTask,
+    callback: CTaskCallback,
+    arg: *mut c_void,
+) -> bool {
+    let Some(task) = task.as_ref() else {
+        return false;
+    };
+
+    let arg = arg as usize; // rust is stupid and `*mut c_void` is not `Send`
+    task.on_done(move || callback(arg as *mut c_void))
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_route_task_is_done(task: *const RouteTask) -> bool {
+    task.as_ref().map_or(true, RouteTask::is_done)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_route_task_cancel(task: *const RouteTask) {
+    if let Some(task) = task.as_ref() {
+        task.cancel();
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_route_task_wait(task: *mut RouteTask) -> CRouteResult {
+    if task.is_null() {
+        CRouteResult::null()
+    } else {
+        Box::from_raw(task).wait().into()
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_route_task_delete(task: *mut RouteTask) {
+    if !task.is_null() {
+        drop(Box::from_raw(task));
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_ch_build(graph: *const Graph) -> *mut CHGraph {
+    if let Some(graph) = graph.as_ref() {
+        Box::into_raw(Box::new(CHGraph::from_graph(graph)))
+    } else {
+        null_mut()
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_ch_graph_delete(ptr: *mut CHGraph) {
+    if !ptr.is_null() {
+        drop(Box::from_raw(ptr));
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_ch_graph_len(graph: *const CHGraph) -> usize {
+    graph.as_ref().map(|g| g.len()).unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_ch_find_route(
+    graph: *const CHGraph,
+    from_id: i64,
+    to_id: i64,
+    max_steps: usize,
+) -> CRouteResult {
+    routx_ch_find_route_with_context(graph, null_mut(), from_id, to_id, max_steps)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_ch_find_route_with_context(
+    graph: *const CHGraph,
+    ctx: *mut SearchContext,
+    from_id: i64,
+    to_id: i64,
+    max_steps: usize,
+) -> CRouteResult {
+    match (graph.as_ref(), ctx.as_mut()) {
+        (Some(graph), Some(ctx)) => graph
+            .find_route_with_context(ctx, from_id, to_id, max_steps)
+            .into(),
+        (Some(graph), None) => graph.find_route(from_id, to_id, max_steps).into(),
+        (None, _) => CRouteResult::null(),
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_compact_graph_build(
+    graph: *const FrozenGraph,
+    cost_scale: f32,
+) -> *mut CompactGraph {
+    let Some(graph) = graph.as_ref() else {
+        return null_mut();
+    };
+    if !(cost_scale > 0.0 && cost_scale.is_finite()) {
+        log::error!(target: "routx", "invalid edge cost scale: {}", cost_scale);
+        return null_mut();
+    }
+    Box::into_raw(Box::new(CompactGraph::from_frozen(graph, cost_scale)))
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_compact_graph_delete(ptr: *mut CompactGraph) {
+    if !ptr.is_null() {
+        drop(Box::from_raw(ptr));
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_compact_graph_save(
+    graph: *const CompactGraph,
+    c_filename: *const c_char,
+) -> bool {
+    if let Some(graph) = graph.as_ref() {
+        let filename = str::from_utf8_unchecked(CStr::from_ptr(c_filename).to_bytes());
+        match graph.save(filename) {
+            Ok(_) => true,
+            Err(e) => {
+                log::error!(target: "routx", "{}: {}", filename, e);
+                false
+            }
+        }
+    } else {
+        false
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_compact_graph_open_mmap(
+    c_filename: *const c_char,
+) -> *mut CompactGraph {
+    let filename = str::from_utf8_unchecked(CStr::from_ptr(c_filename).to_bytes());
+    match CompactGraph::open_mmap(filename) {
+        Ok(graph) => Box::into_raw(Box::new(graph)),
+        Err(e) => {
+            log::error!(target: "routx", "{}: {}", filename, e);
+            null_mut()
+        }
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_compact_graph_len(graph: *const CompactGraph) -> usize {
+    graph.as_ref().map(|g| g.len()).unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_compact_graph_edge_count(graph: *const CompactGraph) -> usize {
+    graph.as_ref().map(|g| g.edge_count()).unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_compact_graph_get_node(graph: *const CompactGraph, id: i64) -> Node {
+    graph
+        .as_ref()
+        .and_then(|g| g.get_node(id))
+        .unwrap_or(Node::ZERO)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_compact_graph_get_edge(
+    graph: *const CompactGraph,
+    from_id: i64,
+    to_id: i64,
+) -> f32 {
+    graph
+        .as_ref()
+        .map(|g| g.get_edge(from_id, to_id))
+        .unwrap_or(f32::INFINITY)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_compact_graph_find_route_with_context(
+    graph: *const CompactGraph,
+    ctx: *mut SearchContext,
+    from_id: i64,
+    to_id: i64,
+    max_steps: usize,
+) -> CRouteResult {
+    match (graph.as_ref(), ctx.as_mut()) {
+        (Some(graph), Some(ctx)) => graph
+            .find_route_with_context(ctx, from_id, to_id, max_steps)
+            .into(),
+        (Some(graph), None) => graph.find_route(from_id, to_id, max_steps).into(),
+        (None, _) => CRouteResult::null(),
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_landmarks_build(
+    graph: *const FrozenGraph,
+    count: usize,
+) -> *mut Landmarks {
+    if let Some(graph) = graph.as_ref() {
+        Box::into_raw(Box::new(Landmarks::build(graph, count)))
+    } else {
+        null_mut()
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_landmarks_delete(ptr: *mut Landmarks) {
+    if !ptr.is_null() {
+        drop(Box::from_raw(ptr));
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_landmarks_len(landmarks: *const Landmarks) -> usize {
+    landmarks.as_ref().map(|lm| lm.len()).unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_landmarks_save(
+    landmarks: *const Landmarks,
+    c_filename: *const c_char,
+) -> bool {
+    if let Some(landmarks) = landmarks.as_ref() {
+        let filename = str::from_utf8_unchecked(CStr::from_ptr(c_filename).to_bytes());
+        match landmarks.save(filename) {
+            Ok(_) => true,
+            Err(e) => {
+                log::error!(target: "routx", "{}: {}", filename, e);
+                false
+            }
+        }
+    } else {
+        false
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_landmarks_load(c_filename: *const c_char) -> *mut Landmarks {
+    let filename = str::from_utf8_unchecked(CStr::from_ptr(c_filename).to_bytes());
+    match Landmarks::load(filename) {
+        Ok(landmarks) => Box::into_raw(Box::new(landmarks)),
+        Err(e) => {
+            log::error!(target: "routx", "{}: {}", filename, e);
+            null_mut()
+        }
+    }
+}
+
+unsafe fn with_landmarks<F, G>(
+    graph: &FrozenGraph,
+    landmarks: *const Landmarks,
+    ctx: *mut SearchContext,
+    with: F,
+    without: G,
+) -> CRouteResult
+where
+    F: FnOnce(&mut SearchContext, &Landmarks) -> Result<Vec<i64>, AStarError>,
+    G: FnOnce(&mut SearchContext) -> Result<Vec<i64>, AStarError>,
+{
+    let mut tmp_ctx = SearchContext::default();
+    let ctx = ctx.as_mut().unwrap_or(&mut tmp_ctx);
+
+    match landmarks.as_ref() {
+        Some(landmarks) if landmarks.is_compatible_with(graph) => with(ctx, landmarks).into(),
+        Some(_) => {
+            log::warn!(target: "routx", "landmarks built for a different graph, ignoring them");
+            without(ctx).into()
+        }
+        None => without(ctx).into(),
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_frozen_graph_find_route_with_landmarks(
+    graph: *const FrozenGraph,
+    landmarks: *const Landmarks,
+    ctx: *mut SearchContext,
+    from_id: i64,
+    to_id: i64,
+    max_steps: usize,
+) -> CRouteResult {
+    if let Some(graph) = graph.as_ref() {
+        with_landmarks(
+            graph,
+            landmarks,
+            ctx,
+            |ctx, lm| graph.find_route_with_landmarks(ctx, lm, from_id, to_id, max_steps),
+            |ctx| graph.find_route_with_context(ctx, from_id, to_id, max_steps),
+        )
+    } else {
+        CRouteResult::null()
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_frozen_graph_find_route_without_turn_around_with_landmarks(
+    graph: *const FrozenGraph,
+    landmarks: *const Landmarks,
+    ctx: *mut SearchContext,
+    from_id: i64,
+    to_id: i64,
+    max_steps: usize,
+) -> CRouteResult {
+    if let Some(graph) = graph.as_ref() {
+        with_landmarks(
+            graph,
+            landmarks,
+            ctx,
+            |ctx, lm| {
+                graph.find_route_without_turn_around_with_landmarks(
+                    ctx, lm, from_id, to_id, max_steps,
+                )
+            },
+            |ctx| graph.find_route_without_turn_around_with_context(ctx, from_id, to_id, max_steps),
+        )
+    } else {
+        CRouteResult::null()
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_cost_overlay_new(graph: *const FrozenGraph) -> *mut CostOverlay {
+    if let Some(graph) = graph.as_ref() {
+        Box::into_raw(Box::new(CostOverlay::new(graph.clone())))
+    } else {
+        null_mut()
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_cost_overlay_delete(ptr: *mut CostOverlay) {
+    if !ptr.is_null() {
+        drop(Box::from_raw(ptr));
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_cost_overlay_epoch(overlay: *const CostOverlay) -> u64 {
+    overlay.as_ref().map(|o| o.epoch()).unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_cost_overlay_snapshot(
+    overlay: *const CostOverlay,
+    out_epoch: *mut u64,
+) -> *mut FrozenGraph {
+    let Some(overlay) = overlay.as_ref() else {
+        return null_mut();
+    };
+
+    let snapshot = overlay.snapshot();
+    if !out_epoch.is_null() {
+        out_epoch.write(snapshot.epoch);
+    }
+    Box::into_raw(Box::new(FrozenGraph::clone(&snapshot.graph)))
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_cost_overlay_set_factors(
+    overlay: *const CostOverlay,
+    factors: *const f32,
+    factors_len: usize,
+) -> u64 {
+    let Some(overlay) = overlay.as_ref() else {
+        return 0;
+    };
+
+    if factors_len != overlay.base().edge_count() {
+        log::error!(
+            target: "routx",
+            "routx_cost_overlay_set_factors: expected {} factors, got {}",
+            overlay.base().edge_count(),
+            factors_len,
+        );
+        return 0;
+    }
+
+    let factors = if factors_len == 0 {
+        &[]
+    } else {
+        slice::from_raw_parts(factors, factors_len)
+    };
+    overlay.set_factors(factors)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_cost_overlay_update_factors(
+    overlay: *const CostOverlay,
+    updates: *const EdgeFactor,
+    updates_len: usize,
+) -> u64 {
+    let Some(overlay) = overlay.as_ref() else {
+        return 0;
+    };
+
+    let updates = if updates_len == 0 {
+        &[]
+    } else {
+        slice::from_raw_parts(updates, updates_len)
+    };
+    overlay.update_factors(updates)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_route_result_delete(result: CRouteResult) {
+    match result.type_ {
+        CRouteResultType::Ok => {
+            let ok = ManuallyDrop::into_inner(result.inner.ok);
+            if !ok.nodes.is_null() {
+                drop(Vec::from_raw_parts(
+                    ok.nodes,
+                    ok.len as usize,
+                    ok.capacity as usize,
+                ));
+            }
+        }
+
+        CRouteResultType::InvalidReference => {
+            // Nothing to free
+        }
+
+        CRouteResultType::StepLimitExceeded
+        | CRouteResultType::Cancelled
+        | CRouteResultType::DeadlineExceeded
+        | CRouteResultType::TileLoadFailed => {
+            // Nothing to free
+        }
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_kd_tree_new(graph: *const Graph) -> *mut KDTree {
+    if let Some(graph) = graph.as_ref() {
+        if let Some(kd) = KDTree::build_from_graph(graph) {
+            return Box::into_raw(Box::new(kd));
+        }
+    }
+
+    null_mut()
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_kd_tree_delete(ptr: *mut KDTree) {
+    if !ptr.is_null() {
+        drop(Box::from_raw(ptr));
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_kd_tree_find_nearest_node(
+    kd_tree: *const KDTree,
+    lat: f32,
+    lon: f32,
+) -> Node {
+    kd_tree
+        .as_ref()
+        .and_then(|kd| Some(kd.find_nearest_node(lat, lon)))
+        .unwrap_or(Node::ZERO)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_kd_tree_find_k_nearest(
+    kd_tree: *const KDTree,
+    lat: f32,
+    lon: f32,
+    k: usize,
+    out: *mut Node,
+) -> usize {
+    if let Some(kd) = kd_tree.as_ref() {
+        let nodes = kd.find_k_nearest_nodes(lat, lon, k);
+        slice::from_raw_parts_mut(out, nodes.len()).copy_from_slice(&nodes);
+        nodes.len()
+    } else {
+        0
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_kd_tree_find_nearest_nodes(
+    kd_tree: *const KDTree,
+    lats: *const f32,
+    lons: *const f32,
+    n: usize,
+    out: *mut Node,
+    threads: c_uint,
+) {
+    if n == 0 {
+        return;
+    }
+
+    let out = slice::from_raw_parts_mut(out, n);
+    if let Some(kd) = kd_tree.as_ref() {
+        let lats = slice::from_raw_parts(lats, n);
+        let lons = slice::from_raw_parts(lons, n);
+        kd.find_nearest_nodes_into(lats, lons, threads as usize, out);
+    } else {
+        out.fill(Node::ZERO);
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_grid_index_new(
+    graph: *const Graph,
+    cell_size: f32,
+) -> *mut GridIndex {
+    let Some(graph) = graph.as_ref() else {
+        return null_mut();
+    };
+    if !(cell_size > 0.0 && cell_size.is_finite()) {
+        log::error!(target: "routx", "invalid grid cell size: {}", cell_size);
+        return null_mut();
+    }
+    if let Some(index) = GridIndex::build_from_graph(graph, cell_size) {
+        Box::into_raw(Box::new(index))
+    } else {
+        null_mut()
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_grid_index_delete(ptr: *mut GridIndex) {
+    if !ptr.is_null() {
+        drop(Box::from_raw(ptr));
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_grid_index_find_nearest_node(
+    index: *const GridIndex,
+    lat: f32,
+    lon: f32,
+) -> Node {
+    index
+        .as_ref()
+        .map(|index| index.find_nearest_node(lat, lon))
+        .unwrap_or(Node::ZERO)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_grid_index_find_nearest_node_cached(
+    index: *const GridIndex,
+    cache: *mut SnapCache,
+    lat: f32,
+    lon: f32,
+) -> Node {
+    match (index.as_ref(), cache.as_mut()) {
+        (Some(index), Some(cache)) => index.find_nearest_node_cached(cache, lat, lon),
+        (Some(index), None) => index.find_nearest_node(lat, lon),
+        (None, _) => Node::ZERO,
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_grid_index_find_nearest_nodes(
+    index: *const GridIndex,
+    lats: *const f32,
+    lons: *const f32,
+    n: usize,
+    out: *mut Node,
+    threads: c_uint,
+) {
+    if n == 0 {
+        return;
+    }
+
+    let out = slice::from_raw_parts_mut(out, n);
+    if let Some(index) = index.as_ref() {
+        let lats = slice::from_raw_parts(lats, n);
+        let lons = slice::from_raw_parts(lons, n);
+        index.find_nearest_nodes_into(lats, lons, threads as usize, out);
+    } else {
+        out.fill(Node::ZERO);
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_snap_cache_new(capacity: usize, quantum: f32) -> *mut SnapCache {
+    if !(quantum > 0.0 && quantum.is_finite()) {
+        log::error!(target: "routx", "invalid snap cache quantum: {}", quantum);
+        return null_mut();
+    }
+    Box::into_raw(Box::new(SnapCache::new(capacity, quantum)))
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_snap_cache_delete(ptr: *mut SnapCache) {
+    if !ptr.is_null() {
+        drop(Box::from_raw(ptr));
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_snap_cache_clear(cache: *mut SnapCache) {
+    if let Some(cache) = cache.as_mut() {
+        cache.clear();
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_snap_cache_len(cache: *const SnapCache) -> usize {
+    cache.as_ref().map(SnapCache::len).unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_snap_cache_hits(cache: *const SnapCache) -> u64 {
+    cache.as_ref().map(SnapCache::hits).unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_snap_cache_misses(cache: *const SnapCache) -> u64 {
+    cache.as_ref().map(SnapCache::misses).unwrap_or(0)
+}
+
+#[derive(Copy, Clone)]
+#[repr(C)]
+pub enum CRouteKind {
+    Shortest = 0,
+    WithoutTurnAround = 1,
+}
+
+impl From<CRouteKind> for RouteKind {
+    fn from(value: CRouteKind) -> Self {
+        match value {
+            CRouteKind::Shortest => RouteKind::Shortest,
+            CRouteKind::WithoutTurnAround => RouteKind::WithoutTurnAround,
+        }
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_route_cache_new(capacity: usize) -> *mut RouteCache {
+    Box::into_raw(Box::new(RouteCache::new(capacity)))
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_route_cache_delete(ptr: *mut RouteCache) {
+    if !ptr.is_null() {
+        drop(Box::from_raw(ptr));
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_route_cache_clear(cache: *const RouteCache) {
+    if let Some(cache) = cache.as_ref() {
+        cache.clear();
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_route_cache_len(cache: *const RouteCache) -> usize {
+    cache.as_ref().map(RouteCache::len).unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_route_cache_hits(cache: *const RouteCache) -> u64 {
+    cache.as_ref().map(RouteCache::hits).unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_route_cache_misses(cache: *const RouteCache) -> u64 {
+    cache.as_ref().map(RouteCache::misses).unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_route_cache_find_route(
+    cache: *const RouteCache,
+    graph: *const Graph,
+    kind: CRouteKind,
+    from_id: i64,
+    to_id: i64,
+    max_steps: usize,
+    out_cost: *mut f32,
+) -> CRouteResult {
+    let Some(graph) = graph.as_ref() else {
+        return CRouteResult::null();
+    };
+
+    // A NULL cache searches without caching anything
+    let result = match cache.as_ref() {
+        Some(cache) => cache.find_route(graph, kind.into(), from_id, to_id, max_steps),
+        None => RouteCache::new(0).find_route(graph, kind.into(), from_id, to_id, max_steps),
+    };
+    CRouteResult::from_cached(result, out_cost)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_route_cache_find_route_with_overlay(
+    cache: *const RouteCache,
+    overlay: *const CostOverlay,
+    kind: CRouteKind,
+    from_id: i64,
+    to_id: i64,
+    max_steps: usize,
+    out_cost: *mut f32,
+) -> CRouteResult {
+    let Some(overlay) = overlay.as_ref() else {
+        return CRouteResult::null();
+    };
+
+    let snapshot = overlay.snapshot();
+    let result = match cache.as_ref() {
+        Some(cache) => {
+            cache.find_route_in_snapshot(&snapshot, kind.into(), from_id, to_id, max_steps)
+        }
+        None => RouteCache::new(0).find_route_in_snapshot(
+            &snapshot,
+            kind.into(),
+            from_id,
+            to_id,
+            max_steps,
+        ),
+    };
+    CRouteResult::from_cached(result, out_cost)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_shared_graph_new(graph: *mut Graph) -> *mut Arc<Graph> {
+    if graph.is_null() {
+        null_mut()
+    } else {
+        let graph = Box::from_raw(graph);
+        Box::into_raw(Box::new(Arc::from(graph)))
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_shared_graph_clone(graph: *const Arc<Graph>) -> *mut Arc<Graph> {
+    if let Some(graph) = graph.as_ref() {
+        Box::into_raw(Box::new(Arc::clone(graph)))
+    } else {
+        null_mut()
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_shared_graph_delete(ptr: *mut Arc<Graph>) {
+    if !ptr.is_null() {
+        drop(Box::from_raw(ptr));
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_shared_graph_get(graph: *const Arc<Graph>) -> *const Graph {
+    graph.as_ref().map_or(std::ptr::null(), |g| Arc::as_ptr(g))
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_shared_graph_use_count(graph: *const Arc<Graph>) -> usize {
+    graph.as_ref().map_or(0, Arc::strong_count)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_graph_slot_new(graph: *const Arc<Graph>) -> *mut SwapCell<Graph> {
+    if let Some(graph) = graph.as_ref() {
+        Box::into_raw(Box::new(SwapCell::new(Arc::clone(graph))))
+    } else {
+        null_mut()
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_graph_slot_delete(ptr: *mut SwapCell<Graph>) {
+    if !ptr.is_null() {
+        drop(Box::from_raw(ptr));
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_graph_slot_load(slot: *const SwapCell<Graph>) -> *mut Arc<Graph> {
+    if let Some(slot) = slot.as_ref() {
+        Box::into_raw(Box::new(slot.load()))
+    } else {
+        null_mut()
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_graph_slot_store(
+    slot: *const SwapCell<Graph>,
+    graph: *const Arc<Graph>,
+) -> bool {
+    match (slot.as_ref(), graph.as_ref()) {
+        (Some(slot), Some(graph)) => {
+            // Drop the previous graph after releasing the lock
+            drop(slot.store(Arc::clone(graph)));
+            true
+        }
+        _ => false,
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_tiled_graph_save(
+    graph: *const FrozenGraph,
+    c_dirname: *const c_char,
+    tile_size: f32,
+) -> bool {
+    let Some(graph) = graph.as_ref() else {
+        return false;
+    };
+
+    let dirname = str::from_utf8_unchecked(CStr::from_ptr(c_dirname).to_bytes());
+    if !(tile_size.is_finite() && tile_size > 0.0) {
+        log::error!(target: "routx", "{}: invalid tile size {}", dirname, tile_size);
+        return false;
+    }
+
+    match TiledGraph::save(graph, dirname, tile_size) {
+        Ok(_) => true,
+        Err(e) => {
+            log::error!(target: "routx", "{}: {}", dirname, e);
+            false
+        }
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_tiled_graph_open(
+    c_dirname: *const c_char,
+    memory_budget: usize,
+) -> *mut TiledGraph {
+    let dirname = str::from_utf8_unchecked(CStr::from_ptr(c_dirname).to_bytes());
+    match TiledGraph::open(dirname, memory_budget) {
+        Ok(graph) => Box::into_raw(Box::new(graph)),
+        Err(e) => {
+            log::error!(target: "routx", "{}: {}", dirname, e);
+            null_mut()
+        }
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_tiled_graph_delete(ptr: *mut TiledGraph) {
+    if !ptr.is_null() {
+        drop(Box::from_raw(ptr));
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_tiled_graph_len(graph: *const TiledGraph) -> usize {
+    graph.as_ref().map(|g| g.len()).unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_tiled_graph_stats(graph: *const TiledGraph) -> TileStats {
+    graph.as_ref().map(|g| g.stats()).unwrap_or_default()
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_tiled_graph_get_node(graph: *const TiledGraph, id: i64) -> Node {
+    let Some(graph) = graph.as_ref() else {
+        return Node::ZERO;
+    };
+
+    match graph.get_node(id) {
+        Ok(node) => node.unwrap_or(Node::ZERO),
+        Err(e) => {
+            log::error!(target: "routx", "failed to load tile of node {}: {}", id, e);
+            Node::ZERO
+        }
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_tiled_graph_find_nearest_node(
+    graph: *const TiledGraph,
+    lat: f32,
+    lon: f32,
+) -> Node {
+    let Some(graph) = graph.as_ref() else {
+        return Node::ZERO;
+    };
+
+    match graph.find_nearest_node(lat, lon) {
+        Ok(node) => node.unwrap_or(Node::ZERO),
+        Err(e) => {
+            log::error!(target: "routx", "failed to load tile near {} {}: {}", lat, lon, e);
+            Node::ZERO
+        }
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_tiled_graph_find_route(
+    graph: *const TiledGraph,
+    from_id: i64,
+    to_id: i64,
+    max_steps: usize,
+) -> CRouteResult {
+    if let Some(graph) = graph.as_ref() {
+        graph.find_route(from_id, to_id, max_steps).into()
+    } else {
+        CRouteResult::null()
+    }
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_earth_distance(lat1: f32, lon1: f32, lat2: f32, lon2: f32) -> f32 {
+    earth_distance(lat1, lon1, lat2, lon2)
+}
+
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn routx_earth_distance_many(
+    lat: f32,
+    lon: f32,
+    lats: *const f32,
+    lons: *const f32,
+    n: usize,
+    out: *mut f32,
+) {
+    if n == 0 {
+        return;
+    }
+
+    let lats = slice::from_raw_parts(lats, n);
+    let lons = slice::from_raw_parts(lons, n);
+    let out = slice::from_raw_parts_mut(out, n);
+    earth_distance_many(lat, lon, lats, lons, out);
 }
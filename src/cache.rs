@@ -0,0 +1,443 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+
+use crate::lru::Lru;
+use crate::{find_route, find_route_without_turn_around, AStarError, CostSnapshot, Graph};
+
+/// Search used to find a route stored in a [RouteCache].
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum RouteKind {
+    /// [find_route] or [FrozenGraph::find_route](crate::FrozenGraph::find_route).
+    Shortest,
+
+    /// [find_route_without_turn_around] or
+    /// [FrozenGraph::find_route_without_turn_around](crate::FrozenGraph::find_route_without_turn_around).
+    WithoutTurnAround,
+}
+
+/// Route stored in a [RouteCache].
+#[derive(Debug, Clone, PartialEq)]
+pub struct CachedRoute {
+    /// [Node::id](crate::Node::id) of every node of the route. Empty if no route exists.
+    pub nodes: Box<[i64]>,
+
+    /// Cost of the whole route, or zero if it is empty.
+    pub cost: f32,
+}
+
+/// Key of a cached route: start and end node ids and the search.
+type RouteKey = (i64, i64, RouteKind);
+
+#[derive(Debug)]
+struct Entries {
+    /// Epoch of the graph at which all cached routes were found.
+    epoch: u64,
+    lru: Lru<RouteKey, Arc<CachedRoute>>,
+}
+
+/// Thread-safe, bounded, least-recently-used cache of routes found over a single graph,
+/// for serving repeated queries (like routes from a depot to its common customers)
+/// without re-running the search.
+///
+/// Routes are keyed by their start and end nodes, the [RouteKind] and the epoch of the graph -
+/// [Graph::epoch] for a [Graph], or [CostSnapshot::epoch] for a [CostOverlay](crate::CostOverlay).
+/// As soon as a newer epoch is seen, all cached routes are dropped; routes found at older
+/// epochs (e.g. on a snapshot taken before an update) are returned, but never cached.
+/// Epochs are unique within the process, so routes are never returned for a graph other than
+/// the one they were found on - but the cache is only effective for one graph at a time.
+///
+/// The internal lock is only held while looking up or storing routes - never during a search.
+/// Concurrent misses of the same route may thus search it more than once.
+///
+/// # Example
+///
+/// ```no_run
+/// let mut g = routx::Graph::new();
+/// // ... load data into g ...
+///
+/// let cache = routx::RouteCache::new(10_000);
+/// let kind = routx::RouteKind::WithoutTurnAround;
+/// let route = cache.find_route(&g, kind, 1, 2, routx::DEFAULT_STEP_LIMIT).unwrap();
+/// let again = cache.find_route(&g, kind, 1, 2, routx::DEFAULT_STEP_LIMIT).unwrap();
+/// assert_eq!(cache.hits(), 1);
+/// ```
+#[derive(Debug)]
+pub struct RouteCache {
+    entries: Mutex<Entries>,
+    hits: AtomicU64,
+    misses: AtomicU64,
+}
+
+impl RouteCache {
+    /// Creates an empty cache of at most `capacity` routes.
+    /// A cache with zero capacity never stores anything.
+    pub fn new(capacity: usize) -> Self {
+        Self {
+            entries: Mutex::new(Entries {
+                epoch: 0,
+                lru: Lru::new(capacity),
+            }),
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+        }
+    }
+
+    /// Returns the number of cached routes.
+    pub fn len(&self) -> usize {
+        self.entries.lock().unwrap().lru.len()
+    }
+
+    /// Returns `true` if there are no cached routes.
+    pub fn is_empty(&self) -> bool {
+        self.entries.lock().unwrap().lru.is_empty()
+    }
+
+    /// Returns the maximum number of cached routes.
+    pub fn capacity(&self) -> usize {
+        self.entries.lock().unwrap().lru.capacity()
+    }
+
+    /// Returns the newest seen epoch of the graph, at which all cached routes were found.
+    pub fn epoch(&self) -> u64 {
+        self.entries.lock().unwrap().epoch
+    }
+
+    /// Returns the number of queries answered from the cache.
+    pub fn hits(&self) -> u64 {
+        self.hits.load(Ordering::Relaxed)
+    }
+
+    /// Returns the number of queries which required a search.
+    pub fn misses(&self) -> u64 {
+        self.misses.load(Ordering::Relaxed)
+    }
+
+    /// Removes all cached routes. Hit and miss counters are preserved.
+    pub fn clear(&self) {
+        self.entries.lock().unwrap().lru.clear();
+    }
+
+    /// Returns a route found at the provided epoch, if it is cached.
+    pub fn get(
+        &self,
+        epoch: u64,
+        kind: RouteKind,
+        from_id: i64,
+        to_id: i64,
+    ) -> Option<Arc<CachedRoute>> {
+        let route = {
+            let mut entries = self.entries.lock().unwrap();
+            entries.advance(epoch);
+            if entries.epoch == epoch {
+                entries.lru.get(&(from_id, to_id, kind)).cloned()
+            } else {
+                None
+            }
+        };
+
+        if route.is_some() {
+            self.hits.fetch_add(1, Ordering::Relaxed);
+        } else {
+            self.misses.fetch_add(1, Ordering::Relaxed);
+        }
+        route
+    }
+
+    /// Stores a route found at the provided epoch. Routes found at epochs older than
+    /// [RouteCache::epoch] are ignored.
+    pub fn insert(
+        &self,
+        epoch: u64,
+        kind: RouteKind,
+        from_id: i64,
+        to_id: i64,
+        route: Arc<CachedRoute>,
+    ) {
+        let mut entries = self.entries.lock().unwrap();
+        entries.advance(epoch);
+        if entries.epoch == epoch {
+            entries.lru.insert((from_id, to_id, kind), route);
+        }
+    }
+
+    /// Returns the cached route between two nodes of a [Graph] at its current [epoch](Graph::epoch),
+    /// or finds (and caches) the route with the search selected by `kind`.
+    ///
+    /// Errors are returned as-is and never cached.
+    pub fn find_route(
+        &self,
+        g: &Graph,
+        kind: RouteKind,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Arc<CachedRoute>, AStarError> {
+        self.get_or_search(
+            g.epoch(),
+            kind,
+            from_id,
+            to_id,
+            || match kind {
+                RouteKind::Shortest => find_route(g, from_id, to_id, step_limit),
+                RouteKind::WithoutTurnAround => {
+                    find_route_without_turn_around(g, from_id, to_id, step_limit)
+                }
+            },
+            |from, to| g.get_edge(from, to),
+        )
+    }
+
+    /// Same as [RouteCache::find_route], but searches a [CostSnapshot] of a
+    /// [CostOverlay](crate::CostOverlay), keyed by the [epoch](CostSnapshot::epoch)
+    /// of the snapshot.
+    pub fn find_route_in_snapshot(
+        &self,
+        snapshot: &CostSnapshot,
+        kind: RouteKind,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Arc<CachedRoute>, AStarError> {
+        self.get_or_search(
+            snapshot.epoch,
+            kind,
+            from_id,
+            to_id,
+            || match kind {
+                RouteKind::Shortest => snapshot.find_route(from_id, to_id, step_limit),
+                RouteKind::WithoutTurnAround => {
+                    snapshot.find_route_without_turn_around(from_id, to_id, step_limit)
+                }
+            },
+            |from, to| snapshot.get_edge(from, to),
+        )
+    }
+
+    fn get_or_search<S, C>(
+        &self,
+        epoch: u64,
+        kind: RouteKind,
+        from_id: i64,
+        to_id: i64,
+        search: S,
+        edge_cost: C,
+    ) -> Result<Arc<CachedRoute>, AStarError>
+    where
+        S: FnOnce() -> Result<Vec<i64>, AStarError>,
+        C: Fn(i64, i64) -> f32,
+    {
+        if let Some(route) = self.get(epoch, kind, from_id, to_id) {
+            return Ok(route);
+        }
+
+        let nodes = search()?;
+        let cost = nodes.windows(2).map(|w| edge_cost(w[0], w[1])).sum();
+        let route = Arc::new(CachedRoute {
+            nodes: nodes.into_boxed_slice(),
+            cost,
+        });
+        self.insert(epoch, kind, from_id, to_id, Arc::clone(&route));
+        Ok(route)
+    }
+}
+
+impl Entries {
+    /// Drops all routes if the provided epoch is newer than the epoch of the cached routes.
+    #[inline]
+    fn advance(&mut self, epoch: u64) {
+        if epoch > self.epoch {
+            self.epoch = epoch;
+            self.lru.clear();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{CostOverlay, Edge, EdgeFactor, Node};
+
+    fn fixture() -> Graph {
+        // 1 ─100─> 2 ─100─> 3
+        //  └──────300──────┘
+        Graph::from_iter(
+            (1..=3).map(|id| Node {
+                id,
+                osm_id: id,
+                lat: 0.0,
+                lon: id as f32 * 0.0001,
+            }),
+            [(1, 2, 100.0), (2, 3, 100.0), (1, 3, 300.0)],
+        )
+    }
+
+    #[test]
+    fn find_route() {
+        let g = fixture();
+        let cache = RouteCache::new(10);
+
+        let route = cache
+            .find_route(&g, RouteKind::Shortest, 1, 3, 100)
+            .unwrap();
+        assert_eq!(route.nodes.as_ref(), &[1, 2, 3]);
+        assert_eq!(route.cost, 200.0);
+        assert_eq!((cache.hits(), cache.misses()), (0, 1));
+
+        let again = cache
+            .find_route(&g, RouteKind::Shortest, 1, 3, 100)
+            .unwrap();
+        assert!(Arc::ptr_eq(&route, &again));
+        assert_eq!((cache.hits(), cache.misses()), (1, 1));
+
+        // Different kinds and directions are cached separately
+        cache
+            .find_route(&g, RouteKind::WithoutTurnAround, 1, 3, 100)
+            .unwrap();
+        let back = cache
+            .find_route(&g, RouteKind::Shortest, 3, 1, 100)
+            .unwrap();
+        assert!(back.nodes.is_empty());
+        assert_eq!(back.cost, 0.0);
+        assert_eq!((cache.hits(), cache.misses()), (1, 3));
+        assert_eq!(cache.len(), 3);
+
+        // Errors are not cached
+        assert_eq!(
+            cache.find_route(&g, RouteKind::Shortest, 1, 42, 100),
+            Err(AStarError::InvalidReference(42)),
+        );
+        assert_eq!(cache.len(), 3);
+    }
+
+    #[test]
+    fn graph_epoch_invalidates() {
+        let mut g = fixture();
+        let cache = RouteCache::new(10);
+        cache
+            .find_route(&g, RouteKind::Shortest, 1, 3, 100)
+            .unwrap();
+
+        let epoch = g.epoch();
+        g.set_edge(2, Edge { to: 3, cost: 500.0 });
+        assert!(g.epoch() > epoch);
+
+        let route = cache
+            .find_route(&g, RouteKind::Shortest, 1, 3, 100)
+            .unwrap();
+        assert_eq!(route.nodes.as_ref(), &[1, 3]);
+        assert_eq!(route.cost, 300.0);
+        assert_eq!((cache.hits(), cache.misses()), (0, 2));
+        assert_eq!(cache.epoch(), g.epoch());
+
+        // Deleting a node also advances the epoch
+        g.delete_node(2);
+        cache
+            .find_route(&g, RouteKind::Shortest, 1, 3, 100)
+            .unwrap();
+        assert_eq!((cache.hits(), cache.misses()), (0, 3));
+        assert_eq!(cache.len(), 1);
+
+        // So does any access to the mutable map of nodes
+        let (_, edges) = g.nodes_mut().get_mut(&1).unwrap();
+        edges.iter_mut().find(|e| e.to == 3).unwrap().cost = 200.0;
+        let route = cache
+            .find_route(&g, RouteKind::Shortest, 1, 3, 100)
+            .unwrap();
+        assert_eq!(route.cost, 200.0);
+        assert_eq!((cache.hits(), cache.misses()), (0, 4));
+    }
+
+    #[test]
+    fn graphs_never_share_epochs() {
+        let cache = RouteCache::new(10);
+        let a = fixture();
+        let mut b = fixture();
+        b.set_edge(2, Edge { to: 3, cost: 500.0 });
+        let mut c = fixture();
+        c.set_edge(2, Edge { to: 3, cost: 600.0 });
+        assert_ne!(b.epoch(), c.epoch());
+
+        // Graphs with the same number of modifications must not get each other's routes
+        let route = cache
+            .find_route(&b, RouteKind::Shortest, 1, 3, 100)
+            .unwrap();
+        assert_eq!(route.nodes.as_ref(), &[1, 3]);
+        let route = cache
+            .find_route(&a, RouteKind::Shortest, 1, 3, 100)
+            .unwrap();
+        assert_eq!(route.nodes.as_ref(), &[1, 2, 3]);
+        assert_eq!((cache.hits(), cache.misses()), (0, 2));
+
+        // Clones share the epoch until modified
+        let d = c.clone();
+        cache
+            .find_route(&c, RouteKind::Shortest, 1, 3, 100)
+            .unwrap();
+        cache
+            .find_route(&d, RouteKind::Shortest, 1, 3, 100)
+            .unwrap();
+        assert_eq!((cache.hits(), cache.misses()), (1, 3));
+    }
+
+    #[test]
+    fn snapshot_epoch_invalidates() {
+        let overlay = CostOverlay::new(fixture().freeze());
+        let cache = RouteCache::new(10);
+
+        let old = overlay.snapshot();
+        let route = cache
+            .find_route_in_snapshot(&old, RouteKind::Shortest, 1, 3, 100)
+            .unwrap();
+        assert_eq!(route.nodes.as_ref(), &[1, 2, 3]);
+
+        overlay.update_factors(&[EdgeFactor {
+            from: 2,
+            to: 3,
+            factor: 5.0,
+        }]);
+        let new = overlay.snapshot();
+        let route = cache
+            .find_route_in_snapshot(&new, RouteKind::Shortest, 1, 3, 100)
+            .unwrap();
+        assert_eq!(route.nodes.as_ref(), &[1, 3]);
+        assert_eq!(cache.epoch(), new.epoch);
+
+        // Routes on older snapshots are found, but not cached
+        let route = cache
+            .find_route_in_snapshot(&old, RouteKind::Shortest, 1, 3, 100)
+            .unwrap();
+        assert_eq!(route.nodes.as_ref(), &[1, 2, 3]);
+        assert_eq!(cache.len(), 1);
+        assert_eq!((cache.hits(), cache.misses()), (0, 3));
+
+        cache
+            .find_route_in_snapshot(&new, RouteKind::Shortest, 1, 3, 100)
+            .unwrap();
+        assert_eq!((cache.hits(), cache.misses()), (1, 3));
+    }
+
+    #[test]
+    fn concurrent() {
+        let g = fixture();
+        let cache = RouteCache::new(2);
+        std::thread::scope(|s| {
+            for _ in 0..4 {
+                s.spawn(|| {
+                    for i in 0..100 {
+                        let (from, to) = [(1, 3), (1, 2), (2, 3)][i % 3];
+                        let route = cache
+                            .find_route(&g, RouteKind::Shortest, from, to, 100)
+                            .unwrap();
+                        assert_eq!(route.nodes.first(), Some(&from));
+                        assert_eq!(route.nodes.last(), Some(&to));
+                    }
+                });
+            }
+        });
+        assert_eq!(cache.hits() + cache.misses(), 400);
+        assert_eq!(cache.len(), 2);
+    }
+}
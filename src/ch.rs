@@ -0,0 +1,780 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+use std::cmp::Reverse;
+use std::collections::BinaryHeap;
+
+use crate::astar::context::{Labels, QueueItem, SearchContext};
+use crate::astar::queue::Queue;
+use crate::astar::stats::count;
+use crate::frozen::{self, NO_INDEX};
+use crate::{AStarError, FrozenGraph, Graph, SearchStats};
+
+/// Maximum number of nodes settled by a single witness search during contraction.
+/// Higher values result in fewer shortcuts, at the expense of preprocessing time.
+const WITNESS_SETTLE_LIMIT: usize = 500;
+
+/// [Contraction hierarchy](https://en.wikipedia.org/wiki/Contraction_hierarchies)
+/// built over a [Graph], for very fast route queries on large graphs.
+///
+/// Preprocessing contracts nodes one-by-one, in an order given by their importance.
+/// Contracting a node adds shortcut edges between its remaining neighbors, whenever the
+/// contracted node lies on the only shortest path between them. Queries then run
+/// a bidirectional Dijkstra search which only follows edges towards more important nodes,
+/// settling a tiny fraction of nodes compared to A*. Shortcuts are unpacked back into
+/// original nodes in the returned routes.
+///
+/// Contraction operates on the graph as-is, so turn restrictions (represented by cloned nodes,
+/// see [Node](crate::Node)) are respected and returned routes are equivalent to those from
+/// [find_route](crate::find_route). Avoiding immediate turnarounds
+/// ([find_route_without_turn_around](crate::find_route_without_turn_around))
+/// is not supported.
+///
+/// A CHGraph is immutable, and isn't affected by changes to the graph it was built from.
+///
+/// # Example
+///
+/// ```no_run
+/// let g = routx::Graph::new();
+/// // ... load data into g ...
+///
+/// let ch = routx::CHGraph::from_graph(&g);
+/// let route = ch.find_route(1, 2, routx::DEFAULT_STEP_LIMIT);
+/// ```
+#[derive(Debug, Default, Clone, PartialEq)]
+pub struct CHGraph {
+    /// [Node::id](crate::Node::id) of every node, in the dense index order of the source graph.
+    pub(crate) ids: Vec<i64>,
+
+    /// Dense indices of all nodes, sorted by their id; empty if `ids` are sorted.
+    pub(crate) id_index: Vec<u32>,
+
+    /// Contraction order of every node; more important nodes have higher ranks.
+    pub(crate) ranks: Vec<u32>,
+
+    /// Offsets into `up_*` arrays; upward edges from node `i`
+    /// (to nodes with higher ranks) are located at `up_offsets[i]..up_offsets[i + 1]`.
+    pub(crate) up_offsets: Vec<u32>,
+    pub(crate) up_targets: Vec<u32>,
+    pub(crate) up_costs: Vec<f32>,
+    pub(crate) up_middles: Vec<u32>,
+
+    /// Offsets into `down_*` arrays; edges incoming into node `i` from nodes with higher ranks
+    /// are located at `down_offsets[i]..down_offsets[i + 1]`.
+    pub(crate) down_offsets: Vec<u32>,
+    pub(crate) down_sources: Vec<u32>,
+    pub(crate) down_costs: Vec<f32>,
+    pub(crate) down_middles: Vec<u32>,
+}
+
+impl CHGraph {
+    /// Builds a contraction hierarchy over the provided [Graph].
+    pub fn from_graph(g: &Graph) -> Self {
+        Self::from_frozen(&g.freeze())
+    }
+
+    /// Builds a contraction hierarchy over the provided [FrozenGraph].
+    pub fn from_frozen(g: &FrozenGraph) -> Self {
+        Builder::new(g).build(g)
+    }
+
+    /// Returns the number of nodes in the hierarchy.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.ids.len()
+    }
+
+    /// Returns `true` if there are no nodes in the hierarchy.
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.ids.is_empty()
+    }
+
+    /// Returns the number of edges (original and shortcuts) in the hierarchy.
+    #[inline]
+    pub fn edge_count(&self) -> usize {
+        self.up_targets.len() + self.down_sources.len()
+    }
+
+    #[inline]
+    fn index_of(&self, id: i64) -> Option<u32> {
+        frozen::index_of(&self.ids, &self.id_index, id)
+    }
+
+    /// Finds the shortest route between two nodes, see [find_route](crate::find_route).
+    ///
+    /// `step_limit` limits the number of nodes settled by both halves of the search together.
+    ///
+    /// Allocates a new [SearchContext] for the search. Prefer
+    /// [CHGraph::find_route_with_context] when answering many queries.
+    pub fn find_route(
+        &self,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Vec<i64>, AStarError> {
+        self.find_route_with_context(&mut SearchContext::new(), from_id, to_id, step_limit)
+    }
+
+    /// Finds the shortest route between two nodes, see [CHGraph::find_route],
+    /// reusing the storage of the provided [SearchContext].
+    pub fn find_route_with_context(
+        &self,
+        ctx: &mut SearchContext,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Vec<i64>, AStarError> {
+        ctx.measure(|ctx| self.search(ctx, from_id, to_id, step_limit))
+    }
+
+    fn search(
+        &self,
+        ctx: &mut SearchContext,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Vec<i64>, AStarError> {
+        assert_ne!(from_id, 0);
+        assert_ne!(to_id, 0);
+
+        let to = self
+            .index_of(to_id)
+            .ok_or(AStarError::InvalidReference(to_id))?;
+        let from = self
+            .index_of(from_id)
+            .ok_or(AStarError::InvalidReference(from_id))?;
+
+        ctx.reset_bidirectional(self.len());
+        ctx.forward.set(from, 0.0, NO_INDEX);
+        ctx.queue.push(QueueItem {
+            at: from,
+            cost: 0.0,
+            score: 0.0,
+        });
+        ctx.backward.set(to, 0.0, NO_INDEX);
+        ctx.backward_queue.push(QueueItem {
+            at: to,
+            cost: 0.0,
+            score: 0.0,
+        });
+
+        let mut meeting = Meeting {
+            cost: f32::INFINITY,
+            node: NO_INDEX,
+        };
+        let mut steps: usize = 0;
+
+        loop {
+            let forward_min = ctx.queue.peek().map_or(f32::INFINITY, |i| i.cost);
+            let backward_min = ctx.backward_queue.peek().map_or(f32::INFINITY, |i| i.cost);
+
+            // Neither half of the search can find a better route
+            if forward_min >= meeting.cost && backward_min >= meeting.cost {
+                break;
+            }
+
+            let settled = if forward_min <= backward_min {
+                settle_next(
+                    &mut ctx.queue,
+                    &mut ctx.forward,
+                    &ctx.backward,
+                    &self.up_offsets,
+                    &self.up_targets,
+                    &self.up_costs,
+                    &mut meeting,
+                    &mut ctx.stats,
+                )
+            } else {
+                settle_next(
+                    &mut ctx.backward_queue,
+                    &mut ctx.backward,
+                    &ctx.forward,
+                    &self.down_offsets,
+                    &self.down_sources,
+                    &self.down_costs,
+                    &mut meeting,
+                    &mut ctx.stats,
+                )
+            };
+
+            if settled {
+                steps += 1;
+                if steps > step_limit {
+                    return Err(AStarError::StepLimitExceeded);
+                }
+                ctx.check_interrupt(steps)?;
+            }
+        }
+
+        if meeting.node == NO_INDEX {
+            return Ok(vec![]);
+        }
+
+        // Collect CH nodes from the start to the meeting node, and then to the end node
+        let mut hops = vec![meeting.node];
+        let mut last = ctx.forward.came_from(meeting.node);
+        while last != NO_INDEX {
+            hops.push(last);
+            last = ctx.forward.came_from(last);
+        }
+        hops.reverse();
+
+        let mut last = ctx.backward.came_from(meeting.node);
+        while last != NO_INDEX {
+            hops.push(last);
+            last = ctx.backward.came_from(last);
+        }
+
+        // Unpack shortcuts
+        let mut path = vec![self.ids[from as usize]];
+        let mut stack: Vec<(u32, u32)> = Vec::default();
+        for hop in hops.windows(2) {
+            stack.push((hop[0], hop[1]));
+            while let Some((a, b)) = stack.pop() {
+                match self.middle_of(a, b) {
+                    NO_INDEX => path.push(self.ids[b as usize]),
+                    middle => {
+                        stack.push((middle, b));
+                        stack.push((a, middle));
+                    }
+                }
+            }
+        }
+
+        Ok(path)
+    }
+
+    /// Returns the node bypassed by a shortcut edge from `a` to `b`,
+    /// or [NO_INDEX] if the edge is an original edge.
+    fn middle_of(&self, a: u32, b: u32) -> u32 {
+        if self.ranks[a as usize] < self.ranks[b as usize] {
+            let range =
+                self.up_offsets[a as usize] as usize..self.up_offsets[a as usize + 1] as usize;
+            range
+                .into_iter()
+                .find(|&e| self.up_targets[e] == b)
+                .map(|e| self.up_middles[e])
+        } else {
+            let range =
+                self.down_offsets[b as usize] as usize..self.down_offsets[b as usize + 1] as usize;
+            range
+                .into_iter()
+                .find(|&e| self.down_sources[e] == a)
+                .map(|e| self.down_middles[e])
+        }
+        .expect("CH route uses an edge which doesn't exist")
+    }
+}
+
+impl From<&Graph> for CHGraph {
+    fn from(g: &Graph) -> Self {
+        Self::from_graph(g)
+    }
+}
+
+/// Best known meeting point of both halves of a bidirectional search.
+struct Meeting {
+    cost: f32,
+    node: u32,
+}
+
+/// Pops the next node from one half of a bidirectional search, and relaxes its edges.
+/// Returns `true` if a node was settled, `false` if a stale queue item was popped.
+fn settle_next(
+    queue: &mut Queue,
+    labels: &mut Labels,
+    other: &Labels,
+    offsets: &[u32],
+    neighbors: &[u32],
+    costs: &[f32],
+    meeting: &mut Meeting,
+    stats: &mut SearchStats,
+) -> bool {
+    let Some(item) = queue.pop() else {
+        return false;
+    };
+
+    // The queue may contain multiple items for the same node
+    if item.cost > labels.cost(item.at) {
+        count!(stats.stale_pops);
+        return false;
+    }
+    count!(stats.settled);
+
+    let through_cost = item.cost + other.cost(item.at);
+    if through_cost < meeting.cost {
+        meeting.cost = through_cost;
+        meeting.node = item.at;
+    }
+
+    let range = offsets[item.at as usize] as usize..offsets[item.at as usize + 1] as usize;
+    count!(stats.relaxed, range.len());
+    for e in range {
+        let neighbor = neighbors[e];
+        let neighbor_cost = item.cost + costs[e];
+        if neighbor_cost < labels.cost(neighbor) {
+            labels.set(neighbor, neighbor_cost, item.at);
+            queue.push(QueueItem {
+                at: neighbor,
+                cost: neighbor_cost,
+                score: neighbor_cost,
+            });
+        }
+    }
+
+    true
+}
+
+/// Edge in the [Builder] adjacency lists.
+#[derive(Debug, Clone, Copy)]
+struct Arc {
+    node: u32,
+    cost: f32,
+    middle: u32,
+}
+
+/// Inserts an [Arc] into an adjacency list, or lowers the cost of an existing arc
+/// to the same node.
+fn insert_arc(list: &mut Vec<Arc>, node: u32, cost: f32, middle: u32) {
+    if let Some(arc) = list.iter_mut().find(|a| a.node == node) {
+        if cost < arc.cost {
+            arc.cost = cost;
+            arc.middle = middle;
+        }
+    } else {
+        list.push(Arc { node, cost, middle });
+    }
+}
+
+/// Shortcut which needs to be added when contracting a node.
+struct Shortcut {
+    from: u32,
+    to: u32,
+    cost: f32,
+}
+
+/// Mutable state of the contraction process.
+struct Builder {
+    outgoing: Vec<Vec<Arc>>,
+    incoming: Vec<Vec<Arc>>,
+    contracted: Vec<bool>,
+    deleted_neighbors: Vec<i32>,
+    witness: SearchContext,
+}
+
+impl Builder {
+    fn new(g: &FrozenGraph) -> Self {
+        let mut b = Self {
+            outgoing: vec![Vec::default(); g.len()],
+            incoming: vec![Vec::default(); g.len()],
+            contracted: vec![false; g.len()],
+            deleted_neighbors: vec![0; g.len()],
+            witness: SearchContext::new(),
+        };
+
+        for from in 0..g.len() as u32 {
+            for (to, cost) in g.edges_at(from) {
+                if from != to {
+                    b.add_edge(from, to, cost, NO_INDEX);
+                }
+            }
+        }
+
+        b
+    }
+
+    fn add_edge(&mut self, from: u32, to: u32, cost: f32, middle: u32) {
+        insert_arc(&mut self.outgoing[from as usize], to, cost, middle);
+        insert_arc(&mut self.incoming[to as usize], from, cost, middle);
+    }
+
+    fn build(mut self, g: &FrozenGraph) -> CHGraph {
+        let n = g.len();
+        let mut ranks = vec![NO_INDEX; n];
+
+        let mut queue: BinaryHeap<Reverse<(i32, u32)>> = (0..n as u32)
+            .map(|v| {
+                let shortcuts = self.shortcuts(v);
+                Reverse((self.priority(v, &shortcuts), v))
+            })
+            .collect();
+
+        let mut rank = 0;
+        while let Some(Reverse((_, v))) = queue.pop() {
+            // Lazy update - re-evaluate the priority and postpone the node if it got worse
+            let shortcuts = self.shortcuts(v);
+            let priority = self.priority(v, &shortcuts);
+            if let Some(&Reverse((next_priority, _))) = queue.peek() {
+                if priority > next_priority {
+                    queue.push(Reverse((priority, v)));
+                    continue;
+                }
+            }
+
+            for s in shortcuts {
+                self.add_edge(s.from, s.to, s.cost, v);
+            }
+
+            self.contracted[v as usize] = true;
+            ranks[v as usize] = rank;
+            rank += 1;
+
+            for arc in self.outgoing[v as usize]
+                .iter()
+                .chain(&self.incoming[v as usize])
+            {
+                if !self.contracted[arc.node as usize] {
+                    self.deleted_neighbors[arc.node as usize] += 1;
+                }
+            }
+        }
+
+        let mut ch = CHGraph {
+            ids: g.ids.to_vec(),
+            id_index: g.id_index.to_vec(),
+            ranks,
+            up_offsets: Vec::with_capacity(n + 1),
+            down_offsets: Vec::with_capacity(n + 1),
+            ..Default::default()
+        };
+
+        ch.up_offsets.push(0);
+        ch.down_offsets.push(0);
+        for v in 0..n {
+            for arc in &self.outgoing[v] {
+                if ch.ranks[arc.node as usize] > ch.ranks[v] {
+                    ch.up_targets.push(arc.node);
+                    ch.up_costs.push(arc.cost);
+                    ch.up_middles.push(arc.middle);
+                }
+            }
+            for arc in &self.incoming[v] {
+                if ch.ranks[arc.node as usize] > ch.ranks[v] {
+                    ch.down_sources.push(arc.node);
+                    ch.down_costs.push(arc.cost);
+                    ch.down_middles.push(arc.middle);
+                }
+            }
+
+            assert!(
+                ch.up_targets.len() < NO_INDEX as usize
+                    && ch.down_sources.len() < NO_INDEX as usize,
+                "too many edges to build a contraction hierarchy"
+            );
+            ch.up_offsets.push(ch.up_targets.len() as u32);
+            ch.down_offsets.push(ch.down_sources.len() as u32);
+        }
+
+        ch
+    }
+
+    /// Contraction priority of a node - nodes with lower priorities are contracted first.
+    fn priority(&self, v: u32, shortcuts: &[Shortcut]) -> i32 {
+        let removed_edges = self.outgoing[v as usize]
+            .iter()
+            .chain(&self.incoming[v as usize])
+            .filter(|a| !self.contracted[a.node as usize])
+            .count();
+        let edge_difference = shortcuts.len() as i32 - removed_edges as i32;
+        edge_difference + self.deleted_neighbors[v as usize]
+    }
+
+    /// Returns all shortcuts which need to be added if `v` was contracted.
+    fn shortcuts(&mut self, v: u32) -> Vec<Shortcut> {
+        let mut shortcuts = Vec::default();
+
+        for i in 0..self.incoming[v as usize].len() {
+            let incoming = self.incoming[v as usize][i];
+            if self.contracted[incoming.node as usize] {
+                continue;
+            }
+
+            let max_outgoing = self.outgoing[v as usize]
+                .iter()
+                .filter(|a| a.node != incoming.node && !self.contracted[a.node as usize])
+                .map(|a| a.cost)
+                .fold(f32::NEG_INFINITY, f32::max);
+            if max_outgoing == f32::NEG_INFINITY {
+                continue;
+            }
+
+            self.witness_search(incoming.node, v, incoming.cost + max_outgoing);
+
+            for outgoing in &self.outgoing[v as usize] {
+                if outgoing.node == incoming.node || self.contracted[outgoing.node as usize] {
+                    continue;
+                }
+
+                let cost = incoming.cost + outgoing.cost;
+                if self.witness.cost(outgoing.node) > cost {
+                    shortcuts.push(Shortcut {
+                        from: incoming.node,
+                        to: outgoing.node,
+                        cost,
+                    });
+                }
+            }
+        }
+
+        shortcuts
+    }
+
+    /// Runs a bounded Dijkstra search from `source` over non-contracted nodes other than `skip`,
+    /// leaving the results in the forward labels of the witness [SearchContext].
+    fn witness_search(&mut self, source: u32, skip: u32, max_cost: f32) {
+        let ctx = &mut self.witness;
+        ctx.reset(self.outgoing.len());
+        ctx.set(source, 0.0, NO_INDEX);
+        ctx.queue.push(QueueItem {
+            at: source,
+            cost: 0.0,
+            score: 0.0,
+        });
+
+        let mut settled: usize = 0;
+        while let Some(item) = ctx.queue.pop() {
+            if item.cost > ctx.cost(item.at) {
+                continue;
+            }
+            if item.cost > max_cost {
+                break;
+            }
+
+            settled += 1;
+            if settled > WITNESS_SETTLE_LIMIT {
+                break;
+            }
+
+            for arc in &self.outgoing[item.at as usize] {
+                if arc.node == skip || self.contracted[arc.node as usize] {
+                    continue;
+                }
+
+                let cost = item.cost + arc.cost;
+                if cost < ctx.cost(arc.node) {
+                    ctx.set(arc.node, cost, item.at);
+                    ctx.queue.push(QueueItem {
+                        at: arc.node,
+                        cost,
+                        score: cost,
+                    });
+                }
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::Node;
+
+    /// Returns a `size × size` grid with bidirectional edges of varying costs.
+    fn grid_fixture(size: i64) -> Graph {
+        let mut g = Graph::default();
+        let id = |x: i64, y: i64| y * size + x + 1;
+
+        for y in 0..size {
+            for x in 0..size {
+                g.set_node(Node {
+                    id: id(x, y),
+                    osm_id: id(x, y),
+                    lat: y as f32 * 0.001,
+                    lon: x as f32 * 0.001,
+                });
+            }
+        }
+
+        for y in 0..size {
+            for x in 0..size {
+                // Pseudo-random, but deterministic costs exceeding the crow-flies distance
+                let cost = 120.0 + ((x * 7 + y * 13) % 5) as f32 * 40.0;
+                if x + 1 < size {
+                    g.set_edge(
+                        id(x, y),
+                        crate::Edge {
+                            to: id(x + 1, y),
+                            cost,
+                        },
+                    );
+                    g.set_edge(
+                        id(x + 1, y),
+                        crate::Edge {
+                            to: id(x, y),
+                            cost: cost + 10.0,
+                        },
+                    );
+                }
+                if y + 1 < size {
+                    g.set_edge(
+                        id(x, y),
+                        crate::Edge {
+                            to: id(x, y + 1),
+                            cost: cost + 20.0,
+                        },
+                    );
+                    g.set_edge(id(x, y + 1), crate::Edge { to: id(x, y), cost });
+                }
+            }
+        }
+
+        g
+    }
+
+    fn route_cost(g: &Graph, route: &[i64]) -> f32 {
+        route.windows(2).map(|w| g.get_edge(w[0], w[1])).sum()
+    }
+
+    #[test]
+    fn same_costs_as_astar() {
+        let g = grid_fixture(8);
+        let ch = CHGraph::from_graph(&g);
+        let mut ctx = SearchContext::new();
+
+        for from in 1..=64 {
+            for to in 1..=64 {
+                let expected = crate::find_route(&g, from, to, 10_000).unwrap();
+                let got = ch
+                    .find_route_with_context(&mut ctx, from, to, 10_000)
+                    .unwrap();
+
+                assert_eq!(got.first(), Some(&from));
+                assert_eq!(got.last(), Some(&to));
+                assert!(got.windows(2).all(|w| g.get_edge(w[0], w[1]).is_finite()));
+                assert!(
+                    (route_cost(&g, &expected) - route_cost(&g, &got)).abs() < 0.01,
+                    "{} -> {}: {:?} vs {:?}",
+                    from,
+                    to,
+                    expected,
+                    got,
+                );
+            }
+        }
+    }
+
+    #[test]
+    fn reordered_graph() {
+        let g = grid_fixture(6);
+        let ch = CHGraph::from_frozen(&g.freeze().reordered(crate::NodeOrder::Hilbert));
+        let mut ctx = SearchContext::new();
+
+        for from in 1..=36 {
+            for to in [1, 8, 21, 36] {
+                let expected = crate::find_route(&g, from, to, 10_000).unwrap();
+                let got = ch
+                    .find_route_with_context(&mut ctx, from, to, 10_000)
+                    .unwrap();
+
+                assert_eq!(got.first(), Some(&from));
+                assert_eq!(got.last(), Some(&to));
+                assert!((route_cost(&g, &expected) - route_cost(&g, &got)).abs() < 0.01);
+            }
+        }
+    }
+
+    #[test]
+    fn turn_restriction() {
+        // 1
+        // │
+        // │10
+        // │ 10
+        // 2─────4
+        // │     │
+        // │10   │100
+        // │ 10  │
+        // 3─────5
+        // mandatory 1-2-4
+        let g = Graph::from_iter(
+            [
+                Node {
+                    id: 1,
+                    osm_id: 1,
+                    lat: 0.00,
+                    lon: 0.02,
+                },
+                Node {
+                    id: 2,
+                    osm_id: 2,
+                    lat: 0.00,
+                    lon: 0.01,
+                },
+                Node {
+                    id: 20,
+                    osm_id: 2,
+                    lat: 0.00,
+                    lon: 0.01,
+                },
+                Node {
+                    id: 3,
+                    osm_id: 3,
+                    lat: 0.00,
+                    lon: 0.00,
+                },
+                Node {
+                    id: 4,
+                    osm_id: 4,
+                    lat: 0.01,
+                    lon: 0.01,
+                },
+                Node {
+                    id: 5,
+                    osm_id: 5,
+                    lat: 0.01,
+                    lon: 0.00,
+                },
+            ],
+            [
+                (1, 20, 10.0),
+                (2, 1, 10.0),
+                (2, 3, 10.0),
+                (2, 4, 10.0),
+                (20, 4, 10.0),
+                (3, 2, 10.0),
+                (3, 5, 10.0),
+                (4, 2, 10.0),
+                (4, 5, 100.0),
+                (5, 3, 10.0),
+                (5, 4, 100.0),
+            ],
+        );
+        let ch = CHGraph::from_graph(&g);
+        assert_eq!(ch.find_route(1, 3, 100), Ok(vec![1, 20, 4, 2, 3]));
+    }
+
+    #[test]
+    fn no_route() {
+        let g = Graph::from_iter(
+            [
+                Node {
+                    id: 1,
+                    osm_id: 1,
+                    lat: 0.01,
+                    lon: 0.01,
+                },
+                Node {
+                    id: 2,
+                    osm_id: 2,
+                    lat: 0.02,
+                    lon: 0.01,
+                },
+            ],
+            [(1, 2, 200.0)],
+        );
+        let ch = CHGraph::from_graph(&g);
+        assert_eq!(ch.find_route(1, 2, 100), Ok(vec![1, 2]));
+        assert_eq!(ch.find_route(2, 1, 100), Ok(vec![]));
+        assert_eq!(ch.find_route(1, 1, 100), Ok(vec![1]));
+        assert_eq!(
+            ch.find_route(1, 42, 100),
+            Err(AStarError::InvalidReference(42))
+        );
+    }
+
+    #[test]
+    fn step_limit() {
+        let ch = CHGraph::from_graph(&grid_fixture(8));
+        assert_eq!(ch.find_route(1, 64, 1), Err(AStarError::StepLimitExceeded));
+    }
+}
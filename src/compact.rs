@@ -0,0 +1,917 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+use std::fs::File;
+use std::io::{self, BufReader, BufWriter, Read, Write};
+use std::path::Path;
+use std::sync::Arc;
+
+use crate::astar::context::{QueueItem, SearchContext};
+use crate::astar::stats::count;
+use crate::frozen::{self, read_section, write_section, NO_INDEX};
+use crate::mmap::{Array, Mmap};
+use crate::{binary, earth_distance, AStarError, Edge, FrozenGraph, Graph, Node, NodeOrder};
+
+/// Default resolution of edge costs of a [CompactGraph] - a ten-thousandth of a cost unit
+/// (a decimetre of an unpenalized road, as costs are distances in kilometres multiplied
+/// by penalties).
+pub const DEFAULT_COST_SCALE: f32 = 1e-4;
+
+/// Resolution of coordinates of a [CompactGraph], in degrees. Equal to the resolution of
+/// coordinates in OpenStreetMap data, and corresponds to about 1 cm.
+const COORDINATE_SCALE: f64 = 1e-7;
+
+/// Encoded cost of edges with infinite (or NaN) costs.
+const INFINITE_COST: u64 = u32::MAX as u64;
+
+/// Number of consecutive nodes whose encoded edges are addressed relative to a shared 64-bit
+/// offset, so that per-node offsets fit in 32 bits regardless of the size of the graph.
+const EDGE_BLOCK_SIZE: usize = 1 << 16;
+
+/// Compressed, read-only snapshot of a [FrozenGraph] for graphs which don't fit in memory
+/// otherwise. Routing runs directly on the compressed form.
+///
+/// Compared to a [FrozenGraph]:
+/// - coordinates are stored as 32-bit fixed-point numbers with a resolution of 10<sup>-7</sup>
+///   degree (about 1 cm, the resolution of OpenStreetMap itself), which is as compact as,
+///   and never less precise than the `f32` coordinates of a [Graph];
+/// - [Node::osm_id] is only stored for nodes for which it differs from [Node::id]
+///   (clones created by turn restrictions), saving 8 bytes per node;
+/// - edges are delta-encoded: every edge is stored as two
+///   [variable-length integers](https://en.wikipedia.org/wiki/LEB128), the difference between
+///   the dense indices of its end and start nodes, followed by its cost as a fixed-point number
+///   with a configurable resolution (`cost_scale`). On graphs [reordered](FrozenGraph::reordered)
+///   along a space-filling curve most edges take 3 to 4 bytes instead of 8.
+///
+/// All together, a node takes 20 bytes instead of 28 bytes (plus 4 bytes for the id index
+/// of reordered graphs), not counting its edges.
+///
+/// # Accuracy
+///
+/// Edge costs are rounded up to a multiple of `cost_scale`, so every edge becomes more
+/// expensive by less than `cost_scale`, and never cheaper. As routes are the shortest ones
+/// given the rounded costs, the cost of a returned route (using the original costs) exceeds the
+/// cost of the shortest route by less than `cost_scale` times the number of edges of the
+/// shortest route. For example, with the [DEFAULT_COST_SCALE], the cost of a route over
+/// 1000 edges exceeds the optimum by less than 0.1 - 100 m of unpenalized roads.
+/// Routes with costs differing by more than that are never confused.
+///
+/// Only [find_route](CompactGraph::find_route) is supported. Edge costs of at least
+/// `u32::MAX * cost_scale` are treated as infinite.
+///
+/// # Example
+///
+/// ```no_run
+/// let g = routx::Graph::new();
+/// // ... load data into g ...
+///
+/// let compact = routx::CompactGraph::from_graph(&g);
+/// let route = compact.find_route(1, 2, routx::DEFAULT_STEP_LIMIT);
+/// ```
+#[derive(Debug, Clone, PartialEq)]
+pub struct CompactGraph {
+    /// [Node::id] of every node.
+    ids: Array<i64>,
+
+    /// Dense indices of all nodes, sorted by their [Node::id]; empty if `ids` are sorted,
+    /// see [FrozenGraph::id_index].
+    id_index: Array<u32>,
+
+    /// [Node::lat] of every node, in units of [COORDINATE_SCALE].
+    lats: Array<i32>,
+
+    /// [Node::lon] of every node, in units of [COORDINATE_SCALE].
+    lons: Array<i32>,
+
+    /// Sorted dense indices of nodes with [Node::osm_id] different than [Node::id].
+    osm_id_indices: Array<u32>,
+
+    /// [Node::osm_id] of nodes from `osm_id_indices`.
+    osm_id_values: Array<i64>,
+
+    /// Offsets into `edge_data` of every block of [EDGE_BLOCK_SIZE] nodes.
+    edge_blocks: Array<u64>,
+
+    /// Offsets into `edge_data`, relative to the offset of the block, of the edges of
+    /// every node; edges of node `i` end where the edges of node `i + 1` start.
+    edge_offsets: Array<u32>,
+
+    /// Encoded edges, see [CompactGraph].
+    edge_data: Array<u8>,
+
+    edge_count: usize,
+    cost_scale: f32,
+}
+
+impl CompactGraph {
+    /// Compresses the provided [Graph], after [reordering](FrozenGraph::reordered) its nodes
+    /// along the Hilbert curve, with the [DEFAULT_COST_SCALE].
+    pub fn from_graph(g: &Graph) -> Self {
+        Self::from_frozen(
+            &g.freeze().reordered(NodeOrder::Hilbert),
+            DEFAULT_COST_SCALE,
+        )
+    }
+
+    /// Compresses the provided [FrozenGraph], keeping the order of its nodes and edges.
+    ///
+    /// Edge costs are rounded up to multiples of `cost_scale`, see [CompactGraph].
+    /// Panics if `cost_scale` is not a positive, finite number.
+    pub fn from_frozen(g: &FrozenGraph, cost_scale: f32) -> Self {
+        assert!(
+            cost_scale > 0.0 && cost_scale.is_finite(),
+            "invalid edge cost scale"
+        );
+
+        let mut osm_id_indices = Vec::default();
+        let mut osm_id_values = Vec::default();
+        for (idx, (&id, &osm_id)) in g.ids.iter().zip(g.osm_ids.iter()).enumerate() {
+            if id != osm_id {
+                osm_id_indices.push(idx as u32);
+                osm_id_values.push(osm_id);
+            }
+        }
+
+        let mut edge_blocks = Vec::with_capacity(g.len() / EDGE_BLOCK_SIZE + 1);
+        let mut edge_offsets = Vec::with_capacity(g.len() + 1);
+        let mut edge_data = Vec::with_capacity(g.edge_count() * 4);
+        for idx in 0..=g.len() {
+            if idx % EDGE_BLOCK_SIZE == 0 {
+                edge_blocks.push(edge_data.len() as u64);
+            }
+            let offset = edge_data.len() as u64 - edge_blocks.last().unwrap();
+            assert!(offset <= u32::MAX as u64, "too many edges in a block");
+            edge_offsets.push(offset as u32);
+
+            if idx < g.len() {
+                for (to, cost) in g.edges_at(idx as u32) {
+                    write_varint(&mut edge_data, zigzag(to as i64 - idx as i64));
+                    write_varint(&mut edge_data, encode_cost(cost, cost_scale));
+                }
+            }
+        }
+        edge_data.shrink_to_fit();
+
+        let to_fixed = |values: &[f32]| -> Vec<i32> {
+            values
+                .iter()
+                .map(|&v| (v as f64 / COORDINATE_SCALE).round() as i32)
+                .collect()
+        };
+
+        Self {
+            ids: g.ids.clone(),
+            id_index: g.id_index.clone(),
+            lats: to_fixed(&g.lats).into(),
+            lons: to_fixed(&g.lons).into(),
+            osm_id_indices: osm_id_indices.into(),
+            osm_id_values: osm_id_values.into(),
+            edge_blocks: edge_blocks.into(),
+            edge_offsets: edge_offsets.into(),
+            edge_data: edge_data.into(),
+            edge_count: g.edge_count(),
+            cost_scale,
+        }
+    }
+
+    /// Returns the number of nodes in the graph.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.ids.len()
+    }
+
+    /// Returns `true` if there are no nodes in the graph.
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.ids.is_empty()
+    }
+
+    /// Returns the number of edges in the graph.
+    #[inline]
+    pub fn edge_count(&self) -> usize {
+        self.edge_count
+    }
+
+    /// Returns the resolution of edge costs, see [CompactGraph].
+    #[inline]
+    pub fn cost_scale(&self) -> f32 {
+        self.cost_scale
+    }
+
+    /// Returns the number of bytes used by the encoded edges.
+    #[inline]
+    pub fn edge_data_len(&self) -> usize {
+        self.edge_data.len()
+    }
+
+    /// Returns the dense index of a node with the provided id.
+    #[inline]
+    pub fn index_of(&self, id: i64) -> Option<u32> {
+        frozen::index_of(&self.ids, &self.id_index, id)
+    }
+
+    /// Returns the [Node] at the provided dense index.
+    ///
+    /// Panics if the index is out of bounds.
+    pub fn node_at(&self, idx: u32) -> Node {
+        let id = self.ids[idx as usize];
+        let osm_id = match self.osm_id_indices.binary_search(&idx) {
+            Ok(i) => self.osm_id_values[i],
+            Err(_) => id,
+        };
+        let (lat, lon) = self.coordinates_at(idx);
+        Node {
+            id,
+            osm_id,
+            lat,
+            lon,
+        }
+    }
+
+    /// Retrieves a [Node] with the provided id.
+    pub fn get_node(&self, id: i64) -> Option<Node> {
+        self.index_of(id).map(|idx| self.node_at(idx))
+    }
+
+    /// Returns an iterator over all [Nodes](Node) in the graph, in the dense index order.
+    pub fn iter(&self) -> impl Iterator<Item = Node> + '_ {
+        (0..self.len() as u32).map(|idx| self.node_at(idx))
+    }
+
+    /// Returns the position of the node at the provided dense index.
+    #[inline]
+    fn coordinates_at(&self, idx: u32) -> (f32, f32) {
+        let idx = idx as usize;
+        (
+            (self.lats[idx] as f64 * COORDINATE_SCALE) as f32,
+            (self.lons[idx] as f64 * COORDINATE_SCALE) as f32,
+        )
+    }
+
+    /// Returns an iterator over `(target index, cost)` pairs of edges outgoing from the
+    /// node at the provided dense index, decoding them on the fly.
+    #[inline]
+    pub fn edges_at(&self, idx: u32) -> impl Iterator<Item = (u32, f32)> + '_ {
+        let start = self.edge_data_offset(idx as usize);
+        let end = self.edge_data_offset(idx as usize + 1);
+        EncodedEdges {
+            data: &self.edge_data[start..end],
+            from: idx,
+            cost_scale: self.cost_scale,
+        }
+    }
+
+    #[inline]
+    fn edge_data_offset(&self, idx: usize) -> usize {
+        (self.edge_blocks[idx / EDGE_BLOCK_SIZE] + self.edge_offsets[idx] as u64) as usize
+    }
+
+    /// Returns an iterator over all outgoing [Edges](Edge) from a node with a given id,
+    /// with rounded costs.
+    pub fn get_edges(&self, from_id: i64) -> impl Iterator<Item = Edge> + '_ {
+        self.index_of(from_id)
+            .into_iter()
+            .flat_map(|idx| self.edges_at(idx))
+            .map(|(to, cost)| Edge {
+                to: self.ids[to as usize],
+                cost,
+            })
+    }
+
+    /// Gets the rounded cost of an [Edge] from one node to another.
+    /// If such an edge doesn't exist, returns [f32::INFINITY].
+    pub fn get_edge(&self, from_id: i64, to_id: i64) -> f32 {
+        match (self.index_of(from_id), self.index_of(to_id)) {
+            (Some(from), Some(to)) => self
+                .edges_at(from)
+                .find_map(|(target, cost)| if target == to { Some(cost) } else { None })
+                .unwrap_or(f32::INFINITY),
+            _ => f32::INFINITY,
+        }
+    }
+
+    /// Finds the shortest route between two nodes, see [find_route](crate::find_route)
+    /// and the accuracy notes on [CompactGraph].
+    ///
+    /// Allocates a new [SearchContext] for the search. Prefer
+    /// [CompactGraph::find_route_with_context] when answering many queries.
+    pub fn find_route(
+        &self,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Vec<i64>, AStarError> {
+        self.find_route_with_context(&mut SearchContext::new(), from_id, to_id, step_limit)
+    }
+
+    /// Finds the shortest route between two nodes, see [CompactGraph::find_route],
+    /// reusing the storage of the provided [SearchContext].
+    pub fn find_route_with_context(
+        &self,
+        ctx: &mut SearchContext,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Vec<i64>, AStarError> {
+        let mut path = Vec::default();
+        self.find_route_into(ctx, from_id, to_id, step_limit, &mut path)?;
+        Ok(path)
+    }
+
+    /// Same as [CompactGraph::find_route_with_context], but writes the route into the provided
+    /// vector instead of allocating a new one, see [FrozenGraph::find_route_into].
+    pub fn find_route_into(
+        &self,
+        ctx: &mut SearchContext,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+        path: &mut Vec<i64>,
+    ) -> Result<(), AStarError> {
+        path.clear();
+        ctx.measure(|ctx| self.search(ctx, from_id, to_id, step_limit, path))
+    }
+
+    /// Crow-flies distance between the node at the provided dense index and a position,
+    /// used as the A* heuristic, equal to the heuristic of searches over a [FrozenGraph].
+    #[inline]
+    fn heuristic(&self, from: u32, to: (f32, f32)) -> f32 {
+        let (lat, lon) = self.coordinates_at(from);
+        earth_distance(lat, lon, to.0, to.1)
+    }
+
+    /// A* search over the compressed edges, equivalent to the search over a [FrozenGraph].
+    fn search(
+        &self,
+        ctx: &mut SearchContext,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+        path: &mut Vec<i64>,
+    ) -> Result<(), AStarError> {
+        assert_ne!(from_id, 0);
+        assert_ne!(to_id, 0);
+
+        let to = self
+            .index_of(to_id)
+            .ok_or(AStarError::InvalidReference(to_id))?;
+        let from = self
+            .index_of(from_id)
+            .ok_or(AStarError::InvalidReference(from_id))?;
+        let to_position = self.coordinates_at(to);
+        let mut steps: usize = 0;
+
+        ctx.reset(self.len());
+        ctx.queue.push(QueueItem {
+            at: from,
+            cost: 0.0,
+            score: self.heuristic(from, to_position),
+        });
+        ctx.set(from, 0.0, NO_INDEX);
+
+        while let Some(item) = ctx.queue.pop() {
+            if item.at == to {
+                let mut last = to;
+                while last != NO_INDEX {
+                    path.push(self.ids[last as usize]);
+                    last = ctx.came_from(last);
+                }
+                path.reverse();
+                return Ok(());
+            }
+
+            if item.cost > ctx.cost(item.at) {
+                count!(ctx.stats.stale_pops);
+                continue;
+            }
+
+            steps += 1;
+            count!(ctx.stats.settled);
+            if steps > step_limit {
+                return Err(AStarError::StepLimitExceeded);
+            }
+            ctx.check_interrupt(steps)?;
+
+            for (neighbor, edge_cost) in self.edges_at(item.at) {
+                count!(ctx.stats.relaxed);
+                let neighbor_cost = item.cost + edge_cost;
+                if neighbor_cost > ctx.cost(neighbor) {
+                    continue;
+                }
+
+                ctx.set(neighbor, neighbor_cost, item.at);
+                ctx.queue.push(QueueItem {
+                    at: neighbor,
+                    cost: neighbor_cost,
+                    score: neighbor_cost + self.heuristic(neighbor, to_position),
+                });
+            }
+        }
+
+        Ok(())
+    }
+}
+
+/// Decoding iterator over the edges of a single node of a [CompactGraph].
+struct EncodedEdges<'a> {
+    data: &'a [u8],
+    from: u32,
+    cost_scale: f32,
+}
+
+impl Iterator for EncodedEdges<'_> {
+    type Item = (u32, f32);
+
+    #[inline]
+    fn next(&mut self) -> Option<(u32, f32)> {
+        if self.data.is_empty() {
+            return None;
+        }
+        let delta = unzigzag(read_varint(&mut self.data));
+        let cost = match read_varint(&mut self.data) {
+            INFINITE_COST => f32::INFINITY,
+            units => units as f32 * self.cost_scale,
+        };
+        Some(((self.from as i64 + delta) as u32, cost))
+    }
+}
+
+/// Converts an edge cost into a multiple of `scale`, rounding up.
+fn encode_cost(cost: f32, scale: f32) -> u64 {
+    let units = (cost as f64 / scale as f64).ceil();
+    // NOTE: Negated comparison, so that NaNs are also treated as infinite
+    if !(units < INFINITE_COST as f64) {
+        INFINITE_COST
+    } else {
+        units.max(0.0) as u64
+    }
+}
+
+#[inline]
+fn zigzag(value: i64) -> u64 {
+    ((value << 1) ^ (value >> 63)) as u64
+}
+
+#[inline]
+fn unzigzag(value: u64) -> i64 {
+    (value >> 1) as i64 ^ -((value & 1) as i64)
+}
+
+/// Appends a [LEB128](https://en.wikipedia.org/wiki/LEB128)-encoded unsigned integer.
+fn write_varint(out: &mut Vec<u8>, mut value: u64) {
+    while value >= 0x80 {
+        out.push(value as u8 | 0x80);
+        value >>= 7;
+    }
+    out.push(value as u8);
+}
+
+/// Reads a [LEB128](https://en.wikipedia.org/wiki/LEB128)-encoded unsigned integer,
+/// advancing the slice. Truncated or overlong integers are decoded into garbage,
+/// but never cause a panic.
+#[inline]
+fn read_varint(data: &mut &[u8]) -> u64 {
+    let mut value = 0_u64;
+    let mut shift = 0_u32;
+    while let Some((&byte, rest)) = data.split_first() {
+        *data = rest;
+        value |= ((byte & 0x7F) as u64).wrapping_shl(shift);
+        if byte < 0x80 {
+            break;
+        }
+        shift += 7;
+    }
+    value
+}
+
+/// Magic bytes at the start of a serialized [CompactGraph].
+const MAGIC: &[u8; 8] = b"RoutxCGR";
+
+/// Version of the serialized [CompactGraph] format.
+const VERSION: u32 = 1;
+
+/// Flag set in the header of a serialized [CompactGraph] with an id index.
+const FLAG_ID_INDEX: u32 = 1;
+
+/// Size of the serialized [CompactGraph] header: magic, version, flags, number of nodes,
+/// edges, nodes with distinct OSM ids and bytes of encoded edges, cost scale and padding.
+const HEADER_SIZE: u64 = 56;
+
+/// Counts of elements of a serialized [CompactGraph].
+#[derive(Debug, Clone, Copy)]
+struct Header {
+    flags: u32,
+    nodes: u64,
+    edges: u64,
+    osm_ids: u64,
+    edge_bytes: u64,
+    cost_scale: f32,
+}
+
+impl Header {
+    /// Returns the number of elements of every array, in the order of serialization.
+    fn lengths(&self) -> [u64; 9] {
+        let n = self.nodes;
+        let indexed = self.flags & FLAG_ID_INDEX != 0;
+        [
+            n,
+            if indexed { n } else { 0 },
+            n,
+            n,
+            self.osm_ids,
+            self.osm_ids,
+            n / EDGE_BLOCK_SIZE as u64 + 1,
+            n + 1,
+            self.edge_bytes,
+        ]
+    }
+
+    /// Returns the byte offsets of every array, and the total size of the file as the last element.
+    fn layout(&self) -> [u64; 10] {
+        let sizes = [8, 4, 4, 4, 4, 8, 8, 4, 1];
+        let mut offsets = [0; 10];
+        let mut offset = HEADER_SIZE;
+        for (i, len) in self.lengths().into_iter().enumerate() {
+            offset = offset.next_multiple_of(frozen::ALIGNMENT);
+            offsets[i] = offset;
+            offset += len * sizes[i];
+        }
+        offsets[9] = offset;
+        offsets
+    }
+
+    fn write<W: Write>(&self, w: &mut W) -> io::Result<()> {
+        w.write_all(MAGIC)?;
+        binary::write(w, VERSION)?;
+        binary::write(w, self.flags)?;
+        binary::write(w, self.nodes)?;
+        binary::write(w, self.edges)?;
+        binary::write(w, self.osm_ids)?;
+        binary::write(w, self.edge_bytes)?;
+        binary::write(w, self.cost_scale)?;
+        binary::write(w, 0_u32)
+    }
+
+    fn read<R: Read>(r: &mut R) -> io::Result<Self> {
+        let mut magic = [0_u8; 8];
+        r.read_exact(&mut magic)?;
+        if &magic != MAGIC {
+            return Err(binary::invalid_data("not a routx compact graph file"));
+        }
+        if binary::read::<_, u32>(r)? != VERSION {
+            return Err(binary::invalid_data(
+                "unsupported routx compact graph version",
+            ));
+        }
+
+        let h = Self {
+            flags: binary::read(r)?,
+            nodes: binary::read(r)?,
+            edges: binary::read(r)?,
+            osm_ids: binary::read(r)?,
+            edge_bytes: binary::read(r)?,
+            cost_scale: binary::read(r)?,
+        };
+        let _padding: u32 = binary::read(r)?;
+
+        if h.nodes >= NO_INDEX as u64 || h.edges >= NO_INDEX as u64 || h.osm_ids > h.nodes {
+            return Err(binary::invalid_data(
+                "too many nodes or edges in routx compact graph",
+            ));
+        }
+        Ok(h)
+    }
+}
+
+impl CompactGraph {
+    fn header(&self) -> Header {
+        Header {
+            flags: if self.id_index.is_empty() {
+                0
+            } else {
+                FLAG_ID_INDEX
+            },
+            nodes: self.len() as u64,
+            edges: self.edge_count as u64,
+            osm_ids: self.osm_id_indices.len() as u64,
+            edge_bytes: self.edge_data.len() as u64,
+            cost_scale: self.cost_scale,
+        }
+    }
+
+    fn from_header(h: &Header) -> Self {
+        Self {
+            edge_count: h.edges as usize,
+            cost_scale: h.cost_scale,
+            ..Default::default()
+        }
+    }
+
+    /// Serializes the graph into a versioned, little-endian binary format, which (like the
+    /// format of [FrozenGraph::write]) mirrors the in-memory layout, so that
+    /// [CompactGraph::open_mmap] can use the arrays in place.
+    pub fn write<W: Write>(&self, w: &mut W) -> io::Result<()> {
+        let header = self.header();
+        let offsets = header.layout();
+        header.write(w)?;
+
+        let mut p = HEADER_SIZE;
+        write_section(w, &mut p, offsets[0], &self.ids)?;
+        write_section(w, &mut p, offsets[1], &self.id_index)?;
+        write_section(w, &mut p, offsets[2], &self.lats)?;
+        write_section(w, &mut p, offsets[3], &self.lons)?;
+        write_section(w, &mut p, offsets[4], &self.osm_id_indices)?;
+        write_section(w, &mut p, offsets[5], &self.osm_id_values)?;
+        write_section(w, &mut p, offsets[6], &self.edge_blocks)?;
+        write_section(w, &mut p, offsets[7], &self.edge_offsets)?;
+        write_section(w, &mut p, offsets[8], &self.edge_data)?;
+        Ok(())
+    }
+
+    /// Deserializes a graph written by [CompactGraph::write], copying all data into memory.
+    pub fn read<R: Read>(r: &mut R) -> io::Result<Self> {
+        let header = Header::read(r)?;
+        let offsets = header.layout();
+        let len = header.lengths().map(|len| len as usize);
+
+        let mut p = HEADER_SIZE;
+        let mut g = Self::from_header(&header);
+        g.ids = read_section(r, &mut p, offsets[0], len[0])?;
+        g.id_index = read_section(r, &mut p, offsets[1], len[1])?;
+        g.lats = read_section(r, &mut p, offsets[2], len[2])?;
+        g.lons = read_section(r, &mut p, offsets[3], len[3])?;
+        g.osm_id_indices = read_section(r, &mut p, offsets[4], len[4])?;
+        g.osm_id_values = read_section(r, &mut p, offsets[5], len[5])?;
+        g.edge_blocks = read_section(r, &mut p, offsets[6], len[6])?;
+        g.edge_offsets = read_section(r, &mut p, offsets[7], len[7])?;
+        g.edge_data = read_section(r, &mut p, offsets[8], len[8])?;
+        g.validate()?;
+        Ok(g)
+    }
+
+    /// Saves the graph to a file, see [CompactGraph::write].
+    pub fn save<P: AsRef<Path>>(&self, path: P) -> io::Result<()> {
+        let mut w = BufWriter::new(File::create(path)?);
+        self.write(&mut w)?;
+        w.flush()
+    }
+
+    /// Loads a graph from a file, copying all data into memory, see [CompactGraph::read].
+    pub fn load<P: AsRef<Path>>(path: P) -> io::Result<Self> {
+        Self::read(&mut BufReader::new(File::open(path)?))
+    }
+
+    /// Opens a graph saved with [CompactGraph::save] by memory-mapping the file,
+    /// see [FrozenGraph::open_mmap].
+    ///
+    /// On non-unix or big-endian platforms, falls back to [CompactGraph::load].
+    ///
+    /// # Safety
+    ///
+    /// The file must not be modified or truncated while any graph (or its clone) using it
+    /// is alive, see [FrozenGraph::open_mmap].
+    pub unsafe fn open_mmap<P: AsRef<Path>>(path: P) -> io::Result<Self> {
+        #[cfg(all(unix, target_endian = "little"))]
+        {
+            let file = File::open(path)?;
+            // SAFETY: Upheld by the caller
+            let map = Arc::new(unsafe { Mmap::map(&file) }?);
+            Self::from_mmap(map)
+        }
+
+        #[cfg(not(all(unix, target_endian = "little")))]
+        {
+            Self::load(path)
+        }
+    }
+
+    #[cfg(all(unix, target_endian = "little"))]
+    fn from_mmap(map: Arc<Mmap>) -> io::Result<Self> {
+        let bytes = map.as_bytes();
+        let header = Header::read(&mut &bytes[..])?;
+        let offsets = header.layout();
+        if (bytes.len() as u64) < offsets[9] {
+            return Err(io::ErrorKind::UnexpectedEof.into());
+        }
+
+        let len = header.lengths().map(|len| len as usize);
+        let at = |i: usize| offsets[i] as usize;
+        let mut g = Self::from_header(&header);
+        g.ids = Array::mapped(&map, at(0), len[0]);
+        g.id_index = Array::mapped(&map, at(1), len[1]);
+        g.lats = Array::mapped(&map, at(2), len[2]);
+        g.lons = Array::mapped(&map, at(3), len[3]);
+        g.osm_id_indices = Array::mapped(&map, at(4), len[4]);
+        g.osm_id_values = Array::mapped(&map, at(5), len[5]);
+        g.edge_blocks = Array::mapped(&map, at(6), len[6]);
+        g.edge_offsets = Array::mapped(&map, at(7), len[7]);
+        g.edge_data = Array::mapped(&map, at(8), len[8]);
+        g.validate()?;
+        Ok(g)
+    }
+
+    /// Performs cheap, constant-time sanity checks of deserialized edge offsets.
+    fn validate(&self) -> io::Result<()> {
+        if self.edge_blocks.first() != Some(&0)
+            || self.edge_data_offset(self.len()) != self.edge_data.len()
+            || !(self.cost_scale > 0.0 && self.cost_scale.is_finite())
+        {
+            return Err(binary::invalid_data(
+                "invalid edge offsets in routx compact graph",
+            ));
+        }
+        Ok(())
+    }
+}
+
+impl Default for CompactGraph {
+    fn default() -> Self {
+        Self::from_frozen(&FrozenGraph::default(), DEFAULT_COST_SCALE)
+    }
+}
+
+impl From<&FrozenGraph> for CompactGraph {
+    fn from(g: &FrozenGraph) -> Self {
+        Self::from_frozen(g, DEFAULT_COST_SCALE)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn grid_fixture(size: i64) -> Graph {
+        let mut g = Graph::default();
+        let id = |x: i64, y: i64| y * size + x + 1;
+
+        for y in 0..size {
+            for x in 0..size {
+                g.set_node(Node {
+                    id: id(x, y),
+                    osm_id: id(x, y),
+                    lat: 52.0 + y as f32 * 0.001,
+                    lon: 21.0 + x as f32 * 0.001,
+                });
+            }
+        }
+
+        for y in 0..size {
+            for x in 0..size {
+                // Pseudo-random, but deterministic costs (in km) exceeding the crow-flies
+                // distance of ~0.11 km, and not multiples of the DEFAULT_COST_SCALE
+                let cost = 0.12 + ((x * 7 + y * 13) % 5) as f32 * 0.04 + 0.0000123;
+                for (nx, ny) in [(x + 1, y), (x, y + 1)] {
+                    if nx < size && ny < size {
+                        g.set_edge(
+                            id(x, y),
+                            Edge {
+                                to: id(nx, ny),
+                                cost,
+                            },
+                        );
+                        g.set_edge(id(nx, ny), Edge { to: id(x, y), cost });
+                    }
+                }
+            }
+        }
+        g
+    }
+
+    #[test]
+    fn varint() {
+        let values = [0, 1, 127, 128, 300, u32::MAX as u64, u64::MAX];
+        let mut data = Vec::default();
+        for &v in &values {
+            write_varint(&mut data, v);
+        }
+        assert_eq!(&data[..5], &[0, 1, 127, 0x80, 1]);
+
+        let mut data = data.as_slice();
+        for &v in &values {
+            assert_eq!(read_varint(&mut data), v);
+        }
+        assert!(data.is_empty());
+
+        for v in [0, 1, -1, 63, -64, i64::MAX, i64::MIN] {
+            assert_eq!(unzigzag(zigzag(v)), v);
+        }
+        assert_eq!(zigzag(-1), 1);
+        assert_eq!(zigzag(1), 2);
+    }
+
+    #[test]
+    fn encode_cost_rounds_up() {
+        assert_eq!(encode_cost(0.0, 0.1), 0);
+        assert_eq!(encode_cost(10.0, 0.5), 20);
+        assert_eq!(encode_cost(10.01, 0.5), 21);
+        assert_eq!(encode_cost(f32::INFINITY, 0.1), INFINITE_COST);
+        assert_eq!(encode_cost(f32::NAN, 0.1), INFINITE_COST);
+        assert_eq!(encode_cost(1e12, 0.1), INFINITE_COST);
+    }
+
+    #[test]
+    fn from_frozen() {
+        let mut g = grid_fixture(4);
+        g.set_node(Node {
+            id: 100,
+            osm_id: 1,
+            lat: 52.0,
+            lon: 21.0,
+        });
+        g.set_edge(100, Edge { to: 2, cost: 1.0 });
+        g.set_edge(
+            2,
+            Edge {
+                to: 100,
+                cost: f32::INFINITY,
+            },
+        );
+        let f = g.freeze();
+        // Exactly representable scale, so that the cost of 100 -> 2 is kept exactly
+        let c = CompactGraph::from_frozen(&f, 1.0 / 64.0);
+
+        assert_eq!(c.len(), f.len());
+        assert_eq!(c.edge_count(), f.edge_count());
+        assert!(c.edge_data_len() < f.edge_count() * 8);
+        assert_eq!(c.osm_id_indices, vec![16]);
+
+        for node in f.iter() {
+            let got = c.get_node(node.id).unwrap();
+            assert_eq!(got.id, node.id);
+            assert_eq!(got.osm_id, node.osm_id);
+            assert!((got.lat - node.lat).abs() < 1e-6);
+            assert!((got.lon - node.lon).abs() < 1e-6);
+
+            let edges: Vec<Edge> = c.get_edges(node.id).collect();
+            let expected: Vec<Edge> = f.get_edges(node.id).collect();
+            assert_eq!(edges.len(), expected.len());
+            for (got, expected) in edges.iter().zip(&expected) {
+                assert_eq!(got.to, expected.to);
+                assert!(got.cost >= expected.cost - 1e-6);
+                assert!(got.cost < expected.cost + 1.0 / 64.0 || got.cost == f32::INFINITY);
+            }
+        }
+        assert_eq!(c.get_edge(2, 100), f32::INFINITY);
+        assert_eq!(c.get_edge(100, 2), 1.0);
+        assert_eq!(c.get_edge(1, 16), f32::INFINITY);
+        assert_eq!(c.get_node(42), None);
+    }
+
+    #[test]
+    fn find_route() {
+        let g = grid_fixture(8);
+        let f = g.freeze();
+        let c = CompactGraph::from_graph(&g);
+        let mut ctx = SearchContext::new();
+        let route_cost =
+            |route: &[i64]| -> f32 { route.windows(2).map(|w| f.get_edge(w[0], w[1])).sum() };
+
+        for from in 1..=64 {
+            for to in [1, 8, 29, 64] {
+                let expected = f.find_route(from, to, 10_000).unwrap();
+                let got = c
+                    .find_route_with_context(&mut ctx, from, to, 10_000)
+                    .unwrap();
+
+                assert_eq!(got.first(), Some(&from));
+                assert_eq!(got.last(), Some(&to));
+                let bound = c.cost_scale() * expected.len() as f32;
+                assert!(route_cost(&got) - route_cost(&expected) < bound + 1e-5);
+            }
+        }
+
+        assert_eq!(
+            c.find_route(1, 100, 100),
+            Err(AStarError::InvalidReference(100))
+        );
+        assert_eq!(c.find_route(1, 64, 5), Err(AStarError::StepLimitExceeded));
+        c.find_route_with_context(&mut ctx, 1, 64, 10_000).unwrap();
+        #[cfg(feature = "stats")]
+        assert!(ctx.stats().settled >= 14);
+    }
+
+    #[test]
+    fn write_read() {
+        let c = CompactGraph::from_graph(&grid_fixture(5));
+
+        let mut buf: Vec<u8> = Vec::default();
+        c.write(&mut buf).unwrap();
+        assert_eq!(buf.len() as u64, c.header().layout()[9]);
+        assert_eq!(CompactGraph::read(&mut buf.as_slice()).unwrap(), c);
+
+        let path = std::env::temp_dir().join(format!("routx-compact-{}", std::process::id()));
+        std::fs::write(&path, &buf).unwrap();
+        // SAFETY: The temporary file is not modified while mapped
+        let mapped = unsafe { CompactGraph::open_mmap(&path) };
+        std::fs::remove_file(&path).unwrap();
+        let mapped = mapped.unwrap();
+        assert_eq!(mapped, c);
+        assert_eq!(mapped.find_route(1, 25, 100), c.find_route(1, 25, 100));
+
+        buf[0] = b'X';
+        assert_eq!(
+            CompactGraph::read(&mut buf.as_slice()).unwrap_err().kind(),
+            io::ErrorKind::InvalidData
+        );
+    }
+}
@@ -3,7 +3,7 @@
 
 /// Mean radius of Earth, in kilometers.
 /// Source: https://en.wikipedia.org/wiki/Earth_radius#Arithmetic_mean_radius
-const EARTH_RADIUS: f64 = 6371.0088;
+pub(crate) const EARTH_RADIUS: f64 = 6371.0088;
 
 /// Mean diameter of Earth, in kilometers.
 /// Source: https://en.wikipedia.org/wiki/Earth_radius#Arithmetic_mean_radius
@@ -26,6 +26,146 @@ pub fn earth_distance(lat1: f32, lon1: f32, lat2: f32, lon2: f32) -> f32 {
     (EARTH_DIAMETER * h.sqrt().asin()) as f32
 }
 
+/// Upper bound of the relative error of [earth_distance_many] and [earth_distance_approx]
+/// compared to [earth_distance], for distances from 1 m to 10 000 km (measured maximum is 1.8e-6).
+/// Below 1 m, the absolute error is below 5 µm. Nearly antipodal positions (above 10 000 km)
+/// are ill-conditioned in single precision, and their absolute error can reach 1 km.
+pub const EARTH_DISTANCE_APPROX_MAX_ERROR: f32 = 4e-6;
+
+/// Degrees to radians conversion factor.
+const DEG_TO_RAD: f32 = std::f32::consts::PI / 180.0;
+
+/// Adding and subtracting this constant rounds a f32 of magnitude below 2²² to the nearest
+/// integer, without calling into libm (which would prevent vectorization).
+const ROUND_MAGIC: f32 = 12582912.0; // 1.5 × 2²³
+
+/// Calculates `sin²(x)` for any finite `x`, using the Taylor polynomial of `sin`
+/// (up to `x¹¹`) after reducing `x` to `[-π/2, π/2]`. The relative truncation error is below
+/// 6e-8 over the reduced range.
+#[inline(always)]
+fn sin_squared(x: f32) -> f32 {
+    // sin²(x) has a period of π
+    let k = (x * std::f32::consts::FRAC_1_PI + ROUND_MAGIC) - ROUND_MAGIC;
+    let x = x - k * std::f32::consts::PI;
+    let x2 = x * x;
+    let p = 1.0 / 39916800.0;
+    let p = p * x2 - 1.0 / 362880.0;
+    let p = p * x2 + 1.0 / 5040.0;
+    let p = p * x2 - 1.0 / 120.0;
+    let p = p * x2 + 1.0 / 6.0;
+    let sin = x - x * x2 * p;
+    sin * sin
+}
+
+/// Calculates `cos(x)` for `x` in `[-π/2, π/2]` as `sin(π/2 - |x|)`.
+#[inline(always)]
+fn cos_lat(x: f32) -> f32 {
+    let x = std::f32::consts::FRAC_PI_2 - x.abs();
+    let x2 = x * x;
+    let p = 1.0 / 39916800.0;
+    let p = p * x2 - 1.0 / 362880.0;
+    let p = p * x2 + 1.0 / 5040.0;
+    let p = p * x2 - 1.0 / 120.0;
+    let p = p * x2 + 1.0 / 6.0;
+    x - x * x2 * p
+}
+
+/// Calculates `asin(x)` for `x` in `[0, 1]`, using the polynomial approximation from
+/// [Cephes](https://www.netlib.org/cephes/) `asinf`, with a relative error below 3e-7.
+#[inline(always)]
+fn asin_unit(x: f32) -> f32 {
+    // NOTE: Both branches are always computed and then selected,
+    //       so that loops over this function can be vectorized.
+    let large = x > 0.5;
+    let z_large = 0.5 * (1.0 - x);
+    let z = if large { z_large } else { x * x };
+    let a = if large { z_large.sqrt() } else { x };
+
+    let p = 4.2163199048e-2_f32;
+    let p = p * z + 2.4181311049e-2;
+    let p = p * z + 4.5470025998e-2;
+    let p = p * z + 7.4953002686e-2;
+    let p = p * z + 1.6666752422e-1;
+    let r = p * z * a + a;
+
+    if large {
+        std::f32::consts::FRAC_PI_2 - 2.0 * r
+    } else {
+        r
+    }
+}
+
+/// Branch-free, single-precision haversine formula, see [earth_distance_approx].
+/// `cos_lat1` must be equal to `cos(lat1)`, so that it can be hoisted out of loops.
+#[inline(always)]
+fn haversine(lat1: f32, lon1: f32, cos_lat1: f32, lat2: f32, lon2: f32) -> f32 {
+    let sin2_dlat_half = sin_squared((lat2 - lat1) * (0.5 * DEG_TO_RAD));
+    let sin2_dlon_half = sin_squared((lon2 - lon1) * (0.5 * DEG_TO_RAD));
+    let h = sin2_dlat_half + cos_lat1 * cos_lat(lat2 * DEG_TO_RAD) * sin2_dlon_half;
+    let h = h.clamp(0.0, 1.0);
+    (EARTH_DIAMETER as f32) * asin_unit(h.sqrt())
+}
+
+/// Calculates the great-circle distance between two lat-lon positions, like [earth_distance],
+/// but in single precision and with polynomial approximations instead of libm trigonometric
+/// functions. See [EARTH_DISTANCE_APPROX_MAX_ERROR] for the error bound.
+#[inline]
+pub fn earth_distance_approx(lat1: f32, lon1: f32, lat2: f32, lon2: f32) -> f32 {
+    haversine(lat1, lon1, cos_lat(lat1 * DEG_TO_RAD), lat2, lon2)
+}
+
+/// Dispatches a call to a kernel function compiled with AVX2 and FMA enabled,
+/// if the CPU supports these extensions, or to its baseline version otherwise.
+/// On other architectures (including aarch64, where NEON is always available),
+/// always calls the baseline version.
+macro_rules! dispatch {
+    ($kernel:ident, $avx2:ident, ($($arg:expr),*)) => {{
+        #[cfg(target_arch = "x86_64")]
+        {
+            if std::is_x86_feature_detected!("avx2") && std::is_x86_feature_detected!("fma") {
+                // SAFETY: Required CPU features were detected at runtime
+                return unsafe { $avx2($($arg),*) };
+            }
+        }
+        $kernel($($arg),*)
+    }};
+}
+
+/// Calculates the great-circle distances from `(lat, lon)` to every `(lats[i], lons[i])`
+/// position, writing the results (in kilometers) to `out[i]`.
+///
+/// This is a vectorized batch equivalent of [earth_distance_approx] - see
+/// [EARTH_DISTANCE_APPROX_MAX_ERROR] for the error bound.
+///
+/// Panics if `lats`, `lons` and `out` have different lengths.
+pub fn earth_distance_many(lat: f32, lon: f32, lats: &[f32], lons: &[f32], out: &mut [f32]) {
+    assert_eq!(
+        lats.len(),
+        lons.len(),
+        "lats and lons must have equal lengths"
+    );
+    assert_eq!(
+        lats.len(),
+        out.len(),
+        "out must have the same length as lats"
+    );
+    dispatch!(many_kernel, many_kernel_avx2, (lat, lon, lats, lons, out))
+}
+
+#[inline(always)]
+fn many_kernel(lat: f32, lon: f32, lats: &[f32], lons: &[f32], out: &mut [f32]) {
+    let cos_lat1 = cos_lat(lat * DEG_TO_RAD);
+    for ((d, &lat2), &lon2) in out.iter_mut().zip(lats).zip(lons) {
+        *d = haversine(lat, lon, cos_lat1, lat2, lon2);
+    }
+}
+
+#[cfg(target_arch = "x86_64")]
+#[target_feature(enable = "avx2,fma")]
+unsafe fn many_kernel_avx2(lat: f32, lon: f32, lats: &[f32], lons: &[f32], out: &mut [f32]) {
+    many_kernel(lat, lon, lats, lons, out)
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -45,4 +185,60 @@ mod tests {
         let d = earth_distance(CENTRUM.0, CENTRUM.1, FALENICA.0, FALENICA.1);
         assert_eq!(d, 15.692483);
     }
+
+    /// Deterministic pseudo-random positions, with both short and long distances.
+    fn positions() -> Vec<(f32, f32)> {
+        let mut state: u32 = 42;
+        let mut next = || {
+            state = state.wrapping_mul(1664525).wrapping_add(1013904223);
+            (state >> 8) as f32 / (1 << 24) as f32
+        };
+        (0..2000)
+            .map(|i| {
+                let scale = [1e-6, 1e-3, 1.0, 180.0][i % 4];
+                let lat = (CENTRUM.0 + (next() - 0.5) * scale).clamp(-89.0, 89.0);
+                let lon = CENTRUM.1 + (next() - 0.5) * 2.0 * scale;
+                (lat, lon)
+            })
+            .collect()
+    }
+
+    fn assert_within_bound(approx: f32, exact: f32) {
+        let error = (approx - exact).abs();
+        assert!(
+            error <= exact * EARTH_DISTANCE_APPROX_MAX_ERROR || error < 1e-9,
+            "approx {approx} vs exact {exact}"
+        );
+    }
+
+    #[test]
+    fn approx_error_bound() {
+        for (lat, lon) in positions() {
+            let exact = earth_distance(CENTRUM.0, CENTRUM.1, lat, lon);
+            let approx = earth_distance_approx(CENTRUM.0, CENTRUM.1, lat, lon);
+            if exact <= 10_000.0 {
+                assert_within_bound(approx, exact);
+            } else {
+                assert!(
+                    (approx - exact).abs() < 1.0,
+                    "approx {approx} vs exact {exact}"
+                );
+            }
+        }
+
+        assert_eq!(earth_distance_approx(10.0, 20.0, 10.0, 20.0), 0.0);
+    }
+
+    #[test]
+    fn many() {
+        let (lats, lons): (Vec<f32>, Vec<f32>) = positions().into_iter().unzip();
+        let mut out = vec![0.0; lats.len()];
+        earth_distance_many(CENTRUM.0, CENTRUM.1, &lats, &lons, &mut out);
+        for i in 0..lats.len() {
+            assert_eq!(
+                out[i],
+                earth_distance_approx(CENTRUM.0, CENTRUM.1, lats[i], lons[i])
+            );
+        }
+    }
 }
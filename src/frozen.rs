@@ -0,0 +1,1660 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+use std::fs::File;
+use std::io::{self, BufReader, BufWriter, Read, Write};
+use std::path::Path;
+use std::sync::{Arc, OnceLock};
+
+use crate::binary::Scalar;
+use crate::mmap::{Array, Mmap};
+use crate::{
+    astar, binary, parallel, AStarError, Edge, Graph, Landmarks, Node, RouteDetailed, SearchContext,
+};
+
+/// Sentinel used in place of a node index to signify the absence of a node.
+pub(crate) const NO_INDEX: u32 = u32::MAX;
+
+/// A single route query for [FrozenGraph::find_routes_parallel].
+#[derive(Debug, Clone, Copy, PartialEq)]
+#[repr(C)]
+pub struct RouteRequest {
+    /// [Node::id] of the start node.
+    pub from: i64,
+
+    /// [Node::id] of the end node.
+    pub to: i64,
+
+    /// Step limit of the search, see [find_route](crate::find_route).
+    pub step_limit: usize,
+
+    /// Whether to use
+    /// [find_route_without_turn_around](crate::find_route_without_turn_around)
+    /// instead of [find_route](crate::find_route).
+    pub without_turn_around: bool,
+}
+
+/// Order of dense node indices of a [FrozenGraph], see [FrozenGraph::reordered].
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum NodeOrder {
+    /// Ascending [Node::id] order, as created by [FrozenGraph::from_graph].
+    #[default]
+    Id,
+
+    /// Order along a [Hilbert curve](https://en.wikipedia.org/wiki/Hilbert_curve) over the
+    /// bounding box of all nodes. Nodes close to each other are (almost always) close in memory,
+    /// so a search exploring a region touches considerably fewer cache lines and pages.
+    Hilbert,
+
+    /// Order along a [Z-order (Morton) curve](https://en.wikipedia.org/wiki/Z-order_curve)
+    /// over the bounding box of all nodes. Cheaper to compute than [NodeOrder::Hilbert],
+    /// but with worse locality - the curve makes long jumps between quadrants.
+    Morton,
+}
+
+/// Immutable, compact snapshot of a [Graph], optimized for route finding.
+///
+/// Nodes are renumbered to dense `u32` indices (in the [NodeOrder::Id] order, unless
+/// [reordered](FrozenGraph::reordered)), their attributes are stored in separate
+/// arrays (struct-of-arrays), and all edges are kept in a single
+/// [compressed sparse row](https://en.wikipedia.org/wiki/Sparse_matrix#Compressed_sparse_row_(CSR,_CRS_or_Yale_format))
+/// structure. This avoids tree lookups and pointer chasing in the A* inner loop,
+/// and uses considerably less memory than a [Graph].
+///
+/// Edges pointing to nodes which don't exist in the source [Graph] are dropped.
+///
+/// # Example
+///
+/// ```no_run
+/// let g = routx::Graph::new();
+/// // ... load data into g ...
+///
+/// let frozen = g.freeze();
+/// let route = frozen.find_route_without_turn_around(1, 2, routx::DEFAULT_STEP_LIMIT);
+/// ```
+#[derive(Debug, Default, Clone, PartialEq)]
+pub struct FrozenGraph {
+    /// [Node::id] of every node.
+    pub(crate) ids: Array<i64>,
+
+    /// Dense indices of all nodes, sorted by their [Node::id]; empty if nodes
+    /// are in the [NodeOrder::Id] order (`ids` are sorted in ascending order).
+    pub(crate) id_index: Array<u32>,
+
+    /// [Node::osm_id] of every node.
+    pub(crate) osm_ids: Array<i64>,
+
+    /// [Node::lat] of every node.
+    pub(crate) lats: Array<f32>,
+
+    /// [Node::lon] of every node.
+    pub(crate) lons: Array<f32>,
+
+    /// Offsets into [FrozenGraph::edge_targets] and [FrozenGraph::edge_costs];
+    /// edges outgoing from node `i` are located at `edge_offsets[i]..edge_offsets[i + 1]`.
+    pub(crate) edge_offsets: Array<u32>,
+
+    /// Index of the node to which an edge points.
+    pub(crate) edge_targets: Array<u32>,
+
+    /// Cost of an edge.
+    pub(crate) edge_costs: Array<f32>,
+
+    /// Reverse adjacency, derived on first use by searches which need it.
+    pub(crate) incoming: LazyIncomingEdges,
+
+    /// Fingerprint of the nodes, edges and edge costs, derived on first use by [Landmarks].
+    pub(crate) fingerprint: LazyFingerprint,
+}
+
+impl FrozenGraph {
+    /// Creates a FrozenGraph snapshot of the provided [Graph].
+    ///
+    /// Panics if the graph has more than `u32::MAX - 1` nodes or edges.
+    pub fn from_graph(g: &Graph) -> Self {
+        let len = g.len();
+        assert!(len < NO_INDEX as usize, "too many nodes to freeze a graph");
+
+        let mut ids = Vec::with_capacity(len);
+        let mut osm_ids = Vec::with_capacity(len);
+        let mut lats = Vec::with_capacity(len);
+        let mut lons = Vec::with_capacity(len);
+
+        // BTreeMap iteration order guarantees that `ids` are sorted
+        for node in g.iter() {
+            ids.push(node.id);
+            osm_ids.push(node.osm_id);
+            lats.push(node.lat);
+            lons.push(node.lon);
+        }
+
+        let mut edge_offsets = Vec::with_capacity(len + 1);
+        let mut edge_targets = Vec::default();
+        let mut edge_costs = Vec::default();
+
+        edge_offsets.push(0);
+        for (_, (_, edges)) in g.nodes() {
+            for edge in edges {
+                // Silently drop edges to non-existing nodes
+                if let Ok(to) = ids.binary_search(&edge.to) {
+                    edge_targets.push(to as u32);
+                    edge_costs.push(edge.cost);
+                }
+            }
+
+            let offset = edge_targets.len();
+            assert!(
+                offset < NO_INDEX as usize,
+                "too many edges to freeze a graph"
+            );
+            edge_offsets.push(offset as u32);
+        }
+
+        edge_targets.shrink_to_fit();
+        edge_costs.shrink_to_fit();
+        Self {
+            ids: ids.into(),
+            id_index: Array::default(),
+            osm_ids: osm_ids.into(),
+            lats: lats.into(),
+            lons: lons.into(),
+            edge_offsets: edge_offsets.into(),
+            edge_targets: edge_targets.into(),
+            edge_costs: edge_costs.into(),
+            incoming: LazyIncomingEdges::default(),
+            fingerprint: LazyFingerprint::default(),
+        }
+    }
+
+    /// Returns the number of nodes in the graph.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.ids.len()
+    }
+
+    /// Returns `true` if there are no nodes in the graph.
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.ids.is_empty()
+    }
+
+    /// Returns the number of edges in the graph.
+    #[inline]
+    pub fn edge_count(&self) -> usize {
+        self.edge_targets.len()
+    }
+
+    /// Returns a copy of the graph with different edge costs, in the order of dense edge indices
+    /// (that is, the order of [FrozenGraph::get_edges] calls over [FrozenGraph::iter]).
+    ///
+    /// All other arrays are shared with this graph, so this only costs the new cost array.
+    ///
+    /// Panics if `costs.len() != self.edge_count()`.
+    pub fn with_edge_costs(&self, costs: Vec<f32>) -> Self {
+        assert_eq!(costs.len(), self.edge_count(), "edge costs length mismatch");
+        Self {
+            ids: self.ids.clone(),
+            id_index: self.id_index.clone(),
+            osm_ids: self.osm_ids.clone(),
+            lats: self.lats.clone(),
+            lons: self.lons.clone(),
+            edge_offsets: self.edge_offsets.clone(),
+            edge_targets: self.edge_targets.clone(),
+            edge_costs: costs.into(),
+            incoming: LazyIncomingEdges::default(),
+            fingerprint: LazyFingerprint::default(),
+        }
+    }
+
+    /// Returns a copy of the graph with nodes renumbered in the provided order.
+    ///
+    /// Edges are reordered to match, and [Node::id] lookups go through an additional
+    /// index sorted by id (unless the order is [NodeOrder::Id]), so all searches return the same
+    /// routes as on this graph. Renumbering along a space-filling curve improves the cache hit
+    /// rate of searches on large graphs, whose node ids rarely correlate with their position.
+    ///
+    /// Dense node and edge indices change, so [Landmarks], [CHGraph](crate::CHGraph)
+    /// and edge costs (see [FrozenGraph::with_edge_costs]) need to be built for the
+    /// returned graph.
+    pub fn reordered(&self, order: NodeOrder) -> Self {
+        // Old dense indices, in the new order.
+        // Sorting is stable, so nodes with equal curve keys remain in the id order.
+        let mut old: Vec<u32> = self.indices_by_id().collect();
+        match order {
+            NodeOrder::Id => {}
+            NodeOrder::Hilbert => self.sort_along_curve(&mut old, hilbert_key),
+            NodeOrder::Morton => self.sort_along_curve(&mut old, morton_key),
+        }
+
+        let mut new = vec![0_u32; self.len()];
+        for (new_idx, &old_idx) in old.iter().enumerate() {
+            new[old_idx as usize] = new_idx as u32;
+        }
+
+        let mut edge_offsets = Vec::with_capacity(self.len() + 1);
+        let mut edge_targets = Vec::with_capacity(self.edge_count());
+        let mut edge_costs = Vec::with_capacity(self.edge_count());
+        edge_offsets.push(0);
+        for &idx in &old {
+            for (to, cost) in self.edges_at(idx) {
+                edge_targets.push(new[to as usize]);
+                edge_costs.push(cost);
+            }
+            edge_offsets.push(edge_targets.len() as u32);
+        }
+
+        let id_index = match order {
+            NodeOrder::Id => Vec::default(),
+            _ => self.indices_by_id().map(|idx| new[idx as usize]).collect(),
+        };
+
+        Self {
+            ids: gather(&self.ids, &old).into(),
+            id_index: id_index.into(),
+            osm_ids: gather(&self.osm_ids, &old).into(),
+            lats: gather(&self.lats, &old).into(),
+            lons: gather(&self.lons, &old).into(),
+            edge_offsets: edge_offsets.into(),
+            edge_targets: edge_targets.into(),
+            edge_costs: edge_costs.into(),
+            incoming: LazyIncomingEdges::default(),
+            fingerprint: LazyFingerprint::default(),
+        }
+    }
+
+    /// Returns the dense indices of all edges from one node to another.
+    pub(crate) fn edge_indices(
+        &self,
+        from_id: i64,
+        to_id: i64,
+    ) -> impl Iterator<Item = usize> + '_ {
+        let edges = match (self.index_of(from_id), self.index_of(to_id)) {
+            (Some(from), Some(to)) => self.edge_range(from).zip(std::iter::repeat(to)),
+            _ => (0..0).zip(std::iter::repeat(0)),
+        };
+        edges.filter_map(|(e, to)| (self.edge_targets[e] == to).then_some(e))
+    }
+
+    /// Returns the dense index of a node with the provided id.
+    #[inline]
+    pub fn index_of(&self, id: i64) -> Option<u32> {
+        index_of(&self.ids, &self.id_index, id)
+    }
+
+    /// Stably sorts dense node indices by the key of their position along a space-filling curve,
+    /// given coordinates quantized to 32 bits over the bounding box of all nodes.
+    fn sort_along_curve(&self, indices: &mut [u32], key: fn(u32, u32) -> u64) {
+        let bounds = |values: &[f32]| {
+            let min = values.iter().cloned().fold(f32::INFINITY, f32::min) as f64;
+            let max = values.iter().cloned().fold(f32::NEG_INFINITY, f32::max) as f64;
+            let scale = if max > min {
+                u32::MAX as f64 / (max - min)
+            } else {
+                0.0
+            };
+            (min, scale)
+        };
+        let (min_lat, lat_scale) = bounds(&self.lats);
+        let (min_lon, lon_scale) = bounds(&self.lons);
+        let quantize = |value: f32, min: f64, scale: f64| ((value as f64 - min) * scale) as u32;
+
+        indices.sort_by_cached_key(|&idx| {
+            let x = quantize(self.lons[idx as usize], min_lon, lon_scale);
+            let y = quantize(self.lats[idx as usize], min_lat, lat_scale);
+            key(x, y)
+        });
+    }
+
+    /// Returns an iterator over dense indices of all nodes, in the ascending [Node::id] order.
+    fn indices_by_id(&self) -> impl Iterator<Item = u32> + '_ {
+        let identity = self.id_index.is_empty().then(|| 0..self.len() as u32);
+        identity
+            .into_iter()
+            .flatten()
+            .chain(self.id_index.iter().cloned())
+    }
+
+    /// Returns the [Node] at the provided dense index.
+    ///
+    /// Panics if the index is out of bounds.
+    #[inline]
+    pub fn node_at(&self, idx: u32) -> Node {
+        let idx = idx as usize;
+        Node {
+            id: self.ids[idx],
+            osm_id: self.osm_ids[idx],
+            lat: self.lats[idx],
+            lon: self.lons[idx],
+        }
+    }
+
+    /// Retrieves a [Node] with the provided id.
+    pub fn get_node(&self, id: i64) -> Option<Node> {
+        self.index_of(id).map(|idx| self.node_at(idx))
+    }
+
+    /// Returns an iterator over all [Nodes](Node) in the graph, in the dense index order.
+    pub fn iter(&self) -> impl Iterator<Item = Node> + '_ {
+        (0..self.len() as u32).map(|idx| self.node_at(idx))
+    }
+
+    /// Returns the range of edge indices outgoing from the node at the provided dense index.
+    #[inline]
+    pub(crate) fn edge_range(&self, idx: u32) -> std::ops::Range<usize> {
+        let idx = idx as usize;
+        self.edge_offsets[idx] as usize..self.edge_offsets[idx + 1] as usize
+    }
+
+    /// Returns an iterator over `(target index, cost)` pairs of edges outgoing from the
+    /// node at the provided dense index.
+    #[inline]
+    pub fn edges_at(&self, idx: u32) -> impl Iterator<Item = (u32, f32)> + '_ {
+        let range = self.edge_range(idx);
+        self.edge_targets[range.clone()]
+            .iter()
+            .cloned()
+            .zip(self.edge_costs[range].iter().cloned())
+    }
+
+    /// Returns the reverse adjacency of the graph, deriving it on first use.
+    pub(crate) fn incoming(&self) -> &IncomingEdges {
+        self.incoming
+            .0
+            .get_or_init(|| Arc::new(IncomingEdges::from_frozen(self)))
+    }
+
+    /// Returns a fingerprint of the node ids, edges and edge costs, computing it on first use.
+    ///
+    /// Graphs derived from another graph by only raising edge costs may inherit its fingerprint
+    /// (see [FrozenGraph::inherit_fingerprint]), as lower bounds of costs computed
+    /// for the original graph remain valid for them.
+    pub(crate) fn fingerprint(&self) -> u64 {
+        *self.fingerprint.0.get_or_init(|| {
+            // FxHash-style mixing of 64-bit words - not cryptographic, but stable across
+            // platforms and processes, as fingerprints are persisted with landmarks.
+            let mut h: u64 = 0;
+            let mut mix =
+                |word: u64| h = (h.rotate_left(5) ^ word).wrapping_mul(0x51_7c_c1_b7_27_22_0a_95);
+            mix(self.len() as u64);
+            mix(self.edge_count() as u64);
+            self.ids.iter().for_each(|&id| mix(id as u64));
+            self.edge_offsets.iter().for_each(|&o| mix(o as u64));
+            self.edge_targets.iter().for_each(|&t| mix(t as u64));
+            self.edge_costs
+                .iter()
+                .for_each(|&c| mix(c.to_bits() as u64));
+            h
+        })
+    }
+
+    /// Makes the graph share the [FrozenGraph::fingerprint] of `original`, which must have
+    /// the same nodes and edges, with none of its edge costs higher than the costs of this graph.
+    /// Does nothing if the fingerprint of this graph was already computed.
+    pub(crate) fn inherit_fingerprint(&self, original: &FrozenGraph) {
+        debug_assert!(self.edge_costs.len() == original.edge_costs.len());
+        let _ = self.fingerprint.0.set(original.fingerprint());
+    }
+
+    /// Returns an iterator over all outgoing [Edges](Edge) from a node with a given id.
+    pub fn get_edges(&self, from_id: i64) -> impl Iterator<Item = Edge> + '_ {
+        self.index_of(from_id)
+            .into_iter()
+            .flat_map(|idx| self.edges_at(idx))
+            .map(|(to, cost)| Edge {
+                to: self.ids[to as usize],
+                cost,
+            })
+    }
+
+    /// Gets the cost of an [Edge] from one node to another.
+    /// If such an edge doesn't exist, returns [f32::INFINITY].
+    pub fn get_edge(&self, from_id: i64, to_id: i64) -> f32 {
+        match (self.index_of(from_id), self.index_of(to_id)) {
+            (Some(from), Some(to)) => self
+                .edges_at(from)
+                .find_map(|(target, cost)| if target == to { Some(cost) } else { None })
+                .unwrap_or(f32::INFINITY),
+            _ => f32::INFINITY,
+        }
+    }
+
+    /// Finds the shortest route between two nodes, see [find_route](crate::find_route).
+    ///
+    /// Allocates a new [SearchContext] for the search. Prefer
+    /// [FrozenGraph::find_route_with_context] when answering many queries.
+    pub fn find_route(
+        &self,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Vec<i64>, AStarError> {
+        self.find_route_with_context(&mut SearchContext::new(), from_id, to_id, step_limit)
+    }
+
+    /// Finds the shortest route between two nodes, see [find_route](crate::find_route),
+    /// reusing the storage of the provided [SearchContext].
+    pub fn find_route_with_context(
+        &self,
+        ctx: &mut SearchContext,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Vec<i64>, AStarError> {
+        let mut path = Vec::default();
+        self.find_route_into(ctx, from_id, to_id, step_limit, &mut path)?;
+        Ok(path)
+    }
+
+    /// Same as [FrozenGraph::find_route_with_context], but writes the route into the provided
+    /// vector instead of allocating a new one. `path` is cleared first, and left empty if
+    /// no route exists or on error.
+    pub fn find_route_into(
+        &self,
+        ctx: &mut SearchContext,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+        path: &mut Vec<i64>,
+    ) -> Result<(), AStarError> {
+        path.clear();
+        ctx.measure(|ctx| astar::frozen::find_route(self, ctx, from_id, to_id, step_limit, path))
+    }
+
+    /// Finds the shortest route between two nodes, see [find_route](crate::find_route),
+    /// using the [ALT](Landmarks) heuristic - the maximum of the crow-flies distance and the
+    /// triangle inequality bounds given by the provided [Landmarks].
+    ///
+    /// Panics if the landmarks were built for a different graph.
+    pub fn find_route_with_landmarks(
+        &self,
+        ctx: &mut SearchContext,
+        landmarks: &Landmarks,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Vec<i64>, AStarError> {
+        assert!(
+            landmarks.is_compatible_with(self),
+            "landmarks built for a different graph"
+        );
+        let mut path = Vec::default();
+        ctx.measure(|ctx| {
+            let (from, to) = astar::frozen::resolve_endpoints(self, from_id, to_id)?;
+            astar::frozen::find_route_between(
+                self,
+                ctx,
+                from,
+                to,
+                step_limit,
+                |v| astar::frozen::heuristic(self, v, to).max(landmarks.lower_bound(v, to)),
+                &mut path,
+            )
+        })?;
+        Ok(path)
+    }
+
+    /// Finds the shortest route between two nodes without immediate turnarounds (A-B-A),
+    /// see [find_route_without_turn_around](crate::find_route_without_turn_around),
+    /// using the [ALT](Landmarks) heuristic, see [FrozenGraph::find_route_with_landmarks].
+    ///
+    /// Panics if the landmarks were built for a different graph.
+    pub fn find_route_without_turn_around_with_landmarks(
+        &self,
+        ctx: &mut SearchContext,
+        landmarks: &Landmarks,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Vec<i64>, AStarError> {
+        assert!(
+            landmarks.is_compatible_with(self),
+            "landmarks built for a different graph"
+        );
+        let mut path = Vec::default();
+        ctx.measure(|ctx| {
+            let (from, to) = astar::frozen::resolve_endpoints(self, from_id, to_id)?;
+            astar::frozen::find_route_without_turn_around_between(
+                self,
+                ctx,
+                from,
+                to,
+                step_limit,
+                |v| astar::frozen::heuristic(self, v, to).max(landmarks.lower_bound(v, to)),
+                &mut path,
+            )
+        })?;
+        Ok(path)
+    }
+
+    /// Finds the shortest route between two nodes, see [find_route](crate::find_route),
+    /// with a bidirectional A* search.
+    ///
+    /// The forward and backward searches meet in the middle, which on medium and long
+    /// queries expands roughly half the nodes of [FrozenGraph::find_route]. `step_limit` limits
+    /// the number of nodes expanded by both searches together. The reverse adjacency required
+    /// by the backward search is derived on first use.
+    ///
+    /// Allocates a new [SearchContext] for the search. Prefer
+    /// [FrozenGraph::find_route_bidirectional_with_context] when answering many queries.
+    pub fn find_route_bidirectional(
+        &self,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Vec<i64>, AStarError> {
+        self.find_route_bidirectional_with_context(
+            &mut SearchContext::new(),
+            from_id,
+            to_id,
+            step_limit,
+        )
+    }
+
+    /// Same as [FrozenGraph::find_route_bidirectional], but reuses the storage
+    /// of the provided [SearchContext].
+    pub fn find_route_bidirectional_with_context(
+        &self,
+        ctx: &mut SearchContext,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Vec<i64>, AStarError> {
+        ctx.measure(|ctx| astar::bidirectional::find_route(self, ctx, from_id, to_id, step_limit))
+    }
+
+    /// Finds the shortest route between two nodes without immediate turnarounds (A-B-A),
+    /// see [find_route_without_turn_around](crate::find_route_without_turn_around).
+    ///
+    /// Allocates a new [SearchContext] for the search. Prefer
+    /// [FrozenGraph::find_route_without_turn_around_with_context] when answering many queries.
+    pub fn find_route_without_turn_around(
+        &self,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Vec<i64>, AStarError> {
+        self.find_route_without_turn_around_with_context(
+            &mut SearchContext::new(),
+            from_id,
+            to_id,
+            step_limit,
+        )
+    }
+
+    /// Finds the shortest route between two nodes without immediate turnarounds (A-B-A),
+    /// see [find_route_without_turn_around](crate::find_route_without_turn_around),
+    /// reusing the storage of the provided [SearchContext].
+    pub fn find_route_without_turn_around_with_context(
+        &self,
+        ctx: &mut SearchContext,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Vec<i64>, AStarError> {
+        let mut path = Vec::default();
+        self.find_route_without_turn_around_into(ctx, from_id, to_id, step_limit, &mut path)?;
+        Ok(path)
+    }
+
+    /// Same as [FrozenGraph::find_route_without_turn_around_with_context], but writes the route
+    /// into the provided vector, see [FrozenGraph::find_route_into].
+    pub fn find_route_without_turn_around_into(
+        &self,
+        ctx: &mut SearchContext,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+        path: &mut Vec<i64>,
+    ) -> Result<(), AStarError> {
+        path.clear();
+        ctx.measure(|ctx| {
+            astar::frozen::find_route_without_turn_around(
+                self, ctx, from_id, to_id, step_limit, path,
+            )
+        })
+    }
+
+    /// Answers a single [RouteRequest] using the provided [SearchContext], returning
+    /// the position and cumulative cost of every node of the route, see
+    /// [find_route_detailed](crate::find_route_detailed).
+    ///
+    /// Positions and costs are read directly from the dense arrays and search labels,
+    /// without any per-node lookups.
+    pub fn find_route_detailed(
+        &self,
+        ctx: &mut SearchContext,
+        r: &RouteRequest,
+    ) -> Result<RouteDetailed, AStarError> {
+        let mut route = RouteDetailed::default();
+        self.find_route_detailed_into(ctx, r, &mut route)?;
+        Ok(route)
+    }
+
+    /// Same as [FrozenGraph::find_route_detailed], but writes the route into the provided
+    /// [RouteDetailed], which is cleared first, and left empty if no route exists or on error.
+    pub fn find_route_detailed_into(
+        &self,
+        ctx: &mut SearchContext,
+        r: &RouteRequest,
+        route: &mut RouteDetailed,
+    ) -> Result<(), AStarError> {
+        route.clear();
+        ctx.measure(|ctx| {
+            if r.without_turn_around {
+                astar::frozen::find_route_without_turn_around(
+                    self,
+                    ctx,
+                    r.from,
+                    r.to,
+                    r.step_limit,
+                    route,
+                )
+            } else {
+                astar::frozen::find_route(self, ctx, r.from, r.to, r.step_limit, route)
+            }
+        })
+    }
+
+    /// Finds all nodes which can be reached from the provided node with a total cost
+    /// of at most `max_cost`, calling `f(node_id, cost)` on each of them, in the order
+    /// of increasing costs. The start node is always reached with a zero cost.
+    ///
+    /// Runs a Dijkstra search bounded by `max_cost`, reusing the storage of the provided
+    /// [SearchContext]. Turn-around restrictions are not taken into account, and nodes
+    /// created for turn restrictions are reported separately from the canonical ones.
+    ///
+    /// `step_limit` limits the number of reached nodes, see [find_route](crate::find_route).
+    /// If it is exceeded, `f` will have already been called on the first `step_limit` nodes.
+    /// Returns the number of reached nodes.
+    pub fn reachable<F: FnMut(i64, f32)>(
+        &self,
+        ctx: &mut SearchContext,
+        from_id: i64,
+        max_cost: f32,
+        step_limit: usize,
+        mut f: F,
+    ) -> Result<usize, AStarError> {
+        ctx.measure(|ctx| {
+            let from = self
+                .index_of(from_id)
+                .ok_or(AStarError::InvalidReference(from_id))?;
+            astar::reachable::reachable(self, ctx, from, max_cost, step_limit, |v, cost| {
+                f(self.ids[v as usize], cost)
+            })
+        })
+    }
+
+    /// Same as [FrozenGraph::reachable], but also writes the vertices of the convex hull
+    /// of all reached nodes (in counter-clockwise order, treating longitudes and latitudes
+    /// as planar coordinates) into `hull`.
+    ///
+    /// `hull` is cleared first, and left empty on error.
+    pub fn reachable_with_hull<F: FnMut(i64, f32)>(
+        &self,
+        ctx: &mut SearchContext,
+        from_id: i64,
+        max_cost: f32,
+        step_limit: usize,
+        hull: &mut Vec<Node>,
+        mut f: F,
+    ) -> Result<usize, AStarError> {
+        hull.clear();
+        ctx.measure(|ctx| {
+            let from = self
+                .index_of(from_id)
+                .ok_or(AStarError::InvalidReference(from_id))?;
+
+            let mut reached = std::mem::take(&mut ctx.reached);
+            reached.clear();
+            let result =
+                astar::reachable::reachable(self, ctx, from, max_cost, step_limit, |v, cost| {
+                    reached.push(self.node_at(v));
+                    f(self.ids[v as usize], cost);
+                });
+            if result.is_ok() {
+                astar::reachable::convex_hull(&mut reached, hull);
+            }
+            ctx.reached = reached;
+            result
+        })
+    }
+
+    /// Calculates the costs of the shortest routes from every source to every target.
+    ///
+    /// Returns a `sources.len() × targets.len()` matrix in row-major order, that is
+    /// the cost from `sources[i]` to `targets[j]` is at `i * targets.len() + j`.
+    ///
+    /// Runs a single Dijkstra search per source, which stops as soon as all targets are settled,
+    /// instead of a separate A* search for every pair. Turn-around restrictions are not taken
+    /// into account. `step_limit` applies to each search separately.
+    ///
+    /// Costs to targets which are unknown, unreachable or not settled within the `step_limit`
+    /// are set to [f32::INFINITY]. All costs from unknown sources are [f32::INFINITY].
+    pub fn cost_matrix(&self, sources: &[i64], targets: &[i64], step_limit: usize) -> Vec<f32> {
+        let mut out = vec![f32::INFINITY; sources.len() * targets.len()];
+        self.cost_matrix_into(
+            &mut SearchContext::new(),
+            sources,
+            targets,
+            step_limit,
+            &mut out,
+        );
+        out
+    }
+
+    /// Same as [FrozenGraph::cost_matrix], but reuses the storage of the provided [SearchContext]
+    /// and writes costs into the provided slice.
+    ///
+    /// Panics if `out.len() != sources.len() * targets.len()`.
+    pub fn cost_matrix_into(
+        &self,
+        ctx: &mut SearchContext,
+        sources: &[i64],
+        targets: &[i64],
+        step_limit: usize,
+        out: &mut [f32],
+    ) {
+        ctx.measure(|ctx| astar::matrix::cost_matrix(self, ctx, sources, targets, step_limit, out))
+    }
+
+    /// Answers a batch of route queries on multiple threads.
+    ///
+    /// Queries are spread over a work-stealing pool of `threads` threads (zero stands for
+    /// [available parallelism](std::thread::available_parallelism)), each with its own
+    /// [SearchContext]. Results are returned in the order of requests.
+    pub fn find_routes_parallel(
+        &self,
+        requests: &[RouteRequest],
+        threads: usize,
+    ) -> Vec<Result<Vec<i64>, AStarError>> {
+        parallel::map(requests, threads, SearchContext::new, |ctx, r| {
+            self.find_route_with_request(ctx, r)
+        })
+    }
+
+    /// Answers a single [RouteRequest] using the provided [SearchContext].
+    pub fn find_route_with_request(
+        &self,
+        ctx: &mut SearchContext,
+        r: &RouteRequest,
+    ) -> Result<Vec<i64>, AStarError> {
+        let mut path = Vec::default();
+        self.find_route_with_request_into(ctx, r, &mut path)?;
+        Ok(path)
+    }
+
+    /// Answers a single [RouteRequest] using the provided [SearchContext],
+    /// writing the route into the provided vector, see [FrozenGraph::find_route_into].
+    pub fn find_route_with_request_into(
+        &self,
+        ctx: &mut SearchContext,
+        r: &RouteRequest,
+        path: &mut Vec<i64>,
+    ) -> Result<(), AStarError> {
+        if r.without_turn_around {
+            self.find_route_without_turn_around_into(ctx, r.from, r.to, r.step_limit, path)
+        } else {
+            self.find_route_into(ctx, r.from, r.to, r.step_limit, path)
+        }
+    }
+}
+
+/// Finds the dense index of a node with the provided id, given the [Node::id] of every node
+/// and the dense indices sorted by id (empty if `ids` are sorted), see [FrozenGraph::id_index].
+#[inline]
+pub(crate) fn index_of(ids: &[i64], id_index: &[u32], id: i64) -> Option<u32> {
+    if id_index.is_empty() {
+        ids.binary_search(&id).ok().map(|idx| idx as u32)
+    } else {
+        id_index
+            .binary_search_by_key(&id, |&idx| ids[idx as usize])
+            .ok()
+            .map(|i| id_index[i])
+    }
+}
+
+/// Returns `values[i]` for every `i` in `indices`.
+fn gather<T: Copy>(values: &[T], indices: &[u32]) -> Vec<T> {
+    indices.iter().map(|&idx| values[idx as usize]).collect()
+}
+
+/// Returns the distance of a point along the
+/// [Hilbert curve](https://en.wikipedia.org/wiki/Hilbert_curve#Applications_and_mapping_algorithms)
+/// filling the 2<sup>32</sup> × 2<sup>32</sup> grid.
+fn hilbert_key(mut x: u32, mut y: u32) -> u64 {
+    let mut d = 0_u64;
+    let mut s = 1_u32 << 31;
+    while s > 0 {
+        let rx = (x & s != 0) as u64;
+        let ry = (y & s != 0) as u64;
+        d += (s as u64) * (s as u64) * ((3 * rx) ^ ry);
+
+        // Rotate the quadrant, so that the curve is continuous
+        if ry == 0 {
+            if rx == 1 {
+                x = !x;
+                y = !y;
+            }
+            std::mem::swap(&mut x, &mut y);
+        }
+        s >>= 1;
+    }
+    d
+}
+
+/// Returns the distance of a point along the
+/// [Z-order curve](https://en.wikipedia.org/wiki/Z-order_curve), that is,
+/// interleaves the bits of both coordinates.
+fn morton_key(x: u32, y: u32) -> u64 {
+    fn spread(v: u32) -> u64 {
+        let mut v = v as u64;
+        v = (v | (v << 16)) & 0x0000_FFFF_0000_FFFF;
+        v = (v | (v << 8)) & 0x00FF_00FF_00FF_00FF;
+        v = (v | (v << 4)) & 0x0F0F_0F0F_0F0F_0F0F;
+        v = (v | (v << 2)) & 0x3333_3333_3333_3333;
+        v = (v | (v << 1)) & 0x5555_5555_5555_5555;
+        v
+    }
+    spread(x) | (spread(y) << 1)
+}
+
+/// Magic bytes at the start of a serialized [FrozenGraph].
+const MAGIC: &[u8; 8] = b"RoutxGRF";
+
+/// Version of the serialized [FrozenGraph] format.
+///
+/// Version 2 adds the id index of [reordered](FrozenGraph::reordered) graphs after
+/// all other arrays. Graphs in the [NodeOrder::Id] order are still written as version 1,
+/// so that they remain readable by older versions of the library.
+const VERSION: u32 = 2;
+
+/// Size of the serialized [FrozenGraph] header: magic, version, reserved flags,
+/// number of nodes and number of edges.
+const HEADER_SIZE: u64 = 32;
+
+/// Alignment of every array in a serialized [FrozenGraph], so that they can be
+/// used in place from a memory map.
+pub(crate) const ALIGNMENT: u64 = 8;
+
+/// Byte offsets of the arrays of a serialized [FrozenGraph], in order:
+/// ids, osm_ids, lats, lons, edge_offsets, edge_targets, edge_costs and id_index
+/// (empty unless `indexed`). The last element is the total size of the file.
+fn layout(nodes: u64, edges: u64, indexed: bool) -> [u64; 9] {
+    let sizes = [
+        nodes * 8,
+        nodes * 8,
+        nodes * 4,
+        nodes * 4,
+        (nodes + 1) * 4,
+        edges * 4,
+        edges * 4,
+        if indexed { nodes * 4 } else { 0 },
+    ];
+
+    let mut offsets = [0; 9];
+    let mut offset = HEADER_SIZE;
+    for (i, size) in sizes.into_iter().enumerate() {
+        offset = offset.next_multiple_of(ALIGNMENT);
+        offsets[i] = offset;
+        offset += size;
+    }
+    offsets[8] = offset;
+    offsets
+}
+
+/// Reads and validates the header of a serialized [FrozenGraph],
+/// returning the number of nodes and edges, and whether the file has an id index.
+fn read_header<R: Read>(r: &mut R) -> io::Result<(u64, u64, bool)> {
+    let mut magic = [0_u8; 8];
+    r.read_exact(&mut magic)?;
+    if &magic != MAGIC {
+        return Err(binary::invalid_data("not a routx graph file"));
+    }
+    let version: u32 = binary::read(r)?;
+    if !(1..=VERSION).contains(&version) {
+        return Err(binary::invalid_data("unsupported routx graph version"));
+    }
+    let _flags: u32 = binary::read(r)?;
+
+    let nodes: u64 = binary::read(r)?;
+    let edges: u64 = binary::read(r)?;
+    if nodes >= NO_INDEX as u64 || edges >= NO_INDEX as u64 {
+        return Err(binary::invalid_data(
+            "too many nodes or edges in routx graph",
+        ));
+    }
+    Ok((nodes, edges, version >= 2))
+}
+
+/// Writes zero padding up to `offset`, followed by all `values`.
+pub(crate) fn write_section<W: Write, T: Scalar>(
+    w: &mut W,
+    position: &mut u64,
+    offset: u64,
+    values: &[T],
+) -> io::Result<()> {
+    w.write_all(&[0_u8; ALIGNMENT as usize][..(offset - *position) as usize])?;
+    binary::write_slice(w, values)?;
+    *position = offset + (values.len() * T::SIZE) as u64;
+    Ok(())
+}
+
+/// Skips padding up to `offset`, and reads `len` values.
+pub(crate) fn read_section<R: Read, T: Scalar>(
+    r: &mut R,
+    position: &mut u64,
+    offset: u64,
+    len: usize,
+) -> io::Result<Array<T>> {
+    let padding = offset - *position;
+    if io::copy(&mut r.take(padding), &mut io::sink())? != padding {
+        return Err(io::ErrorKind::UnexpectedEof.into());
+    }
+    let values = binary::read_vec(r, len)?;
+    *position = offset + (len * T::SIZE) as u64;
+    Ok(Array::from(values))
+}
+
+impl FrozenGraph {
+    /// Serializes the graph into a versioned, little-endian binary format.
+    ///
+    /// The format mirrors the in-memory layout: a 32-byte header followed by every array of
+    /// the graph, each aligned to 8 bytes. This allows [FrozenGraph::open_mmap] to use the
+    /// arrays in place, without any parsing.
+    pub fn write<W: Write>(&self, w: &mut W) -> io::Result<()> {
+        let indexed = !self.id_index.is_empty();
+        let offsets = layout(self.len() as u64, self.edge_count() as u64, indexed);
+        w.write_all(MAGIC)?;
+        binary::write(w, if indexed { VERSION } else { 1 })?;
+        binary::write(w, 0_u32)?;
+        binary::write(w, self.len() as u64)?;
+        binary::write(w, self.edge_count() as u64)?;
+
+        let mut p = HEADER_SIZE;
+        write_section(w, &mut p, offsets[0], &self.ids)?;
+        write_section(w, &mut p, offsets[1], &self.osm_ids)?;
+        write_section(w, &mut p, offsets[2], &self.lats)?;
+        write_section(w, &mut p, offsets[3], &self.lons)?;
+        write_section(w, &mut p, offsets[4], &self.edge_offsets)?;
+        write_section(w, &mut p, offsets[5], &self.edge_targets)?;
+        write_section(w, &mut p, offsets[6], &self.edge_costs)?;
+        write_section(w, &mut p, offsets[7], &self.id_index)?;
+        Ok(())
+    }
+
+    /// Deserializes a graph written by [FrozenGraph::write], copying all data into memory.
+    pub fn read<R: Read>(r: &mut R) -> io::Result<Self> {
+        let (nodes, edges, indexed) = read_header(r)?;
+        let offsets = layout(nodes, edges, indexed);
+        let (n, m) = (nodes as usize, edges as usize);
+        let k = if indexed { n } else { 0 };
+
+        let mut p = HEADER_SIZE;
+        let mut g = Self {
+            ids: read_section(r, &mut p, offsets[0], n)?,
+            id_index: Array::default(),
+            osm_ids: read_section(r, &mut p, offsets[1], n)?,
+            lats: read_section(r, &mut p, offsets[2], n)?,
+            lons: read_section(r, &mut p, offsets[3], n)?,
+            edge_offsets: read_section(r, &mut p, offsets[4], n + 1)?,
+            edge_targets: read_section(r, &mut p, offsets[5], m)?,
+            edge_costs: read_section(r, &mut p, offsets[6], m)?,
+            incoming: LazyIncomingEdges::default(),
+            fingerprint: LazyFingerprint::default(),
+        };
+        g.id_index = read_section(r, &mut p, offsets[7], k)?;
+        g.validate()?;
+        Ok(g)
+    }
+
+    /// Saves the graph to a file, see [FrozenGraph::write].
+    pub fn save<P: AsRef<Path>>(&self, path: P) -> io::Result<()> {
+        let mut w = BufWriter::new(File::create(path)?);
+        self.write(&mut w)?;
+        w.flush()
+    }
+
+    /// Loads a graph from a file, copying all data into memory, see [FrozenGraph::read].
+    pub fn load<P: AsRef<Path>>(path: P) -> io::Result<Self> {
+        Self::read(&mut BufReader::new(File::open(path)?))
+    }
+
+    /// Opens a graph saved with [FrozenGraph::save] by memory-mapping the file.
+    ///
+    /// All arrays are used in place, straight from the (shared, read-only) mapping, and multiple
+    /// processes opening the same file share a single page-cache copy of the graph.
+    /// Opening still reads the ids, edge offsets and edge targets once, to validate them
+    /// like [FrozenGraph::read] does, so that a corrupted file can't cause panics
+    /// during searches. Coordinates and costs are not validated,
+    /// a corrupted file may still result in wrong routes.
+    ///
+    /// On non-unix or big-endian platforms, falls back to [FrozenGraph::load].
+    ///
+    /// # Safety
+    ///
+    /// The file must not be modified or truncated (by this or any other process) while any
+    /// graph (or its clone) using it is alive. Otherwise, the arrays of the graph may change
+    /// underneath shared references, which is undefined behavior, or reading them may
+    /// raise `SIGBUS`. To atomically replace a mapped graph, write a new file and rename it over
+    /// the old one - which keeps the old file alive for as long as it is mapped.
+    pub unsafe fn open_mmap<P: AsRef<Path>>(path: P) -> io::Result<Self> {
+        #[cfg(all(unix, target_endian = "little"))]
+        {
+            let file = File::open(path)?;
+            // SAFETY: Upheld by the caller
+            let map = Arc::new(unsafe { Mmap::map(&file) }?);
+            Self::from_mmap(map)
+        }
+
+        #[cfg(not(all(unix, target_endian = "little")))]
+        {
+            Self::load(path)
+        }
+    }
+
+    #[cfg(all(unix, target_endian = "little"))]
+    fn from_mmap(map: Arc<Mmap>) -> io::Result<Self> {
+        let bytes = map.as_bytes();
+        let (nodes, edges, indexed) = read_header(&mut &bytes[..])?;
+        let offsets = layout(nodes, edges, indexed);
+        if (bytes.len() as u64) < offsets[8] {
+            return Err(io::ErrorKind::UnexpectedEof.into());
+        }
+
+        let (n, m) = (nodes as usize, edges as usize);
+        let at = |i: usize| offsets[i] as usize;
+        let g = Self {
+            ids: Array::mapped(&map, at(0), n),
+            id_index: Array::mapped(&map, at(7), if indexed { n } else { 0 }),
+            osm_ids: Array::mapped(&map, at(1), n),
+            lats: Array::mapped(&map, at(2), n),
+            lons: Array::mapped(&map, at(3), n),
+            edge_offsets: Array::mapped(&map, at(4), n + 1),
+            edge_targets: Array::mapped(&map, at(5), m),
+            edge_costs: Array::mapped(&map, at(6), m),
+            incoming: LazyIncomingEdges::default(),
+            fingerprint: LazyFingerprint::default(),
+        };
+        g.validate()?;
+        Ok(g)
+    }
+
+    /// Performs sanity checks of deserialized edge offsets and node ids. As lookups by id
+    /// binary-search them, ids must be strictly ascending - either directly (version 1),
+    /// or along the id index, which must only point at existing nodes (version 2).
+    fn validate(&self) -> io::Result<()> {
+        if self.edge_offsets.first() != Some(&0)
+            || self.edge_offsets.last().map(|&o| o as usize) != Some(self.edge_count())
+            || !self.edge_offsets.windows(2).all(|w| w[0] <= w[1])
+        {
+            return Err(binary::invalid_data("invalid edge offsets in routx graph"));
+        }
+
+        if !self
+            .edge_targets
+            .iter()
+            .all(|&to| (to as usize) < self.len())
+        {
+            return Err(binary::invalid_data("invalid edge targets in routx graph"));
+        }
+
+        if self.id_index.is_empty() {
+            if !self.ids.windows(2).all(|w| w[0] < w[1]) {
+                return Err(binary::invalid_data("unsorted ids in routx graph"));
+            }
+        } else if self.id_index.len() != self.len()
+            || !self.id_index.iter().all(|&i| (i as usize) < self.len())
+            || !self
+                .id_index
+                .windows(2)
+                .all(|w| self.ids[w[0] as usize] < self.ids[w[1] as usize])
+        {
+            return Err(binary::invalid_data("invalid id index in routx graph"));
+        }
+        Ok(())
+    }
+}
+
+/// Reverse [compressed sparse row](FrozenGraph) adjacency of a [FrozenGraph]:
+/// edges incoming into node `i` are located at `offsets[i]..offsets[i + 1]`.
+#[derive(Debug, Default, Clone, PartialEq)]
+pub(crate) struct IncomingEdges {
+    pub(crate) offsets: Vec<u32>,
+    pub(crate) sources: Vec<u32>,
+    pub(crate) costs: Vec<f32>,
+}
+
+impl IncomingEdges {
+    fn from_frozen(g: &FrozenGraph) -> Self {
+        // Counting sort of edges by their targets
+        let mut offsets = vec![0_u32; g.len() + 1];
+        for &to in g.edge_targets.iter() {
+            offsets[to as usize + 1] += 1;
+        }
+        for i in 1..offsets.len() {
+            offsets[i] += offsets[i - 1];
+        }
+
+        let mut next = offsets.clone();
+        let mut sources = vec![0_u32; g.edge_count()];
+        let mut costs = vec![0.0_f32; g.edge_count()];
+        for from in 0..g.len() as u32 {
+            for e in g.edge_range(from) {
+                let slot = &mut next[g.edge_targets[e] as usize];
+                sources[*slot as usize] = from;
+                costs[*slot as usize] = g.edge_costs[e];
+                *slot += 1;
+            }
+        }
+
+        Self {
+            offsets,
+            sources,
+            costs,
+        }
+    }
+
+    /// Returns an iterator over `(source index, cost)` pairs of edges incoming into
+    /// the node at the provided dense index.
+    #[inline]
+    pub(crate) fn edges_at(&self, idx: u32) -> impl Iterator<Item = (u32, f32)> + '_ {
+        let range = self.offsets[idx as usize] as usize..self.offsets[idx as usize + 1] as usize;
+        self.sources[range.clone()]
+            .iter()
+            .cloned()
+            .zip(self.costs[range].iter().cloned())
+    }
+}
+
+/// Lazily-initialized [IncomingEdges], shared between clones of a graph. As the index
+/// is fully derived from the graph, it is ignored when comparing two graphs.
+#[derive(Debug, Default, Clone)]
+pub(crate) struct LazyIncomingEdges(pub(crate) OnceLock<Arc<IncomingEdges>>);
+
+impl PartialEq for LazyIncomingEdges {
+    fn eq(&self, _: &Self) -> bool {
+        true
+    }
+}
+
+/// Lazily-computed [FrozenGraph::fingerprint]. As it is fully derived from the graph,
+/// it is ignored when comparing two graphs.
+#[derive(Debug, Default, Clone)]
+pub(crate) struct LazyFingerprint(pub(crate) OnceLock<u64>);
+
+impl PartialEq for LazyFingerprint {
+    fn eq(&self, _: &Self) -> bool {
+        true
+    }
+}
+
+impl From<&Graph> for FrozenGraph {
+    fn from(g: &Graph) -> Self {
+        Self::from_graph(g)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[inline]
+    fn fixture_graph() -> Graph {
+        Graph::from_iter(
+            [
+                Node {
+                    id: 3,
+                    osm_id: 3,
+                    lat: 0.03,
+                    lon: 0.01,
+                },
+                Node {
+                    id: 1,
+                    osm_id: 1,
+                    lat: 0.01,
+                    lon: 0.01,
+                },
+                Node {
+                    id: 2,
+                    osm_id: 2,
+                    lat: 0.02,
+                    lon: 0.01,
+                },
+                Node {
+                    id: 20,
+                    osm_id: 2,
+                    lat: 0.02,
+                    lon: 0.01,
+                },
+            ],
+            [
+                (1, 2, 200.0),
+                (1, 20, 200.0),
+                (2, 1, 200.0),
+                (2, 3, 150.0),
+                (3, 2, 150.0),
+                (20, 3, 150.0),
+            ],
+        )
+    }
+
+    #[test]
+    fn from_graph() {
+        let mut g = fixture_graph();
+        g.delete_node(20); // leaves a dangling 1->20 edge
+        let f = g.freeze();
+
+        assert_eq!(f.len(), 3);
+        assert_eq!(f.edge_count(), 4);
+        assert_eq!(f.ids, vec![1, 2, 3]);
+        assert_eq!(f.edge_offsets, vec![0, 1, 3, 4]);
+        assert_eq!(f.edge_targets, vec![1, 0, 2, 1]);
+        assert_eq!(f.edge_costs, vec![200.0, 200.0, 150.0, 150.0]);
+    }
+
+    #[test]
+    fn reordered() {
+        let f = fixture_graph().freeze();
+        let r = f.reordered(NodeOrder::Hilbert);
+
+        // Nodes are ordered by latitude along the curve, as all share the same longitude
+        assert_eq!(r.ids, vec![1, 2, 20, 3]);
+        assert_eq!(r.id_index, vec![0, 1, 3, 2]);
+        assert_eq!(r.index_of(3), Some(3));
+        assert_eq!(r.index_of(42), None);
+        for node in f.iter() {
+            assert_eq!(r.get_node(node.id), Some(node));
+            assert_eq!(
+                r.get_edges(node.id).collect::<Vec<_>>(),
+                f.get_edges(node.id).collect::<Vec<_>>(),
+            );
+        }
+        assert_eq!(r.find_route(1, 3, 100), f.find_route(1, 3, 100));
+        assert_eq!(
+            r.find_route_bidirectional(3, 1, 100),
+            f.find_route(3, 1, 100)
+        );
+
+        assert_eq!(r.reordered(NodeOrder::Id), f);
+        assert_eq!(f.reordered(NodeOrder::Id), f);
+        assert_eq!(r.reordered(NodeOrder::Hilbert), r);
+        assert_eq!(f.reordered(NodeOrder::Morton).ids, vec![1, 2, 20, 3]);
+    }
+
+    #[test]
+    fn curve_keys() {
+        // Visiting cells of a 4×4 grid in the order of the keys must only make unit steps
+        // for the Hilbert curve, and visit quadrants one after another for the Morton curve.
+        let mut cells: Vec<(u32, u32)> = (0..16).map(|i| (i % 4, i / 4)).collect();
+        cells.sort_by_key(|&(x, y)| hilbert_key(x << 30, y << 30));
+        assert_eq!(cells[0], (0, 0));
+        for w in cells.windows(2) {
+            assert_eq!(w[0].0.abs_diff(w[1].0) + w[0].1.abs_diff(w[1].1), 1);
+        }
+
+        assert_eq!(morton_key(0b11, 0b00), 0b0101);
+        assert_eq!(morton_key(0b00, 0b11), 0b1010);
+        assert_eq!(morton_key(u32::MAX, u32::MAX), u64::MAX);
+    }
+
+    #[test]
+    fn incoming() {
+        let f = fixture_graph().freeze();
+        let incoming = f.incoming();
+        assert_eq!(incoming.offsets, vec![0, 1, 3, 5, 6]);
+        assert_eq!(incoming.sources, vec![1, 0, 2, 1, 3, 0]);
+        assert_eq!(
+            incoming.costs,
+            vec![200.0, 200.0, 150.0, 150.0, 150.0, 200.0]
+        );
+        assert_eq!(
+            incoming.edges_at(2).collect::<Vec<_>>(),
+            vec![(1, 150.0), (3, 150.0)]
+        );
+    }
+
+    #[test]
+    fn get_node() {
+        let f = fixture_graph().freeze();
+        assert_eq!(
+            f.get_node(20),
+            Some(Node {
+                id: 20,
+                osm_id: 2,
+                lat: 0.02,
+                lon: 0.01,
+            })
+        );
+        assert_eq!(f.get_node(42), None);
+        assert_eq!(f.index_of(3), Some(2));
+    }
+
+    #[test]
+    fn get_edges() {
+        let f = fixture_graph().freeze();
+        assert_eq!(
+            f.get_edges(1).collect::<Vec<_>>(),
+            vec![
+                Edge { to: 2, cost: 200.0 },
+                Edge {
+                    to: 20,
+                    cost: 200.0
+                }
+            ],
+        );
+        assert_eq!(f.get_edges(42).count(), 0);
+        assert_eq!(f.get_edge(20, 3), 150.0);
+        assert_eq!(f.get_edge(3, 20), f32::INFINITY);
+        assert_eq!(f.get_edge(42, 3), f32::INFINITY);
+    }
+
+    #[test]
+    fn write_read() {
+        let f = fixture_graph().freeze();
+
+        let mut buf: Vec<u8> = Vec::default();
+        f.write(&mut buf).unwrap();
+        assert_eq!(buf.len() as u64, layout(4, 6, false)[8]);
+        assert_eq!(FrozenGraph::read(&mut buf.as_slice()).unwrap(), f);
+
+        buf[0] = b'X';
+        assert_eq!(
+            FrozenGraph::read(&mut buf.as_slice()).unwrap_err().kind(),
+            io::ErrorKind::InvalidData
+        );
+    }
+
+    #[test]
+    fn write_read_reordered() {
+        let f = fixture_graph().freeze().reordered(NodeOrder::Hilbert);
+
+        let mut buf: Vec<u8> = Vec::default();
+        f.write(&mut buf).unwrap();
+        assert_eq!(buf.len() as u64, layout(4, 6, true)[8]);
+        assert_eq!(buf[8], 2); // version
+        let read = FrozenGraph::read(&mut buf.as_slice()).unwrap();
+        assert_eq!(read, f);
+        assert_eq!(read.index_of(3), Some(3));
+
+        let path = std::env::temp_dir().join(format!("routx-reordered-{}", std::process::id()));
+        std::fs::write(&path, &buf).unwrap();
+        // SAFETY: The temporary file is not modified while mapped
+        let mapped = unsafe { FrozenGraph::open_mmap(&path) };
+        std::fs::remove_file(&path).unwrap();
+        assert_eq!(mapped.unwrap(), f);
+    }
+
+    #[test]
+    fn read_invalid_ids() {
+        let invalid_data = |buf: &[u8]| {
+            FrozenGraph::read(&mut &buf[..]).unwrap_err().kind() == io::ErrorKind::InvalidData
+        };
+
+        // Version 1: ids must be ascending
+        let mut buf: Vec<u8> = Vec::default();
+        fixture_graph().freeze().write(&mut buf).unwrap();
+        let ids = layout(4, 6, false)[0] as usize;
+        buf[ids..ids + 8].copy_from_slice(&5_i64.to_le_bytes());
+        assert!(invalid_data(&buf));
+
+        // Version 2: id index must only point at existing nodes, in the order of ids
+        let f = fixture_graph().freeze().reordered(NodeOrder::Hilbert);
+        let mut buf: Vec<u8> = Vec::default();
+        f.write(&mut buf).unwrap();
+        let index = layout(4, 6, true)[7] as usize;
+
+        let mut out_of_bounds = buf.clone();
+        out_of_bounds[index..index + 4].copy_from_slice(&4_u32.to_le_bytes());
+        assert!(invalid_data(&out_of_bounds));
+
+        let mut unsorted = buf.clone();
+        unsorted[index..index + 4].copy_from_slice(&f.id_index[1].to_le_bytes());
+        unsorted[index + 4..index + 8].copy_from_slice(&f.id_index[0].to_le_bytes());
+        assert!(invalid_data(&unsorted));
+    }
+
+    #[test]
+    fn read_invalid_edges() {
+        let invalid_data = |buf: &[u8]| {
+            FrozenGraph::read(&mut &buf[..]).unwrap_err().kind() == io::ErrorKind::InvalidData
+        };
+
+        let mut buf: Vec<u8> = Vec::default();
+        fixture_graph().freeze().write(&mut buf).unwrap();
+        let [.., offsets, targets, _, _, _] = layout(4, 6, false);
+        let (offsets, targets) = (offsets as usize, targets as usize);
+
+        // Edge offsets must be non-decreasing
+        let mut decreasing = buf.clone();
+        decreasing[offsets + 4..offsets + 8].copy_from_slice(&7_u32.to_le_bytes());
+        assert!(invalid_data(&decreasing));
+
+        // Edge targets must point at existing nodes
+        let mut out_of_bounds = buf.clone();
+        out_of_bounds[targets..targets + 4].copy_from_slice(&4_u32.to_le_bytes());
+        assert!(invalid_data(&out_of_bounds));
+    }
+
+    #[test]
+    fn open_mmap() {
+        let f = fixture_graph().freeze();
+        let path = std::env::temp_dir().join(format!("routx-graph-{}", std::process::id()));
+        f.save(&path).unwrap();
+
+        // SAFETY: The temporary file is not modified while mapped
+        let mapped = unsafe { FrozenGraph::open_mmap(&path) };
+        let loaded = FrozenGraph::load(&path);
+        std::fs::remove_file(&path).unwrap();
+
+        let mapped = mapped.unwrap();
+        assert_eq!(mapped, f);
+        assert_eq!(loaded.unwrap(), f);
+        assert_eq!(mapped.find_route(1, 3, 100), f.find_route(1, 3, 100));
+    }
+
+    #[test]
+    #[cfg(feature = "stats")]
+    fn search_stats() {
+        let f = fixture_graph().freeze();
+        let mut ctx = SearchContext::new();
+
+        f.find_route_with_context(&mut ctx, 1, 3, 100).unwrap();
+        let stats = ctx.stats();
+        assert!(stats.settled > 0);
+        assert!(stats.relaxed > 0);
+        assert_eq!(stats.pops, stats.settled + stats.stale_pops + 1); // +1 for the target
+        assert!(stats.pushes >= stats.pops);
+        assert!(stats.peak_queue_size > 0);
+        assert_eq!(stats.elapsed_ns, 0);
+
+        assert_eq!(
+            f.find_route_with_context(&mut ctx, 1, 3, 1),
+            Err(AStarError::StepLimitExceeded),
+        );
+        assert_eq!(ctx.stats().settled, 2);
+
+        ctx.set_timing(true);
+        f.find_route_without_turn_around_with_context(&mut ctx, 1, 3, 100)
+            .unwrap();
+        assert!(ctx.stats().elapsed_ns > 0);
+
+        // Stats are reset even if the search fails early
+        assert!(f.find_route_with_context(&mut ctx, 1, 42, 100).is_err());
+        assert_eq!(ctx.stats().settled, 0);
+        assert_eq!(ctx.stats().pushes, 0);
+    }
+
+    #[test]
+    fn find_route_into() {
+        let f = fixture_graph().freeze();
+        let mut ctx = SearchContext::new();
+        let mut path = vec![42, 42, 42, 42, 42];
+
+        f.find_route_into(&mut ctx, 2, 3, 100, &mut path).unwrap();
+        assert_eq!(path, vec![2, 3]);
+
+        let r = RouteRequest {
+            from: 3,
+            to: 1,
+            step_limit: 100,
+            without_turn_around: true,
+        };
+        f.find_route_with_request_into(&mut ctx, &r, &mut path)
+            .unwrap();
+        assert_eq!(path, vec![3, 2, 1]);
+
+        assert_eq!(
+            f.find_route_into(&mut ctx, 1, 42, 100, &mut path),
+            Err(AStarError::InvalidReference(42))
+        );
+        assert!(path.is_empty());
+    }
+
+    #[test]
+    fn find_route_without_turn_around_second_arrival() {
+        // 1 ───5───> 2 ─1─> 30 ─1─> 5
+        //  └─1─> 3 ─1─┘
+        // 30 is a clone of 3, so the cheapest arrival at 2 (from 3) can't continue to it.
+        let g = Graph::from_iter(
+            [(1, 1), (2, 2), (3, 3), (30, 3), (5, 5)].map(|(id, osm_id)| Node {
+                id,
+                osm_id,
+                lat: 0.0,
+                lon: 0.0,
+            }),
+            [
+                (1, 2, 5.0),
+                (1, 3, 1.0),
+                (3, 2, 1.0),
+                (2, 30, 1.0),
+                (30, 5, 1.0),
+            ],
+        );
+        let f = g.freeze();
+        let mut ctx = SearchContext::new();
+
+        assert_eq!(f.find_route(1, 5, 100), Ok(vec![1, 3, 2, 30, 5]));
+        assert_eq!(
+            f.find_route_without_turn_around_with_context(&mut ctx, 1, 5, 100),
+            Ok(vec![1, 2, 30, 5]),
+        );
+        assert_eq!(
+            f.find_route_without_turn_around_with_context(&mut ctx, 1, 5, 100),
+            crate::find_route_without_turn_around(&g, 1, 5, 100),
+        );
+    }
+
+    #[test]
+    fn reachable() {
+        let f = fixture_graph().freeze();
+        let mut ctx = SearchContext::new();
+        let mut reached = Vec::default();
+
+        let count = f
+            .reachable(&mut ctx, 3, 350.0, 100, |id, cost| reached.push((id, cost)))
+            .unwrap();
+        assert_eq!(count, 3);
+        assert_eq!(reached, vec![(3, 0.0), (2, 150.0), (1, 350.0)]);
+
+        reached.clear();
+        f.reachable(&mut ctx, 3, 349.0, 100, |id, cost| reached.push((id, cost)))
+            .unwrap();
+        assert_eq!(reached, vec![(3, 0.0), (2, 150.0)]);
+
+        assert_eq!(
+            f.reachable(&mut ctx, 3, 350.0, 2, |_, _| {}),
+            Err(AStarError::StepLimitExceeded)
+        );
+        assert_eq!(
+            f.reachable(&mut ctx, 42, 350.0, 100, |_, _| {}),
+            Err(AStarError::InvalidReference(42))
+        );
+    }
+
+    #[test]
+    fn reachable_hull() {
+        let f = fixture_graph().freeze();
+        let mut ctx = SearchContext::new();
+        let mut hull = Vec::default();
+
+        // All nodes of the fixture lie on a single meridian (with 2 on top of 20),
+        // so the hull degenerates to the two extreme nodes
+        let count = f
+            .reachable_with_hull(&mut ctx, 1, 1000.0, 100, &mut hull, |_, _| {})
+            .unwrap();
+        assert_eq!(count, 4);
+        assert_eq!(hull.len(), 2);
+        assert_eq!(hull[0].id, 1);
+        assert_eq!(hull[1].id, 3);
+
+        // 4 ─── 3      6
+        // │  5  │
+        // 1 ─── 2
+        // 5 has edges to all corners of the square, and 3 to the far-away 6
+        let node = |id: i64, lat: f32, lon: f32| Node {
+            id,
+            osm_id: id,
+            lat,
+            lon,
+        };
+        let f = Graph::from_iter(
+            [
+                node(1, 0.0, 0.0),
+                node(2, 0.0, 0.01),
+                node(3, 0.01, 0.01),
+                node(4, 0.01, 0.0),
+                node(5, 0.005, 0.005),
+                node(6, 0.02, 0.02),
+            ],
+            [
+                (5, 1, 1.0),
+                (5, 2, 1.0),
+                (5, 3, 1.0),
+                (5, 4, 1.0),
+                (3, 6, 100.0),
+            ],
+        )
+        .freeze();
+        let ids = |hull: &[Node]| hull.iter().map(|n| n.id).collect::<Vec<_>>();
+
+        let count = f
+            .reachable_with_hull(&mut ctx, 5, 10.0, 100, &mut hull, |_, _| {})
+            .unwrap();
+        assert_eq!(count, 5);
+        assert_eq!(ids(&hull), vec![1, 2, 3, 4]); // 5 is inside
+
+        let count = f
+            .reachable_with_hull(&mut ctx, 5, 1000.0, 100, &mut hull, |_, _| {})
+            .unwrap();
+        assert_eq!(count, 6);
+        assert_eq!(ids(&hull), vec![1, 2, 6, 4]); // 3 and 5 are inside
+    }
+
+    #[test]
+    fn find_route_detailed() {
+        let f = fixture_graph().freeze();
+        let mut ctx = SearchContext::new();
+        let mut r = RouteRequest {
+            from: 3,
+            to: 1,
+            step_limit: 100,
+            without_turn_around: false,
+        };
+
+        let route = f.find_route_detailed(&mut ctx, &r).unwrap();
+        assert_eq!(route.ids, vec![3, 2, 1]);
+        assert_eq!(route.lats, vec![0.03, 0.02, 0.01]);
+        assert_eq!(route.lons, vec![0.01, 0.01, 0.01]);
+        assert_eq!(route.costs, vec![0.0, 150.0, 350.0]);
+        assert_eq!(route.total_cost(), 350.0);
+
+        r.without_turn_around = true;
+        assert_eq!(f.find_route_detailed(&mut ctx, &r).unwrap(), route);
+
+        r.to = 42;
+        assert_eq!(
+            f.find_route_detailed(&mut ctx, &r),
+            Err(AStarError::InvalidReference(42))
+        );
+    }
+}
@@ -1,13 +1,52 @@
 // (c) Copyright 2025 Mikołaj Kuranowski
 // SPDX-License-Identifier: MIT
 
-use crate::{earth_distance, Edge, Node};
+use crate::{earth_distance_many, Edge, FrozenGraph, Node};
 use std::collections::btree_map::{BTreeMap, Entry};
+use std::sync::atomic::{AtomicU64, Ordering};
+
+/// Returns a new epoch, unique within the process and greater than all epochs
+/// returned before. Never returns zero.
+pub(crate) fn next_epoch() -> u64 {
+    static NEXT_EPOCH: AtomicU64 = AtomicU64::new(1);
+    NEXT_EPOCH.fetch_add(1, Ordering::Relaxed)
+}
 
 /// Represents an OpenStreetMap network as a set of [Nodes](Node)
 /// and [Edges](Edge) between them.
-#[derive(Debug, Default, Clone, PartialEq)]
-pub struct Graph(pub BTreeMap<i64, (Node, Vec<Edge>)>);
+///
+/// Every modification made through the methods of the graph advances its [epoch](Graph::epoch).
+#[derive(Debug, Clone)]
+pub struct Graph {
+    /// All nodes and their outgoing edges, by node id.
+    nodes: BTreeMap<i64, (Node, Vec<Edge>)>,
+
+    /// Epoch of the last modification, see [Graph::epoch].
+    epoch: u64,
+}
+
+impl Default for Graph {
+    fn default() -> Self {
+        Self::from(BTreeMap::default())
+    }
+}
+
+impl From<BTreeMap<i64, (Node, Vec<Edge>)>> for Graph {
+    /// Creates a graph from a map of nodes and their outgoing edges, by node id.
+    fn from(nodes: BTreeMap<i64, (Node, Vec<Edge>)>) -> Self {
+        Self {
+            nodes,
+            epoch: next_epoch(),
+        }
+    }
+}
+
+impl PartialEq for Graph {
+    /// Graphs are equal if they have the same nodes and edges, regardless of their epochs.
+    fn eq(&self, other: &Self) -> bool {
+        self.nodes == other.nodes
+    }
+}
 
 impl Graph {
     /// Creates a new empty graph.
@@ -18,12 +57,39 @@ impl Graph {
 
     /// Returns the number of nodes in the graph.
     pub fn len(&self) -> usize {
-        self.0.len()
+        self.nodes.len()
+    }
+
+    /// Returns the epoch of the graph - a number assigned anew when the graph is created
+    /// and on every modification (of nodes or edges). Epochs are drawn from a process-wide
+    /// counter, so different graphs never share an epoch, unless one is a clone of the other
+    /// without any subsequent modifications.
+    ///
+    /// Routes found before and after a change of the epoch may be different - for example,
+    /// a [RouteCache](crate::RouteCache) drops all routes found at an older epoch.
+    #[inline]
+    pub fn epoch(&self) -> u64 {
+        self.epoch
+    }
+
+    /// Returns the map of all nodes and their outgoing edges, by node id.
+    #[inline]
+    pub fn nodes(&self) -> &BTreeMap<i64, (Node, Vec<Edge>)> {
+        &self.nodes
+    }
+
+    /// Returns the mutable map of all nodes and their outgoing edges, by node id,
+    /// for modifications not covered by other methods. Advances the [epoch](Graph::epoch),
+    /// regardless of whether the map is actually modified.
+    #[inline]
+    pub fn nodes_mut(&mut self) -> &mut BTreeMap<i64, (Node, Vec<Edge>)> {
+        self.epoch = next_epoch();
+        &mut self.nodes
     }
 
     /// Returns an iterator over all [Nodes](Node) in the graph.
     pub fn iter(&self) -> impl Iterator<Item = &Node> {
-        self.0.iter().map(|(_, (node, _))| node)
+        self.nodes.iter().map(|(_, (node, _))| node)
     }
 
     /// Creates a Graph from 2 separate iterators over [Nodes](Node)
@@ -42,7 +108,7 @@ impl Graph {
         N: IntoIterator<Item = Node>,
         E: IntoIterator<Item = (i64, i64, f32)>,
     {
-        let mut g = Graph(BTreeMap::from_iter(
+        let mut g = Graph::from(BTreeMap::from_iter(
             nodes.into_iter().map(|n| (n.id, (n, vec![]))),
         ));
 
@@ -55,7 +121,7 @@ impl Graph {
 
     /// Retrieves a [Node] with the provided id.
     pub fn get_node(&self, id: i64) -> Option<Node> {
-        self.0.get(&id).map(|&(node, _)| node)
+        self.nodes.get(&id).map(|&(node, _)| node)
     }
 
     /// Creates or updates a [Node] with `node.id`.
@@ -69,8 +135,9 @@ impl Graph {
     /// `false` if a new node was created.
     pub fn set_node(&mut self, node: Node) -> bool {
         assert_ne!(node.id, 0);
+        self.epoch = next_epoch();
 
-        match self.0.entry(node.id) {
+        match self.nodes.entry(node.id) {
             Entry::Vacant(e) => {
                 e.insert((node, Vec::default()));
                 false
@@ -93,7 +160,11 @@ impl Graph {
     ///
     /// Returns `true` if a node was deleted, `false` if no such node existed.
     pub fn delete_node(&mut self, id: i64) -> bool {
-        self.0.remove(&id).is_some()
+        let deleted = self.nodes.remove(&id).is_some();
+        if deleted {
+            self.epoch = next_epoch();
+        }
+        deleted
     }
 
     /// Finds the closest canonical (`id == osm_id`) [Node] to the given position.
@@ -101,22 +172,41 @@ impl Graph {
     /// This function requires computing the distance to every [Node] in the graph,
     /// and is not suitable for large graphs.
     pub fn find_nearest_node(&self, lat: f32, lon: f32) -> Option<Node> {
-        self.0
-            .iter()
-            .filter_map(|(_, &(nd, _))| {
-                if nd.id == nd.osm_id {
-                    Some((earth_distance(lat, lon, nd.lat, nd.lon), nd))
-                } else {
-                    None
+        // Distances are computed in batches with the vectorized earth_distance_many
+        const BATCH: usize = 256;
+        let mut nodes = [Node::ZERO; BATCH];
+        let mut lats = [0.0_f32; BATCH];
+        let mut lons = [0.0_f32; BATCH];
+        let mut distances = [0.0_f32; BATCH];
+        let mut best: Option<(f32, Node)> = None;
+
+        let mut canonical = self.iter().filter(|nd| nd.id == nd.osm_id);
+        loop {
+            let mut len = 0;
+            for nd in canonical.by_ref().take(BATCH) {
+                nodes[len] = *nd;
+                lats[len] = nd.lat;
+                lons[len] = nd.lon;
+                len += 1;
+            }
+            if len == 0 {
+                break;
+            }
+
+            earth_distance_many(lat, lon, &lats[..len], &lons[..len], &mut distances[..len]);
+            for i in 0..len {
+                if best.map_or(true, |(best_dist, _)| distances[i] < best_dist) {
+                    best = Some((distances[i], nodes[i]));
                 }
-            })
-            .min_by(|(a_dist, _), (b_dist, _)| a_dist.partial_cmp(b_dist).unwrap())
-            .map(|(_, nd)| nd)
+            }
+        }
+
+        best.map(|(_, nd)| nd)
     }
 
     /// Gets all outgoing [Edges](Edge) from a node with a given id.
     pub fn get_edges(&self, from_id: i64) -> &[Edge] {
-        self.0
+        self.nodes
             .get(&from_id)
             .map(|(_, e)| e.as_slice())
             .unwrap_or_default()
@@ -125,7 +215,7 @@ impl Graph {
     /// Gets the cost of an [Edge] from one node to another.
     /// If such an edge doesn't exist, returns [f32::INFINITY].
     pub fn get_edge(&self, from_id: i64, to_id: i64) -> f32 {
-        self.0
+        self.nodes
             .get(&from_id)
             .map(|(_, e)| {
                 e.iter().find_map(|edge| {
@@ -149,11 +239,12 @@ impl Graph {
         assert_ne!(from_id, 0);
         assert_ne!(edge.to, 0);
 
-        if !self.0.contains_key(&edge.to) {
+        if !self.nodes.contains_key(&edge.to) {
             return false;
         }
 
-        if let Some((_, edges)) = self.0.get_mut(&from_id) {
+        if let Some((_, edges)) = self.nodes.get_mut(&from_id) {
+            self.epoch = next_epoch();
             if let Some(candidate) = edges.iter_mut().find(|e| e.to == edge.to) {
                 *candidate = edge;
                 return true;
@@ -169,7 +260,7 @@ impl Graph {
     ///
     /// Returns `true` if an edge was removed, `false` otherwise.
     pub fn delete_edge(&mut self, from_id: i64, to_id: i64) -> bool {
-        if let Some((_, edges)) = self.0.get_mut(&from_id) {
+        if let Some((_, edges)) = self.nodes.get_mut(&from_id) {
             if let Some(idx) =
                 edges.iter().enumerate().find_map(
                     |(idx, edge)| {
@@ -182,6 +273,7 @@ impl Graph {
                 )
             {
                 edges.swap_remove(idx);
+                self.epoch = next_epoch();
                 return true;
             }
         }
@@ -189,23 +281,30 @@ impl Graph {
         false
     }
 
+    /// Creates an immutable [FrozenGraph] snapshot of this graph, better suited for
+    /// answering many route queries.
+    pub fn freeze(&self) -> FrozenGraph {
+        FrozenGraph::from_graph(self)
+    }
+
     /// Replaces all edges from `dst` by cloning all edges outgoing from `src`.
     pub(crate) fn clone_edges(&mut self, dst: i64, src: i64) {
         // Don't clone if dst doesn't exist
-        if !self.0.contains_key(&dst) {
+        if !self.nodes.contains_key(&dst) {
             return;
         }
 
         // Get a clone of source edges
-        let edges = if let Some((_, src_edges)) = self.0.get(&src) {
+        let edges = if let Some((_, src_edges)) = self.nodes.get(&src) {
             src_edges.clone()
         } else {
             Vec::new()
         };
 
         // Overwrite dst edges
-        if let Some((_, dst_edges)) = self.0.get_mut(&dst) {
+        if let Some((_, dst_edges)) = self.nodes.get_mut(&dst) {
             *dst_edges = edges;
+            self.epoch = next_epoch();
         }
     }
 }
@@ -0,0 +1,694 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+use crate::lru::Lru;
+use crate::{parallel, Graph, Node};
+
+/// Recommended size of [GridIndex] cells, in meters.
+pub const DEFAULT_GRID_CELL_SIZE: f32 = 100.0;
+
+/// Recommended quantum of [SnapCache] keys, in meters.
+pub const DEFAULT_SNAP_QUANTUM: f32 = 1.0;
+
+/// Approximate length of one degree of latitude, in meters.
+const METERS_PER_DEGREE: f32 = 111_195.0;
+
+/// Cell sizes are doubled until there are at most this many cells per node
+/// (plus a small constant), bounding the memory used by sparse data.
+const MAX_CELLS_PER_NODE: usize = 4;
+
+/// GridIndex is a uniform grid of cells over all canonical (`id == osm_id`) nodes,
+/// for fast nearest-neighbor search with densely distributed data, like road networks.
+///
+/// Nodes are stored contiguously per cell, and a search only has to visit the cell
+/// of the query position and its immediate neighbors, unless the area is sparse;
+/// on average, it takes constant time - unlike a [KDTree](crate::KDTree) search,
+/// which takes logarithmic time.
+///
+/// Cells are `cell_size` meters high, and (at the middle latitude of the data) about
+/// as wide. Columns cover the shortest range of longitudes containing all nodes, so data
+/// crossing the antimeridian (180°/-180° longitude) is handled correctly, and columns
+/// wrap around if all longitudes are covered.
+///
+/// Searches compare squared distances in a local
+/// [equirectangular projection](https://en.wikipedia.org/wiki/Equirectangular_projection)
+/// centered at the query position, with longitude differences taken around the antimeridian.
+/// Results close to the poles are approximate.
+///
+/// Repeated lookups of the same positions can be sped up further with a [SnapCache].
+///
+/// # Example
+///
+/// ```no_run
+/// let g = routx::Graph::new();
+/// // ... load data into g ...
+///
+/// let index = routx::GridIndex::build_from_graph(&g, routx::DEFAULT_GRID_CELL_SIZE).unwrap();
+/// let mut cache = routx::SnapCache::new(10_000, routx::DEFAULT_SNAP_QUANTUM);
+///
+/// let start_node = index.find_nearest_node(43.7384, 7.4246);
+/// let end_node = index.find_nearest_node_cached(&mut cache, 43.7478, 7.4323);
+/// ```
+#[derive(Debug, Clone)]
+pub struct GridIndex {
+    /// [Node::id] (equal to [Node::osm_id]) of every node, ordered by cells.
+    ids: Vec<i64>,
+
+    /// `[lat, lon]` of every node, ordered by cells.
+    coords: Vec<[f32; 2]>,
+
+    /// Index of the first node of every (row-major) cell, followed by the number of nodes.
+    offsets: Vec<u32>,
+
+    rows: u32,
+    cols: u32,
+
+    /// Latitude of the southern edge of the grid.
+    lat0: f32,
+
+    /// Longitude of the middle of the columns.
+    lon_center: f32,
+
+    /// Height of a cell, in degrees.
+    cell_lat: f32,
+
+    /// Width of a cell, in degrees.
+    cell_lon: f32,
+
+    /// Whether the columns cover all longitudes, and thus wrap around the antimeridian.
+    wraps: bool,
+}
+
+impl GridIndex {
+    /// Returns the number of nodes in the index.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.ids.len()
+    }
+
+    /// Returns `true` if there are no nodes in the index. Never true for indices returned
+    /// by the build functions.
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.ids.is_empty()
+    }
+
+    /// Returns the number of `(rows, columns)` of the grid.
+    pub fn dimensions(&self) -> (usize, usize) {
+        (self.rows as usize, self.cols as usize)
+    }
+
+    /// Finds the closest canonical (`id == osm_id`) [Node] to the given position.
+    pub fn find_nearest_node(&self, lat: f32, lon: f32) -> Node {
+        let q = Query::new(lat, lon);
+        let (qr, qc) = self.cell_of(lat, lon);
+        let (rows, cols) = (self.rows as i64, self.cols as i64);
+
+        // Rings closer than the grid itself are empty
+        let outside = |x: i64, n: i64| (-x).max(x - (n - 1)).max(0);
+        let first_ring = if self.wraps {
+            outside(qr, rows)
+        } else {
+            outside(qr, rows).max(outside(qc, cols))
+        };
+
+        // Nodes beyond ring `r` are at least `(r - 1) * step` away from the query - unless
+        // the columns don't wrap and the shorter way to a node crosses the gap around
+        // the antimeridian, in which case the node is at least `across_gap` away.
+        let step = self.cell_lat.min(self.cell_lon * q.lon_scale);
+        let half_width = self.cols as f32 * self.cell_lon * 0.5;
+        let offset = wrap_lon(lon - self.lon_center).abs();
+        let across_gap = if !self.wraps && offset + half_width > 180.0 {
+            (360.0 - offset - half_width) * q.lon_scale
+        } else {
+            f32::INFINITY
+        };
+
+        let mut best = (0, f32::INFINITY);
+        for r in first_ring.. {
+            let bound = ((r - 1).max(0) as f32 * step).min(across_gap);
+            if best.1 <= bound * bound {
+                break;
+            }
+
+            self.visit_ring(&q, qr, qc, r, &mut best);
+
+            let covers_rows = qr - r <= 0 && qr + r >= rows - 1;
+            let covers_cols = if self.wraps {
+                2 * r + 1 >= cols
+            } else {
+                qc - r <= 0 && qc + r >= cols - 1
+            };
+            if covers_rows && covers_cols {
+                break;
+            }
+        }
+
+        self.node_at(best.0)
+    }
+
+    /// Same as [GridIndex::find_nearest_node], but first looks up the (quantized) position
+    /// in the provided cache, and stores the result in the cache on a miss.
+    ///
+    /// The cache must only be used with this index.
+    pub fn find_nearest_node_cached(&self, cache: &mut SnapCache, lat: f32, lon: f32) -> Node {
+        let key = cache.key(lat, lon);
+        if let Some(node) = cache.get(key) {
+            return node;
+        }
+
+        let node = self.find_nearest_node(lat, lon);
+        cache.insert(key, node);
+        node
+    }
+
+    /// Finds the closest canonical (`id == osm_id`) [Node] to every `(lats[i], lons[i])`
+    /// position, spreading the queries over `threads` threads (zero stands for
+    /// [available parallelism](std::thread::available_parallelism)).
+    ///
+    /// Panics if `lats` and `lons` have different lengths.
+    pub fn find_nearest_nodes(&self, lats: &[f32], lons: &[f32], threads: usize) -> Vec<Node> {
+        assert_eq!(
+            lats.len(),
+            lons.len(),
+            "lats and lons must have equal lengths"
+        );
+        let mut out = vec![Node::ZERO; lats.len()];
+        self.find_nearest_nodes_into(lats, lons, threads, &mut out);
+        out
+    }
+
+    /// Same as [GridIndex::find_nearest_nodes], but writes the nodes into the provided slice.
+    ///
+    /// Panics if `lats`, `lons` and `out` have different lengths.
+    pub fn find_nearest_nodes_into(
+        &self,
+        lats: &[f32],
+        lons: &[f32],
+        threads: usize,
+        out: &mut [Node],
+    ) {
+        assert_eq!(
+            lats.len(),
+            lons.len(),
+            "lats and lons must have equal lengths"
+        );
+        assert_eq!(
+            lats.len(),
+            out.len(),
+            "out must have the same length as lats"
+        );
+        parallel::fill(
+            out,
+            threads,
+            || (),
+            |_, i| self.find_nearest_node(lats[i], lons[i]),
+        );
+    }
+
+    #[inline]
+    fn node_at(&self, idx: usize) -> Node {
+        let [lat, lon] = self.coords[idx];
+        Node {
+            id: self.ids[idx],
+            osm_id: self.ids[idx],
+            lat,
+            lon,
+        }
+    }
+
+    /// Returns the (possibly out-of-bounds) row and column of a position.
+    /// Columns are already wrapped around if the grid [wraps](GridIndex::wraps).
+    #[inline]
+    fn cell_of(&self, lat: f32, lon: f32) -> (i64, i64) {
+        let row = ((lat - self.lat0) / self.cell_lat).floor() as i64;
+        let half_width = self.cols as f32 * self.cell_lon * 0.5;
+        let col = ((wrap_lon(lon - self.lon_center) + half_width) / self.cell_lon).floor() as i64;
+        if self.wraps {
+            (row, col.rem_euclid(self.cols as i64))
+        } else {
+            (row, col)
+        }
+    }
+
+    /// Visits all cells exactly `r` rows or columns away from the query cell.
+    fn visit_ring(&self, q: &Query, qr: i64, qc: i64, r: i64, best: &mut (usize, f32)) {
+        let (rows, cols) = (self.rows as i64, self.cols as i64);
+        for row in (qr - r).max(0)..=(qr + r).min(rows - 1) {
+            if row == qr - r || row == qr + r {
+                // Whole top and bottom rows of the ring
+                if self.wraps && 2 * r + 1 >= cols {
+                    (0..cols).for_each(|col| self.visit_cell(q, row, col, best));
+                } else if self.wraps {
+                    (qc - r..=qc + r)
+                        .for_each(|col| self.visit_cell(q, row, col.rem_euclid(cols), best));
+                } else {
+                    ((qc - r).max(0)..=(qc + r).min(cols - 1))
+                        .for_each(|col| self.visit_cell(q, row, col, best));
+                }
+            } else if self.wraps {
+                // Left and right cells of the ring, unless all columns were already visited
+                if 2 * r - 1 < cols {
+                    let (left, right) = ((qc - r).rem_euclid(cols), (qc + r).rem_euclid(cols));
+                    self.visit_cell(q, row, left, best);
+                    if right != left {
+                        self.visit_cell(q, row, right, best);
+                    }
+                }
+            } else {
+                for col in [qc - r, qc + r] {
+                    if (0..cols).contains(&col) {
+                        self.visit_cell(q, row, col, best);
+                    }
+                }
+            }
+        }
+    }
+
+    #[inline]
+    fn visit_cell(&self, q: &Query, row: i64, col: i64, best: &mut (usize, f32)) {
+        let cell = (row * self.cols as i64 + col) as usize;
+        let (start, end) = (self.offsets[cell] as usize, self.offsets[cell + 1] as usize);
+        for (idx, &point) in self.coords[start..end].iter().enumerate() {
+            let dist = q.distance_squared(point);
+            if dist < best.1 {
+                *best = (start + idx, dist);
+            }
+        }
+    }
+
+    /// Builds a grid index from an iterable of [Nodes](Node), with cells of the provided size
+    /// (in meters). Non-canonical (`id != osm_id`) nodes are skipped.
+    ///
+    /// Panics if `cell_size` is not a positive, finite number.
+    pub fn from_iter<I: IntoIterator<Item = Node>>(nodes: I, cell_size: f32) -> Option<Self> {
+        let nodes = nodes
+            .into_iter()
+            .filter(|n| n.id == n.osm_id)
+            .collect::<Vec<_>>();
+        Self::build(&nodes, cell_size)
+    }
+
+    /// Builds a grid index from a Graph, with cells of the provided size (in meters).
+    /// Only canonical (`id == osm_id`) nodes are indexed.
+    ///
+    /// Panics if `cell_size` is not a positive, finite number.
+    pub fn build_from_graph(graph: &Graph, cell_size: f32) -> Option<Self> {
+        let nodes: Vec<_> = graph.iter().filter(|n| n.id == n.osm_id).cloned().collect();
+        Self::build(&nodes, cell_size)
+    }
+
+    /// Builds a grid index from a slice of canonical (`id == osm_id`) [Nodes](Node),
+    /// with cells of the provided size (in meters). Returns `None` if there are no nodes.
+    ///
+    /// If the cells would greatly outnumber the nodes, their size is doubled
+    /// (possibly multiple times) to bound the memory usage.
+    ///
+    /// Panics if `cell_size` is not a positive, finite number.
+    pub fn build(nodes: &[Node], cell_size: f32) -> Option<Self> {
+        assert!(
+            cell_size > 0.0 && cell_size.is_finite(),
+            "invalid grid cell size"
+        );
+        debug_assert!(nodes.iter().all(|n| n.id == n.osm_id));
+        if nodes.is_empty() {
+            return None;
+        }
+
+        let (min_lat, max_lat) = nodes
+            .iter()
+            .fold((f32::INFINITY, f32::NEG_INFINITY), |acc, n| {
+                (acc.0.min(n.lat), acc.1.max(n.lat))
+            });
+        let (lon_start, lon_span) = shortest_lon_range(nodes);
+        let lon_scale = ((min_lat + max_lat) * 0.5).to_radians().cos().max(0.01);
+
+        let mut cell_lat = cell_size / METERS_PER_DEGREE;
+        let max_cells = MAX_CELLS_PER_NODE * nodes.len() + 64;
+        let mut index = loop {
+            let index = Self::empty(min_lat, max_lat, lon_start, lon_span, cell_lat, lon_scale);
+            if index.rows as usize * index.cols as usize <= max_cells {
+                break index;
+            }
+            cell_lat *= 2.0;
+        };
+
+        // Counting sort of the nodes by their cells
+        let cells: Vec<usize> = nodes
+            .iter()
+            .map(|n| {
+                let (row, col) = index.cell_of(n.lat, n.lon);
+                let row = row.clamp(0, index.rows as i64 - 1);
+                let col = col.clamp(0, index.cols as i64 - 1);
+                (row * index.cols as i64 + col) as usize
+            })
+            .collect();
+        for &cell in &cells {
+            index.offsets[cell + 1] += 1;
+        }
+        for cell in 1..index.offsets.len() {
+            index.offsets[cell] += index.offsets[cell - 1];
+        }
+
+        let mut next = index.offsets.clone();
+        index.ids = vec![0; nodes.len()];
+        index.coords = vec![[0.0; 2]; nodes.len()];
+        for (n, &cell) in nodes.iter().zip(&cells) {
+            let idx = next[cell] as usize;
+            next[cell] += 1;
+            index.ids[idx] = n.id;
+            index.coords[idx] = [n.lat, n.lon];
+        }
+        Some(index)
+    }
+
+    /// Creates a grid without any nodes, with cells `cell_lat` degrees high and
+    /// `cell_lat / lon_scale` degrees wide over the provided bounds.
+    fn empty(
+        min_lat: f32,
+        max_lat: f32,
+        lon_start: f32,
+        lon_span: f32,
+        cell_lat: f32,
+        lon_scale: f32,
+    ) -> Self {
+        let mut cell_lon = (cell_lat / lon_scale).min(360.0);
+        let rows = ((max_lat - min_lat) / cell_lat).floor() as u32 + 1;
+
+        // Wrap around if the longitudes outside of the span don't fill a whole column
+        let wraps = lon_span + cell_lon >= 360.0;
+        let (cols, lon_center) = if wraps {
+            let cols = (360.0 / cell_lon).floor().max(1.0) as u32;
+            cell_lon = 360.0 / cols as f32;
+            (cols, 0.0)
+        } else {
+            let cols = (lon_span / cell_lon).floor() as u32 + 1;
+            (cols, lon_start + cols as f32 * cell_lon * 0.5)
+        };
+
+        Self {
+            ids: Vec::default(),
+            coords: Vec::default(),
+            offsets: vec![0; rows as usize * cols as usize + 1],
+            rows,
+            cols,
+            lat0: min_lat,
+            lon_center: wrap_lon(lon_center),
+            cell_lat,
+            cell_lon,
+            wraps,
+        }
+    }
+}
+
+/// Returns the start and the length (in degrees) of the shortest range of longitudes,
+/// going eastwards (possibly across the antimeridian), which contains all nodes.
+fn shortest_lon_range(nodes: &[Node]) -> (f32, f32) {
+    let mut lons: Vec<f32> = nodes.iter().map(|n| wrap_lon(n.lon)).collect();
+    lons.sort_unstable_by(f32::total_cmp);
+
+    // The range starts after the largest gap between consecutive longitudes
+    let mut gap = (lons[0] + 360.0 - lons[lons.len() - 1], 0);
+    for i in 1..lons.len() {
+        let g = lons[i] - lons[i - 1];
+        if g > gap.0 {
+            gap = (g, i);
+        }
+    }
+    (lons[gap.1], 360.0 - gap.0)
+}
+
+/// Wraps a longitude (or a difference of longitudes) into the `[-180, 180]` range.
+#[inline]
+fn wrap_lon(lon: f32) -> f32 {
+    lon - 360.0 * (lon / 360.0).round()
+}
+
+/// Query position with a precomputed longitude scale of the local equirectangular projection.
+struct Query {
+    lat: f32,
+    lon: f32,
+    lon_scale: f32,
+}
+
+impl Query {
+    fn new(lat: f32, lon: f32) -> Self {
+        Self {
+            lat,
+            lon,
+            lon_scale: lat.to_radians().cos(),
+        }
+    }
+
+    /// Returns the squared, projected distance to a `[lat, lon]` point.
+    #[inline]
+    fn distance_squared(&self, point: [f32; 2]) -> f32 {
+        let dlat = point[0] - self.lat;
+        let dlon = wrap_lon(point[1] - self.lon) * self.lon_scale;
+        dlat * dlat + dlon * dlon
+    }
+}
+
+/// Bounded, least-recently-used cache of nearest-node lookups,
+/// see [GridIndex::find_nearest_node_cached].
+///
+/// Positions are quantized to multiples of `quantum` meters (of latitude; longitudes are
+/// quantized to the same number of degrees), and all positions with the same quantized
+/// coordinates share a cache entry - the node of the first lookup is returned for all
+/// of them. Keep the quantum well below the distance between nodes.
+///
+/// Like a [SearchContext](crate::SearchContext), a SnapCache may only be used by one lookup
+/// at a time, and multi-threaded applications should keep one cache per thread.
+#[derive(Debug, Clone)]
+pub struct SnapCache {
+    /// Quantum of the keys, in degrees.
+    quantum: f32,
+    lru: Lru<u64, Node>,
+    hits: u64,
+    misses: u64,
+}
+
+impl SnapCache {
+    /// Creates an empty cache of at most `capacity` entries, quantizing positions
+    /// to multiples of `quantum` meters. A cache with zero capacity never stores anything.
+    ///
+    /// Panics if `quantum` is not a positive, finite number.
+    pub fn new(capacity: usize, quantum: f32) -> Self {
+        assert!(
+            quantum > 0.0 && quantum.is_finite(),
+            "invalid snap cache quantum"
+        );
+        Self {
+            quantum: quantum / METERS_PER_DEGREE,
+            lru: Lru::new(capacity),
+            hits: 0,
+            misses: 0,
+        }
+    }
+
+    /// Returns the number of cached lookups.
+    pub fn len(&self) -> usize {
+        self.lru.len()
+    }
+
+    /// Returns `true` if there are no cached lookups.
+    pub fn is_empty(&self) -> bool {
+        self.lru.is_empty()
+    }
+
+    /// Returns the maximum number of cached lookups.
+    pub fn capacity(&self) -> usize {
+        self.lru.capacity()
+    }
+
+    /// Returns the number of lookups answered from the cache.
+    pub fn hits(&self) -> u64 {
+        self.hits
+    }
+
+    /// Returns the number of lookups which weren't cached.
+    pub fn misses(&self) -> u64 {
+        self.misses
+    }
+
+    /// Removes all cached lookups, e.g. after switching to a different [GridIndex].
+    /// Hit and miss counters are preserved.
+    pub fn clear(&mut self) {
+        self.lru.clear();
+    }
+
+    #[inline]
+    fn key(&self, lat: f32, lon: f32) -> u64 {
+        let lat = (lat / self.quantum).round() as i32 as u32;
+        let lon = (wrap_lon(lon) / self.quantum).round() as i32 as u32;
+        (lat as u64) << 32 | lon as u64
+    }
+
+    fn get(&mut self, key: u64) -> Option<Node> {
+        let node = self.lru.get(&key).copied();
+        if node.is_some() {
+            self.hits += 1;
+        } else {
+            self.misses += 1;
+        }
+        node
+    }
+
+    fn insert(&mut self, key: u64, node: Node) {
+        self.lru.insert(key, node);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn node(id: i64, lat: f32, lon: f32) -> Node {
+        Node {
+            id,
+            osm_id: id,
+            lat,
+            lon,
+        }
+    }
+
+    /// Large random-ish set of nodes, with a deterministic pseudo-random generator.
+    fn scattered(n: usize, lat: f32, lon: f32, lat_spread: f32, lon_spread: f32) -> Vec<Node> {
+        let mut state: u64 = 42;
+        let mut next = move || {
+            state = state
+                .wrapping_mul(6364136223846793005)
+                .wrapping_add(1442695040888963407);
+            (state >> 40) as f32 / (1 << 24) as f32
+        };
+        (1..=n as i64)
+            .map(|id| {
+                let lat = lat + lat_spread * next();
+                node(id, lat, wrap_lon(lon + lon_spread * next()))
+            })
+            .collect()
+    }
+
+    /// Checks that the index returns the nodes closest to the queries, by comparing
+    /// the distances against a brute-force search over all nodes.
+    fn assert_nearest(index: &GridIndex, nodes: &[Node], queries: &[Node]) {
+        for q in queries {
+            let query = Query::new(q.lat, q.lon);
+            let expected = nodes
+                .iter()
+                .map(|n| query.distance_squared([n.lat, n.lon]))
+                .fold(f32::INFINITY, f32::min);
+            let got = index.find_nearest_node(q.lat, q.lon);
+            let got = query.distance_squared([got.lat, got.lon]);
+            assert_eq!(got, expected, "query at {} {}", q.lat, q.lon);
+        }
+    }
+
+    #[test]
+    fn find_nearest_node() {
+        let nodes = scattered(2000, 52.1, 20.9, 0.2, 0.2);
+        let index = GridIndex::build(&nodes, 500.0).unwrap();
+        assert_eq!(index.len(), 2000);
+        assert!(!index.wraps);
+
+        let (rows, cols) = index.dimensions();
+        assert!(rows * cols <= MAX_CELLS_PER_NODE * 2000 + 64);
+
+        // Including queries far outside of the grid
+        assert_nearest(&index, &nodes, &scattered(500, 51.9, 20.7, 0.6, 0.6));
+        assert_nearest(&index, &nodes, &scattered(10, -40.0, -170.0, 10.0, 10.0));
+    }
+
+    #[test]
+    fn antimeridian() {
+        let nodes = [
+            node(1, -17.0, 179.99),
+            node(2, -17.0, -179.995),
+            node(3, -17.0, 178.0),
+            node(4, -17.5, -179.5),
+        ];
+        let index = GridIndex::build(&nodes, 100.0).unwrap();
+        assert!(!index.wraps);
+        assert_eq!(index.find_nearest_node(-17.0, -179.999).id, 2);
+        assert_eq!(index.find_nearest_node(-17.0, 179.998).id, 2);
+        assert_eq!(index.find_nearest_node(-17.0, 180.0).id, 2);
+        assert_eq!(index.find_nearest_node(-17.0, 179.5).id, 1);
+        assert_eq!(index.find_nearest_node(-17.6, -179.0).id, 4);
+        assert_eq!(index.find_nearest_node(-17.0, 170.0).id, 3);
+
+        // Shorter way from the query crosses the gap between -150° and 140°
+        let nodes = [
+            node(1, 0.0, -150.0),
+            node(2, 0.0, -100.0),
+            node(3, 0.0, 0.0),
+            node(4, 0.0, 100.0),
+            node(5, 0.0, 140.0),
+        ];
+        let index = GridIndex::build(&nodes, 100_000.0).unwrap();
+        assert!(!index.wraps);
+        assert_eq!(index.find_nearest_node(0.0, 179.0).id, 1);
+        assert_eq!(index.find_nearest_node(0.0, 170.0).id, 5);
+        assert_eq!(index.find_nearest_node(0.0, -178.0).id, 1);
+
+        // Nodes spread over all longitudes wrap around
+        let nodes = scattered(1000, -60.0, -180.0, 120.0, 360.0);
+        let index = GridIndex::build(&nodes, 100_000.0).unwrap();
+        assert!(index.wraps);
+        assert_nearest(&index, &nodes, &scattered(200, -70.0, 170.0, 140.0, 20.0));
+    }
+
+    #[test]
+    fn single_node() {
+        let index = GridIndex::build(&[node(7, 10.0, 10.0)], 100.0).unwrap();
+        assert_eq!(index.dimensions(), (1, 1));
+        assert_eq!(index.find_nearest_node(-50.0, -170.0).id, 7);
+        assert!(GridIndex::build(&[], 100.0).is_none());
+    }
+
+    #[test]
+    fn snap_cache() {
+        let nodes = scattered(100, 52.1, 20.9, 0.05, 0.05);
+        let index = GridIndex::build(&nodes, 200.0).unwrap();
+        let mut cache = SnapCache::new(2, 1.0);
+
+        let a = index.find_nearest_node_cached(&mut cache, 52.12, 20.92);
+        assert_eq!(a, index.find_nearest_node(52.12, 20.92));
+        assert_eq!((cache.hits(), cache.misses()), (0, 1));
+
+        // Within the same quantum
+        assert_eq!(
+            index.find_nearest_node_cached(&mut cache, 52.120001, 20.920001),
+            a
+        );
+        assert_eq!((cache.hits(), cache.misses()), (1, 1));
+
+        let b = index.find_nearest_node_cached(&mut cache, 52.13, 20.93);
+        assert_eq!(index.find_nearest_node_cached(&mut cache, 52.12, 20.92), a);
+        assert_eq!(cache.len(), 2);
+
+        // Evicts the least recently used (52.13, 20.93)
+        index.find_nearest_node_cached(&mut cache, 52.14, 20.94);
+        assert_eq!(cache.len(), 2);
+        assert_eq!((cache.hits(), cache.misses()), (2, 3));
+        assert_eq!(index.find_nearest_node_cached(&mut cache, 52.13, 20.93), b);
+        assert_eq!((cache.hits(), cache.misses()), (2, 4));
+        assert_ne!(
+            index.find_nearest_node_cached(&mut cache, 52.14, 20.94).id,
+            0
+        );
+        assert_eq!((cache.hits(), cache.misses()), (3, 4));
+
+        cache.clear();
+        assert!(cache.is_empty());
+        index.find_nearest_node_cached(&mut cache, 52.12, 20.92);
+        assert_eq!((cache.hits(), cache.misses()), (3, 5));
+
+        let mut disabled = SnapCache::new(0, 1.0);
+        index.find_nearest_node_cached(&mut disabled, 52.12, 20.92);
+        index.find_nearest_node_cached(&mut disabled, 52.12, 20.92);
+        assert_eq!(
+            (disabled.hits(), disabled.misses(), disabled.len()),
+            (0, 2, 0)
+        );
+    }
+}
@@ -1,7 +1,9 @@
 // (c) Copyright 2025 Mikołaj Kuranowski
 // SPDX-License-Identifier: MIT
 
-use crate::{earth_distance, Graph, Node};
+use std::collections::BinaryHeap;
+
+use crate::{earth_distance, parallel, Graph, Node};
 
 /// KDTree implements the [k-d tree data structure](https://en.wikipedia.org/wiki/K-d_tree),
 /// which can be used to speed up nearest-neighbor search for large datasets.
@@ -10,10 +12,17 @@ use crate::{earth_distance, Graph, Node};
 /// significantly more time than [find_route](crate::find_route) when generating multiple routes.
 /// A k-d tree can help with that, trading memory usage for CPU time.
 ///
-/// This implementation assumes euclidean geometry, even though the default distance function
-/// used is [earth_distance]. This results in undefined behavior when points
+/// The tree is stored as a flat, implicit array - the pivot of every subtree is located
+/// in the middle of the subtree's range, with the left and right subtrees on either side of it.
+/// This avoids pointer chasing, and keeps the coordinates (visited by every search) separate
+/// from the node ids (only needed for the results).
+///
+/// Searches compare squared distances in a local
+/// [equirectangular projection](https://en.wikipedia.org/wiki/Equirectangular_projection)
+/// centered at the query position, which doesn't require any trigonometric functions
+/// per visited node. This results in undefined behavior when points
 /// are close to the ante meridian (180°/-180° longitude) or poles (90°/-90° latitude),
-/// or when the data spans multiple continents.
+/// or when the data spans multiple continents - use a [GridIndex](crate::GridIndex) for such data.
 ///
 /// # Example
 ///
@@ -29,64 +38,178 @@ use crate::{earth_distance, Graph, Node};
 /// ```
 #[derive(Debug, Clone)]
 pub struct KDTree {
-    pivot: Node,
-    left: Option<Box<KDTree>>,
-    right: Option<Box<KDTree>>,
+    /// [Node::id] (equal to [Node::osm_id]) of every node, in the implicit tree order.
+    ids: Vec<i64>,
+
+    /// `[lat, lon]` of every node, in the implicit tree order.
+    coords: Vec<[f32; 2]>,
 }
 
 impl KDTree {
+    /// Returns the number of nodes in the tree.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.ids.len()
+    }
+
+    /// Returns `true` if there are no nodes in the tree. Never true for trees returned
+    /// by the build functions.
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.ids.is_empty()
+    }
+
     /// Finds the closest canonical (`id == osm_id`) [Node] to the given position.
     pub fn find_nearest_node(&self, lat: f32, lon: f32) -> Node {
-        self.find_nearest_node_impl(lat, lon, false).0
+        let q = Query::new(lat, lon);
+        let mut best = (0, f32::INFINITY);
+        self.find_nearest_impl(&q, 0, self.len(), false, &mut best);
+        self.node_at(best.0)
     }
 
-    fn find_nearest_node_impl(&self, lat: f32, lon: f32, lon_divides: bool) -> (Node, f32) {
-        // Start by assuming that pivot is the closest
-        let mut best = self.pivot;
-        let mut best_dist = earth_distance(lat, lon, best.lat, best.lon);
+    /// Finds up to `k` closest canonical (`id == osm_id`) [Nodes](Node) to the given position,
+    /// ordered by increasing [earth_distance].
+    pub fn find_k_nearest_nodes(&self, lat: f32, lon: f32, k: usize) -> Vec<Node> {
+        if k == 0 {
+            return Vec::default();
+        }
 
-        // Select which branch to recurse into first
-        let first_left = if lon_divides {
-            lon < best.lon
-        } else {
-            lat < best.lat
-        };
-        let (first, second) = if first_left {
-            (&self.left, &self.right)
+        let q = Query::new(lat, lon);
+        let mut heap = BinaryHeap::with_capacity(k + 1);
+        self.find_k_nearest_impl(&q, 0, self.len(), false, k, &mut heap);
+
+        // Only the final candidates are ordered by their great-circle distance
+        let mut nodes: Vec<(f32, Node)> = heap
+            .into_iter()
+            .map(|c| {
+                let n = self.node_at(c.idx);
+                (earth_distance(lat, lon, n.lat, n.lon), n)
+            })
+            .collect();
+        nodes.sort_by(|a, b| a.0.total_cmp(&b.0));
+        nodes.into_iter().map(|(_, n)| n).collect()
+    }
+
+    /// Finds the closest canonical (`id == osm_id`) [Node] to every `(lats[i], lons[i])`
+    /// position, spreading the queries over `threads` threads (zero stands for
+    /// [available parallelism](std::thread::available_parallelism)).
+    ///
+    /// Panics if `lats` and `lons` have different lengths.
+    pub fn find_nearest_nodes(&self, lats: &[f32], lons: &[f32], threads: usize) -> Vec<Node> {
+        let mut out = vec![Node::ZERO; lats.len()];
+        self.find_nearest_nodes_into(lats, lons, threads, &mut out);
+        out
+    }
+
+    /// Same as [KDTree::find_nearest_nodes], but writes the nodes into the provided slice.
+    ///
+    /// Panics if `lats`, `lons` and `out` have different lengths.
+    pub fn find_nearest_nodes_into(
+        &self,
+        lats: &[f32],
+        lons: &[f32],
+        threads: usize,
+        out: &mut [Node],
+    ) {
+        assert_eq!(
+            lats.len(),
+            lons.len(),
+            "lats and lons must have equal lengths"
+        );
+        assert_eq!(
+            lats.len(),
+            out.len(),
+            "out must have the same length as lats"
+        );
+        parallel::fill(
+            out,
+            threads,
+            || (),
+            |_, i| self.find_nearest_node(lats[i], lons[i]),
+        );
+    }
+
+    #[inline]
+    fn node_at(&self, idx: usize) -> Node {
+        let [lat, lon] = self.coords[idx];
+        Node {
+            id: self.ids[idx],
+            osm_id: self.ids[idx],
+            lat,
+            lon,
+        }
+    }
+
+    fn find_nearest_impl(
+        &self,
+        q: &Query,
+        lo: usize,
+        hi: usize,
+        lon_divides: bool,
+        best: &mut (usize, f32),
+    ) {
+        if lo >= hi {
+            return;
+        }
+
+        // Start by checking the pivot
+        let mid = lo + (hi - lo) / 2;
+        let pivot = self.coords[mid];
+        let dist = q.distance_squared(pivot);
+        if dist < best.1 {
+            *best = (mid, dist);
+        }
+
+        // Recurse into the side of the splitting axis with the query point first.
+        // A closer node is possible in the other side if and only if
+        // the splitting axis is closer than the current best candidate.
+        let axis = q.axis_offset(pivot, lon_divides);
+        let (first, second) = if axis < 0.0 {
+            ((lo, mid), (mid + 1, hi))
         } else {
-            (&self.right, &self.left)
+            ((mid + 1, hi), (lo, mid))
         };
 
-        // Recurse into the first branch
-        if let Some(ref branch) = first {
-            let (alt, alt_dist) = branch.find_nearest_node_impl(lat, lon, !lon_divides);
-            if alt_dist < best_dist {
-                best = alt;
-                best_dist = alt_dist;
-            }
+        self.find_nearest_impl(q, first.0, first.1, !lon_divides, best);
+        if axis * axis < best.1 {
+            self.find_nearest_impl(q, second.0, second.1, !lon_divides, best);
         }
+    }
 
-        // (Optionally) recurse into the second branch
-        if let Some(ref branch) = second {
-            // A closer node is possible in the second branch if and only if
-            // the splitting axis is closer than the current best candidate.
-            let (axis_lat, axis_lon) = if lon_divides {
-                (lat, self.pivot.lon)
-            } else {
-                (self.pivot.lat, lon)
-            };
-            let dist_to_axis = earth_distance(lat, lon, axis_lat, axis_lon);
-
-            if dist_to_axis < best_dist {
-                let (alt, alt_dist) = branch.find_nearest_node_impl(lat, lon, !lon_divides);
-                if alt_dist < best_dist {
-                    best = alt;
-                    best_dist = alt_dist;
-                }
-            }
+    fn find_k_nearest_impl(
+        &self,
+        q: &Query,
+        lo: usize,
+        hi: usize,
+        lon_divides: bool,
+        k: usize,
+        heap: &mut BinaryHeap<Candidate>,
+    ) {
+        if lo >= hi {
+            return;
         }
 
-        return (best, best_dist);
+        let mid = lo + (hi - lo) / 2;
+        let pivot = self.coords[mid];
+        let dist = q.distance_squared(pivot);
+        if heap.len() < k {
+            heap.push(Candidate { dist, idx: mid });
+        } else if dist < heap.peek().unwrap().dist {
+            heap.pop();
+            heap.push(Candidate { dist, idx: mid });
+        }
+
+        let axis = q.axis_offset(pivot, lon_divides);
+        let (first, second) = if axis < 0.0 {
+            ((lo, mid), (mid + 1, hi))
+        } else {
+            ((mid + 1, hi), (lo, mid))
+        };
+
+        self.find_k_nearest_impl(q, first.0, first.1, !lon_divides, k, heap);
+        if heap.len() < k || axis * axis < heap.peek().unwrap().dist {
+            self.find_k_nearest_impl(q, second.0, second.1, !lon_divides, k, heap);
+        }
     }
 
     /// Builds a k-d tree from an iterable of [Nodes](Node).
@@ -106,7 +229,15 @@ impl KDTree {
     /// this is checked with a `debug_assert!`.
     pub fn build(nodes: &mut [Node]) -> Option<Self> {
         debug_assert!(nodes.iter().all(|n| n.id == n.osm_id));
-        Self::build_impl(nodes, false)
+        if nodes.is_empty() {
+            return None;
+        }
+
+        Self::build_impl(nodes, false);
+        Some(Self {
+            ids: nodes.iter().map(|n| n.id).collect(),
+            coords: nodes.iter().map(|n| [n.lat, n.lon]).collect(),
+        })
     }
 
     /// Builds a k-d tree from a Graph, collecting all canonical (`id == osm_id`) nodes into a [Vec] first.
@@ -115,46 +246,95 @@ impl KDTree {
         Self::build(&mut nodes)
     }
 
-    fn build_impl(nodes: &mut [Node], lon_divides: bool) -> Option<Self> {
-        match nodes.len() {
-            0 => None,
-            1 => Some(Self {
-                pivot: nodes[0],
-                left: None,
-                right: None,
-            }),
-            _ => {
-                if lon_divides {
-                    nodes.sort_by(|a, b| a.lon.partial_cmp(&b.lon).unwrap());
-                } else {
-                    nodes.sort_by(|a, b| a.lat.partial_cmp(&b.lat).unwrap());
-                }
-                let median = nodes.len() / 2;
-                let pivot = nodes[median];
-                let (left, right_and_pivot) = nodes.split_at_mut(median);
-                let right = &mut right_and_pivot[1..];
-                Some(Self {
-                    pivot,
-                    left: box_option(Self::build_impl(left, !lon_divides)),
-                    right: box_option(Self::build_impl(right, !lon_divides)),
-                })
-            }
+    /// Reorders the nodes into the implicit tree order: the median (by the splitting axis)
+    /// in the middle, and recursively built subtrees on either side.
+    fn build_impl(nodes: &mut [Node], lon_divides: bool) {
+        if nodes.len() <= 1 {
+            return;
         }
+
+        let median = nodes.len() / 2;
+        if lon_divides {
+            nodes.select_nth_unstable_by(median, |a, b| a.lon.total_cmp(&b.lon));
+        } else {
+            nodes.select_nth_unstable_by(median, |a, b| a.lat.total_cmp(&b.lat));
+        }
+
+        let (left, right_and_pivot) = nodes.split_at_mut(median);
+        Self::build_impl(left, !lon_divides);
+        Self::build_impl(&mut right_and_pivot[1..], !lon_divides);
     }
 }
 
-#[inline]
-fn box_option<T>(o: Option<T>) -> Option<Box<T>> {
-    o.map(Box::new)
+/// Query position with a precomputed longitude scale of the local equirectangular projection.
+struct Query {
+    lat: f32,
+    lon: f32,
+    lon_scale: f32,
+}
+
+impl Query {
+    fn new(lat: f32, lon: f32) -> Self {
+        Self {
+            lat,
+            lon,
+            lon_scale: lat.to_radians().cos(),
+        }
+    }
+
+    /// Returns the squared, projected distance to a `[lat, lon]` point.
+    #[inline]
+    fn distance_squared(&self, point: [f32; 2]) -> f32 {
+        let dlat = point[0] - self.lat;
+        let dlon = (point[1] - self.lon) * self.lon_scale;
+        dlat * dlat + dlon * dlon
+    }
+
+    /// Returns the signed, projected distance from the query to the splitting axis going through
+    /// a `[lat, lon]` pivot. Negative values mean that the query lies on the left side.
+    #[inline]
+    fn axis_offset(&self, pivot: [f32; 2], lon_divides: bool) -> f32 {
+        if lon_divides {
+            (self.lon - pivot[1]) * self.lon_scale
+        } else {
+            self.lat - pivot[0]
+        }
+    }
+}
+
+/// Entry of the bounded max-heap of k-nearest search candidates.
+#[derive(Debug, Clone, Copy)]
+struct Candidate {
+    dist: f32,
+    idx: usize,
+}
+
+impl PartialEq for Candidate {
+    fn eq(&self, other: &Self) -> bool {
+        self.dist.total_cmp(&other.dist).is_eq()
+    }
+}
+
+impl Eq for Candidate {}
+
+impl PartialOrd for Candidate {
+    fn partial_cmp(&self, other: &Self) -> Option<std::cmp::Ordering> {
+        Some(self.cmp(other))
+    }
+}
+
+impl Ord for Candidate {
+    fn cmp(&self, other: &Self) -> std::cmp::Ordering {
+        self.dist.total_cmp(&other.dist)
+    }
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
 
-    #[test]
-    fn kd_tree() {
-        let tree = KDTree::build(&mut [
+    fn fixture() -> KDTree {
+        KDTree::build(&mut [
             Node {
                 id: 1,
                 osm_id: 1,
@@ -210,11 +390,67 @@ mod tests {
                 lon: 0.09,
             },
         ])
-        .expect("k-d tree from non-empty slice must not be empty");
+        .expect("k-d tree from non-empty slice must not be empty")
+    }
 
+    #[test]
+    fn kd_tree() {
+        let tree = fixture();
+        assert_eq!(tree.len(), 9);
         assert_eq!(tree.find_nearest_node(0.02, 0.02).id, 1);
         assert_eq!(tree.find_nearest_node(0.05, 0.03).id, 4);
         assert_eq!(tree.find_nearest_node(0.05, 0.08).id, 5);
         assert_eq!(tree.find_nearest_node(0.09, 0.06).id, 8);
     }
+
+    #[test]
+    fn find_k_nearest_nodes() {
+        let tree = fixture();
+        let ids = |nodes: Vec<Node>| nodes.iter().map(|n| n.id).collect::<Vec<_>>();
+        assert_eq!(ids(tree.find_k_nearest_nodes(0.05, 0.03, 3)), vec![4, 6, 7]);
+        assert_eq!(ids(tree.find_k_nearest_nodes(0.09, 0.06, 1)), vec![8]);
+        assert_eq!(tree.find_k_nearest_nodes(0.0, 0.0, 0), vec![]);
+        assert_eq!(tree.find_k_nearest_nodes(0.0, 0.0, 100).len(), 9);
+    }
+
+    #[test]
+    fn find_nearest_nodes() {
+        let tree = fixture();
+        let lats = [0.02, 0.05, 0.05, 0.09];
+        let lons = [0.02, 0.03, 0.08, 0.06];
+        for threads in [1, 2] {
+            let nodes = tree.find_nearest_nodes(&lats, &lons, threads);
+            assert_eq!(
+                nodes.iter().map(|n| n.id).collect::<Vec<_>>(),
+                vec![1, 4, 5, 8]
+            );
+        }
+    }
+
+    #[test]
+    fn same_as_brute_force() {
+        let nodes: Vec<Node> = (0..500)
+            .map(|i| Node {
+                id: i,
+                osm_id: i,
+                lat: 52.0 + ((i * 7919) % 1000) as f32 * 1e-3,
+                lon: 21.0 + ((i * 104729) % 1000) as f32 * 1e-3,
+            })
+            .collect();
+        let tree = KDTree::from_iter(nodes.iter().cloned()).unwrap();
+
+        for i in 0..50 {
+            let lat = 52.0 + ((i * 31) % 100) as f32 * 1e-2;
+            let lon = 21.0 + ((i * 17) % 100) as f32 * 1e-2;
+            let expected = nodes
+                .iter()
+                .min_by(|a, b| {
+                    Query::new(lat, lon)
+                        .distance_squared([a.lat, a.lon])
+                        .total_cmp(&Query::new(lat, lon).distance_squared([b.lat, b.lon]))
+                })
+                .unwrap();
+            assert_eq!(tree.find_nearest_node(lat, lon).id, expected.id);
+        }
+    }
 }
@@ -0,0 +1,398 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+use std::fs::File;
+use std::io::{self, BufReader, BufWriter, Read, Write};
+use std::path::Path;
+
+use crate::astar::context::{QueueItem, SearchContext};
+use crate::frozen::{IncomingEdges, NO_INDEX};
+use crate::{binary, FrozenGraph};
+
+/// Magic bytes at the start of serialized [Landmarks].
+const MAGIC: &[u8; 8] = b"RoutxLMK";
+
+/// Version of the serialized [Landmarks] format.
+const VERSION: u32 = 2;
+
+/// Precomputed distances to and from a set of landmark nodes of a [FrozenGraph],
+/// used by the [ALT](https://www.microsoft.com/en-us/research/publication/computing-the-shortest-path-a-search-meets-graph-theory/)
+/// (A*, landmarks, triangle inequality) heuristic.
+///
+/// For any landmark `L`, the triangle inequality gives two lower bounds of the cost
+/// from `v` to `t`: `d(L, t) - d(L, v)` and `d(v, L) - d(t, L)`. Unlike the crow-flies
+/// distance, those bounds take edge costs (and thus profile penalties) into account,
+/// which can drastically reduce the number of nodes expanded by A*.
+///
+/// Landmarks are selected with the "farthest" strategy - every next landmark is the node
+/// farthest away from all already selected landmarks. Building requires 2 full Dijkstra
+/// searches per landmark, and the result takes `8 × count` bytes per node.
+///
+/// # Example
+///
+/// ```no_run
+/// let g = routx::Graph::new().freeze();
+/// let landmarks = routx::Landmarks::build(&g, 16);
+/// let mut ctx = routx::SearchContext::new();
+/// let route = g.find_route_with_landmarks(&mut ctx, &landmarks, 1, 2, routx::DEFAULT_STEP_LIMIT);
+/// ```
+#[derive(Debug, Default, Clone, PartialEq)]
+pub struct Landmarks {
+    /// Dense indices of the landmark nodes.
+    pub(crate) nodes: Vec<u32>,
+
+    /// Number of nodes and edges of the graph the landmarks were built for.
+    pub(crate) graph_shape: (u64, u64),
+
+    /// [FrozenGraph::fingerprint] of the graph the landmarks were built for.
+    pub(crate) graph_fingerprint: u64,
+
+    /// Cost from every landmark to every node: `d(L_i, v) = from_landmark[v * count + i]`.
+    pub(crate) from_landmark: Vec<f32>,
+
+    /// Cost from every node to every landmark: `d(v, L_i) = to_landmark[v * count + i]`.
+    pub(crate) to_landmark: Vec<f32>,
+}
+
+impl Landmarks {
+    /// Selects up to `count` landmarks of the provided graph,
+    /// and computes distances to and from them.
+    pub fn build(g: &FrozenGraph, count: usize) -> Self {
+        let n = g.len();
+        let count = count.min(n);
+        let mut ctx = SearchContext::new();
+        let mut lm = Self {
+            nodes: Vec::with_capacity(count),
+            graph_shape: (n as u64, g.edge_count() as u64),
+            graph_fingerprint: g.fingerprint(),
+            from_landmark: vec![f32::INFINITY; n * count],
+            to_landmark: vec![f32::INFINITY; n * count],
+        };
+        if count == 0 {
+            return lm;
+        }
+
+        // Distance from the closest landmark; initially from an arbitrary node,
+        // so that the first landmark lies on the periphery of the graph.
+        let mut closest = vec![f32::INFINITY; n];
+        dijkstra(g, &mut ctx, 0, None, |v, cost| closest[v as usize] = cost);
+
+        for i in 0..count {
+            let landmark = farthest(&closest, &lm.nodes);
+            lm.nodes.push(landmark);
+            if i == 0 {
+                closest.fill(f32::INFINITY);
+            }
+
+            dijkstra(g, &mut ctx, landmark, None, |v, cost| {
+                lm.from_landmark[v as usize * count + i] = cost;
+                closest[v as usize] = closest[v as usize].min(cost);
+            });
+            dijkstra(g, &mut ctx, landmark, Some(g.incoming()), |v, cost| {
+                lm.to_landmark[v as usize * count + i] = cost;
+            });
+        }
+
+        lm
+    }
+
+    /// Returns the number of landmarks.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.nodes.len()
+    }
+
+    /// Returns `true` if there are no landmarks.
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.nodes.is_empty()
+    }
+
+    /// Returns `true` if the landmarks were built for the provided graph - that is, for a graph
+    /// with the same node ids, node order, edges and edge costs. Snapshots of a
+    /// [CostOverlay](crate::CostOverlay) with no edge costs lower than the base costs
+    /// are also compatible with landmarks built for the base graph.
+    ///
+    /// Graphs are compared by a fingerprint, computed (in linear time) on first use and cached.
+    pub fn is_compatible_with(&self, g: &FrozenGraph) -> bool {
+        self.graph_shape == (g.len() as u64, g.edge_count() as u64)
+            && self.graph_fingerprint == g.fingerprint()
+    }
+
+    /// Returns a lower bound of the cost from `v` to `t` (dense indices), taking the maximum of
+    /// the triangle inequality bounds over all landmarks. May return [f32::INFINITY] if the
+    /// landmarks prove that `t` is unreachable from `v`.
+    #[inline]
+    pub(crate) fn lower_bound(&self, v: u32, t: u32) -> f32 {
+        let k = self.nodes.len();
+        let v = v as usize * k;
+        let t = t as usize * k;
+        let mut bound: f32 = 0.0;
+
+        // NOTE: Unreachable nodes have infinite distances. Differences of infinities
+        // are NaN, which fail all comparisons and are thus ignored. A positive infinity
+        // is only produced if `t` can't be reached from `v`.
+        for i in 0..k {
+            let forward = self.from_landmark[t + i] - self.from_landmark[v + i];
+            let backward = self.to_landmark[v + i] - self.to_landmark[t + i];
+            if forward > bound {
+                bound = forward;
+            }
+            if backward > bound {
+                bound = backward;
+            }
+        }
+
+        bound
+    }
+
+    /// Serializes the landmarks into a versioned, little-endian binary format.
+    pub fn write<W: Write>(&self, w: &mut W) -> io::Result<()> {
+        w.write_all(MAGIC)?;
+        binary::write(w, VERSION)?;
+        binary::write(w, self.graph_shape.0)?;
+        binary::write(w, self.graph_shape.1)?;
+        binary::write(w, self.graph_fingerprint)?;
+        binary::write(w, self.nodes.len() as u32)?;
+        binary::write_slice(w, &self.nodes)?;
+        binary::write_slice(w, &self.from_landmark)?;
+        binary::write_slice(w, &self.to_landmark)?;
+        Ok(())
+    }
+
+    /// Deserializes landmarks written by [Landmarks::write].
+    pub fn read<R: Read>(r: &mut R) -> io::Result<Self> {
+        let mut magic = [0_u8; 8];
+        r.read_exact(&mut magic)?;
+        if &magic != MAGIC {
+            return Err(binary::invalid_data("not a routx landmarks file"));
+        }
+        if binary::read::<_, u32>(r)? != VERSION {
+            return Err(binary::invalid_data("unsupported routx landmarks version"));
+        }
+
+        let graph_shape = (binary::read(r)?, binary::read(r)?);
+        let graph_fingerprint = binary::read(r)?;
+        let count = binary::read::<_, u32>(r)? as usize;
+        let nodes: Vec<u32> = binary::read_vec(r, count)?;
+        if nodes.iter().any(|&idx| idx as u64 >= graph_shape.0) {
+            return Err(binary::invalid_data("landmark node out of bounds"));
+        }
+
+        let total = (graph_shape.0 as usize)
+            .checked_mul(count)
+            .ok_or_else(|| binary::invalid_data("too many landmarks"))?;
+        Ok(Self {
+            nodes,
+            graph_shape,
+            graph_fingerprint,
+            from_landmark: binary::read_vec(r, total)?,
+            to_landmark: binary::read_vec(r, total)?,
+        })
+    }
+
+    /// Saves the landmarks to a file, see [Landmarks::write].
+    pub fn save<P: AsRef<Path>>(&self, path: P) -> io::Result<()> {
+        let mut w = BufWriter::new(File::create(path)?);
+        self.write(&mut w)?;
+        w.flush()
+    }
+
+    /// Loads landmarks from a file, see [Landmarks::read].
+    pub fn load<P: AsRef<Path>>(path: P) -> io::Result<Self> {
+        Self::read(&mut BufReader::new(File::open(path)?))
+    }
+}
+
+/// Returns the node with the largest (unreachable nodes first) distance,
+/// which isn't already a landmark.
+fn farthest(distances: &[f32], landmarks: &[u32]) -> u32 {
+    let mut best = NO_INDEX;
+    let mut best_distance = f32::NEG_INFINITY;
+    for (v, &d) in distances.iter().enumerate() {
+        if d > best_distance && !landmarks.contains(&(v as u32)) {
+            best = v as u32;
+            best_distance = d;
+        }
+    }
+    best
+}
+
+/// Runs a full Dijkstra search from `source`, calling `settled(node, cost)` on every
+/// reachable node. Follows incoming edges (computing distances _to_ `source`) if provided,
+/// outgoing edges otherwise.
+fn dijkstra<F: FnMut(u32, f32)>(
+    g: &FrozenGraph,
+    ctx: &mut SearchContext,
+    source: u32,
+    incoming: Option<&IncomingEdges>,
+    mut settled: F,
+) {
+    ctx.reset(g.len());
+    ctx.set(source, 0.0, NO_INDEX);
+    ctx.queue.push(QueueItem {
+        at: source,
+        cost: 0.0,
+        score: 0.0,
+    });
+
+    while let Some(item) = ctx.queue.pop() {
+        if item.cost > ctx.cost(item.at) {
+            continue;
+        }
+        settled(item.at, item.cost);
+
+        let mut relax = |neighbor: u32, edge_cost: f32| {
+            let cost = item.cost + edge_cost;
+            if cost < ctx.cost(neighbor) {
+                ctx.set(neighbor, cost, item.at);
+                ctx.queue.push(QueueItem {
+                    at: neighbor,
+                    cost,
+                    score: cost,
+                });
+            }
+        };
+
+        match incoming {
+            Some(incoming) => incoming.edges_at(item.at).for_each(|(v, c)| relax(v, c)),
+            None => g.edges_at(item.at).for_each(|(v, c)| relax(v, c)),
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{Graph, Node};
+
+    fn line_fixture() -> FrozenGraph {
+        // 1 ─100─> 2 ─100─> 3 ─100─> 4
+        //   <─300─   <─300─   <─300─
+        Graph::from_iter(
+            (1..=4).map(|id| Node {
+                id,
+                osm_id: id,
+                lat: 0.0,
+                lon: id as f32 * 0.0001,
+            }),
+            [
+                (1, 2, 100.0),
+                (2, 3, 100.0),
+                (3, 4, 100.0),
+                (2, 1, 300.0),
+                (3, 2, 300.0),
+                (4, 3, 300.0),
+            ],
+        )
+        .freeze()
+    }
+
+    #[test]
+    fn build() {
+        let g = line_fixture();
+        let lm = Landmarks::build(&g, 2);
+        assert_eq!(lm.len(), 2);
+        assert_eq!(lm.nodes, vec![3, 0]); // farthest from node 0, and then farthest from node 3
+        assert!(lm.is_compatible_with(&g));
+
+        // d(4, 1) = 900; d(2, 1) = 300
+        assert_eq!(lm.to_landmark[3 * 2 + 1], 900.0);
+        assert_eq!(lm.to_landmark[1 * 2 + 1], 300.0);
+        // d(4, 2) = 600
+        assert_eq!(lm.from_landmark[1 * 2 + 0], 600.0);
+    }
+
+    #[test]
+    fn is_compatible_with() {
+        let g = line_fixture();
+        let lm = Landmarks::build(&g, 2);
+        assert!(lm.is_compatible_with(&g));
+        assert!(lm.is_compatible_with(&g.clone()));
+
+        // Same shape, different node order
+        let mut reversed = Graph::default();
+        for node in g.iter() {
+            reversed.set_node(Node {
+                lon: (5 - node.id) as f32 * 0.0001,
+                ..node
+            });
+            for edge in g.get_edges(node.id) {
+                reversed.set_edge(node.id, edge);
+            }
+        }
+        let reversed = reversed.freeze();
+        let lm_reversed = Landmarks::build(&reversed, 2);
+        let reordered = reversed.reordered(crate::NodeOrder::Hilbert);
+        assert_ne!(reordered.ids, reversed.ids);
+        assert!(lm_reversed.is_compatible_with(&reversed));
+        assert!(!lm_reversed.is_compatible_with(&reordered));
+
+        // Same shape, different costs
+        let mut costs = g.edge_costs.to_vec();
+        costs[0] = 50.0;
+        assert!(!lm.is_compatible_with(&g.with_edge_costs(costs)));
+    }
+
+    #[test]
+    fn is_compatible_with_overlay() {
+        let overlay = crate::CostOverlay::new(line_fixture());
+        let lm = Landmarks::build(overlay.base(), 2);
+        assert!(lm.is_compatible_with(&overlay.snapshot()));
+
+        overlay.set_factors(&[1.0, 2.0, 1.0, 1.0, 1.0, 1.0]);
+        assert!(lm.is_compatible_with(&overlay.snapshot()));
+
+        overlay.set_factors(&[1.0, 0.5, 1.0, 1.0, 1.0, 1.0]);
+        assert!(!lm.is_compatible_with(&overlay.snapshot()));
+    }
+
+    #[test]
+    fn lower_bound() {
+        let g = line_fixture();
+        let lm = Landmarks::build(&g, 2);
+        // Exact lower bounds on a line graph
+        assert_eq!(lm.lower_bound(0, 3), 300.0);
+        assert_eq!(lm.lower_bound(3, 0), 900.0);
+        assert_eq!(lm.lower_bound(2, 1), 300.0);
+        assert_eq!(lm.lower_bound(1, 1), 0.0);
+    }
+
+    #[test]
+    fn lower_bound_unreachable() {
+        let g = Graph::from_iter(
+            (1..=3).map(|id| Node {
+                id,
+                osm_id: id,
+                lat: 0.0,
+                lon: id as f32 * 0.0001,
+            }),
+            [(1, 2, 100.0), (2, 1, 100.0)],
+        )
+        .freeze();
+        let lm = Landmarks::build(&g, 2);
+        assert_eq!(lm.lower_bound(0, 1), 100.0);
+        assert_eq!(lm.lower_bound(0, 2), f32::INFINITY);
+    }
+
+    #[test]
+    fn write_read() {
+        let g = line_fixture();
+        let lm = Landmarks::build(&g, 3);
+
+        let mut buf: Vec<u8> = Vec::default();
+        lm.write(&mut buf).unwrap();
+        assert_eq!(Landmarks::read(&mut buf.as_slice()).unwrap(), lm);
+
+        let mut reread = Landmarks::read(&mut buf.as_slice()).unwrap();
+        assert!(reread.is_compatible_with(&g));
+        reread.graph_fingerprint ^= 1;
+        assert!(!reread.is_compatible_with(&g));
+
+        buf[0] = b'X';
+        assert_eq!(
+            Landmarks::read(&mut buf.as_slice()).unwrap_err().kind(),
+            io::ErrorKind::InvalidData
+        );
+    }
+}
@@ -16,6 +16,7 @@
 //!     profile: &routx::osm::CAR_PROFILE,
 //!     file_format: routx::osm::FileFormat::Unknown,
 //!     bbox: [0.0; 4],
+//!     threads: 0,
 //! };
 //! routx::osm::add_features_from_file(
 //!     &mut g,
@@ -30,18 +31,57 @@
 //!
 //! println!("Route: {:?}", route);
 //! ```
+//!
+//! # Thread safety
+//!
+//! All graphs and indices are `Send + Sync`, and methods taking `&self` never mutate
+//! shared state, so any number of threads may route, look up nodes and read edges of the same
+//! graph (e.g. behind an [Arc](std::sync::Arc)) without locking. Scratch space is kept in
+//! a [SearchContext], which must not be shared between concurrent searches. A [SwapCell]
+//! replaces a shared graph without blocking queries which are already running,
+//! and a [RouteCache] may be shared by all threads routing on the same graph. Similarly,
+//! all threads searching a [TiledGraph] share its cache of loaded tiles.
 
 mod astar;
+mod binary;
 pub mod c;
+mod cache;
+mod ch;
+mod compact;
 mod distance;
+mod frozen;
 mod graph;
+mod grid;
 mod kd;
+mod landmarks;
+mod lru;
+mod mmap;
 pub mod osm;
+mod overlay;
+mod parallel;
+mod pool;
+mod shared;
+mod tiled;
 
-pub use astar::{find_route, find_route_without_turn_around, AStarError, DEFAULT_STEP_LIMIT};
-pub use distance::earth_distance;
+pub use astar::{
+    find_route, find_route_detailed, find_route_without_turn_around, AStarError, CancelToken,
+    QueueKind, RouteDetailed, SearchContext, SearchStats, DEFAULT_STEP_LIMIT,
+};
+pub use cache::{CachedRoute, RouteCache, RouteKind};
+pub use ch::CHGraph;
+pub use compact::{CompactGraph, DEFAULT_COST_SCALE};
+pub use distance::{
+    earth_distance, earth_distance_approx, earth_distance_many, EARTH_DISTANCE_APPROX_MAX_ERROR,
+};
+pub use frozen::{FrozenGraph, NodeOrder, RouteRequest};
 pub use graph::Graph;
+pub use grid::{GridIndex, SnapCache, DEFAULT_GRID_CELL_SIZE, DEFAULT_SNAP_QUANTUM};
 pub use kd::KDTree;
+pub use landmarks::Landmarks;
+pub use overlay::{CostOverlay, CostSnapshot, EdgeFactor};
+pub use pool::{RouteTask, SearchPool};
+pub use shared::SwapCell;
+pub use tiled::{TileStats, TiledGraph, DEFAULT_TILE_SIZE};
 
 /// Represents an element of the [Graph].
 ///
@@ -0,0 +1,215 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+use std::collections::HashMap;
+use std::hash::Hash;
+
+const NIL: u32 = u32::MAX;
+
+#[derive(Debug, Clone)]
+struct Entry<K, V> {
+    key: K,
+    value: V,
+    prev: u32,
+    next: u32,
+}
+
+/// Bounded map which evicts the least recently used entries.
+///
+/// Entries are kept in a single vector and linked into a recency list by their indices,
+/// so that a full cache reuses the storage of evicted entries instead of allocating.
+#[derive(Debug, Clone)]
+pub(crate) struct Lru<K, V> {
+    capacity: usize,
+    slots: HashMap<K, u32>,
+    entries: Vec<Entry<K, V>>,
+
+    /// Most recently used entry.
+    head: u32,
+
+    /// Least recently used entry.
+    tail: u32,
+}
+
+impl<K: Hash + Eq + Copy, V> Lru<K, V> {
+    /// Creates an empty cache of at most `capacity` entries.
+    /// A cache with zero capacity never stores anything.
+    pub(crate) fn new(capacity: usize) -> Self {
+        Self {
+            capacity,
+            slots: HashMap::default(),
+            entries: Vec::default(),
+            head: NIL,
+            tail: NIL,
+        }
+    }
+
+    #[inline]
+    pub(crate) fn len(&self) -> usize {
+        self.entries.len()
+    }
+
+    #[inline]
+    pub(crate) fn is_empty(&self) -> bool {
+        self.entries.is_empty()
+    }
+
+    #[inline]
+    pub(crate) fn capacity(&self) -> usize {
+        self.capacity
+    }
+
+    pub(crate) fn clear(&mut self) {
+        self.slots.clear();
+        self.entries.clear();
+        self.head = NIL;
+        self.tail = NIL;
+    }
+
+    /// Returns the value of the provided key, marking it as the most recently used.
+    pub(crate) fn get(&mut self, key: &K) -> Option<&V> {
+        let slot = *self.slots.get(key)?;
+        self.unlink(slot);
+        self.push_front(slot);
+        Some(&self.entries[slot as usize].value)
+    }
+
+    /// Inserts or replaces the value of the provided key, evicting the least recently used
+    /// entry if the cache is full.
+    pub(crate) fn insert(&mut self, key: K, value: V) {
+        if self.capacity == 0 {
+            return;
+        }
+
+        let slot = if let Some(&slot) = self.slots.get(&key) {
+            self.unlink(slot);
+            self.entries[slot as usize].value = value;
+            slot
+        } else if self.entries.len() < self.capacity {
+            self.entries.push(Entry {
+                key,
+                value,
+                prev: NIL,
+                next: NIL,
+            });
+            let slot = (self.entries.len() - 1) as u32;
+            self.slots.insert(key, slot);
+            slot
+        } else {
+            // Reuse the least recently used entry
+            let slot = self.tail;
+            self.unlink(slot);
+            self.slots.remove(&self.entries[slot as usize].key);
+            self.entries[slot as usize].key = key;
+            self.entries[slot as usize].value = value;
+            self.slots.insert(key, slot);
+            slot
+        };
+        self.push_front(slot);
+    }
+
+    /// Removes and returns the least recently used entry.
+    pub(crate) fn pop_lru(&mut self) -> Option<(K, V)> {
+        if self.tail == NIL {
+            return None;
+        }
+
+        let slot = self.tail;
+        self.unlink(slot);
+        let entry = self.entries.swap_remove(slot as usize);
+        self.slots.remove(&entry.key);
+
+        // Relink the entry moved into the freed slot
+        if (slot as usize) < self.entries.len() {
+            let Entry {
+                key, prev, next, ..
+            } = self.entries[slot as usize];
+            self.slots.insert(key, slot);
+            if prev == NIL {
+                self.head = slot;
+            } else {
+                self.entries[prev as usize].next = slot;
+            }
+            if next == NIL {
+                self.tail = slot;
+            } else {
+                self.entries[next as usize].prev = slot;
+            }
+        }
+
+        Some((entry.key, entry.value))
+    }
+
+    fn unlink(&mut self, slot: u32) {
+        let (prev, next) = {
+            let e = &self.entries[slot as usize];
+            (e.prev, e.next)
+        };
+        if prev == NIL {
+            self.head = next;
+        } else {
+            self.entries[prev as usize].next = next;
+        }
+        if next == NIL {
+            self.tail = prev;
+        } else {
+            self.entries[next as usize].prev = prev;
+        }
+    }
+
+    fn push_front(&mut self, slot: u32) {
+        let old_head = self.head;
+        self.entries[slot as usize].prev = NIL;
+        self.entries[slot as usize].next = old_head;
+        if old_head == NIL {
+            self.tail = slot;
+        } else {
+            self.entries[old_head as usize].prev = slot;
+        }
+        self.head = slot;
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn evicts_least_recently_used() {
+        let mut lru = Lru::new(2);
+        lru.insert(1, "a");
+        lru.insert(2, "b");
+        assert_eq!(lru.get(&1), Some(&"a"));
+
+        lru.insert(3, "c");
+        assert_eq!(lru.len(), 2);
+        assert_eq!(lru.get(&2), None);
+        assert_eq!(lru.get(&1), Some(&"a"));
+        assert_eq!(lru.get(&3), Some(&"c"));
+
+        // Replacing marks the entry as the most recently used
+        lru.insert(1, "A");
+        lru.insert(4, "d");
+        assert_eq!(lru.get(&3), None);
+        assert_eq!(lru.get(&1), Some(&"A"));
+        assert_eq!(lru.get(&4), Some(&"d"));
+
+        lru.clear();
+        assert!(lru.is_empty());
+        assert_eq!(lru.get(&1), None);
+
+        lru.insert(1, "a");
+        lru.insert(2, "b");
+        lru.get(&1);
+        lru.insert(3, "c");
+        assert_eq!(lru.pop_lru(), Some((1, "a")));
+        assert_eq!(lru.pop_lru(), Some((3, "c")));
+        assert_eq!(lru.pop_lru(), None);
+        assert!(lru.is_empty());
+
+        let mut disabled = Lru::new(0);
+        disabled.insert(1, "a");
+        assert!(disabled.is_empty());
+        assert_eq!(disabled.get(&1), None);
+    }
+}
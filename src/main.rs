@@ -24,13 +24,17 @@ struct Cli {
 
     /// Longitude of the end point
     end_lon: f32,
+
+    /// Read the OSM file twice, only keeping nodes of routable ways in memory
+    #[arg(long)]
+    two_pass: bool,
 }
 
 pub fn main() -> Result<(), Box<dyn Error>> {
     colog::init();
     let cli = Cli::parse();
 
-    let g = load_graph(&cli.osm_file)?;
+    let g = load_graph(&cli.osm_file, cli.two_pass)?;
 
     let start = g
         .find_nearest_node(cli.start_lat, cli.start_lon)
@@ -72,14 +76,20 @@ pub fn main() -> Result<(), Box<dyn Error>> {
     Ok(())
 }
 
-fn load_graph<P: AsRef<Path>>(path: P) -> Result<routx::Graph, GraphLoadError> {
+fn load_graph<P: AsRef<Path>>(path: P, two_pass: bool) -> Result<routx::Graph, GraphLoadError> {
     let mut g = routx::Graph::default();
     let options = routx::osm::Options {
         profile: &routx::osm::CAR_PROFILE,
         file_format: routx::osm::FileFormat::Xml,
         bbox: [0.0; 4],
+        threads: 0,
+    };
+    let result = if two_pass {
+        routx::osm::add_features_from_file_two_pass(&mut g, &options, path.as_ref())
+    } else {
+        routx::osm::add_features_from_file(&mut g, &options, path.as_ref())
     };
-    match routx::osm::add_features_from_file(&mut g, &options, path.as_ref()) {
+    match result {
         Ok(()) => Ok(g),
         Err(e) => Err(GraphLoadError(PathBuf::from(path.as_ref()), e)),
     }
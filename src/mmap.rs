@@ -0,0 +1,205 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+//! Read-only memory maps, and arrays which may borrow their elements from them.
+
+use std::fmt;
+use std::fs::File;
+use std::io;
+use std::ops::Deref;
+use std::sync::Arc;
+
+use crate::binary::Scalar;
+
+/// Read-only, shared memory map of a whole file.
+///
+/// As the mapping is shared, multiple processes mapping the same file use the same
+/// page-cache copy of it. The file must not be modified or truncated while mapped,
+/// see [Mmap::map].
+pub(crate) struct Mmap {
+    ptr: *const u8,
+    len: usize,
+}
+
+// SAFETY: The mapping is read-only and never mutated through this handle.
+unsafe impl Send for Mmap {}
+unsafe impl Sync for Mmap {}
+
+impl Mmap {
+    /// Maps the whole file into memory. Fails on empty files.
+    ///
+    /// # Safety
+    ///
+    /// The file must not be modified or truncated (by this or any other process) while
+    /// the map is alive. Otherwise, the bytes borrowed from the map may change underneath
+    /// shared references, or reading them may raise `SIGBUS`.
+    #[cfg(unix)]
+    pub(crate) unsafe fn map(file: &File) -> io::Result<Self> {
+        use std::os::unix::io::AsRawFd;
+
+        let len = usize::try_from(file.metadata()?.len())
+            .map_err(|_| io::Error::new(io::ErrorKind::OutOfMemory, "file too large to map"))?;
+        if len == 0 {
+            return Err(io::Error::new(
+                io::ErrorKind::UnexpectedEof,
+                "can't map an empty file",
+            ));
+        }
+
+        // SAFETY: Mapping a valid file descriptor read-only; the result is checked below.
+        let ptr = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ,
+                libc::MAP_SHARED,
+                file.as_raw_fd(),
+                0,
+            )
+        };
+        if ptr == libc::MAP_FAILED {
+            return Err(io::Error::last_os_error());
+        }
+
+        Ok(Self {
+            ptr: ptr as *const u8,
+            len,
+        })
+    }
+
+    /// Returns the mapped bytes.
+    #[inline]
+    pub(crate) fn as_bytes(&self) -> &[u8] {
+        // SAFETY: `ptr` points to `len` readable bytes for as long as self is alive.
+        unsafe { std::slice::from_raw_parts(self.ptr, self.len) }
+    }
+}
+
+impl Drop for Mmap {
+    fn drop(&mut self) {
+        #[cfg(unix)]
+        // SAFETY: `ptr` and `len` describe a mapping created by Mmap::map.
+        unsafe {
+            libc::munmap(self.ptr as *mut libc::c_void, self.len);
+        }
+    }
+}
+
+/// Immutable array of scalars, either owned or borrowed from a shared [Mmap].
+///
+/// Dereferences to a slice, so it can be used as a drop-in replacement
+/// for a [Vec] which is never modified. Owned elements are reference-counted,
+/// so clones share the same storage.
+pub(crate) enum Array<T: Scalar> {
+    Owned(Arc<Vec<T>>),
+    Mapped {
+        map: Arc<Mmap>,
+        ptr: *const T,
+        len: usize,
+    },
+}
+
+// SAFETY: Mapped arrays are read-only views into a Send + Sync Mmap,
+// kept alive by the Arc.
+unsafe impl<T: Scalar + Send> Send for Array<T> {}
+unsafe impl<T: Scalar + Sync> Sync for Array<T> {}
+
+impl<T: Scalar> Array<T> {
+    /// Borrows `len` elements located at byte `offset` of the provided map.
+    ///
+    /// Only available on little-endian hosts, as elements are reinterpreted in place.
+    /// Panics if the elements are out of bounds or misaligned.
+    #[cfg(target_endian = "little")]
+    pub(crate) fn mapped(map: &Arc<Mmap>, offset: usize, len: usize) -> Self {
+        let bytes = &map.as_bytes()[offset..offset + len * T::SIZE];
+        let ptr = bytes.as_ptr() as *const T;
+        assert!(ptr.is_aligned(), "misaligned mapped array");
+        Self::Mapped {
+            map: Arc::clone(map),
+            ptr,
+            len,
+        }
+    }
+}
+
+impl<T: Scalar> Deref for Array<T> {
+    type Target = [T];
+
+    #[inline]
+    fn deref(&self) -> &[T] {
+        match self {
+            Self::Owned(v) => v,
+            // SAFETY: `ptr` was derived from an aligned, in-bounds range of the map,
+            // and all Scalar types are valid for any bit pattern.
+            Self::Mapped { ptr, len, .. } => unsafe { std::slice::from_raw_parts(*ptr, *len) },
+        }
+    }
+}
+
+impl<T: Scalar> Default for Array<T> {
+    fn default() -> Self {
+        Self::Owned(Arc::default())
+    }
+}
+
+impl<T: Scalar> Clone for Array<T> {
+    fn clone(&self) -> Self {
+        match self {
+            Self::Owned(v) => Self::Owned(Arc::clone(v)),
+            Self::Mapped { map, ptr, len } => Self::Mapped {
+                map: Arc::clone(map),
+                ptr: *ptr,
+                len: *len,
+            },
+        }
+    }
+}
+
+impl<T: Scalar + fmt::Debug> fmt::Debug for Array<T> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        fmt::Debug::fmt(&**self, f)
+    }
+}
+
+impl<T: Scalar + PartialEq> PartialEq for Array<T> {
+    fn eq(&self, other: &Self) -> bool {
+        **self == **other
+    }
+}
+
+impl<T: Scalar + PartialEq> PartialEq<Vec<T>> for Array<T> {
+    fn eq(&self, other: &Vec<T>) -> bool {
+        **self == **other
+    }
+}
+
+impl<T: Scalar> From<Vec<T>> for Array<T> {
+    fn from(v: Vec<T>) -> Self {
+        Self::Owned(Arc::new(v))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[cfg(all(unix, target_endian = "little"))]
+    #[test]
+    fn mapped() {
+        use std::io::Write;
+
+        let path = std::env::temp_dir().join(format!("routx-mmap-{}", std::process::id()));
+        let mut f = File::create(&path).unwrap();
+        f.write_all(&[0, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0]).unwrap();
+        drop(f);
+
+        // SAFETY: The temporary file is not modified while mapped
+        let map = Arc::new(unsafe { Mmap::map(&File::open(&path).unwrap()) }.unwrap());
+        std::fs::remove_file(&path).unwrap();
+
+        let a: Array<u32> = Array::mapped(&map, 4, 2);
+        drop(map);
+        assert_eq!(a, vec![1, 2]);
+        assert_eq!(a.clone(), Array::from(vec![1, 2]));
+    }
+}
@@ -0,0 +1,385 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+use std::collections::{HashMap, HashSet};
+
+use super::profile::{self, Profile, TurnRestriction};
+
+/// Tag keys with fixed meaning read by the matching functions of [Profile],
+/// regardless of its penalties and access modes.
+const FIXED_KEYS: &[&str] = &[
+    "except",
+    "highway",
+    "junction",
+    "motorroad",
+    "oneway",
+    "oneway:foot",
+    "public_transport",
+    "railway",
+    "restriction",
+    "restriction:foot",
+    "type",
+];
+
+/// [Profile] with precomputed tag lookups, see [Profile::compile].
+///
+/// Matching a way against a [Profile] scans all of its [Penalties](super::Penalty)
+/// and formats mode-specific tag keys (like `oneway:motorcar`) on every call.
+/// A compiled profile instead owns a hash table of penalties per tag key and
+/// all mode-specific keys, so that matching only performs a single lookup per distinct key.
+///
+/// Compiled profiles behave exactly the same as the profile they were compiled from,
+/// and can be shared by many loads of OSM data (see [add_features_from_file_compiled](super::add_features_from_file_compiled)).
+///
+/// Tag keys are matched against PBF string tables once per block (see [CompiledProfile::uses_key]),
+/// so tags irrelevant for routing are dropped by index, without building their strings.
+/// Tag values are not interned: all readers hand over tags as strings,
+/// and matching hashes each value of a kept key once.
+#[derive(Debug, Clone, PartialEq)]
+pub struct CompiledProfile {
+    /// Penalties grouped by tag key, with keys in order of their first appearance.
+    /// Every value maps to the position of its [Penalty](super::Penalty) in
+    /// [Profile::penalties] and the penalty itself.
+    penalties: Vec<(String, HashMap<String, (usize, f32)>)>,
+
+    /// [Profile::access], in order from the most to the least specific.
+    access: Vec<String>,
+
+    /// Set of [Profile::access] modes, for checking `except` tags.
+    access_set: HashSet<String>,
+
+    /// `oneway:MODE` keys followed by `oneway`, in order from the most to the least specific.
+    oneway_keys: Vec<String>,
+
+    /// `restriction:MODE` keys followed by `restriction`,
+    /// in order from the most to the least specific.
+    restriction_keys: Vec<String>,
+
+    disallow_motorroad: bool,
+    disable_restrictions: bool,
+
+    /// Profile name is "foot", see [Profile::name].
+    foot: bool,
+
+    /// All tag keys which can influence matching, see [CompiledProfile::uses_key].
+    keys: HashSet<String>,
+}
+
+impl CompiledProfile {
+    /// Compiles the provided [Profile]. Equivalent to [Profile::compile].
+    pub fn new(p: &Profile) -> Self {
+        let mut penalties: Vec<(String, HashMap<String, (usize, f32)>)> = Vec::default();
+        for (order, penalty) in p.penalties.iter().enumerate() {
+            let values = match penalties.iter_mut().find(|(key, _)| key == penalty.key) {
+                Some((_, values)) => values,
+                None => {
+                    penalties.push((penalty.key.to_string(), HashMap::default()));
+                    &mut penalties.last_mut().unwrap().1
+                }
+            };
+
+            // Only the first penalty with a given key and value can ever match
+            values
+                .entry(penalty.value.to_string())
+                .or_insert((order, penalty.penalty));
+        }
+
+        let modes = || p.access.iter().rev().filter(|&&mode| mode != "access");
+        let foot = p.name == "foot";
+        let (oneway_keys, restriction_keys) = if foot {
+            // foot profile exception - handled separately by foot_oneway_value,
+            // only "restriction:foot" is considered
+            (Vec::default(), vec!["restriction:foot".to_string()])
+        } else {
+            (
+                modes()
+                    .map(|mode| format!("oneway:{}", mode))
+                    .chain(std::iter::once("oneway".to_string()))
+                    .collect(),
+                modes()
+                    .map(|mode| format!("restriction:{}", mode))
+                    .chain(std::iter::once("restriction".to_string()))
+                    .collect(),
+            )
+        };
+
+        let keys = FIXED_KEYS
+            .iter()
+            .map(|&key| key.to_string())
+            .chain(penalties.iter().map(|(key, _)| key.clone()))
+            .chain(p.access.iter().map(|&mode| mode.to_string()))
+            .chain(oneway_keys.iter().cloned())
+            .chain(restriction_keys.iter().cloned())
+            .collect();
+
+        Self {
+            penalties,
+            access: p
+                .access
+                .iter()
+                .rev()
+                .map(|&mode| mode.to_string())
+                .collect(),
+            access_set: p.access.iter().map(|&mode| mode.to_string()).collect(),
+            oneway_keys,
+            restriction_keys,
+            disallow_motorroad: p.disallow_motorroad,
+            disable_restrictions: p.disable_restrictions,
+            foot,
+            keys,
+        }
+    }
+
+    /// Returns true if a tag with the provided key can influence any of the matching functions.
+    /// Other tags can be dropped from features before matching, without changing the results.
+    pub fn uses_key(&self, key: &str) -> bool {
+        self.keys.contains(key)
+    }
+
+    /// Finds the first matching penalty for a way with given tags,
+    /// see [Profile::way_penalty].
+    pub fn way_penalty(&self, tags: &HashMap<String, String>) -> f32 {
+        let penalty = self.get_penalty(tags);
+        if !penalty.is_normal() || !self.is_allowed(tags) {
+            return f32::INFINITY;
+        }
+        return penalty;
+    }
+
+    /// Returns the first matching penalty from way tags, or [f32::INFINITY] otherwise.
+    fn get_penalty(&self, tags: &HashMap<String, String>) -> f32 {
+        self.penalties
+            .iter()
+            .filter_map(|(key, values)| values.get(tags.get(key)?))
+            .min_by_key(|&&(order, _)| order)
+            .map_or(f32::INFINITY, |&(_, penalty)| penalty)
+    }
+
+    /// Checks if the way is routable, see [Profile::is_allowed].
+    pub fn is_allowed(&self, tags: &HashMap<String, String>) -> bool {
+        // Check against the motorroad tag
+        if self.disallow_motorroad && tags.get("motorroad").map(|v| v.as_str()) == Some("yes") {
+            return false;
+        }
+
+        // Check against the access tags
+        profile::is_access_allowed(
+            self.access
+                .iter()
+                .find_map(|mode| tags.get(mode).map(|v| v.as_str())),
+        )
+    }
+
+    /// Checks if a way is traversable forward (first return value) and
+    /// backwards (second return value), see [Profile::way_direction].
+    pub fn way_direction(&self, tags: &HashMap<String, String>) -> (bool, bool) {
+        let oneway = if self.foot {
+            profile::foot_oneway_value(tags)
+        } else {
+            self.first_value(&self.oneway_keys, tags)
+        };
+        profile::way_direction(self.foot, tags, oneway)
+    }
+
+    /// Figures out what kind of [TurnRestriction] a relation with given tags represents,
+    /// see [Profile::restriction_kind].
+    pub fn restriction_kind(&self, tags: &HashMap<String, String>) -> TurnRestriction {
+        if self.disable_restrictions
+            || tags.get("type").map(|v| v.as_str()) != Some("restriction")
+            || self.is_exempted(tags)
+        {
+            return TurnRestriction::Inapplicable;
+        }
+
+        profile::restriction_kind(self.first_value(&self.restriction_keys, tags))
+    }
+
+    /// Returns true if any access mode of the profile is present in the `except` tag,
+    /// see [Profile::is_exempted].
+    pub fn is_exempted(&self, tags: &HashMap<String, String>) -> bool {
+        tags.get("except")
+            .map_or("", |v| v.as_str())
+            .split(';')
+            .any(|exempted_type| self.access_set.contains(exempted_type))
+    }
+
+    /// Returns the value of the first present tag out of `keys`, or an empty string.
+    fn first_value<'t>(&self, keys: &[String], tags: &'t HashMap<String, String>) -> &'t str {
+        keys.iter()
+            .find_map(|key| tags.get(key))
+            .map_or("", |v| v.as_str())
+    }
+}
+
+impl From<&Profile<'_>> for CompiledProfile {
+    fn from(p: &Profile) -> Self {
+        Self::new(p)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::osm::{
+        Penalty, BICYCLE_PROFILE, BUS_PROFILE, CAR_PROFILE, FOOT_PROFILE, RAILWAY_PROFILE,
+        SUBWAY_PROFILE, TRAM_PROFILE,
+    };
+
+    macro_rules! tags {
+        ($($k:expr => $v:expr),* $(,)?) => {
+            HashMap::from_iter([$(($k.to_string(), $v.to_string())),*])
+        };
+    }
+
+    #[test]
+    fn matches_profile() {
+        const OVERLAPPING_PROFILE: Profile = Profile {
+            name: "bus",
+            penalties: &[
+                Penalty {
+                    key: "highway",
+                    value: "primary",
+                    penalty: 2.0,
+                },
+                Penalty {
+                    key: "railway",
+                    value: "tram",
+                    penalty: 3.0,
+                },
+                Penalty {
+                    key: "highway",
+                    value: "service",
+                    penalty: 4.0,
+                },
+                Penalty {
+                    key: "highway",
+                    value: "primary",
+                    penalty: 5.0,
+                },
+            ],
+            access: &["access", "vehicle", "bus"],
+            disallow_motorroad: true,
+            disable_restrictions: false,
+        };
+
+        let cases: Vec<HashMap<String, String>> = vec![
+            tags! {},
+            tags! {"highway" => "primary", "name" => "Main Street", "surface" => "asphalt"},
+            tags! {"highway" => "service", "railway" => "tram"},
+            tags! {"highway" => "primary", "railway" => "tram"},
+            tags! {"highway" => "motorway", "motorroad" => "yes"},
+            tags! {"highway" => "residential", "access" => "no", "bus" => "yes"},
+            tags! {"highway" => "residential", "vehicle" => "private"},
+            tags! {"highway" => "footway", "oneway" => "yes"},
+            tags! {"highway" => "footway", "oneway" => "yes", "oneway:foot" => "no"},
+            tags! {"highway" => "primary", "oneway" => "yes", "oneway:bus" => "no"},
+            tags! {"highway" => "primary", "oneway" => "-1", "oneway:bicycle" => "no"},
+            tags! {"highway" => "motorway_link"},
+            tags! {"junction" => "roundabout", "oneway:motorcar" => "no"},
+            tags! {"railway" => "rail", "oneway:train" => "yes"},
+            tags! {"type" => "restriction", "restriction" => "no_left_turn", "ref" => "1"},
+            tags! {"type" => "restriction", "restriction" => "only_straight_on", "except" => "bus"},
+            tags! {"type" => "restriction", "restriction:foot" => "no_u_turn"},
+            tags! {"type" => "restriction", "restriction:bus" => "only_right_turn"},
+            tags! {"type" => "restriction", "restriction:motorcar" => "no_entry"},
+        ];
+
+        for p in [
+            &CAR_PROFILE,
+            &BUS_PROFILE,
+            &BICYCLE_PROFILE,
+            &FOOT_PROFILE,
+            &RAILWAY_PROFILE,
+            &TRAM_PROFILE,
+            &SUBWAY_PROFILE,
+            &OVERLAPPING_PROFILE,
+        ] {
+            let c = p.compile();
+            for tags in &cases {
+                let used_tags: HashMap<String, String> = tags
+                    .iter()
+                    .filter(|(k, _)| c.uses_key(k))
+                    .map(|(k, v)| (k.clone(), v.clone()))
+                    .collect();
+                assert_eq!(c.way_penalty(&used_tags), p.way_penalty(tags));
+                assert_eq!(c.way_direction(&used_tags), p.way_direction(tags));
+                assert_eq!(c.restriction_kind(&used_tags), p.restriction_kind(tags));
+
+                assert_eq!(
+                    c.way_penalty(tags),
+                    p.way_penalty(tags),
+                    "{} {:?}",
+                    p.name,
+                    tags
+                );
+                assert_eq!(
+                    c.is_allowed(tags),
+                    p.is_allowed(tags),
+                    "{} {:?}",
+                    p.name,
+                    tags
+                );
+                assert_eq!(
+                    c.way_direction(tags),
+                    p.way_direction(tags),
+                    "{} {:?}",
+                    p.name,
+                    tags
+                );
+                assert_eq!(
+                    c.is_exempted(tags),
+                    p.is_exempted(tags),
+                    "{} {:?}",
+                    p.name,
+                    tags
+                );
+                assert_eq!(
+                    c.restriction_kind(tags),
+                    p.restriction_kind(tags),
+                    "{} {:?}",
+                    p.name,
+                    tags,
+                );
+            }
+        }
+    }
+
+    #[test]
+    fn first_penalty_wins() {
+        let c = CompiledProfile::new(&Profile {
+            name: "test",
+            penalties: &[
+                Penalty {
+                    key: "railway",
+                    value: "tram",
+                    penalty: 3.0,
+                },
+                Penalty {
+                    key: "highway",
+                    value: "primary",
+                    penalty: 2.0,
+                },
+                Penalty {
+                    key: "railway",
+                    value: "tram",
+                    penalty: 5.0,
+                },
+            ],
+            access: &[],
+            disallow_motorroad: false,
+            disable_restrictions: false,
+        });
+
+        assert_eq!(c.way_penalty(&tags! {"railway" => "tram"}), 3.0);
+        assert_eq!(c.way_penalty(&tags! {"highway" => "primary"}), 2.0);
+        assert_eq!(
+            c.way_penalty(&tags! {"highway" => "primary", "railway" => "tram"}),
+            3.0
+        );
+        assert_eq!(c.way_penalty(&tags! {"highway" => "trunk"}), f32::INFINITY);
+
+        assert!(c.uses_key("railway"));
+        assert!(c.uses_key("oneway"));
+        assert!(!c.uses_key("name"));
+    }
+}
@@ -18,16 +18,20 @@
 //! - [access](https://wiki.openstreetmap.org/wiki/Key:access) tags on nodes ([barriers](https://wiki.openstreetmap.org/wiki/Key:barrier)),
 //! - [conditional (especially time-based) restrictions](https://wiki.openstreetmap.org/wiki/Conditional_restrictions).
 
+mod compiled;
 mod profile;
 mod reader;
 
+pub use compiled::CompiledProfile;
 pub use profile::{
     Penalty, Profile, TurnRestriction, BICYCLE_PROFILE, BUS_PROFILE, CAR_PROFILE, FOOT_PROFILE,
     RAILWAY_PROFILE, SUBWAY_PROFILE, TRAM_PROFILE,
 };
 pub use reader::{
-    add_features_from_buffer, add_features_from_file, add_features_from_io, Error, FileFormat,
-    Options,
+    add_features_from_buffer, add_features_from_buffer_compiled, add_features_from_file,
+    add_features_from_file_compiled, add_features_from_file_two_pass,
+    add_features_from_file_two_pass_compiled, add_features_from_io, add_features_from_io_compiled,
+    ingest_stats, Error, FileFormat, IngestStats, Options,
 };
 
 // Expose reader::pbf::Error
@@ -152,6 +156,7 @@ mod tests {
                 profile: &CAR_PROFILE,
                 file_format: FileFormat::Xml,
                 bbox: [0.0; 4],
+                threads: 0,
             };
             add_features_from_buffer(&mut g, &options, DATA).unwrap();
             g
@@ -170,6 +175,7 @@ mod tests {
                 profile: &CAR_PROFILE,
                 file_format: FileFormat::Unknown,
                 bbox: [0.0; 4],
+                threads: 0,
             };
             add_features_from_buffer(&mut g, &options, DATA).unwrap();
             g
@@ -188,6 +194,7 @@ mod tests {
                 profile: &CAR_PROFILE,
                 file_format: FileFormat::XmlGz,
                 bbox: [0.0; 4],
+                threads: 0,
             };
             add_features_from_buffer(&mut g, &options, DATA).unwrap();
             g
@@ -206,6 +213,7 @@ mod tests {
                 profile: &CAR_PROFILE,
                 file_format: FileFormat::Unknown,
                 bbox: [0.0; 4],
+                threads: 0,
             };
             add_features_from_buffer(&mut g, &options, DATA).unwrap();
             g
@@ -224,6 +232,7 @@ mod tests {
                 profile: &CAR_PROFILE,
                 file_format: FileFormat::XmlBz2,
                 bbox: [0.0; 4],
+                threads: 0,
             };
             add_features_from_buffer(&mut g, &options, DATA).unwrap();
             g
@@ -242,6 +251,7 @@ mod tests {
                 profile: &CAR_PROFILE,
                 file_format: FileFormat::Unknown,
                 bbox: [0.0; 4],
+                threads: 0,
             };
             add_features_from_buffer(&mut g, &options, DATA).unwrap();
             g
@@ -260,6 +270,7 @@ mod tests {
                 profile: &CAR_PROFILE,
                 file_format: FileFormat::Pbf,
                 bbox: [0.0; 4],
+                threads: 0,
             };
             add_features_from_buffer(&mut g, &options, DATA).unwrap();
             g
@@ -278,6 +289,7 @@ mod tests {
                 profile: &CAR_PROFILE,
                 file_format: FileFormat::Unknown,
                 bbox: [0.0; 4],
+                threads: 0,
             };
             add_features_from_buffer(&mut g, &options, DATA).unwrap();
             g
@@ -285,4 +297,111 @@ mod tests {
 
         check_simple_graph(&g);
     }
+
+    #[test]
+    fn test_build_graph_pbf_single_threaded_round_trip() {
+        const DATA: &[u8] = include_bytes!("reader/test_fixtures/simple.osm.pbf");
+
+        let g = {
+            let mut g = Graph::default();
+            let options = Options {
+                profile: &CAR_PROFILE,
+                file_format: FileFormat::Pbf,
+                bbox: [0.0; 4],
+                threads: 1,
+            };
+            add_features_from_buffer(&mut g, &options, DATA).unwrap();
+            g
+        };
+
+        check_simple_graph(&g);
+    }
+
+    #[test]
+    fn test_build_graph_parallel_ways() {
+        const XML: &[u8] = include_bytes!("reader/test_fixtures/simple.osm");
+        const PBF: &[u8] = include_bytes!("reader/test_fixtures/simple.osm.pbf");
+
+        for data in [XML, PBF] {
+            let [sequential, parallel] = [1, 4].map(|threads| {
+                let mut g = Graph::default();
+                let options = Options {
+                    profile: &CAR_PROFILE,
+                    file_format: FileFormat::Unknown,
+                    bbox: [0.0; 4],
+                    threads,
+                };
+                add_features_from_buffer(&mut g, &options, data).unwrap();
+                g
+            });
+
+            check_simple_graph(&parallel);
+            assert_eq!(sequential, parallel);
+        }
+    }
+
+    #[test]
+    fn test_build_graph_two_pass_round_trip() {
+        for (name, threads) in [
+            ("simple.osm", 0),
+            ("simple.osm.gz", 0),
+            ("simple.osm.pbf", 1),
+            ("simple.osm.pbf", 4),
+        ] {
+            let mut g = Graph::default();
+            let options = Options {
+                profile: &CAR_PROFILE,
+                file_format: FileFormat::Unknown,
+                bbox: [0.0; 4],
+                threads,
+            };
+            let path = format!(
+                "{}/src/osm/reader/test_fixtures/{}",
+                env!("CARGO_MANIFEST_DIR"),
+                name,
+            );
+            add_features_from_file_two_pass(&mut g, &options, path).unwrap();
+            check_simple_graph(&g);
+        }
+    }
+
+    #[test]
+    fn test_ingest_stats() {
+        const DATA: &[u8] = include_bytes!("reader/test_fixtures/simple.osm.gz");
+
+        // Other tests may read files concurrently, so only lower bounds can be checked
+        let before = ingest_stats();
+        let mut g = Graph::default();
+        let options = Options {
+            profile: &CAR_PROFILE,
+            file_format: FileFormat::XmlGz,
+            bbox: [0.0; 4],
+            threads: 0,
+        };
+        add_features_from_buffer(&mut g, &options, DATA).unwrap();
+        let after = ingest_stats();
+
+        assert!(after.nodes >= before.nodes + 12);
+        assert!(after.ways >= before.ways + 12);
+        assert!(after.relations >= before.relations + 3);
+        assert!(after.restrictions_applied >= before.restrictions_applied + 2);
+        assert!(after.bytes_decompressed >= before.bytes_decompressed + 3965);
+    }
+
+    #[test]
+    fn test_build_graph_pbf_truncated() {
+        const DATA: &[u8] = include_bytes!("reader/test_fixtures/simple.osm.pbf");
+
+        for threads in [1, 4] {
+            let mut g = Graph::default();
+            let options = Options {
+                profile: &CAR_PROFILE,
+                file_format: FileFormat::Pbf,
+                bbox: [0.0; 4],
+                threads,
+            };
+            let err = add_features_from_buffer(&mut g, &options, &DATA[..DATA.len() - 10]);
+            assert!(matches!(err, Err(Error::Io(_))), "{:?}", err);
+        }
+    }
 }
@@ -3,6 +3,8 @@
 
 use std::collections::HashMap;
 
+use super::CompiledProfile;
+
 /// Describes how to convert OSM data into a [Graph](crate::Graph).
 #[derive(Debug, Clone, Copy, PartialEq)]
 pub struct Profile<'a> {
@@ -121,15 +123,12 @@ impl<'a> Profile<'a> {
         }
 
         // Check against the access tags
-        match self
-            .access
-            .iter()
-            .rev()
-            .find_map(|&mode| tags.get(mode).map(|v| v.as_str()))
-        {
-            Some("no") | Some("private") => false,
-            _ => true,
-        }
+        is_access_allowed(
+            self.access
+                .iter()
+                .rev()
+                .find_map(|&mode| tags.get(mode).map(|v| v.as_str())),
+        )
     }
 
     /// Checks if a way is traversable forward (first return value) and
@@ -138,47 +137,11 @@ impl<'a> Profile<'a> {
     /// Some ways (highway=motorway, highway=motorway_link, junction=roundabout and
     /// junction=circular) default to being one-way, except if overridden by specific tags.
     pub fn way_direction(&self, tags: &HashMap<String, String>) -> (bool, bool) {
-        let mut forward = true;
-        let mut backward = true;
-
-        // Default one-way ways (foot profile exception - does not apply)
-        if !self.apply_foot_exceptions() {
-            match tags.get("highway").map(|s| s.as_str()).unwrap_or("") {
-                "motorway" | "motorway_link" => {
-                    backward = false;
-                }
-                _ => {}
-            }
-
-            match tags.get("junction").map(|s| s.as_str()).unwrap_or("") {
-                "roundabout" | "circular" => {
-                    backward = false;
-                }
-                _ => {}
-            }
-        }
-
-        // Check the oneway tag
-        match self.get_active_oneway_value(tags) {
-            "yes" | "true" | "1" => {
-                forward = true;
-                backward = false;
-            }
-
-            "-1" | "reverse" => {
-                forward = false;
-                backward = true;
-            }
-
-            "no" => {
-                forward = true;
-                backward = true;
-            }
-
-            _ => {}
-        }
-
-        return (forward, backward);
+        way_direction(
+            self.apply_foot_exceptions(),
+            tags,
+            self.get_active_oneway_value(tags),
+        )
     }
 
     /// Returns the value of the most specific "oneway:MODE" tag (based on [Profile::access]),
@@ -186,17 +149,7 @@ impl<'a> Profile<'a> {
     fn get_active_oneway_value<'t>(&self, tags: &'t HashMap<String, String>) -> &'t str {
         if self.apply_foot_exceptions() {
             // foot profile exception - only consider "oneway:foot" and "oneway" in select cases
-            if let Some(oneway_foot) = tags.get("oneway:foot") {
-                return oneway_foot.as_str();
-            }
-
-            if Self::allow_generic_oneway_to_apply_on_foot(tags) {
-                if let Some(oneway) = tags.get("oneway") {
-                    return oneway.as_str();
-                }
-            }
-
-            return "";
+            foot_oneway_value(tags)
         } else {
             self.access
                 .iter()
@@ -209,30 +162,6 @@ impl<'a> Profile<'a> {
         }
     }
 
-    fn allow_generic_oneway_to_apply_on_foot(tags: &HashMap<String, String>) -> bool {
-        // By default, on foot, only "oneway:foot" is considered. However, on the following
-        // ways the generic "oneway" tag also applies.
-
-        // highway=footway, highway=path, highway=steps, highway=platform
-        match tags.get("highway").map(|v| v.as_str()) {
-            Some("footway") | Some("path") | Some("steps") | Some("platform") => return true,
-            _ => {}
-        }
-
-        // public_transport=platform
-        if tags.get("public_transport").map(|v| v.as_str()) == Some("platform") {
-            return true;
-        }
-
-        // railway=platform
-        if tags.get("railway").map(|v| v.as_str()) == Some("platform") {
-            return true;
-        }
-
-        // Default to false
-        return false;
-    }
-
     /// Figures out what kind of [TurnRestriction] a relation with given tags represents.
     pub fn restriction_kind(&self, tags: &HashMap<String, String>) -> TurnRestriction {
         // Short-circuit when restrictions are disabled,
@@ -245,23 +174,7 @@ impl<'a> Profile<'a> {
         }
 
         // Parse the restriction tag
-        let (kind, description) = self
-            .get_active_restriction_tag(tags)
-            .split_once('_')
-            .unwrap_or(("", ""));
-
-        // Check that the description is supported
-        match description {
-            "right_turn" | "left_turn" | "u_turn" | "straight_on" => {}
-            _ => return TurnRestriction::Inapplicable,
-        }
-
-        // Return the applicable restriction kind
-        return match kind {
-            "no" => TurnRestriction::Prohibitory,
-            "only" => TurnRestriction::Mandatory,
-            _ => TurnRestriction::Inapplicable,
-        };
+        restriction_kind(self.get_active_restriction_tag(tags))
     }
 
     /// Returns true if [Profile::access] intersects with any mode present in the `except` tag.
@@ -297,6 +210,129 @@ impl<'a> Profile<'a> {
     fn apply_foot_exceptions(&self) -> bool {
         self.name == "foot"
     }
+
+    /// Precomputes the tag lookups of this profile into a [CompiledProfile],
+    /// which can be reused across multiple loads of OSM data.
+    pub fn compile(&self) -> CompiledProfile {
+        CompiledProfile::new(self)
+    }
+}
+
+/// Checks the value of the most specific access tag present on a way.
+pub(super) fn is_access_allowed(value: Option<&str>) -> bool {
+    match value {
+        Some("no") | Some("private") => false,
+        _ => true,
+    }
+}
+
+/// Checks if a way is traversable forward and backwards, given the value of the
+/// most specific relevant oneway tag. See [Profile::way_direction].
+pub(super) fn way_direction(
+    foot: bool,
+    tags: &HashMap<String, String>,
+    oneway: &str,
+) -> (bool, bool) {
+    let mut forward = true;
+    let mut backward = true;
+
+    // Default one-way ways (foot profile exception - does not apply)
+    if !foot {
+        match tags.get("highway").map(|s| s.as_str()).unwrap_or("") {
+            "motorway" | "motorway_link" => {
+                backward = false;
+            }
+            _ => {}
+        }
+
+        match tags.get("junction").map(|s| s.as_str()).unwrap_or("") {
+            "roundabout" | "circular" => {
+                backward = false;
+            }
+            _ => {}
+        }
+    }
+
+    // Check the oneway tag
+    match oneway {
+        "yes" | "true" | "1" => {
+            forward = true;
+            backward = false;
+        }
+
+        "-1" | "reverse" => {
+            forward = false;
+            backward = true;
+        }
+
+        "no" => {
+            forward = true;
+            backward = true;
+        }
+
+        _ => {}
+    }
+
+    return (forward, backward);
+}
+
+/// Returns the value of the oneway tag relevant for the foot profile - only "oneway:foot",
+/// or "oneway" in select cases - or an empty string if no relevant tag was found.
+pub(super) fn foot_oneway_value(tags: &HashMap<String, String>) -> &str {
+    if let Some(oneway_foot) = tags.get("oneway:foot") {
+        return oneway_foot.as_str();
+    }
+
+    if allow_generic_oneway_to_apply_on_foot(tags) {
+        if let Some(oneway) = tags.get("oneway") {
+            return oneway.as_str();
+        }
+    }
+
+    return "";
+}
+
+fn allow_generic_oneway_to_apply_on_foot(tags: &HashMap<String, String>) -> bool {
+    // By default, on foot, only "oneway:foot" is considered. However, on the following
+    // ways the generic "oneway" tag also applies.
+
+    // highway=footway, highway=path, highway=steps, highway=platform
+    match tags.get("highway").map(|v| v.as_str()) {
+        Some("footway") | Some("path") | Some("steps") | Some("platform") => return true,
+        _ => {}
+    }
+
+    // public_transport=platform
+    if tags.get("public_transport").map(|v| v.as_str()) == Some("platform") {
+        return true;
+    }
+
+    // railway=platform
+    if tags.get("railway").map(|v| v.as_str()) == Some("platform") {
+        return true;
+    }
+
+    // Default to false
+    return false;
+}
+
+/// Parses the value of the most specific relevant restriction tag
+/// (like `no_left_turn`) into a [TurnRestriction].
+pub(super) fn restriction_kind(restriction: &str) -> TurnRestriction {
+    let (kind, description) = restriction.split_once('_').unwrap_or(("", ""));
+
+    // Check that the description is supported
+    match description {
+        "right_turn" | "left_turn" | "u_turn" | "straight_on" => {}
+        _ => return TurnRestriction::Inapplicable,
+    }
+
+    // Return the applicable restriction kind
+    return match kind {
+        "no" => TurnRestriction::Prohibitory,
+        "only" => TurnRestriction::Mandatory,
+        _ => TurnRestriction::Inapplicable,
+    };
 }
 
 /// Example routing [Profile] for cars, with high preference for faster roads
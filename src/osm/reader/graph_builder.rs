@@ -1,53 +1,111 @@
 // (c) Copyright 2025 Mikołaj Kuranowski
 // SPDX-License-Identifier: MIT
 
+use std::borrow::Cow;
 use std::collections::{HashMap, HashSet};
 
 use crate::osm::profile::TurnRestriction;
 use crate::osm::reader::FeatureReader;
+use crate::osm::CompiledProfile;
+use crate::parallel;
 use crate::{earth_distance, Edge, Graph, Node};
 
 use super::model::FeatureType;
+use super::stats::{self, IngestStats};
 use super::{model, Options};
 
 const MAX_NODE_ID: i64 = 0x0008_0000_0000_0000;
 
+/// Number of ways buffered before their edges are computed in parallel.
+const WAY_BATCH_SIZE: usize = 8192;
+
 /// Helper object used for storing state related to converting [OSM features](super::model::Feature)
 /// into a [Graph].
 pub(super) struct GraphBuilder<'a> {
     g: &'a mut Graph,
     options: &'a Options<'a>,
+
+    /// Profile explicitly provided to [GraphBuilder::with_profile],
+    /// or compiled [Options::profile] in tests.
+    profile: Cow<'a, CompiledProfile>,
+
     phantom_node_id_counter: i64,
     unused_nodes: HashSet<i64>,
     way_nodes: HashMap<i64, Vec<i64>>,
     ignore_bbox: bool,
+
+    /// Sorted ids of nodes to add, see [GraphBuilder::with_required_nodes].
+    required_nodes: Option<&'a [i64]>,
+
+    /// Number of threads computing edges of ways; ways are only buffered
+    /// in [GraphBuilder::pending_ways] if greater than one.
+    threads: usize,
+
+    /// Ways which edges are yet to be added to the graph, see [GraphBuilder::flush_ways].
+    pending_ways: Vec<model::Way>,
+
+    /// Counters published to the process-wide [IngestStats] once all features are added.
+    stats: IngestStats,
 }
 
 impl<'a> GraphBuilder<'a> {
-    /// Create a new, empty graph builder.
+    /// Create a new, empty graph builder, compiling [Options::profile].
+    #[cfg(test)]
     pub(super) fn new(g: &'a mut Graph, options: &'a Options<'a>) -> Self {
+        Self::with_cow_profile(g, options, Cow::Owned(options.profile.compile()))
+    }
+
+    /// Create a new, empty graph builder with an already compiled profile,
+    /// which takes precedence over [Options::profile].
+    pub(super) fn with_profile(
+        g: &'a mut Graph,
+        options: &'a Options<'a>,
+        profile: &'a CompiledProfile,
+    ) -> Self {
+        Self::with_cow_profile(g, options, Cow::Borrowed(profile))
+    }
+
+    fn with_cow_profile(
+        g: &'a mut Graph,
+        options: &'a Options<'a>,
+        profile: Cow<'a, CompiledProfile>,
+    ) -> Self {
         // Start adding phantom nodes at MAX_NODE_ID,
         // or the max node ID from the graph (in case phantom nodes were already added).
-        let phantom_node_id_counter =
-            MAX_NODE_ID.max(g.0.iter().map(|(&node_id, _)| node_id).max().unwrap_or(0));
+        let phantom_node_id_counter = MAX_NODE_ID.max(g.nodes().keys().copied().max().unwrap_or(0));
 
         let ignore_bbox = !is_bbox_applicable(options.bbox);
 
         Self {
             g,
             options,
+            profile,
             phantom_node_id_counter,
             unused_nodes: HashSet::default(),
             way_nodes: HashMap::default(),
             ignore_bbox,
+            required_nodes: None,
+            threads: parallel::effective_threads(options.threads, usize::MAX),
+            pending_ways: Vec::default(),
+            stats: IngestStats::default(),
         }
     }
 
+    /// Only add nodes from the provided sorted list of ids (see [RoutableNodes]),
+    /// ignoring all other nodes instead of adding them and removing them in cleanup.
+    pub(super) fn with_required_nodes(mut self, nodes: &'a [i64]) -> Self {
+        self.required_nodes = Some(nodes);
+        self
+    }
+
     /// Add all features from the provided [FeatureReader].
     pub(super) fn add_features<F: FeatureReader>(&mut self, features: F) -> Result<(), F::Error> {
-        for f in features {
-            self.add_feature(f?);
-        }
+        let result = features
+            .into_iter()
+            .try_for_each(|f| f.map(|f| self.add_feature(f)));
+        self.flush_ways();
+        stats::publish(&std::mem::take(&mut self.stats));
+        result?;
         self.cleanup();
         Ok(())
     }
@@ -60,9 +118,72 @@ impl<'a> GraphBuilder<'a> {
 
     fn add_feature(&mut self, f: model::Feature) {
         match f {
-            model::Feature::Node(n) => self.add_node(n),
-            model::Feature::Way(w) => self.add_way(w),
-            model::Feature::Relation(r) => self.add_relation(r),
+            model::Feature::Node(n) => {
+                self.stats.nodes += 1;
+                self.flush_ways();
+                self.add_node(n)
+            }
+            model::Feature::Way(w) if self.threads > 1 => {
+                self.stats.ways += 1;
+                self.pending_ways.push(w);
+                if self.pending_ways.len() >= WAY_BATCH_SIZE {
+                    self.flush_ways();
+                }
+            }
+            model::Feature::Way(w) => {
+                self.stats.ways += 1;
+                self.add_way(w)
+            }
+            model::Feature::Relation(r) => {
+                self.stats.relations += 1;
+                self.flush_ways();
+                self.add_relation(r)
+            }
+        }
+    }
+
+    /// Adds all [pending ways](GraphBuilder::pending_ways) to the graph. Penalties, directions
+    /// and edge costs are computed in parallel, while the edges are merged into the graph serially,
+    /// in the order of ways. The results are thus exactly the same as of [GraphBuilder::add_way].
+    ///
+    /// Must be called before any other feature is added, as ways depend on previously added
+    /// nodes, and relations on previously added ways.
+    fn flush_ways(&mut self) {
+        if self.pending_ways.is_empty() {
+            return;
+        }
+
+        let ways = std::mem::take(&mut self.pending_ways);
+        let prepared = parallel::map(&ways, self.threads, || (), |_, w| self.prepare_way(w));
+        self.pending_ways = ways;
+        self.pending_ways.clear();
+
+        // Stable sort by the start node, so that edges from the same node are added with
+        // a single lookup, and that later ways still override earlier ones
+        let mut edges: Vec<(i64, Edge)> = prepared
+            .iter()
+            .flatten()
+            .flat_map(|p| p.edges.iter().copied())
+            .collect();
+        edges.sort_by_key(|&(from, _)| from);
+
+        // Edges are added directly to the map, bypassing Graph::set_edge,
+        // but Graph::nodes_mut still advances the epoch
+        let nodes = self.g.nodes_mut();
+        for group in edges.chunk_by(|a, b| a.0 == b.0) {
+            let (_, existing) = nodes
+                .get_mut(&group[0].0)
+                .expect("prepare_way should only return edges between existing nodes");
+            for &(_, edge) in group {
+                match existing.iter_mut().find(|e| e.to == edge.to) {
+                    Some(e) => *e = edge,
+                    None => existing.push(edge),
+                }
+            }
+        }
+
+        for p in prepared.into_iter().flatten() {
+            self.update_state_after_adding_way(p.id, p.nodes);
         }
     }
 
@@ -74,6 +195,13 @@ impl<'a> GraphBuilder<'a> {
             return;
         }
 
+        // Node not referenced by any routable way - ignore
+        if let Some(required) = self.required_nodes {
+            if required.binary_search(&n.id).is_err() {
+                return;
+            }
+        }
+
         // Node id invalid - ignore & warn
         if !Self::is_valid_node_id(n.id) {
             log::warn!(target: "routx::osm", "node with invalid id {} - ignoring", n.id);
@@ -103,34 +231,38 @@ impl<'a> GraphBuilder<'a> {
     }
 
     fn add_way(&mut self, w: model::Way) {
+        if let Some(p) = self.prepare_way(&w) {
+            p.edges
+                .iter()
+                .for_each(|&(from, edge)| _ = self.g.set_edge(from, edge));
+            self.update_state_after_adding_way(p.id, p.nodes);
+        }
+    }
+
+    /// Computes the edges created by a way, without modifying the graph.
+    /// Returns [None] if the way is not routable.
+    fn prepare_way(&self, w: &model::Way) -> Option<PreparedWay> {
         let penalty = self.get_way_penalty(&w);
         if penalty.is_infinite() {
-            return;
+            return None;
         }
 
         let nodes = self.get_way_nodes(&w);
         if nodes.is_empty() {
-            return;
+            return None;
         }
 
-        let (forward, backward) = self.options.profile.way_direction(&w.tags);
+        let (forward, backward) = self.profile.way_direction(&w.tags);
 
-        self.create_edges(&nodes, penalty, forward, backward);
-        self.update_state_after_adding_way(w.id, nodes);
+        Some(PreparedWay {
+            id: w.id,
+            edges: self.create_edges(&nodes, penalty, forward, backward),
+            nodes,
+        })
     }
 
-    /// Gets the [penalty](crate::osm::profile::Penalty) applicable for the provided
-    /// way and validates it. Returns [f32::INFINITY] or a valid (>= 1) penalty value.
     fn get_way_penalty(&self, w: &model::Way) -> f32 {
-        let penalty = self.options.profile.way_penalty(&w.tags);
-        if !penalty.is_finite() {
-            f32::INFINITY // Way not routable
-        } else if penalty < 1.0 {
-            log::error!(target: "routx", "profile has invalid penalty {} - assuming non-routable", penalty);
-            f32::INFINITY
-        } else {
-            penalty
-        }
+        get_way_penalty(&self.profile, w)
     }
 
     fn get_way_nodes(&self, w: &model::Way) -> Vec<i64> {
@@ -157,12 +289,20 @@ impl<'a> GraphBuilder<'a> {
         }
     }
 
-    fn create_edges(&mut self, nodes: &[i64], penalty: f32, forward: bool, backward: bool) {
+    fn create_edges(
+        &self,
+        nodes: &[i64],
+        penalty: f32,
+        forward: bool,
+        backward: bool,
+    ) -> Vec<(i64, Edge)> {
         debug_assert!(nodes.len() >= 2);
         debug_assert!(penalty.is_finite() && penalty >= 1.0);
         debug_assert!(forward || backward);
 
-        nodes.windows(2).for_each(|pair| {
+        let mut edges =
+            Vec::with_capacity((nodes.len() - 1) * (forward as usize + backward as usize));
+        for pair in nodes.windows(2) {
             let left = self
                 .g
                 .get_node(pair[0])
@@ -173,15 +313,18 @@ impl<'a> GraphBuilder<'a> {
                 .get_node(pair[1])
                 .expect("get_way_nodes should only return nodes which exist");
 
+            // NOTE: Costs use the exact earth_distance, which is also the A* heuristic,
+            //       so that the heuristic remains consistent.
             let cost = penalty * earth_distance(left.lat, left.lon, right.lat, right.lon);
 
             if forward {
-                self.g.set_edge(left.id, Edge { to: right.id, cost });
+                edges.push((pair[0], Edge { to: pair[1], cost }));
             }
             if backward {
-                self.g.set_edge(right.id, Edge { to: left.id, cost });
+                edges.push((pair[1], Edge { to: pair[0], cost }));
             }
-        });
+        }
+        edges
     }
 
     fn update_state_after_adding_way(&mut self, way_id: i64, nodes: Vec<i64>) {
@@ -194,12 +337,15 @@ impl<'a> GraphBuilder<'a> {
     fn add_relation(&mut self, r: model::Relation) {
         match self.add_relation_inner(&r) {
             Ok(()) => {}
-            Err(e) => e.log(r.id),
+            Err(e) => {
+                self.stats.restrictions_rejected += 1;
+                e.log(r.id)
+            }
         }
     }
 
     fn add_relation_inner(&mut self, r: &model::Relation) -> Result<(), InvalidRestriction> {
-        let kind = self.options.profile.restriction_kind(&r.tags);
+        let kind = self.profile.restriction_kind(&r.tags);
         if kind == TurnRestriction::Inapplicable {
             return Ok(());
         }
@@ -371,7 +517,9 @@ impl<'a> GraphBuilder<'a> {
         let cloned_nodes = if let Some(n) = change.restriction_as_cloned_nodes(self.g, nodes) {
             n
         } else {
-            return Ok(()); // failed to apply the restriction - discard it
+            // failed to apply the restriction - discard it
+            self.stats.restrictions_rejected += 1;
+            return Ok(());
         };
 
         match kind {
@@ -392,6 +540,7 @@ impl<'a> GraphBuilder<'a> {
         }
 
         change.apply(self);
+        self.stats.restrictions_applied += 1;
         return Ok(());
     }
 }
@@ -602,6 +751,80 @@ impl GraphChange {
     }
 }
 
+/// Edges of a routable way, computed by [GraphBuilder::prepare_way].
+struct PreparedWay {
+    id: i64,
+    nodes: Vec<i64>,
+
+    /// Start node id and the edge, in the order they should be added to the graph.
+    edges: Vec<(i64, Edge)>,
+}
+
+/// Collects ids of all nodes referenced by routable ways, which is the first pass
+/// of a two-pass ingest (see [add_features_from_file_two_pass](crate::osm::add_features_from_file_two_pass)).
+///
+/// References are periodically sorted and deduplicated, so memory usage is proportional
+/// to the number of distinct routable nodes.
+pub(super) struct RoutableNodes<'a> {
+    profile: &'a CompiledProfile,
+    nodes: Vec<i64>,
+
+    /// Length of [RoutableNodes::nodes] after the last deduplication.
+    compacted_len: usize,
+}
+
+impl<'a> RoutableNodes<'a> {
+    pub(super) fn new(profile: &'a CompiledProfile) -> Self {
+        Self {
+            profile,
+            nodes: Vec::default(),
+            compacted_len: 0,
+        }
+    }
+
+    /// Reads all features and returns the sorted ids of nodes referenced by routable ways.
+    pub(super) fn collect<F: FeatureReader>(mut self, features: F) -> Result<Vec<i64>, F::Error> {
+        for f in features {
+            if let model::Feature::Way(w) = f? {
+                self.add_way(&w);
+            }
+        }
+        self.compact();
+        Ok(self.nodes)
+    }
+
+    fn add_way(&mut self, w: &model::Way) {
+        if w.nodes.len() < 2 || get_way_penalty(self.profile, w).is_infinite() {
+            return;
+        }
+
+        self.nodes.extend_from_slice(&w.nodes);
+        if self.nodes.len() >= 2 * self.compacted_len.max(1 << 16) {
+            self.compact();
+        }
+    }
+
+    fn compact(&mut self) {
+        self.nodes.sort_unstable();
+        self.nodes.dedup();
+        self.compacted_len = self.nodes.len();
+    }
+}
+
+/// Gets the [penalty](crate::osm::profile::Penalty) applicable for the provided
+/// way and validates it. Returns [f32::INFINITY] or a valid (>= 1) penalty value.
+fn get_way_penalty(profile: &CompiledProfile, w: &model::Way) -> f32 {
+    let penalty = profile.way_penalty(&w.tags);
+    if !penalty.is_finite() {
+        f32::INFINITY // Way not routable
+    } else if penalty < 1.0 {
+        log::error!(target: "routx", "profile has invalid penalty {} - assuming non-routable", penalty);
+        f32::INFINITY
+    } else {
+        penalty
+    }
+}
+
 fn is_bbox_applicable(bbox: [f32; 4]) -> bool {
     // All elements 0 - no bbox
     if bbox.iter().all(|&x| x == 0.0) {
@@ -731,6 +954,7 @@ mod tests {
         profile: &CAR_PROFILE,
         file_format: FileFormat::Xml,
         bbox: [0.0; 4],
+        threads: 0,
     };
 
     mod graph_builder {
@@ -783,6 +1007,36 @@ mod tests {
             assert_eq!(g.get_node(MAX_NODE_ID), None);
         }
 
+        #[test]
+        fn test_add_node_not_required() {
+            let mut g = Graph::default();
+
+            {
+                let b = GraphBuilder::new(&mut g, &DEFAULT_OPTIONS);
+                let mut b = b.with_required_nodes(&[1, 3]);
+                b.add_node(n!(1, 0.0, 0.0));
+                b.add_node(n!(2, 1.0, 0.0));
+                b.add_node(n!(3, 0.0, 1.0));
+            }
+
+            assert!(g.get_node(1).is_some());
+            assert_eq!(g.get_node(2), None);
+            assert!(g.get_node(3).is_some());
+        }
+
+        #[test]
+        fn test_routable_nodes() {
+            let profile = CAR_PROFILE.compile();
+            let mut b = RoutableNodes::new(&profile);
+            b.add_way(&w!(1, vec![5, 2, 3], tags!("highway": "primary")));
+            b.add_way(&w!(2, vec![3, 4], tags!("highway": "footway")));
+            b.add_way(&w!(3, vec![6], tags!("highway": "primary")));
+            b.add_way(&w!(4, vec![1, 2, 5], tags!("highway": "residential")));
+
+            let features = [model::Feature::Node(n!(7, 0.0, 0.0))].map(Ok::<_, std::io::Error>);
+            assert_eq!(b.collect(features).unwrap(), vec![1, 2, 3, 5]);
+        }
+
         #[test]
         fn test_add_way() {
             let mut g = Graph::default();
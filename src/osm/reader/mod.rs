@@ -6,16 +6,19 @@ use std::io;
 use std::path::Path;
 use std::sync::Arc;
 
-use graph_builder::GraphBuilder;
+use graph_builder::{GraphBuilder, RoutableNodes};
 
-use crate::osm::Profile;
+use crate::osm::{CompiledProfile, Profile};
 use crate::Graph;
 
 mod graph_builder;
 pub mod model;
 pub mod pbf;
+mod stats;
 pub mod xml;
 
+pub use stats::{ingest_stats, IngestStats};
+
 /// Error which can occur during OSM reading and parsing.
 #[derive(Debug, Clone, thiserror::Error)]
 pub enum Error {
@@ -110,6 +113,12 @@ pub struct Options<'a> {
     /// Filter features by a specific bounding box. In order: left (min lon), bottom (min lat),
     /// right (max lon), top (max lat). Ignored if all values are set to zero.
     pub bbox: [f32; 4],
+
+    /// Number of threads used to decompress and decode [FileFormat::Pbf] files, and to compute
+    /// edges of ways (in files of any format). Zero stands for
+    /// [available parallelism](std::thread::available_parallelism), and one disables
+    /// multi-threading.
+    pub threads: usize,
 }
 
 /// Trait alias for objects which can stream [osm features](model::Feature)
@@ -131,8 +140,66 @@ where
 pub fn add_features_from_io<'a, R: io::BufRead>(
     g: &'a mut Graph,
     options: &'a Options<'a>,
-    mut reader: R,
+    reader: R,
+) -> Result<(), Error> {
+    add_features_from_io_compiled(g, options, &options.profile.compile(), reader)
+}
+
+/// Parse OSM features from a reader into a [Graph] as per the provided [Options],
+/// using an already [compiled profile](Profile::compile) instead of [Options::profile].
+///
+/// The provided stream will be automatically wrapped in a buffered reader when needed.
+pub fn add_features_from_io_compiled<'a, R: io::BufRead>(
+    g: &'a mut Graph,
+    options: &'a Options<'a>,
+    profile: &'a CompiledProfile,
+    reader: R,
 ) -> Result<(), Error> {
+    let builder = GraphBuilder::with_profile(g, options, profile);
+    read_features(options, profile, reader, builder)
+}
+
+/// Consumer of all [features](model::Feature) read by [read_features].
+///
+/// Readers of different formats produce different iterator types, so
+/// this trait stands in for a closure generic over the [FeatureReader].
+trait FeatureSink {
+    type Output;
+
+    /// Whether bytes decompressed while reading the features are added to
+    /// [IngestStats::bytes_decompressed]. Disabled for the first pass of a two-pass ingest,
+    /// so that every file is only counted once.
+    const COUNT_DECOMPRESSED: bool = true;
+
+    fn consume<F: FeatureReader>(self, features: F) -> Result<Self::Output, F::Error>;
+}
+
+impl FeatureSink for GraphBuilder<'_> {
+    type Output = ();
+
+    fn consume<F: FeatureReader>(mut self, features: F) -> Result<(), F::Error> {
+        self.add_features(features)
+    }
+}
+
+impl FeatureSink for RoutableNodes<'_> {
+    type Output = Vec<i64>;
+
+    const COUNT_DECOMPRESSED: bool = false;
+
+    fn consume<F: FeatureReader>(self, features: F) -> Result<Vec<i64>, F::Error> {
+        self.collect(features)
+    }
+}
+
+/// Reads all OSM features from the provided stream, detecting its format if necessary,
+/// and passes them to the provided [FeatureSink].
+fn read_features<R: io::BufRead, S: FeatureSink>(
+    options: &Options,
+    profile: &CompiledProfile,
+    mut reader: R,
+    sink: S,
+) -> Result<S::Output, Error> {
     // Attempt to detect the file format if not specified
     let detected_format = if options.file_format == FileFormat::Unknown {
         FileFormat::detect(reader.fill_buf()?)
@@ -144,32 +211,37 @@ pub fn add_features_from_io<'a, R: io::BufRead>(
         FileFormat::Unknown => Err(Error::UnknownFileFormat),
 
         FileFormat::Xml => {
-            let features = xml::features_from_file(reader);
-            GraphBuilder::new(g, options).add_features(features)?;
-            Ok(())
+            let features = xml::features_from_file(reader, |k| profile.uses_key(k));
+            Ok(sink.consume(features)?)
         }
 
         FileFormat::XmlGz => {
             let d = flate2::bufread::MultiGzDecoder::new(reader);
-            let b = io::BufReader::new(d);
-            let features = xml::features_from_file(b);
-            GraphBuilder::new(g, options).add_features(features)?;
-            Ok(())
+            let b = io::BufReader::new(stats::CountingReader::new(d, S::COUNT_DECOMPRESSED));
+            let features = xml::features_from_file(b, |k| profile.uses_key(k));
+            Ok(sink.consume(features)?)
         }
 
         FileFormat::XmlBz2 => {
             let d = bzip2::bufread::MultiBzDecoder::new(reader);
-            let b = io::BufReader::new(d);
-            let features = xml::features_from_file(b);
-            GraphBuilder::new(g, options).add_features(features)?;
-            Ok(())
+            let b = io::BufReader::new(stats::CountingReader::new(d, S::COUNT_DECOMPRESSED));
+            let features = xml::features_from_file(b, |k| profile.uses_key(k));
+            Ok(sink.consume(features)?)
         }
 
-        FileFormat::Pbf => {
-            let features = pbf::features_from_file(reader);
-            GraphBuilder::new(g, options).add_features(features)?;
-            Ok(())
+        FileFormat::Pbf if options.threads == 1 => {
+            let features =
+                pbf::features_from_file(reader, S::COUNT_DECOMPRESSED, |k| profile.uses_key(k));
+            Ok(sink.consume(features)?)
         }
+
+        FileFormat::Pbf => Ok(pbf::with_features_from_file_parallel(
+            reader,
+            options.threads,
+            S::COUNT_DECOMPRESSED,
+            |k| profile.uses_key(k),
+            |features| sink.consume(features),
+        )?),
     }
 }
 
@@ -178,10 +250,54 @@ pub fn add_features_from_file<'a, P: AsRef<Path>>(
     g: &'a mut Graph,
     options: &'a Options<'a>,
     path: P,
+) -> Result<(), Error> {
+    add_features_from_file_compiled(g, options, &options.profile.compile(), path)
+}
+
+/// Parse OSM features from a file at the provided path into a [Graph] as per the provided [Options],
+/// using an already [compiled profile](Profile::compile) instead of [Options::profile].
+pub fn add_features_from_file_compiled<'a, P: AsRef<Path>>(
+    g: &'a mut Graph,
+    options: &'a Options<'a>,
+    profile: &'a CompiledProfile,
+    path: P,
 ) -> Result<(), Error> {
     let f = File::open(path)?;
     let b = io::BufReader::new(f);
-    add_features_from_io(g, options, b)
+    add_features_from_io_compiled(g, options, profile, b)
+}
+
+/// Parse OSM features from a file at the provided path into a [Graph] as per the provided [Options],
+/// reading the file twice to bound memory usage.
+///
+/// The first pass collects the ids of nodes referenced by routable ways, and the second pass
+/// builds the graph with only those nodes. Peak memory usage is thus proportional to the size
+/// of the routable network, instead of to the number of all nodes in the file (as with
+/// [add_features_from_file]), at the cost of reading and decoding the file twice.
+/// The results are the same as with [add_features_from_file].
+pub fn add_features_from_file_two_pass<'a, P: AsRef<Path>>(
+    g: &'a mut Graph,
+    options: &'a Options<'a>,
+    path: P,
+) -> Result<(), Error> {
+    add_features_from_file_two_pass_compiled(g, options, &options.profile.compile(), path)
+}
+
+/// Same as [add_features_from_file_two_pass], but using an already
+/// [compiled profile](Profile::compile) instead of [Options::profile].
+pub fn add_features_from_file_two_pass_compiled<'a, P: AsRef<Path>>(
+    g: &'a mut Graph,
+    options: &'a Options<'a>,
+    profile: &'a CompiledProfile,
+    path: P,
+) -> Result<(), Error> {
+    let open = || File::open(path.as_ref()).map(io::BufReader::new);
+
+    let required_nodes = read_features(options, profile, open()?, RoutableNodes::new(profile))?;
+
+    let builder =
+        GraphBuilder::with_profile(g, options, profile).with_required_nodes(&required_nodes);
+    read_features(options, profile, open()?, builder)
 }
 
 /// Parse OSM features from a static buffer into a [Graph] as per the provided [Options].
@@ -190,15 +306,33 @@ pub fn add_features_from_buffer<'a>(
     options: &'a Options<'a>,
     data: &[u8],
 ) -> Result<(), Error> {
-    if options.file_format == FileFormat::Xml {
+    add_features_from_buffer_compiled(g, options, &options.profile.compile(), data)
+}
+
+/// Parse OSM features from a static buffer into a [Graph] as per the provided [Options],
+/// using an already [compiled profile](Profile::compile) instead of [Options::profile].
+pub fn add_features_from_buffer_compiled<'a>(
+    g: &'a mut Graph,
+    options: &'a Options<'a>,
+    profile: &'a CompiledProfile,
+    data: &[u8],
+) -> Result<(), Error> {
+    // Attempt to detect the file format if not specified
+    let detected_format = if options.file_format == FileFormat::Unknown {
+        FileFormat::detect(data)
+    } else {
+        options.file_format
+    };
+
+    if detected_format == FileFormat::Xml {
         // Fast path is available for in-memory XML data
-        let features = xml::features_from_buffer(data);
-        GraphBuilder::new(g, options).add_features(features)?;
+        let features = xml::features_from_buffer(data, |k| profile.uses_key(k));
+        GraphBuilder::with_profile(g, options, profile).add_features(features)?;
         Ok(())
     } else {
         // Wrap the buffer in a cursor and use the IO path
         let cursor = io::Cursor::new(data);
-        add_features_from_io(g, options, cursor)
+        add_features_from_io_compiled(g, options, profile, cursor)
     }
 }
 
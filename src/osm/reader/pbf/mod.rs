@@ -5,14 +5,15 @@ mod fileformat;
 mod osmformat;
 
 use super::model::{Feature, FeatureType, Relation, RelationMember, Way};
-use crate::Node;
+use crate::{parallel, Node};
 
 use protobuf::Message;
-use std::collections::HashMap;
+use std::collections::{HashMap, VecDeque};
 use std::io;
 use std::io::Read;
 use std::rc::Rc;
-use std::sync::Arc;
+use std::sync::{mpsc, Arc, Mutex};
+use std::thread;
 
 /// Max permitted size for a serialized [blob header](https://wiki.openstreetmap.org/wiki/PBF_Format#File_format) -
 /// 64 KiB.
@@ -25,7 +26,36 @@ const MAX_BLOB_SIZE: u32 = 32 * 1024 * 1024;
 /// All strings used by an [OSM PBF Block](https://wiki.openstreetmap.org/wiki/PBF_Format#Definition_of_OSMData_fileblock),
 /// reference-counted as this table is referred to by multiple coexisting iterators and
 /// closures without any concrete ownership.
-type StringTable = Rc<Vec<String>>;
+type StringTable = Rc<Strings>;
+
+/// Strings of an [OSM PBF Block](https://wiki.openstreetmap.org/wiki/PBF_Format#Definition_of_OSMData_fileblock),
+/// matched against the tag filter once per block.
+///
+/// Tags of ways and relations refer to the table by index, so checking whether a tag
+/// is kept is a single array lookup, instead of a string comparison (or hashing) per tag.
+/// Only strings which are actually read (keys and values of kept tags, and member roles)
+/// are converted into owned [Strings](String).
+struct Strings {
+    strings: Vec<String>,
+
+    /// Whether the string at a given index is a key of tags which are kept.
+    kept_keys: Vec<bool>,
+}
+
+impl Strings {
+    /// Returns the string at the provided index, or an empty string if it's out of bounds
+    /// (or wasn't converted).
+    #[inline]
+    fn get(&self, idx: u32) -> String {
+        self.strings.get(idx as usize).cloned().unwrap_or_default()
+    }
+
+    /// Returns true if the string at the provided index is a key of tags which are kept.
+    #[inline]
+    fn is_kept_key(&self, idx: u32) -> bool {
+        self.kept_keys.get(idx as usize).copied().unwrap_or(false)
+    }
+}
 
 /// Error which can occur when reading a PBF file.
 #[derive(Debug, Clone, thiserror::Error)]
@@ -67,20 +97,173 @@ impl From<protobuf::Error> for Error {
     }
 }
 
-/// Returns an iterator over all features from an OSM PBF file.
-pub fn features_from_file<R: io::Read>(reader: R) -> impl Iterator<Item = Result<Feature, Error>> {
-    File(reader).features()
+/// Returns an iterator over all features from an OSM PBF file. Only tags with keys
+/// for which `keep_tag` returns true are collected; `keep_tag` is called once
+/// per string of every block, not once per tag.
+///
+/// If `count_decompressed` is set, decompressed bytes are added to
+/// [IngestStats::bytes_decompressed](crate::osm::IngestStats::bytes_decompressed).
+pub fn features_from_file<R: io::Read, K: Fn(&str) -> bool>(
+    reader: R,
+    count_decompressed: bool,
+    keep_tag: K,
+) -> impl Iterator<Item = Result<Feature, Error>> {
+    File {
+        reader,
+        count_decompressed,
+    }
+    .features(keep_tag)
+}
+
+/// Calls `f` with an iterator over all features from an OSM PBF file, which are decoded
+/// on a pool of `threads` worker threads (zero stands for
+/// [available parallelism](std::thread::available_parallelism)).
+///
+/// Framed blobs are read from `reader` on the calling thread (which also consumes the features),
+/// while workers decompress and decode them into batches of features. Features are still
+/// yielded in file order. At most `2 × threads` blobs are decoded ahead of the consumer,
+/// which bounds the memory usage. See [features_from_file] for `count_decompressed`
+/// and `keep_tag`.
+pub fn with_features_from_file_parallel<R, K, F, T>(
+    reader: R,
+    threads: usize,
+    count_decompressed: bool,
+    keep_tag: K,
+    f: F,
+) -> T
+where
+    R: io::Read,
+    K: Fn(&str) -> bool + Sync,
+    F: FnOnce(ParallelFeatures<R>) -> T,
+{
+    let threads = parallel::effective_threads(threads, usize::MAX);
+    let (jobs, job_receiver) = mpsc::channel::<DecodeJob>();
+    let job_receiver = Mutex::new(job_receiver);
+
+    thread::scope(|s| {
+        for _ in 0..threads {
+            s.spawn(|| decode_worker(&job_receiver, count_decompressed, &keep_tag));
+        }
+
+        // NOTE: The iterator owns the only job sender - once it is dropped (after `f` returns),
+        //       workers finish their current job and exit, which lets the scope end.
+        f(ParallelFeatures {
+            blobs: FileBlocks {
+                reader,
+                count_decompressed,
+                done: false,
+                seen_header: false,
+            },
+            jobs,
+            in_flight: VecDeque::with_capacity(2 * threads),
+            max_in_flight: 2 * threads,
+            batch: Vec::new().into_iter(),
+            read_error: None,
+            done: false,
+        })
+    })
+}
+
+/// Raw, compressed [fileformat::Blob] with a channel for sending back its decoded features.
+type DecodeJob = (Vec<u8>, mpsc::SyncSender<Result<Vec<Feature>, Error>>);
+
+/// Decodes [DecodeJobs](DecodeJob) until the job channel is closed.
+fn decode_worker(
+    jobs: &Mutex<mpsc::Receiver<DecodeJob>>,
+    count_decompressed: bool,
+    keep_tag: &dyn Fn(&str) -> bool,
+) {
+    loop {
+        let job = jobs.lock().unwrap().recv();
+        let Ok((raw_blob, result)) = job else {
+            return;
+        };
+
+        let features = decode_data(&raw_blob, count_decompressed)
+            .map(|block| block.features(keep_tag).collect());
+
+        // The consumer might have stopped early - ignore closed result channels
+        _ = result.send(features);
+    }
+}
+
+/// Iterator over features decoded by [with_features_from_file_parallel].
+pub struct ParallelFeatures<R: io::Read> {
+    blobs: FileBlocks<R>,
+    jobs: mpsc::Sender<DecodeJob>,
+    in_flight: VecDeque<mpsc::Receiver<Result<Vec<Feature>, Error>>>,
+    max_in_flight: usize,
+    batch: std::vec::IntoIter<Feature>,
+    read_error: Option<Error>,
+    done: bool,
+}
+
+impl<R: io::Read> ParallelFeatures<R> {
+    /// Reads and dispatches blobs to workers, until enough of them are in flight or there
+    /// are no more blobs to read.
+    fn dispatch(&mut self) {
+        while self.read_error.is_none() && self.in_flight.len() < self.max_in_flight {
+            match self.blobs.read_until_next_data_blob() {
+                Ok(Some(raw_blob)) => {
+                    let (sender, receiver) = mpsc::sync_channel(1);
+                    self.jobs
+                        .send((raw_blob, sender))
+                        .expect("all pbf decoding workers have exited");
+                    self.in_flight.push_back(receiver);
+                }
+                Ok(None) => break,
+                Err(e) => self.read_error = Some(e),
+            }
+        }
+    }
+}
+
+impl<R: io::Read> Iterator for ParallelFeatures<R> {
+    type Item = Result<Feature, Error>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        loop {
+            if let Some(f) = self.batch.next() {
+                return Some(Ok(f));
+            } else if self.done {
+                return None;
+            }
+
+            self.dispatch();
+            match self.in_flight.pop_front() {
+                Some(receiver) => {
+                    match receiver.recv().expect("pbf decoding worker has panicked") {
+                        Ok(batch) => self.batch = batch.into_iter(),
+                        Err(e) => {
+                            self.done = true;
+                            return Some(Err(e));
+                        }
+                    }
+                }
+
+                None => {
+                    // All blobs were decoded - report a read error, if one has occurred
+                    self.done = true;
+                    return self.read_error.take().map(Err);
+                }
+            }
+        }
+    }
 }
 
 /// File abstracts away a whole OSM PBF file, a file encoding multiple [blocks](osmformat::PrimitiveBlock).
 /// [fileformat::Blob] pairs, into a friendly interface.
-struct File<R: io::Read>(R);
+struct File<R: io::Read> {
+    reader: R,
+    count_decompressed: bool,
+}
 
 impl<R: io::Read> File<R> {
     /// Returns an iterator over all [Blocks](Block) in this file.
     fn blocks(self) -> impl Iterator<Item = Result<Block, Error>> {
         FileBlocks {
-            reader: self.0,
+            reader: self.reader,
+            count_decompressed: self.count_decompressed,
             done: false,
             seen_header: false,
         }
@@ -88,14 +271,22 @@ impl<R: io::Read> File<R> {
 
     /// Returns a flattened iterator over all [Features](Feature) from all
     /// [Groups](Group) from all [Blocks](Block) in this file.
-    fn features(self) -> impl Iterator<Item = Result<Feature, Error>> {
-        self.blocks().flat_map(block_result_features)
+    fn features<K: Fn(&str) -> bool>(
+        self,
+        keep_tag: K,
+    ) -> impl Iterator<Item = Result<Feature, Error>> {
+        self.blocks()
+            .flat_map(move |block| block_result_features(block, &keep_tag))
     }
 }
 
 /// Iterator over [Blocks](Block) in a [File].
 struct FileBlocks<R: io::Read> {
     reader: R,
+
+    /// Whether decompressed bytes are added to the process-wide ingest counters.
+    count_decompressed: bool,
+
     done: bool,
     seen_header: bool,
 }
@@ -124,7 +315,16 @@ impl<R: io::Read> Iterator for FileBlocks<R> {
 
 impl<R: io::Read> FileBlocks<R> {
     fn read_until_next_block(&mut self) -> Result<Option<Block>, Error> {
-        // Loop until EOF or a Block
+        match self.read_until_next_data_blob()? {
+            Some(raw_blob) => Ok(Some(decode_data(&raw_blob, self.count_decompressed)?)),
+            None => Ok(None),
+        }
+    }
+
+    /// Reads blobs until EOF or an `OSMData` blob, which is returned without decompressing or
+    /// decoding it. `OSMHeader` blobs are validated, and blobs of unknown types are skipped.
+    fn read_until_next_data_blob(&mut self) -> Result<Option<Vec<u8>>, Error> {
+        // Loop until EOF or an OSMData blob
         loop {
             // 1. Read 4 bytes with the size of the following BlobHeader
             let blob_header_size = match self.read_blob_header_size()? {
@@ -147,7 +347,7 @@ impl<R: io::Read> FileBlocks<R> {
                     if !self.seen_header {
                         return Err(Error::DataBlobBeforeHeader);
                     }
-                    return Ok(Some(self.read_data(blob_size)?));
+                    return Ok(Some(self.read_raw_blob(blob_size)?));
                 }
 
                 _ => {
@@ -155,7 +355,7 @@ impl<R: io::Read> FileBlocks<R> {
                     // https://wiki.openstreetmap.org/wiki/PBF_Format#Encoding_OSM_entities_into_fileblocks
                     // Unfortunately, io::Read doesn't have an easy way to discard data, so
                     // we still have to allocate the blob.
-                    _ = self.read_blob(blob_size)?;
+                    _ = self.read_raw_blob(blob_size)?;
                 }
             }
         }
@@ -168,7 +368,7 @@ impl<R: io::Read> FileBlocks<R> {
     /// or an [Error] if anything bad has happened.
     fn read_and_check_header(&mut self, blob_size: i32) -> Result<(), Error> {
         // 1. Read the OSMHeader blob
-        let blob = self.read_blob(blob_size)?;
+        let blob = decompress_blob(&self.read_raw_blob(blob_size)?, self.count_decompressed)?;
         let header = osmformat::HeaderBlock::parse_from_bytes(&blob)?;
 
         // 2. Check required features
@@ -187,14 +387,6 @@ impl<R: io::Read> FileBlocks<R> {
         Ok(())
     }
 
-    /// Reads the next [fileformat::Blob], assuming it's an `OSMData`
-    /// block containing an [Block] ([osmformat::PrimitiveBlock]).
-    fn read_data(&mut self, blob_size: i32) -> Result<Block, Error> {
-        let blob = self.read_blob(blob_size)?;
-        let block = osmformat::PrimitiveBlock::parse_from_bytes(&blob)?;
-        Ok(Block(block))
-    }
-
     /// Reads the next 4 bytes to read the size of the subsequent [fileformat::BlobHeader].
     ///
     /// Returns `Ok(Some(_))` on success, `Ok(None)` on EOF, or an [Error].
@@ -223,50 +415,68 @@ impl<R: io::Read> FileBlocks<R> {
         Ok(header)
     }
 
-    /// Reads the next [fileformat::Blob] and returns the decompressed contents of it.
-    fn read_blob(&mut self, size: i32) -> Result<Vec<u8>, Error> {
+    /// Reads the next serialized [fileformat::Blob], without parsing or decompressing it.
+    fn read_raw_blob(&mut self, size: i32) -> Result<Vec<u8>, Error> {
         if size < 0 {
             return Err(Error::NegativeBlobHeaderSize);
         }
 
         let mut buf = vec![0u8; size as usize];
         self.reader.read_exact(&mut buf)?;
+        Ok(buf)
+    }
+}
 
-        let blob = fileformat::Blob::parse_from_bytes(&buf)?;
+/// Parses a serialized `OSMData` [fileformat::Blob] into a [Block] ([osmformat::PrimitiveBlock]).
+fn decode_data(raw_blob: &[u8], count_decompressed: bool) -> Result<Block, Error> {
+    let blob = decompress_blob(raw_blob, count_decompressed)?;
+    let block = osmformat::PrimitiveBlock::parse_from_bytes(&blob)?;
+    Ok(Block(block))
+}
 
-        // FIXME: Don't blindly trust `blob.raw_size` for detecting too large blobs.
-        //        There should be a way to prevent too large allocations during decompression.
-        let blob_size = blob.raw_size() as u32;
-        if blob_size > MAX_BLOB_SIZE {
-            return Err(Error::BlobTooLarge(blob_size));
-        }
+/// Parses a serialized [fileformat::Blob] and returns the decompressed contents of it.
+/// The size of the contents is added to the process-wide ingest counters if `count` is set.
+fn decompress_blob(raw_blob: &[u8], count: bool) -> Result<Vec<u8>, Error> {
+    let blob = fileformat::Blob::parse_from_bytes(raw_blob)?;
 
-        match blob
-            .data
-            .expect("Blob.data must not be None after parse_from_bytes")
-        {
-            fileformat::blob::Data::Raw(data) => Ok(data),
-
-            fileformat::blob::Data::ZlibData(data) => {
-                let mut d = flate2::read::ZlibDecoder::new(&data[..]);
-                let mut decompressed = Vec::with_capacity(blob_size as usize);
-                d.read_to_end(&mut decompressed)?;
-                Ok(decompressed)
+    // FIXME: Don't blindly trust `blob.raw_size` for detecting too large blobs.
+    //        There should be a way to prevent too large allocations during decompression.
+    let blob_size = blob.raw_size() as u32;
+    if blob_size > MAX_BLOB_SIZE {
+        return Err(Error::BlobTooLarge(blob_size));
+    }
+
+    match blob
+        .data
+        .expect("Blob.data must not be None after parse_from_bytes")
+    {
+        fileformat::blob::Data::Raw(data) => Ok(data),
+
+        fileformat::blob::Data::ZlibData(data) => {
+            let mut d = flate2::read::ZlibDecoder::new(&data[..]);
+            let mut decompressed = Vec::with_capacity(blob_size as usize);
+            d.read_to_end(&mut decompressed)?;
+            if count {
+                super::stats::publish_decompressed(decompressed.len());
             }
+            Ok(decompressed)
+        }
 
-            fileformat::blob::Data::LzmaData(_) => Err(Error::UnsupportedCompression("lzma")),
+        fileformat::blob::Data::LzmaData(_) => Err(Error::UnsupportedCompression("lzma")),
 
-            fileformat::blob::Data::OBSOLETEBzip2Data(data) => {
-                let mut d = bzip2::read::BzDecoder::new(&data[..]);
-                let mut decompressed = Vec::with_capacity(blob_size as usize);
-                d.read_to_end(&mut decompressed)?;
-                Ok(decompressed)
+        fileformat::blob::Data::OBSOLETEBzip2Data(data) => {
+            let mut d = bzip2::read::BzDecoder::new(&data[..]);
+            let mut decompressed = Vec::with_capacity(blob_size as usize);
+            d.read_to_end(&mut decompressed)?;
+            if count {
+                super::stats::publish_decompressed(decompressed.len());
             }
+            Ok(decompressed)
+        }
 
-            fileformat::blob::Data::Lz4Data(_) => Err(Error::UnsupportedCompression("lz4")),
+        fileformat::blob::Data::Lz4Data(_) => Err(Error::UnsupportedCompression("lz4")),
 
-            fileformat::blob::Data::ZstdData(_) => Err(Error::UnsupportedCompression("zstd")),
-        }
+        fileformat::blob::Data::ZstdData(_) => Err(Error::UnsupportedCompression("zstd")),
     }
 }
 
@@ -296,9 +506,10 @@ impl<I: Iterator<Item = Feature>> Iterator for BlockResultFeatureIterator<I> {
 
 fn block_result_features(
     block_result: Result<Block, Error>,
+    keep_tag: &dyn Fn(&str) -> bool,
 ) -> BlockResultFeatureIterator<impl Iterator<Item = Feature>> {
     match block_result {
-        Ok(block) => BlockResultFeatureIterator::Iterating(block.features()),
+        Ok(block) => BlockResultFeatureIterator::Iterating(block.features(keep_tag)),
         Err(e) => BlockResultFeatureIterator::Done(Some(e)),
     }
 }
@@ -308,9 +519,9 @@ struct Block(osmformat::PrimitiveBlock);
 
 impl Block {
     /// Returns an iterator over all [Groups](Group) in this block.
-    fn groups(self) -> impl Iterator<Item = Group> {
+    fn groups(self, keep_tag: &dyn Fn(&str) -> bool) -> impl Iterator<Item = Group> {
         let coordinate_converter = self.build_coordinate_converter();
-        let string_table = Rc::new(self.build_string_table());
+        let string_table = Rc::new(self.build_string_table(keep_tag));
         self.0.primitivegroup.into_iter().map(move |g| Group {
             primitive_group: g,
             coordinate_converter: coordinate_converter,
@@ -319,18 +530,42 @@ impl Block {
     }
 
     /// Returns a flattened iterator over all [Features](Feature) from all [Groups](Group) in this block.
-    fn features(self) -> impl Iterator<Item = Feature> {
-        self.groups().flat_map(|g| g.features())
+    /// Only tags with keys for which `keep_tag` returns true are collected.
+    fn features(self, keep_tag: &dyn Fn(&str) -> bool) -> impl Iterator<Item = Feature> {
+        self.groups(keep_tag).flat_map(|g| g.features())
     }
 
-    /// Converts the [osmformat::StringTable] into a simpler `Vec<String>`.
-    fn build_string_table(&self) -> Vec<String> {
-        self.0
-            .stringtable
-            .s
+    /// Converts the [osmformat::StringTable] into [Strings], matching every string
+    /// against `keep_tag` once, and only converting strings which are read afterwards.
+    fn build_string_table(&self, keep_tag: &dyn Fn(&str) -> bool) -> Strings {
+        let raw = &self.0.stringtable.s;
+        let kept_keys: Vec<bool> = raw
+            .iter()
+            .map(|bytes| std::str::from_utf8(bytes).is_ok_and(keep_tag))
+            .collect();
+
+        let mut used = vec![false; raw.len()];
+        for group in &self.0.primitivegroup {
+            for way in &group.ways {
+                mark_kept_tags(&mut used, &kept_keys, &way.keys, &way.vals);
+            }
+            for relation in &group.relations {
+                mark_kept_tags(&mut used, &kept_keys, &relation.keys, &relation.vals);
+                for &role_idx in &relation.roles_sid {
+                    mark_used(&mut used, role_idx as u32);
+                }
+            }
+        }
+
+        let strings = raw
             .iter()
-            .map(|bytes| String::from_utf8_lossy(bytes).to_string())
-            .collect()
+            .zip(used)
+            .map(|(bytes, used)| match used {
+                true => String::from_utf8_lossy(bytes).into_owned(),
+                false => String::new(),
+            })
+            .collect();
+        Strings { strings, kept_keys }
     }
 
     /// Builds a [CoordinateConverter] for this block.
@@ -458,15 +693,28 @@ impl CoordinateConverter {
     }
 }
 
-fn collect_tags(keys: &[u32], values: &[u32], string_table: &[String]) -> HashMap<String, String> {
+/// Marks keys and values of tags with kept keys as used.
+fn mark_kept_tags(used: &mut [bool], kept_keys: &[bool], keys: &[u32], values: &[u32]) {
+    for (&key_idx, &value_idx) in keys.iter().zip(values) {
+        if kept_keys.get(key_idx as usize).copied().unwrap_or(false) {
+            mark_used(used, key_idx);
+            mark_used(used, value_idx);
+        }
+    }
+}
+
+#[inline]
+fn mark_used(used: &mut [bool], idx: u32) {
+    if let Some(u) = used.get_mut(idx as usize) {
+        *u = true;
+    }
+}
+
+fn collect_tags(keys: &[u32], values: &[u32], string_table: &Strings) -> HashMap<String, String> {
     keys.iter()
         .zip(values.iter())
-        .map(|(&key_idx, &value_idx)| {
-            (
-                get_string(string_table, key_idx),
-                get_string(string_table, value_idx),
-            )
-        })
+        .filter(|(&key_idx, _)| string_table.is_kept_key(key_idx))
+        .map(|(&key_idx, &value_idx)| (string_table.get(key_idx), string_table.get(value_idx)))
         .collect()
 }
 
@@ -484,7 +732,7 @@ fn collect_relation_members(
     member_id_deltas: &[i64],
     roles: &[i32],
     types: &[protobuf::EnumOrUnknown<osmformat::relation::MemberType>],
-    string_table: &[String],
+    string_table: &Strings,
 ) -> Vec<RelationMember> {
     member_id_deltas
         .iter()
@@ -500,12 +748,7 @@ fn collect_relation_members(
                 osmformat::relation::MemberType::WAY => FeatureType::Way,
                 osmformat::relation::MemberType::RELATION => FeatureType::Relation,
             },
-            role: get_string(string_table, role_idx as u32),
+            role: string_table.get(role_idx as u32),
         })
         .collect()
 }
-
-#[inline]
-fn get_string(table: &[String], idx: u32) -> String {
-    table.get(idx as usize).cloned().unwrap_or_default()
-}
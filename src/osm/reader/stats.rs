@@ -0,0 +1,108 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+//! Process-wide counters of OSM data ingest.
+
+use std::io;
+use std::sync::atomic::{AtomicU64, Ordering};
+
+/// Process-wide counters of all OSM data read so far, see [ingest_stats].
+///
+/// Counters only ever increase, so they can be directly exported as monotonic metrics.
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+#[repr(C)]
+pub struct IngestStats {
+    /// Number of read OSM nodes, including the ones which were later ignored.
+    pub nodes: u64,
+
+    /// Number of read OSM ways, including the ones which were later ignored.
+    pub ways: u64,
+
+    /// Number of read OSM relations, including the ones which were later ignored.
+    pub relations: u64,
+
+    /// Number of turn restrictions applied to the graph.
+    pub restrictions_applied: u64,
+
+    /// Number of turn restrictions which were invalid or couldn't be applied to the graph,
+    /// for example because they reference features outside of the requested bounding box.
+    pub restrictions_rejected: u64,
+
+    /// Number of bytes produced by decompressing .osm.gz and .osm.bz2 files,
+    /// and compressed blobs of .osm.pbf files. Files read twice by a two-pass ingest
+    /// are only counted once.
+    pub bytes_decompressed: u64,
+}
+
+static NODES: AtomicU64 = AtomicU64::new(0);
+static WAYS: AtomicU64 = AtomicU64::new(0);
+static RELATIONS: AtomicU64 = AtomicU64::new(0);
+static RESTRICTIONS_APPLIED: AtomicU64 = AtomicU64::new(0);
+static RESTRICTIONS_REJECTED: AtomicU64 = AtomicU64::new(0);
+static BYTES_DECOMPRESSED: AtomicU64 = AtomicU64::new(0);
+
+/// Returns the process-wide counters of all OSM data read so far.
+///
+/// Readers count features locally and only publish the totals once done with a file,
+/// so the counters don't slow down parsing, but they also don't include files
+/// which are still being read.
+pub fn ingest_stats() -> IngestStats {
+    IngestStats {
+        nodes: NODES.load(Ordering::Relaxed),
+        ways: WAYS.load(Ordering::Relaxed),
+        relations: RELATIONS.load(Ordering::Relaxed),
+        restrictions_applied: RESTRICTIONS_APPLIED.load(Ordering::Relaxed),
+        restrictions_rejected: RESTRICTIONS_REJECTED.load(Ordering::Relaxed),
+        bytes_decompressed: BYTES_DECOMPRESSED.load(Ordering::Relaxed),
+    }
+}
+
+/// Adds locally collected counters to the process-wide ones.
+pub(super) fn publish(s: &IngestStats) {
+    NODES.fetch_add(s.nodes, Ordering::Relaxed);
+    WAYS.fetch_add(s.ways, Ordering::Relaxed);
+    RELATIONS.fetch_add(s.relations, Ordering::Relaxed);
+    RESTRICTIONS_APPLIED.fetch_add(s.restrictions_applied, Ordering::Relaxed);
+    RESTRICTIONS_REJECTED.fetch_add(s.restrictions_rejected, Ordering::Relaxed);
+    BYTES_DECOMPRESSED.fetch_add(s.bytes_decompressed, Ordering::Relaxed);
+}
+
+/// Adds to the process-wide [IngestStats::bytes_decompressed] counter.
+pub(super) fn publish_decompressed(bytes: usize) {
+    BYTES_DECOMPRESSED.fetch_add(bytes as u64, Ordering::Relaxed);
+}
+
+/// Reader counting the bytes read from a decompressor,
+/// published to [IngestStats::bytes_decompressed] when dropped (if `publish` is set).
+pub(super) struct CountingReader<R: io::Read> {
+    inner: R,
+    count: usize,
+    publish: bool,
+}
+
+impl<R: io::Read> CountingReader<R> {
+    pub(super) fn new(inner: R, publish: bool) -> Self {
+        Self {
+            inner,
+            count: 0,
+            publish,
+        }
+    }
+}
+
+impl<R: io::Read> io::Read for CountingReader<R> {
+    #[inline]
+    fn read(&mut self, buf: &mut [u8]) -> io::Result<usize> {
+        let n = self.inner.read(buf)?;
+        self.count += n;
+        Ok(n)
+    }
+}
+
+impl<R: io::Read> Drop for CountingReader<R> {
+    fn drop(&mut self) {
+        if self.publish {
+            publish_decompressed(self.count);
+        }
+    }
+}
@@ -8,17 +8,24 @@ use std::str::from_utf8;
 use super::model;
 use crate::Node;
 
-pub fn features_from_file<R: io::BufRead>(
+/// Streams features from an XML file. Only tags with keys for which `keep_tag` returns
+/// true are collected; other tags are skipped without allocating.
+pub fn features_from_file<R: io::BufRead, F: Fn(&str) -> bool>(
     reader: R,
+    keep_tag: F,
 ) -> impl Iterator<Item = Result<model::Feature, quick_xml::Error>> {
-    Reader::from_io(reader)
+    Reader::from_io(reader, keep_tag)
 }
 
-pub fn features_from_buffer(
-    b: &[u8],
-) -> impl Iterator<Item = Result<model::Feature, quick_xml::Error>> + '_ {
-    Reader::from_buffer(b)
+/// Streams features from an in-memory XML document. Events borrow directly from the buffer,
+/// and only tags with keys for which `keep_tag` returns true are collected.
+pub fn features_from_buffer<'a, F: Fn(&str) -> bool + 'a>(
+    b: &'a [u8],
+    keep_tag: F,
+) -> impl Iterator<Item = Result<model::Feature, quick_xml::Error>> + 'a {
+    Reader::from_buffer(b, keep_tag)
 }
+
 /// Parser is a trait for objects which can parse XML.
 ///
 /// This trait only exists to fix the mismatch of
@@ -63,19 +70,26 @@ impl<'a> Parser for BufParser<'a> {
 }
 
 /// Reader reads osm [Features](Feature) from an XML file.
-struct Reader<P: Parser> {
+struct Reader<P: Parser, F: Fn(&str) -> bool> {
     parser: P,
     eof: bool,
+
+    /// Filter of tag keys to collect.
+    keep_tag: F,
 }
 
-impl<P: Parser> Reader<P> {
+impl<P: Parser, F: Fn(&str) -> bool> Reader<P, F> {
     #[inline]
-    fn new(parser: P) -> Self {
-        Self { parser, eof: false }
+    fn new(parser: P, keep_tag: F) -> Self {
+        Self {
+            parser,
+            eof: false,
+            keep_tag,
+        }
     }
 }
 
-impl<P: Parser> Iterator for Reader<P> {
+impl<P: Parser, F: Fn(&str) -> bool> Iterator for Reader<P, F> {
     type Item = Result<model::Feature, quick_xml::Error>;
 
     fn next(&mut self) -> Option<Self::Item> {
@@ -97,7 +111,7 @@ impl<P: Parser> Iterator for Reader<P> {
                         // "way" or "relation" can't be self-closing
                         b"tag" => {
                             if let Some((feature_id, tags)) = feature_tags(&mut f) {
-                                if let Some((k, v)) = parse_tag(start, feature_id) {
+                                if let Some((k, v)) = parse_tag(start, feature_id, &self.keep_tag) {
                                     tags.insert(k, v);
                                 }
                             }
@@ -149,17 +163,17 @@ impl<P: Parser> Iterator for Reader<P> {
     }
 }
 
-impl<'a> Reader<BufParser<'a>> {
+impl<'a, F: Fn(&str) -> bool> Reader<BufParser<'a>, F> {
     #[inline]
-    fn from_buffer(data: &'a [u8]) -> Self {
-        Self::new(BufParser::new(data))
+    fn from_buffer(data: &'a [u8], keep_tag: F) -> Self {
+        Self::new(BufParser::new(data), keep_tag)
     }
 }
 
-impl<R: io::BufRead> Reader<IoParser<R>> {
+impl<R: io::BufRead, F: Fn(&str) -> bool> Reader<IoParser<R>, F> {
     #[inline]
-    fn from_io(reader: R) -> Self {
-        Self::new(IoParser::new(reader))
+    fn from_io(reader: R, keep_tag: F) -> Self {
+        Self::new(IoParser::new(reader), keep_tag)
     }
 }
 
@@ -262,23 +276,31 @@ fn parse_relation(start: quick_xml::events::BytesStart<'_>) -> Option<model::Rel
     }
 }
 
-fn parse_tag(
+fn parse_tag<F: Fn(&str) -> bool>(
     start: quick_xml::events::BytesStart<'_>,
     feature_id: i64,
+    keep_tag: F,
 ) -> Option<(String, String)> {
     let mut k = None;
     let mut v = None;
 
+    // NOTE: Attribute values borrow from the event, so skipped tags never allocate.
     for attr in start.attributes() {
         let attr = attr.ok()?;
         match attr.key.as_ref() {
-            b"k" => k = Some(parse_string(&attr.value)),
-            b"v" => v = Some(parse_string(&attr.value)),
+            b"k" => k = Some(attr.value),
+            b"v" => v = Some(attr.value),
             _ => {}
         }
     }
 
-    match (k, v) {
+    if let Some(k) = &k {
+        if !keep_tag(&String::from_utf8_lossy(k)) {
+            return None;
+        }
+    }
+
+    match (k.map(|k| parse_string(&k)), v.map(|v| parse_string(&v))) {
         (None, _) => {
             log::warn!(target: "routx::osm", "feature {} has tag without a key - skipping tag", feature_id);
             None
@@ -374,7 +396,7 @@ fn parse_f32(s: &[u8]) -> Option<f32> {
 }
 
 fn parse_string(s: &[u8]) -> String {
-    String::from_utf8_lossy(s).to_string()
+    String::from_utf8_lossy(s).into_owned()
 }
 
 fn parse_feature_type(s: &[u8]) -> Option<model::FeatureType> {
@@ -667,11 +689,29 @@ mod tests {
 
     #[test]
     fn parse_from_buf() -> Result<(), quick_xml::Error> {
-        check_against_expected(Reader::from_buffer(SIMPLE_XML))
+        check_against_expected(Reader::from_buffer(SIMPLE_XML, |_| true))
     }
 
     #[test]
     fn parse_from_io() -> Result<(), quick_xml::Error> {
-        check_against_expected(Reader::from_io(io::Cursor::new(SIMPLE_XML)))
+        check_against_expected(Reader::from_io(io::Cursor::new(SIMPLE_XML), |_| true))
+    }
+
+    #[test]
+    fn parse_with_tag_filter() -> Result<(), quick_xml::Error> {
+        let (_, ways, relations) = collect_all(Reader::from_buffer(SIMPLE_XML, |k| k != "ref"))?;
+
+        let mut expected_ways = get_expected_ways();
+        expected_ways.iter_mut().for_each(|w| {
+            w.tags.remove("ref");
+        });
+        assert_eq!(ways, expected_ways);
+
+        let mut expected_relations = get_expected_relations();
+        expected_relations.iter_mut().for_each(|r| {
+            r.tags.remove("ref");
+        });
+        assert_eq!(relations, expected_relations);
+        Ok(())
     }
 }
@@ -0,0 +1,253 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+use std::ops::Deref;
+use std::sync::{Arc, Mutex, RwLock};
+
+use crate::graph::next_epoch;
+use crate::{earth_distance, FrozenGraph};
+
+/// Per-edge multiplier of the base cost, used by [CostOverlay::update_factors].
+#[derive(Debug, Clone, Copy, PartialEq)]
+#[repr(C)]
+pub struct EdgeFactor {
+    /// [Node::id](crate::Node::id) of the start of the edge.
+    pub from: i64,
+
+    /// [Node::id](crate::Node::id) of the end of the edge.
+    pub to: i64,
+
+    /// Multiplier of the base cost of the edge. [f32::INFINITY] closes the edge.
+    pub factor: f32,
+}
+
+/// Immutable [FrozenGraph] with the costs published by a [CostOverlay] at a given epoch.
+///
+/// Dereferences to the [FrozenGraph], so it can be used for routing directly.
+#[derive(Debug, Clone)]
+pub struct CostSnapshot {
+    /// Epoch at which the snapshot was published. Epochs are drawn from the same process-wide
+    /// counter as [Graph::epoch](crate::Graph::epoch), so they increase with every publication,
+    /// and snapshots of different overlays never share an epoch.
+    pub epoch: u64,
+
+    /// Graph with the published costs.
+    pub graph: Arc<FrozenGraph>,
+}
+
+impl Deref for CostSnapshot {
+    type Target = FrozenGraph;
+
+    #[inline]
+    fn deref(&self) -> &FrozenGraph {
+        &self.graph
+    }
+}
+
+/// Epoch-based, copy-on-write overlay of edge costs over a [FrozenGraph],
+/// for live traffic updates while route queries are running.
+///
+/// Writers publish new costs as multipliers ("factors") of the base costs of the graph.
+/// Every publication builds a new cost array, which shares all other arrays with the base graph,
+/// and atomically replaces the current [CostSnapshot], advancing the epoch.
+/// Readers take a snapshot (a reference-count increment under a briefly held lock)
+/// and route on it without any further synchronization. Old snapshots stay valid for
+/// as long as they are used.
+///
+/// Published costs are never lower than the crow-flies distance between the edge's endpoints
+/// (or the base cost, if it already was lower), so that the A* heuristic remains admissible.
+/// [Landmarks](crate::Landmarks) built for the base graph are accepted by snapshots
+/// as long as all factors are at least 1.
+///
+/// # Example
+///
+/// ```no_run
+/// let overlay = routx::CostOverlay::new(routx::Graph::new().freeze());
+///
+/// // Writer thread
+/// overlay.update_factors(&[routx::EdgeFactor { from: 1, to: 2, factor: 1.5 }]);
+///
+/// // Reader threads
+/// let g = overlay.snapshot();
+/// let route = g.find_route(1, 3, routx::DEFAULT_STEP_LIMIT);
+/// ```
+#[derive(Debug)]
+pub struct CostOverlay {
+    base: Arc<FrozenGraph>,
+
+    /// Lowest allowed cost of every edge.
+    floors: Vec<f32>,
+
+    /// Currently published factors; also serializes writers.
+    factors: Mutex<Vec<f32>>,
+
+    current: RwLock<CostSnapshot>,
+}
+
+impl CostOverlay {
+    /// Creates an overlay with the costs of the provided graph (all factors equal to 1)
+    /// published at a new epoch.
+    pub fn new(base: FrozenGraph) -> Self {
+        let mut floors = Vec::with_capacity(base.edge_count());
+        for from in 0..base.len() as u32 {
+            let (lat, lon) = (base.lats[from as usize], base.lons[from as usize]);
+            for (to, cost) in base.edges_at(from) {
+                let distance =
+                    earth_distance(lat, lon, base.lats[to as usize], base.lons[to as usize]);
+                floors.push(cost.min(distance));
+            }
+        }
+
+        let base = Arc::new(base);
+        Self {
+            floors,
+            factors: Mutex::new(vec![1.0; base.edge_count()]),
+            current: RwLock::new(CostSnapshot {
+                epoch: next_epoch(),
+                graph: Arc::clone(&base),
+            }),
+            base,
+        }
+    }
+
+    /// Returns the graph with the base costs.
+    pub fn base(&self) -> &FrozenGraph {
+        &self.base
+    }
+
+    /// Returns the most recently published snapshot.
+    pub fn snapshot(&self) -> CostSnapshot {
+        self.current.read().unwrap().clone()
+    }
+
+    /// Returns the epoch of the most recently published snapshot.
+    pub fn epoch(&self) -> u64 {
+        self.current.read().unwrap().epoch
+    }
+
+    /// Publishes new factors of all edges, in the order of dense edge indices
+    /// (see [FrozenGraph::with_edge_costs]). Returns the epoch of the new snapshot.
+    ///
+    /// Panics if `factors.len()` is different than the number of edges of the graph.
+    pub fn set_factors(&self, factors: &[f32]) -> u64 {
+        let mut current = self.factors.lock().unwrap();
+        current.copy_from_slice(factors);
+        self.publish(&current)
+    }
+
+    /// Publishes new factors of the provided edges, keeping the factors of all other edges.
+    /// Factors of edges which don't exist are ignored; all edges between the same pair
+    /// of nodes receive the same factor. Returns the epoch of the new snapshot.
+    pub fn update_factors(&self, updates: &[EdgeFactor]) -> u64 {
+        let mut current = self.factors.lock().unwrap();
+        for u in updates {
+            for e in self.base.edge_indices(u.from, u.to) {
+                current[e] = u.factor;
+            }
+        }
+        self.publish(&current)
+    }
+
+    /// Builds and publishes a snapshot with the provided factors. Must be called
+    /// with the factors lock held.
+    fn publish(&self, factors: &[f32]) -> u64 {
+        // NOTE: f32::max ignores NaNs, so invalid factors fall back to the floor.
+        let costs: Vec<f32> = self
+            .base
+            .edge_costs
+            .iter()
+            .zip(factors)
+            .zip(&self.floors)
+            .map(|((&cost, &factor), &floor)| (cost * factor).max(floor))
+            .collect();
+        let raised_only = costs
+            .iter()
+            .zip(self.base.edge_costs.iter())
+            .all(|(new, old)| new >= old);
+        let graph = Arc::new(self.base.with_edge_costs(costs));
+        if raised_only {
+            // Landmarks built for the base graph remain admissible
+            graph.inherit_fingerprint(&self.base);
+        }
+
+        let mut current = self.current.write().unwrap();
+        current.epoch = next_epoch();
+        current.graph = graph;
+        current.epoch
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{Graph, Node};
+
+    fn fixture() -> CostOverlay {
+        // 1 ─100─> 2 ─100─> 3
+        //  └──────300──────┘
+        // (nodes are ~11 m apart, so the crow-flies floor is ~0.011 or ~0.022 km)
+        let g = Graph::from_iter(
+            (1..=3).map(|id| Node {
+                id,
+                osm_id: id,
+                lat: 0.0,
+                lon: id as f32 * 0.0001,
+            }),
+            [(1, 2, 100.0), (2, 3, 100.0), (1, 3, 300.0)],
+        );
+        CostOverlay::new(g.freeze())
+    }
+
+    #[test]
+    fn update_factors() {
+        let overlay = fixture();
+        let before = overlay.snapshot();
+        assert_ne!(before.epoch, 0);
+        assert_eq!(before.find_route(1, 3, 100), Ok(vec![1, 2, 3]));
+
+        let epoch = overlay.update_factors(&[
+            EdgeFactor {
+                from: 2,
+                to: 3,
+                factor: 3.0,
+            },
+            EdgeFactor {
+                from: 3,
+                to: 42,
+                factor: 3.0,
+            },
+        ]);
+        assert!(epoch > before.epoch);
+        assert_eq!(overlay.epoch(), epoch);
+
+        // Epochs are never shared between overlays
+        assert!(fixture().epoch() > epoch);
+
+        let after = overlay.snapshot();
+        assert_eq!(after.get_edge(2, 3), 300.0);
+        assert_eq!(after.get_edge(1, 2), 100.0);
+        assert_eq!(after.find_route(1, 3, 100), Ok(vec![1, 3]));
+
+        // Old snapshots are not affected, and topology is shared
+        assert_eq!(before.get_edge(2, 3), 100.0);
+        assert_eq!(before.find_route(1, 3, 100), Ok(vec![1, 2, 3]));
+        assert!(std::ptr::eq(before.ids.as_ptr(), after.ids.as_ptr()));
+    }
+
+    #[test]
+    fn set_factors_keeps_floor() {
+        let overlay = fixture();
+        let base_epoch = overlay.epoch();
+        overlay.set_factors(&[0.0, f32::NAN, f32::INFINITY]);
+        let g = overlay.snapshot();
+        let distance = |from: i64, to: i64| {
+            let (from, to) = (g.get_node(from).unwrap(), g.get_node(to).unwrap());
+            earth_distance(from.lat, from.lon, to.lat, to.lon)
+        };
+
+        assert_eq!(g.get_edge(1, 2), distance(1, 2));
+        assert_eq!(g.get_edge(1, 3), distance(1, 3));
+        assert_eq!(g.get_edge(2, 3), f32::INFINITY);
+        assert!(g.epoch > base_epoch);
+    }
+}
@@ -0,0 +1,236 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+//! Minimal work-stealing scheduler for embarrassingly parallel batches of queries.
+//!
+//! Every worker owns a contiguous range of item indices. Workers take items one-by-one
+//! from the front of their own range, and once it's exhausted, steal the back half
+//! of the largest remaining range of another worker. As no new work is ever created,
+//! a worker exits once all ranges are empty.
+
+use std::num::NonZeroUsize;
+use std::ops::Range;
+use std::sync::Mutex;
+use std::thread;
+
+/// Returns the number of threads to use for the provided requested number of threads
+/// and amount of work. Zero requested threads stands for the available parallelism.
+pub(crate) fn effective_threads(requested: usize, work: usize) -> usize {
+    let threads = if requested == 0 {
+        thread::available_parallelism()
+            .map(NonZeroUsize::get)
+            .unwrap_or(1)
+    } else {
+        requested
+    };
+    threads.min(work).max(1)
+}
+
+struct Worker {
+    range: Mutex<Range<usize>>,
+}
+
+impl Worker {
+    fn next(&self) -> Option<usize> {
+        let mut range = self.range.lock().unwrap();
+        range.next()
+    }
+}
+
+/// Steals the back half of the largest range of a worker other than `me`,
+/// and stores it as the range of `me`. Returns `false` if there was nothing to steal.
+fn steal(workers: &[Worker], me: usize) -> bool {
+    loop {
+        let victim = (0..workers.len())
+            .filter(|&i| i != me)
+            .map(|i| (i, workers[i].range.lock().unwrap().len()))
+            .max_by_key(|&(_, len)| len);
+
+        let victim = match victim {
+            Some((victim, len)) if len > 0 => victim,
+            _ => return false,
+        };
+
+        let stolen = {
+            let mut range = workers[victim].range.lock().unwrap();
+            if range.is_empty() {
+                // Victim has finished its work in the meantime, look for another one
+                continue;
+            }
+
+            let mid = range.start + range.len() / 2;
+            let stolen = mid..range.end;
+            range.end = mid;
+            stolen
+        };
+
+        *workers[me].range.lock().unwrap() = stolen;
+        return true;
+    }
+}
+
+/// Calls `f(&mut state, i)` for every `i` in `0..n`, spreading the calls over `threads` worker
+/// threads. Every worker creates its own state with `init`.
+///
+/// With a single thread, all calls are made on the current thread.
+pub(crate) fn for_each<S, I, F>(n: usize, threads: usize, init: I, f: F)
+where
+    I: Fn() -> S + Sync,
+    F: Fn(&mut S, usize) + Sync,
+{
+    let threads = effective_threads(threads, n);
+    if threads == 1 {
+        let mut state = init();
+        (0..n).for_each(|i| f(&mut state, i));
+        return;
+    }
+
+    let workers: Vec<Worker> = (0..threads)
+        .map(|t| Worker {
+            range: Mutex::new((n * t / threads)..(n * (t + 1) / threads)),
+        })
+        .collect();
+
+    thread::scope(|s| {
+        for me in 0..threads {
+            let (workers, init, f) = (&workers, &init, &f);
+            s.spawn(move || {
+                let mut state = init();
+                loop {
+                    while let Some(i) = workers[me].next() {
+                        f(&mut state, i);
+                    }
+                    if !steal(workers, me) {
+                        break;
+                    }
+                }
+            });
+        }
+    });
+}
+
+/// Pointer to the start of an output buffer, shared between workers.
+/// Safe to use as long as every index is written by exactly one worker.
+struct SharedOutput<R>(*mut R);
+
+unsafe impl<R: Send> Sync for SharedOutput<R> {}
+
+impl<R> SharedOutput<R> {
+    /// Writes a value at the provided index of the buffer, without dropping the previous one.
+    ///
+    /// # Safety
+    ///
+    /// `i` must be within the allocated buffer, and no other thread may access it concurrently.
+    unsafe fn write(&self, i: usize, value: R) {
+        self.0.add(i).write(value)
+    }
+
+    /// Replaces a value at the provided index of the buffer, dropping the previous one.
+    ///
+    /// # Safety
+    ///
+    /// `i` must be within the initialized buffer, and no other thread may access it concurrently.
+    unsafe fn replace(&self, i: usize, value: R) {
+        *self.0.add(i) = value
+    }
+}
+
+/// Maps every item through `f(&mut state, item)` on `threads` worker threads,
+/// see [for_each]. The results are returned in the order of items.
+pub(crate) fn map<T, R, S, I, F>(items: &[T], threads: usize, init: I, f: F) -> Vec<R>
+where
+    T: Sync,
+    R: Send,
+    I: Fn() -> S + Sync,
+    F: Fn(&mut S, &T) -> R + Sync,
+{
+    let mut results: Vec<R> = Vec::with_capacity(items.len());
+    let out = SharedOutput(results.as_mut_ptr());
+
+    for_each(items.len(), threads, init, |state, i| {
+        let r = f(state, &items[i]);
+        // SAFETY: for_each calls f exactly once for every index in 0..items.len(),
+        // which is within the allocated capacity.
+        unsafe { out.write(i, r) };
+    });
+
+    // SAFETY: for_each has returned normally, so all items were initialized.
+    // If any worker panicked, the panic is propagated by thread::scope before this point.
+    unsafe { results.set_len(items.len()) };
+    results
+}
+
+/// Sets every `out[i]` to `f(&mut state, i)` on `threads` worker threads, see [for_each].
+pub(crate) fn fill<R, S, I, F>(out: &mut [R], threads: usize, init: I, f: F)
+where
+    R: Send,
+    I: Fn() -> S + Sync,
+    F: Fn(&mut S, usize) -> R + Sync,
+{
+    let n = out.len();
+    let shared = SharedOutput(out.as_mut_ptr());
+
+    for_each(n, threads, init, |state, i| {
+        let r = f(state, i);
+        // SAFETY: for_each calls f exactly once for every index in 0..out.len().
+        unsafe { shared.replace(i, r) };
+    });
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::atomic::{AtomicUsize, Ordering};
+
+    #[test]
+    fn for_each_visits_all_once() {
+        for threads in [1, 2, 3, 8] {
+            let visits: Vec<AtomicUsize> = (0..1000).map(|_| AtomicUsize::new(0)).collect();
+            for_each(
+                visits.len(),
+                threads,
+                || (),
+                |_, i| {
+                    visits[i].fetch_add(1, Ordering::Relaxed);
+                },
+            );
+            assert!(visits.iter().all(|v| v.load(Ordering::Relaxed) == 1));
+        }
+    }
+
+    #[test]
+    fn map_preserves_order() {
+        let items: Vec<usize> = (0..1000).collect();
+        let results = map(
+            &items,
+            4,
+            || 0_usize,
+            |calls, &x| {
+                *calls += 1;
+                x * 2
+            },
+        );
+        assert_eq!(results, (0..1000).map(|x| x * 2).collect::<Vec<_>>());
+    }
+
+    #[test]
+    fn fill_all() {
+        let mut out = vec![0_usize; 1000];
+        fill(&mut out, 4, || (), |_, i| i + 1);
+        assert_eq!(out, (1..=1000).collect::<Vec<_>>());
+    }
+
+    #[test]
+    fn map_empty() {
+        let results: Vec<usize> = map(&[] as &[usize], 4, || (), |_, &x| x);
+        assert!(results.is_empty());
+    }
+
+    #[test]
+    fn effective_threads() {
+        assert_eq!(super::effective_threads(4, 2), 2);
+        assert_eq!(super::effective_threads(4, 0), 1);
+        assert_eq!(super::effective_threads(3, 100), 3);
+        assert!(super::effective_threads(0, 100) >= 1);
+    }
+}
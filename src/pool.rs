@@ -0,0 +1,404 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+use std::collections::VecDeque;
+use std::panic::{self, AssertUnwindSafe};
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread;
+use std::time::{Duration, Instant};
+
+use crate::{parallel, AStarError, CancelToken, FrozenGraph, RouteRequest, SearchContext};
+
+/// Pool of worker threads answering [RouteRequest]s in the background, for callers
+/// which must not block for the duration of a search (like event loops).
+///
+/// Every worker keeps its own [SearchContext]. Searches are started in the order
+/// of submission, and every [RouteTask] can be cancelled or given a deadline, so that
+/// long searches can be stopped instead of delaying the ones queued behind them.
+///
+/// Dropping the pool waits for all submitted searches to finish. Workers outlive panics
+/// of searches and of [RouteTask::on_done] callbacks - see [RouteTask::wait].
+///
+/// ```no_run
+/// let g = routx::Graph::new().freeze();
+/// let pool = routx::SearchPool::new(0);
+///
+/// let request = routx::RouteRequest {
+///     from: 1,
+///     to: 2,
+///     step_limit: routx::DEFAULT_STEP_LIMIT,
+///     without_turn_around: false,
+/// };
+/// let task = pool.submit(&g, request, Some(std::time::Duration::from_millis(100)));
+/// task.on_done(|| println!("route found"));
+/// let route = task.wait();
+/// ```
+#[derive(Debug)]
+pub struct SearchPool {
+    queue: Arc<JobQueue>,
+    workers: Vec<thread::JoinHandle<()>>,
+}
+
+impl SearchPool {
+    /// Starts a pool with the provided number of worker threads.
+    /// Zero threads stands for the available parallelism.
+    pub fn new(threads: usize) -> Self {
+        let queue = Arc::new(JobQueue::default());
+        let workers = (0..parallel::effective_threads(threads, usize::MAX))
+            .map(|_| {
+                let queue = Arc::clone(&queue);
+                thread::spawn(move || work(&queue))
+            })
+            .collect();
+        Self { queue, workers }
+    }
+
+    /// Returns the number of worker threads.
+    pub fn threads(&self) -> usize {
+        self.workers.len()
+    }
+
+    /// Queues a search on a (cheap) clone of the provided graph. If a `timeout` is provided,
+    /// the search fails with [AStarError::DeadlineExceeded] once that time passes
+    /// since the submission, including the time spent waiting in the queue.
+    ///
+    /// Requests with a zero `from` or `to` id fail right away with
+    /// [AStarError::InvalidReference], without being queued.
+    pub fn submit(
+        &self,
+        graph: &FrozenGraph,
+        request: RouteRequest,
+        timeout: Option<Duration>,
+    ) -> RouteTask {
+        let task = Arc::new(TaskState::default());
+        if request.from == 0 || request.to == 0 {
+            task.finish(Ok(Err(AStarError::InvalidReference(0))));
+            return RouteTask { state: task };
+        }
+
+        self.queue.push(Job {
+            graph: graph.clone(),
+            request,
+            deadline: timeout.map(|t| Instant::now() + t),
+            task: Arc::clone(&task),
+        });
+        RouteTask { state: task }
+    }
+}
+
+impl Drop for SearchPool {
+    fn drop(&mut self) {
+        self.queue.close();
+        for worker in self.workers.drain(..) {
+            let _ = worker.join();
+        }
+    }
+}
+
+/// Handle to a search submitted to a [SearchPool].
+///
+/// Dropping the handle doesn't stop the search - call [RouteTask::cancel] for that.
+#[derive(Debug)]
+pub struct RouteTask {
+    state: Arc<TaskState>,
+}
+
+impl RouteTask {
+    /// Returns `true` if the search has finished, so that [RouteTask::wait] won't block.
+    pub fn is_done(&self) -> bool {
+        self.state.outcome.lock().unwrap().done
+    }
+
+    /// Asks the search to stop; it then fails with [AStarError::Cancelled],
+    /// unless it has already finished. Searches which haven't started yet are never started.
+    pub fn cancel(&self) {
+        self.state.cancel.cancel();
+    }
+
+    /// Registers a callback invoked (on the worker thread) once the search finishes,
+    /// replacing any previously registered callback.
+    ///
+    /// Returns `false` if the search has already finished - in this case the callback
+    /// is dropped without being called.
+    pub fn on_done<F: FnOnce() + Send + 'static>(&self, callback: F) -> bool {
+        let mut outcome = self.state.outcome.lock().unwrap();
+        if outcome.done {
+            return false;
+        }
+        outcome.on_done = Some(Box::new(callback));
+        true
+    }
+
+    /// Waits for the search to finish and returns its result.
+    ///
+    /// If the search has panicked, the panic is resumed on the calling thread
+    /// (like with [JoinHandle::join](thread::JoinHandle::join)).
+    pub fn wait(self) -> Result<Vec<i64>, AStarError> {
+        let mut outcome = self.state.outcome.lock().unwrap();
+        while !outcome.done {
+            outcome = self.state.finished.wait(outcome).unwrap();
+        }
+        let result = outcome.result.take();
+        drop(outcome);
+
+        match result {
+            Some(Ok(result)) => result,
+            Some(Err(panic)) => panic::resume_unwind(panic),
+            None => Ok(vec![]),
+        }
+    }
+}
+
+#[derive(Default)]
+struct Outcome {
+    done: bool,
+    result: Option<thread::Result<Result<Vec<i64>, AStarError>>>,
+    on_done: Option<Box<dyn FnOnce() + Send>>,
+}
+
+#[derive(Default)]
+struct TaskState {
+    cancel: CancelToken,
+    outcome: Mutex<Outcome>,
+    finished: Condvar,
+}
+
+impl std::fmt::Debug for TaskState {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("TaskState")
+            .field("cancel", &self.cancel)
+            .finish_non_exhaustive()
+    }
+}
+
+impl TaskState {
+    /// Publishes the result of the search (or its panic) and invokes the callback,
+    /// outside of the lock.
+    fn finish(&self, result: thread::Result<Result<Vec<i64>, AStarError>>) {
+        let callback = {
+            let mut outcome = self.outcome.lock().unwrap();
+            outcome.done = true;
+            outcome.result = Some(result);
+            outcome.on_done.take()
+        };
+        self.finished.notify_all();
+        if let Some(callback) = callback {
+            // The result is already published, and the panic hook has reported the panic,
+            // so there's nothing else to do with it - but the worker must keep running
+            let _ = panic::catch_unwind(AssertUnwindSafe(callback));
+        }
+    }
+}
+
+struct Job {
+    graph: FrozenGraph,
+    request: RouteRequest,
+    deadline: Option<Instant>,
+    task: Arc<TaskState>,
+}
+
+/// FIFO queue of [Job]s shared by the workers of a [SearchPool].
+#[derive(Debug, Default)]
+struct JobQueue {
+    /// Pending jobs and whether the queue was closed.
+    jobs: Mutex<(VecDeque<Job>, bool)>,
+    available: Condvar,
+}
+
+impl std::fmt::Debug for Job {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("Job")
+            .field("request", &self.request)
+            .field("deadline", &self.deadline)
+            .finish_non_exhaustive()
+    }
+}
+
+impl JobQueue {
+    fn push(&self, job: Job) {
+        self.jobs.lock().unwrap().0.push_back(job);
+        self.available.notify_one();
+    }
+
+    /// Waits for the next job. Returns `None` once the queue is closed and empty.
+    fn pop(&self) -> Option<Job> {
+        let mut jobs = self.jobs.lock().unwrap();
+        loop {
+            if let Some(job) = jobs.0.pop_front() {
+                return Some(job);
+            } else if jobs.1 {
+                return None;
+            }
+            jobs = self.available.wait(jobs).unwrap();
+        }
+    }
+
+    fn close(&self) {
+        self.jobs.lock().unwrap().1 = true;
+        self.available.notify_all();
+    }
+}
+
+fn work(queue: &JobQueue) {
+    let mut ctx = SearchContext::new();
+    while let Some(job) = queue.pop() {
+        ctx.set_cancel_token(Some(job.task.cancel.clone()));
+        ctx.set_deadline(job.deadline);
+        let result = panic::catch_unwind(AssertUnwindSafe(|| {
+            ctx.interrupted()
+                .and_then(|()| job.graph.find_route_with_request(&mut ctx, &job.request))
+        }));
+        if result.is_err() {
+            // State of an interrupted search can't be trusted
+            ctx = SearchContext::new();
+        }
+        job.task.finish(result);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{Graph, Node};
+    use std::sync::mpsc;
+
+    fn line(len: i64) -> FrozenGraph {
+        Graph::from_iter(
+            (1..=len).map(|id| Node {
+                id,
+                osm_id: id,
+                lat: 0.0,
+                lon: id as f32 * 0.001,
+            }),
+            (1..len).map(|id| (id, id + 1, 200.0)),
+        )
+        .freeze()
+    }
+
+    fn request(from: i64, to: i64) -> RouteRequest {
+        RouteRequest {
+            from,
+            to,
+            step_limit: 1_000_000,
+            without_turn_around: false,
+        }
+    }
+
+    #[test]
+    fn submit() {
+        let g = line(10);
+        let pool = SearchPool::new(2);
+        assert_eq!(pool.threads(), 2);
+
+        let tasks: Vec<_> = (2..=10)
+            .map(|to| pool.submit(&g, request(1, to), None))
+            .collect();
+        for (task, to) in tasks.into_iter().zip(2..=10) {
+            assert_eq!(task.wait(), Ok((1..=to).collect::<Vec<_>>()));
+        }
+
+        let task = pool.submit(&g, request(1, 42), None);
+        assert_eq!(task.wait(), Err(AStarError::InvalidReference(42)));
+    }
+
+    #[test]
+    fn submit_zero_id() {
+        let g = line(10);
+        let pool = SearchPool::new(1);
+
+        for r in [request(0, 5), request(5, 0)] {
+            let task = pool.submit(&g, r, None);
+            assert!(task.is_done());
+            assert_eq!(task.wait(), Err(AStarError::InvalidReference(0)));
+        }
+        assert_eq!(
+            pool.submit(&g, request(1, 3), None).wait(),
+            Ok(vec![1, 2, 3])
+        );
+    }
+
+    #[test]
+    fn panicking_callback() {
+        let g = line(10);
+        let pool = SearchPool::new(1);
+
+        let (release, blocked) = mpsc::channel::<()>();
+        let blocker = pool.submit(&g, request(1, 2), None);
+        assert!(blocker.on_done(move || blocked.recv().unwrap()));
+        let task = pool.submit(&g, request(1, 5), None);
+        assert!(task.on_done(|| panic!("panicking callback")));
+        release.send(()).unwrap();
+        assert_eq!(task.wait(), Ok(vec![1, 2, 3, 4, 5]));
+
+        // The only worker must have survived the panic
+        assert_eq!(
+            pool.submit(&g, request(1, 3), None).wait(),
+            Ok(vec![1, 2, 3])
+        );
+    }
+
+    #[test]
+    fn on_done() {
+        let g = line(10);
+        let pool = SearchPool::new(1);
+
+        // Keep the only worker busy, so that the callback is registered in time
+        let (release, blocked) = mpsc::channel::<()>();
+        let blocker = pool.submit(&g, request(1, 2), None);
+        assert!(blocker.on_done(move || blocked.recv().unwrap()));
+
+        let (done, finished) = mpsc::channel();
+        let task = pool.submit(&g, request(1, 10), None);
+        assert!(task.on_done(move || done.send(()).unwrap()));
+        release.send(()).unwrap();
+
+        finished.recv().unwrap();
+        assert!(task.is_done());
+        assert!(!task.on_done(|| panic!("callback of a finished task")));
+        assert_eq!(task.wait().map(|r| r.len()), Ok(10));
+    }
+
+    #[test]
+    fn cancel_and_deadline() {
+        // Without a route between the halves, searches expand all 100 000 nodes of the first one
+        let g = Graph::from_iter(
+            (1..=200_000).map(|id| Node {
+                id,
+                osm_id: id,
+                lat: 0.0,
+                lon: id as f32 * 0.00001,
+            }),
+            (1..100_000).map(|id| (id, id + 1, 2.0)),
+        )
+        .freeze();
+        let pool = SearchPool::new(1);
+
+        let (release, blocked) = mpsc::channel::<()>();
+        let blocker = pool.submit(&g, request(1, 2), None);
+        assert!(blocker.on_done(move || blocked.recv().unwrap()));
+        let task = pool.submit(&g, request(1, 200_000), None);
+        task.cancel();
+        release.send(()).unwrap();
+        assert_eq!(task.wait(), Err(AStarError::Cancelled));
+
+        let task = pool.submit(&g, request(1, 200_000), Some(Duration::ZERO));
+        assert_eq!(task.wait(), Err(AStarError::DeadlineExceeded));
+
+        let mut ctx = SearchContext::new();
+        let token = CancelToken::new();
+        ctx.set_cancel_token(Some(token.clone()));
+        assert_eq!(
+            g.find_route_with_context(&mut ctx, 1, 200_000, 1_000_000),
+            Ok(vec![])
+        );
+        token.cancel();
+        assert_eq!(
+            g.find_route_with_context(&mut ctx, 1, 200_000, 1_000_000),
+            Err(AStarError::Cancelled)
+        );
+        assert_eq!(
+            g.find_route_with_context(&mut ctx, 1, 2, 1_000_000),
+            Err(AStarError::Cancelled)
+        );
+    }
+}
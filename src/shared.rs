@@ -0,0 +1,93 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+use std::sync::{Arc, RwLock};
+
+/// Holds a shared, immutable value (like a [Graph](crate::Graph)) which can be atomically
+/// replaced while other threads are using it.
+///
+/// Readers [load](SwapCell::load) their own [Arc] and keep using it for as long as they need,
+/// so queries which are in flight during a [store](SwapCell::store) finish on the old value,
+/// while all later loads see the new one. The lock is only held for the duration of cloning or
+/// replacing the [Arc] - never while a value is used, built or dropped.
+///
+/// ```
+/// use std::sync::Arc;
+///
+/// let cell = routx::SwapCell::new(Arc::new(routx::Graph::new()));
+///
+/// // Reader threads
+/// let g = cell.load();
+/// let route = routx::find_route(&g, 1, 2, routx::DEFAULT_STEP_LIMIT);
+///
+/// // Writer thread
+/// let old = cell.store(Arc::new(routx::Graph::new()));
+/// ```
+#[derive(Debug, Default)]
+pub struct SwapCell<T> {
+    current: RwLock<Arc<T>>,
+}
+
+impl<T> SwapCell<T> {
+    /// Creates a cell holding the provided value.
+    pub fn new(value: Arc<T>) -> Self {
+        Self {
+            current: RwLock::new(value),
+        }
+    }
+
+    /// Returns the currently held value.
+    pub fn load(&self) -> Arc<T> {
+        Arc::clone(&self.current.read().unwrap())
+    }
+
+    /// Replaces the held value, returning the previous one. The previous value is only
+    /// deallocated once the returned [Arc] and all loaded copies are dropped.
+    pub fn store(&self, value: Arc<T>) -> Arc<T> {
+        std::mem::replace(&mut *self.current.write().unwrap(), value)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{Graph, Node};
+
+    fn line(len: i64) -> Graph {
+        Graph::from_iter(
+            (1..=len).map(|id| Node {
+                id,
+                osm_id: id,
+                lat: 0.0,
+                lon: id as f32 * 0.001,
+            }),
+            (1..len).map(|id| (id, id + 1, 200.0)),
+        )
+    }
+
+    #[test]
+    fn store_while_routing() {
+        let cell = SwapCell::new(Arc::new(line(10)));
+        std::thread::scope(|s| {
+            let readers: Vec<_> = (0..4)
+                .map(|_| {
+                    s.spawn(|| {
+                        for _ in 0..100 {
+                            let g = cell.load();
+                            let len = g.len() as i64;
+                            let route = crate::find_route(&g, 1, len, 1000).unwrap();
+                            assert_eq!(route, (1..=len).collect::<Vec<_>>());
+                        }
+                    })
+                })
+                .collect();
+
+            for len in 2..=20 {
+                let old = cell.store(Arc::new(line(len)));
+                assert!(old.len() >= 2);
+            }
+            readers.into_iter().for_each(|r| r.join().unwrap());
+        });
+        assert_eq!(cell.load().len(), 20);
+    }
+}
@@ -0,0 +1,905 @@
+// (c) Copyright 2025 Mikołaj Kuranowski
+// SPDX-License-Identifier: MIT
+
+use std::collections::{BTreeMap, BinaryHeap, HashMap, HashSet};
+use std::fs::{self, File};
+use std::io::{self, BufWriter, Read, Write};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, OnceLock};
+
+use crate::astar::context::QueueItem;
+use crate::distance::EARTH_RADIUS;
+use crate::frozen::{write_section, NO_INDEX};
+use crate::lru::Lru;
+use crate::mmap::{Array, Mmap};
+use crate::{
+    binary, earth_distance, AStarError, FrozenGraph, Graph, GridIndex, Node, DEFAULT_GRID_CELL_SIZE,
+};
+
+/// Recommended size of [TiledGraph] tiles, in degrees.
+pub const DEFAULT_TILE_SIZE: f32 = 1.0;
+
+/// Tiles may be at most this many times smaller than the whole range of longitudes.
+const MAX_TILES_PER_AXIS: f32 = (1 << 20) as f32;
+
+/// Name of the file describing all tiles of a [TiledGraph].
+const MANIFEST_FILE: &str = "tiles.bin";
+
+/// TiledGraph is a read-only graph split into square tiles (in degrees of latitude
+/// and longitude), stored in a directory as separate [FrozenGraph] files and loaded
+/// only when searches reach them.
+///
+/// Every node belongs to the tile containing its position. Edges are stored with the tile
+/// of their start node; if an edge crosses into another tile, the tile also includes
+/// an edge-less copy of its target (a border node), whose position tells
+/// the search which tile to load next.
+///
+/// Loaded tiles are memory-mapped (see [FrozenGraph::open_mmap]) and kept in a cache.
+/// Once the total size of files of cached tiles exceeds the memory budget, least recently used
+/// tiles are dropped - apart from the most recently used one. Tiles used by a running search
+/// stay alive until it finishes, even if they are dropped from the cache.
+///
+/// Opening the graph only maps the index of all node ids, so it is near-instant even
+/// for continent-sized graphs.
+///
+/// TiledGraph is [Sync] - the cache is guarded by a mutex, which is not held while loading
+/// tiles or searching.
+///
+/// # Example
+///
+/// ```no_run
+/// let g = routx::Graph::new();
+/// // ... load data into g ...
+///
+/// routx::TiledGraph::save(&g.freeze(), "tiles", routx::DEFAULT_TILE_SIZE).unwrap();
+///
+/// // SAFETY: Files of the graph are not modified while it's open
+/// let tiled = unsafe { routx::TiledGraph::open("tiles", 512 << 20) }.unwrap();
+/// let start_node = tiled.find_nearest_node(52.23024, 21.01062).unwrap().unwrap();
+/// let end_node = tiled.find_nearest_node(52.23852, 21.0446).unwrap().unwrap();
+/// let route = tiled.find_route(start_node.id, end_node.id, routx::DEFAULT_STEP_LIMIT);
+/// ```
+#[derive(Debug)]
+pub struct TiledGraph {
+    dir: PathBuf,
+    manifest: Manifest,
+    memory_budget: u64,
+    loaded: Mutex<LoadedTiles>,
+    loads: AtomicU64,
+    evictions: AtomicU64,
+}
+
+/// Counters of a [TiledGraph] tile cache.
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+#[repr(C)]
+pub struct TileStats {
+    /// Number of tiles of the graph.
+    pub tiles: u64,
+
+    /// Number of tiles currently in the cache.
+    pub loaded_tiles: u64,
+
+    /// Total size of files of tiles currently in the cache, in bytes.
+    pub resident_bytes: u64,
+
+    /// Number of times a tile was loaded.
+    pub loads: u64,
+
+    /// Number of times a tile was dropped from the cache to stay within the memory budget.
+    pub evictions: u64,
+}
+
+#[derive(Debug)]
+struct Tile {
+    graph: FrozenGraph,
+
+    /// Index of the canonical nodes of the tile, built on first use by
+    /// [TiledGraph::find_nearest_node].
+    index: OnceLock<Option<GridIndex>>,
+}
+
+impl Tile {
+    fn index(&self) -> Option<&GridIndex> {
+        self.index
+            .get_or_init(|| GridIndex::from_iter(self.graph.iter(), DEFAULT_GRID_CELL_SIZE))
+            .as_ref()
+    }
+}
+
+#[derive(Debug)]
+struct LoadedTiles {
+    /// Cached tiles by their indices; bounded by the memory budget, not by capacity.
+    lru: Lru<u32, Arc<Tile>>,
+
+    /// Total size of files of cached tiles.
+    resident: u64,
+}
+
+/// Division of the globe into rows and columns of square tiles.
+#[derive(Debug, Clone, Copy, PartialEq)]
+struct Tiling {
+    /// Height and width of a tile, in degrees.
+    size: f32,
+    rows: u32,
+    cols: u32,
+}
+
+impl Tiling {
+    fn new(size: f32) -> Option<Self> {
+        if !(size.is_finite() && size > 0.0 && 360.0 / size <= MAX_TILES_PER_AXIS) {
+            return None;
+        }
+        Some(Self {
+            size,
+            rows: (180.0 / size).ceil() as u32,
+            cols: (360.0 / size).ceil() as u32,
+        })
+    }
+
+    /// Returns the `(row, column)` of the tile containing the provided position.
+    fn cell_of(&self, lat: f32, lon: f32) -> (u32, u32) {
+        let row = ((lat + 90.0) / self.size).floor().max(0.0) as u32;
+        let col = ((lon + 180.0) / self.size).floor().max(0.0) as u32;
+        (row.min(self.rows - 1), col.min(self.cols - 1))
+    }
+
+    /// Returns the key of the tile containing the provided position.
+    fn key_of(&self, lat: f32, lon: f32) -> u64 {
+        let (row, col) = self.cell_of(lat, lon);
+        key(row, col)
+    }
+}
+
+#[inline]
+fn key(row: u32, col: u32) -> u64 {
+    (row as u64) << 32 | col as u64
+}
+
+/// Returns the name of the file of a tile with the provided key.
+fn tile_file(key: u64) -> String {
+    format!("tile_{}_{}.bin", key >> 32, key & 0xFFFF_FFFF)
+}
+
+/// Index of all tiles and nodes of a [TiledGraph], stored in [MANIFEST_FILE].
+#[derive(Debug)]
+struct Manifest {
+    tiling: Tiling,
+
+    /// Sorted keys (`row << 32 | column`) of all tiles.
+    keys: Array<u64>,
+
+    /// Sizes of the files of all tiles, in bytes.
+    sizes: Array<u64>,
+
+    /// Sorted [Node::id] of all nodes.
+    ids: Array<i64>,
+
+    /// Index of the tile (in `keys`) of every node in `ids`.
+    node_tiles: Array<u32>,
+}
+
+/// Magic bytes at the start of a serialized [Manifest].
+const MAGIC: &[u8; 8] = b"RoutxTLS";
+
+/// Version of the serialized [Manifest] format.
+const VERSION: u32 = 1;
+
+/// Size of the serialized [Manifest] header: magic, version, reserved flags, tile size,
+/// padding, number of tiles and number of nodes.
+const HEADER_SIZE: u64 = 40;
+
+/// Returns the byte offsets of the arrays of a serialized [Manifest], in order: keys, sizes,
+/// ids and node_tiles. The last element is the total size of the file.
+fn layout(tiles: u64, nodes: u64) -> [u64; 5] {
+    let sizes = [tiles * 8, tiles * 8, nodes * 8, nodes * 4];
+    let mut offsets = [0; 5];
+    let mut offset = HEADER_SIZE;
+    for (i, size) in sizes.into_iter().enumerate() {
+        offset = offset.next_multiple_of(crate::frozen::ALIGNMENT);
+        offsets[i] = offset;
+        offset += size;
+    }
+    offsets[4] = offset;
+    offsets
+}
+
+/// Reads and validates the header of a serialized [Manifest],
+/// returning the tiling, and the number of tiles and nodes.
+fn read_header<R: Read>(r: &mut R) -> io::Result<(Tiling, u64, u64)> {
+    let mut magic = [0_u8; 8];
+    r.read_exact(&mut magic)?;
+    if &magic != MAGIC {
+        return Err(binary::invalid_data("not a routx tile manifest"));
+    }
+    if binary::read::<_, u32>(r)? != VERSION {
+        return Err(binary::invalid_data(
+            "unsupported routx tile manifest version",
+        ));
+    }
+    let _flags: u32 = binary::read(r)?;
+    let tile_size: f32 = binary::read(r)?;
+    let _padding: u32 = binary::read(r)?;
+    let tiles: u64 = binary::read(r)?;
+    let nodes: u64 = binary::read(r)?;
+
+    let tiling =
+        Tiling::new(tile_size).ok_or_else(|| binary::invalid_data("invalid routx tile size"))?;
+    if tiles >= NO_INDEX as u64 || nodes > (isize::MAX as u64) / 8 {
+        return Err(binary::invalid_data(
+            "too many tiles or nodes in routx tile manifest",
+        ));
+    }
+    Ok((tiling, tiles, nodes))
+}
+
+impl Manifest {
+    fn write<W: Write>(&self, w: &mut W) -> io::Result<()> {
+        let offsets = layout(self.keys.len() as u64, self.ids.len() as u64);
+        w.write_all(MAGIC)?;
+        binary::write(w, VERSION)?;
+        binary::write(w, 0_u32)?;
+        binary::write(w, self.tiling.size)?;
+        binary::write(w, 0_u32)?;
+        binary::write(w, self.keys.len() as u64)?;
+        binary::write(w, self.ids.len() as u64)?;
+
+        let mut p = HEADER_SIZE;
+        write_section(w, &mut p, offsets[0], &self.keys)?;
+        write_section(w, &mut p, offsets[1], &self.sizes)?;
+        write_section(w, &mut p, offsets[2], &self.ids)?;
+        write_section(w, &mut p, offsets[3], &self.node_tiles)?;
+        Ok(())
+    }
+
+    #[cfg(not(all(unix, target_endian = "little")))]
+    fn read<R: Read>(r: &mut R) -> io::Result<Self> {
+        use crate::frozen::read_section;
+
+        let (tiling, tiles, nodes) = read_header(r)?;
+        let offsets = layout(tiles, nodes);
+        let (t, n) = (tiles as usize, nodes as usize);
+
+        let mut p = HEADER_SIZE;
+        Ok(Self {
+            tiling,
+            keys: read_section(r, &mut p, offsets[0], t)?,
+            sizes: read_section(r, &mut p, offsets[1], t)?,
+            ids: read_section(r, &mut p, offsets[2], n)?,
+            node_tiles: read_section(r, &mut p, offsets[3], n)?,
+        })
+    }
+
+    /// Opens a manifest by memory-mapping it, or on non-unix or big-endian platforms,
+    /// by reading it into memory.
+    ///
+    /// # Safety
+    ///
+    /// The file must not be modified while the manifest is alive, see [Mmap::map].
+    unsafe fn open(path: &Path) -> io::Result<Self> {
+        #[cfg(all(unix, target_endian = "little"))]
+        {
+            // SAFETY: Upheld by the caller
+            let map = Arc::new(unsafe { Mmap::map(&File::open(path)?) }?);
+            let bytes = map.as_bytes();
+            let (tiling, tiles, nodes) = read_header(&mut &bytes[..])?;
+            let offsets = layout(tiles, nodes);
+            if (bytes.len() as u64) < offsets[4] {
+                return Err(io::ErrorKind::UnexpectedEof.into());
+            }
+
+            let (t, n) = (tiles as usize, nodes as usize);
+            let at = |i: usize| offsets[i] as usize;
+            Ok(Self {
+                tiling,
+                keys: Array::mapped(&map, at(0), t),
+                sizes: Array::mapped(&map, at(1), t),
+                ids: Array::mapped(&map, at(2), n),
+                node_tiles: Array::mapped(&map, at(3), n),
+            })
+        }
+
+        #[cfg(not(all(unix, target_endian = "little")))]
+        {
+            Self::read(&mut io::BufReader::new(File::open(path)?))
+        }
+    }
+
+    /// Returns the index of the tile with the provided key.
+    fn tile_with_key(&self, key: u64) -> Option<u32> {
+        self.keys.binary_search(&key).ok().map(|t| t as u32)
+    }
+
+    /// Returns the index of the tile containing the provided position.
+    fn tile_at(&self, lat: f32, lon: f32) -> Option<u32> {
+        self.tile_with_key(self.tiling.key_of(lat, lon))
+    }
+
+    /// Returns the index of the tile containing the node with the provided id.
+    fn tile_of_node(&self, id: i64) -> Option<u32> {
+        let idx = self.ids.binary_search(&id).ok()?;
+        Some(self.node_tiles[idx])
+    }
+}
+
+/// Node reached by a [TiledGraph::find_route] search.
+#[derive(Debug, Clone, Copy)]
+struct Label {
+    id: i64,
+    tile: u32,
+    cost: f32,
+
+    /// Label of the previous node of the route, or [NO_INDEX].
+    prev: u32,
+}
+
+impl TiledGraph {
+    /// Splits a graph into tiles of `tile_size` degrees, and saves them along with
+    /// an index of all nodes into the `dir` directory, creating it if necessary.
+    ///
+    /// Panics if `tile_size` is not a positive, finite number, or if the globe would be split
+    /// into more than 2<sup>20</sup> columns of tiles.
+    pub fn save<P: AsRef<Path>>(g: &FrozenGraph, dir: P, tile_size: f32) -> io::Result<()> {
+        let tiling = Tiling::new(tile_size).expect("tile_size must be a positive, finite number");
+        let dir = dir.as_ref();
+        fs::create_dir_all(dir)?;
+
+        let mut tiles: BTreeMap<u64, Vec<u32>> = BTreeMap::default();
+        for idx in 0..g.len() as u32 {
+            let node = g.node_at(idx);
+            tiles
+                .entry(tiling.key_of(node.lat, node.lon))
+                .or_default()
+                .push(idx);
+        }
+
+        let mut keys = Vec::with_capacity(tiles.len());
+        let mut sizes = Vec::with_capacity(tiles.len());
+        let mut nodes = Vec::with_capacity(g.len());
+        for (t, (&key, owned)) in tiles.iter().enumerate() {
+            let mut tile_nodes = Vec::with_capacity(owned.len());
+            let mut tile_edges = Vec::new();
+            for &idx in owned {
+                let node = g.node_at(idx);
+                tile_nodes.push(node);
+                nodes.push((node.id, t as u32));
+
+                for (to_idx, cost) in g.edges_at(idx) {
+                    let to = g.node_at(to_idx);
+                    if tiling.key_of(to.lat, to.lon) != key {
+                        tile_nodes.push(to);
+                    }
+                    tile_edges.push((node.id, to.id, cost));
+                }
+            }
+
+            let path = dir.join(tile_file(key));
+            Graph::from_iter(tile_nodes, tile_edges)
+                .freeze()
+                .save(&path)?;
+            keys.push(key);
+            sizes.push(fs::metadata(&path)?.len());
+        }
+
+        nodes.sort_unstable();
+        let manifest = Manifest {
+            tiling,
+            keys: Array::from(keys),
+            sizes: Array::from(sizes),
+            ids: Array::from(nodes.iter().map(|&(id, _)| id).collect::<Vec<_>>()),
+            node_tiles: Array::from(nodes.iter().map(|&(_, t)| t).collect::<Vec<_>>()),
+        };
+
+        let mut w = BufWriter::new(File::create(dir.join(MANIFEST_FILE))?);
+        manifest.write(&mut w)?;
+        w.flush()
+    }
+
+    /// Opens a graph saved with [TiledGraph::save] in the `dir` directory, only reading
+    /// the index of all nodes. Tiles are loaded on demand, and dropped once the total size
+    /// of their files exceeds `memory_budget` bytes.
+    ///
+    /// Tiles are validated when loaded, see [FrozenGraph::open_mmap], but the contents of
+    /// the index are trusted.
+    ///
+    /// # Safety
+    ///
+    /// Files in `dir` must not be modified or truncated while the graph (or any route search
+    /// running on it) is alive, as they are memory-mapped, see [FrozenGraph::open_mmap].
+    pub unsafe fn open<P: AsRef<Path>>(dir: P, memory_budget: usize) -> io::Result<Self> {
+        let dir = dir.as_ref().to_path_buf();
+        // SAFETY: Upheld by the caller
+        let manifest = unsafe { Manifest::open(&dir.join(MANIFEST_FILE)) }?;
+        Ok(Self {
+            dir,
+            manifest,
+            memory_budget: memory_budget as u64,
+            loaded: Mutex::new(LoadedTiles {
+                lru: Lru::new(usize::MAX),
+                resident: 0,
+            }),
+            loads: AtomicU64::new(0),
+            evictions: AtomicU64::new(0),
+        })
+    }
+
+    /// Returns the number of nodes in the graph.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.manifest.ids.len()
+    }
+
+    /// Returns `true` if there are no nodes in the graph.
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.manifest.ids.is_empty()
+    }
+
+    /// Returns the size of the tiles, in degrees.
+    #[inline]
+    pub fn tile_size(&self) -> f32 {
+        self.manifest.tiling.size
+    }
+
+    /// Returns the counters of the tile cache.
+    pub fn stats(&self) -> TileStats {
+        let loaded = self.loaded.lock().unwrap();
+        TileStats {
+            tiles: self.manifest.keys.len() as u64,
+            loaded_tiles: loaded.lru.len() as u64,
+            resident_bytes: loaded.resident,
+            loads: self.loads.load(Ordering::Relaxed),
+            evictions: self.evictions.load(Ordering::Relaxed),
+        }
+    }
+
+    /// Returns the tile with the provided index, loading it if it's not cached.
+    fn tile(&self, t: u32) -> io::Result<Arc<Tile>> {
+        if let Some(tile) = self.loaded.lock().unwrap().lru.get(&t) {
+            return Ok(Arc::clone(tile));
+        }
+
+        let key = self.manifest.keys[t as usize];
+        let tile = Arc::new(Tile {
+            // SAFETY: Upheld by the caller of TiledGraph::open
+            graph: unsafe { FrozenGraph::open_mmap(self.dir.join(tile_file(key))) }?,
+            index: OnceLock::new(),
+        });
+        self.loads.fetch_add(1, Ordering::Relaxed);
+
+        let mut loaded = self.loaded.lock().unwrap();
+        if let Some(concurrently_loaded) = loaded.lru.get(&t) {
+            return Ok(Arc::clone(concurrently_loaded));
+        }
+        loaded.lru.insert(t, Arc::clone(&tile));
+        loaded.resident += self.manifest.sizes[t as usize];
+
+        while loaded.resident > self.memory_budget && loaded.lru.len() > 1 {
+            let (evicted, _) = loaded.lru.pop_lru().expect("cache should not be empty");
+            loaded.resident -= self.manifest.sizes[evicted as usize];
+            self.evictions.fetch_add(1, Ordering::Relaxed);
+        }
+        Ok(tile)
+    }
+
+    /// Returns the tile with the provided index from `pinned`, loading it if necessary.
+    /// Load errors are logged, as [AStarError] can't carry them.
+    fn pin(&self, pinned: &mut HashMap<u32, Arc<Tile>>, t: u32) -> Result<Arc<Tile>, AStarError> {
+        if let Some(tile) = pinned.get(&t) {
+            return Ok(Arc::clone(tile));
+        }
+
+        match self.tile(t) {
+            Ok(tile) => {
+                pinned.insert(t, Arc::clone(&tile));
+                Ok(tile)
+            }
+            Err(e) => {
+                let path = self.dir.join(tile_file(self.manifest.keys[t as usize]));
+                log::error!(target: "routx", "{}: {}", path.display(), e);
+                Err(AStarError::TileLoadFailed)
+            }
+        }
+    }
+
+    /// Retrieves a [Node] with the provided id, loading its tile if necessary.
+    pub fn get_node(&self, id: i64) -> io::Result<Option<Node>> {
+        match self.manifest.tile_of_node(id) {
+            Some(t) => Ok(self.tile(t)?.graph.get_node(id)),
+            None => Ok(None),
+        }
+    }
+
+    /// Finds the closest canonical (`id == osm_id`) [Node] to the given position,
+    /// searching (and loading) tiles in growing rings around it.
+    ///
+    /// Returns `None` if the graph has no canonical nodes.
+    pub fn find_nearest_node(&self, lat: f32, lon: f32) -> io::Result<Option<Node>> {
+        let tiling = self.manifest.tiling;
+        let (qr, qc) = tiling.cell_of(lat, lon);
+        let (qr, qc) = (qr as i64, qc as i64);
+        let (rows, cols) = (tiling.rows as i64, tiling.cols as i64);
+
+        let mut best: Option<(f32, Node)> = None;
+        let mut visited: HashSet<u32> = HashSet::default();
+        for r in 0.. {
+            for row in (qr - r).max(0)..=(qr + r).min(rows - 1) {
+                // Rows between the first and last one of the ring only have its edge columns
+                let step = if (row - qr).abs() == r { 1 } else { 2 * r };
+                for dc in (-r..=r).step_by(step as usize) {
+                    let col = (qc + dc).rem_euclid(cols);
+                    let Some(t) = self.manifest.tile_with_key(key(row as u32, col as u32)) else {
+                        continue;
+                    };
+                    if !visited.insert(t) {
+                        continue;
+                    }
+
+                    if let Some(index) = self.tile(t)?.index() {
+                        let node = index.find_nearest_node(lat, lon);
+                        let distance = earth_distance(lat, lon, node.lat, node.lon);
+                        if best.map_or(true, |(d, _)| distance < d) {
+                            best = Some((distance, node));
+                        }
+                    }
+                }
+            }
+
+            let covers_rows = r >= qr && r >= rows - 1 - qr;
+            let covers_cols = 2 * r + 1 >= cols;
+            if (covers_rows && covers_cols) || visited.len() == self.manifest.keys.len() {
+                break;
+            }
+            if best.is_some_and(|(d, _)| d <= self.outside_distance(lat, lon, r)) {
+                break;
+            }
+        }
+
+        Ok(best.map(|(_, node)| node))
+    }
+
+    /// Returns a lower bound of the distance (in kilometers) between the given position,
+    /// and any position outside of the block of tiles within `r` rows and columns
+    /// from its tile.
+    fn outside_distance(&self, lat: f32, lon: f32, r: i64) -> f32 {
+        let tiling = self.manifest.tiling;
+        let (qr, qc) = tiling.cell_of(lat, lon);
+        let (qr, qc) = (qr as i64, qc as i64);
+        let size = tiling.size as f64;
+        let (lat, lon) = (lat as f64, lon as f64);
+
+        // Positions beyond the southern or northern edge differ in latitude by at least
+        // the distance to that edge, unless the block reaches the pole
+        let south = (qr - r) as f64 * size - 90.0;
+        let north = (qr + r + 1) as f64 * size - 90.0;
+        let mut lat_degrees = f64::INFINITY;
+        if south > -90.0 {
+            lat_degrees = lat_degrees.min(lat - south);
+        }
+        if north < 90.0 {
+            lat_degrees = lat_degrees.min(north - lat);
+        }
+        let by_lat = lat_degrees.max(0.0).to_radians() * EARTH_RADIUS;
+
+        // Positions beyond the western or eastern edge are at least as far as the meridian
+        // of that edge. The last column is narrower if tiles don't divide 360°, which shifts
+        // the edges of blocks wrapping around the antimeridian by at most `gap`.
+        let by_lon = if 2 * r + 1 >= tiling.cols as i64 {
+            f64::INFINITY
+        } else {
+            let west = (qc - r) as f64 * size - 180.0;
+            let east = (qc + r + 1) as f64 * size - 180.0;
+            let gap = tiling.cols as f64 * size - 360.0;
+            let lon_degrees = ((lon - west).min(east - lon) - gap).clamp(0.0, 90.0);
+            (lat.to_radians().cos() * lon_degrees.to_radians().sin()).asin() * EARTH_RADIUS
+        };
+
+        by_lat.min(by_lon) as f32
+    }
+
+    /// Uses the [A* algorithm](https://en.wikipedia.org/wiki/A*_search_algorithm)
+    /// to find the shortest route between two nodes, like [find_route](crate::find_route).
+    /// Tiles are loaded as the search reaches them.
+    ///
+    /// Returns [AStarError::TileLoadFailed] if any of the needed tiles can't be loaded;
+    /// the reason is logged.
+    pub fn find_route(
+        &self,
+        from_id: i64,
+        to_id: i64,
+        step_limit: usize,
+    ) -> Result<Vec<i64>, AStarError> {
+        let mut pinned: HashMap<u32, Arc<Tile>> = HashMap::default();
+        let mut locate = |id: i64| -> Result<(u32, Node), AStarError> {
+            let t = self
+                .manifest
+                .tile_of_node(id)
+                .ok_or(AStarError::InvalidReference(id))?;
+            let node = self
+                .pin(&mut pinned, t)?
+                .graph
+                .get_node(id)
+                .ok_or(AStarError::InvalidReference(id))?;
+            Ok((t, node))
+        };
+        let (_, to_node) = locate(to_id)?;
+        let (from_tile, from_node) = locate(from_id)?;
+
+        let mut queue: BinaryHeap<QueueItem> = BinaryHeap::default();
+        let mut labels: Vec<Label> = Vec::default();
+        let mut slots: HashMap<i64, u32> = HashMap::default();
+        let mut steps: usize = 0;
+
+        labels.push(Label {
+            id: from_id,
+            tile: from_tile,
+            cost: 0.0,
+            prev: NO_INDEX,
+        });
+        slots.insert(from_id, 0);
+        queue.push(QueueItem {
+            at: 0,
+            cost: 0.0,
+            score: earth_distance(from_node.lat, from_node.lon, to_node.lat, to_node.lon),
+        });
+
+        while let Some(item) = queue.pop() {
+            let label = labels[item.at as usize];
+            if label.id == to_id {
+                let mut route = vec![];
+                let mut at = item.at;
+                while at != NO_INDEX {
+                    route.push(labels[at as usize].id);
+                    at = labels[at as usize].prev;
+                }
+                route.reverse();
+                return Ok(route);
+            }
+
+            // Contrary to the wikipedia definition, we might keep multiple items in the queue for the same node.
+            if item.cost > label.cost {
+                continue;
+            }
+
+            steps += 1;
+            if steps > step_limit {
+                return Err(AStarError::StepLimitExceeded);
+            }
+
+            let tile = self.pin(&mut pinned, label.tile)?;
+            let Some(idx) = tile.graph.index_of(label.id) else {
+                continue;
+            };
+
+            for (to_idx, edge_cost) in tile.graph.edges_at(idx) {
+                let neighbor = tile.graph.node_at(to_idx);
+                let neighbor_cost = item.cost + edge_cost;
+
+                let slot = match slots.get(&neighbor.id) {
+                    Some(&slot) => {
+                        // Check if this is the cheapest way to the neighbor
+                        if neighbor_cost >= labels[slot as usize].cost {
+                            continue;
+                        }
+                        labels[slot as usize].cost = neighbor_cost;
+                        labels[slot as usize].prev = item.at;
+                        slot
+                    }
+                    None => {
+                        // Border nodes are expanded in the tile containing them
+                        let Some(neighbor_tile) = self.manifest.tile_at(neighbor.lat, neighbor.lon)
+                        else {
+                            continue;
+                        };
+                        let slot = labels.len() as u32;
+                        labels.push(Label {
+                            id: neighbor.id,
+                            tile: neighbor_tile,
+                            cost: neighbor_cost,
+                            prev: item.at,
+                        });
+                        slots.insert(neighbor.id, slot);
+                        slot
+                    }
+                };
+
+                queue.push(QueueItem {
+                    at: slot,
+                    cost: neighbor_cost,
+                    score: neighbor_cost
+                        + earth_distance(neighbor.lat, neighbor.lon, to_node.lat, to_node.lon),
+                });
+            }
+        }
+
+        Ok(vec![])
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Grid of 5×5 nodes spaced 0.2° apart, crossing the 1° tile boundary at latitude
+    /// and longitude 10°, with two-way edges between adjacent nodes.
+    fn fixture_graph() -> Graph {
+        let mut nodes = vec![];
+        let mut edges = vec![];
+        for i in 0..5 {
+            for j in 0..5 {
+                let id = (i * 5 + j + 1) as i64;
+                nodes.push(Node {
+                    id,
+                    osm_id: id,
+                    lat: 9.55 + i as f32 * 0.2,
+                    lon: 9.5 + j as f32 * 0.2,
+                });
+                if j < 4 {
+                    edges.push((id, id + 1, 25.0));
+                    edges.push((id + 1, id, 25.0));
+                }
+                if i < 4 {
+                    edges.push((id, id + 5, 25.0));
+                    edges.push((id + 5, id, 25.0));
+                }
+            }
+        }
+        Graph::from_iter(nodes, edges)
+    }
+
+    fn temp_dir(name: &str) -> PathBuf {
+        std::env::temp_dir().join(format!("routx-{}-{}", name, std::process::id()))
+    }
+
+    #[test]
+    fn tiling() {
+        let t = Tiling::new(1.0).unwrap();
+        assert_eq!((t.rows, t.cols), (180, 360));
+        assert_eq!(t.cell_of(0.5, 0.5), (90, 180));
+        assert_eq!(t.cell_of(-90.0, -180.0), (0, 0));
+        assert_eq!(t.cell_of(90.0, 180.0), (179, 359));
+
+        let t = Tiling::new(0.7).unwrap();
+        assert_eq!((t.rows, t.cols), (258, 515));
+        assert_eq!(t.cell_of(90.0, 180.0), (257, 514));
+
+        assert_eq!(Tiling::new(0.0), None);
+        assert_eq!(Tiling::new(f32::NAN), None);
+        assert_eq!(Tiling::new(1e-6), None);
+    }
+
+    #[test]
+    fn find_route_across_tiles() {
+        let g = fixture_graph();
+        let dir = temp_dir("tiles-route");
+        TiledGraph::save(&g.freeze(), &dir, 1.0).unwrap();
+
+        // SAFETY: Test files are not modified while open
+        let tiled = unsafe { TiledGraph::open(&dir, 0) }.unwrap();
+        assert_eq!(tiled.len(), 25);
+        assert_eq!(tiled.stats().tiles, 4);
+        assert_eq!(tiled.stats().loads, 0);
+
+        let route = tiled.find_route(1, 25, 100).unwrap();
+        assert_eq!(route.len(), 9);
+        assert_eq!(route.first(), Some(&1));
+        assert_eq!(route.last(), Some(&25));
+
+        // With a zero budget, only the most recently used tile stays cached
+        let stats = tiled.stats();
+        assert_eq!(stats.loaded_tiles, 1);
+        assert_eq!(stats.evictions, stats.loads - 1);
+        assert!(stats.loads >= 3);
+
+        assert_eq!(tiled.find_route(1, 1, 100), Ok(vec![1]));
+        assert_eq!(
+            tiled.find_route(1, 26, 100),
+            Err(AStarError::InvalidReference(26))
+        );
+        assert_eq!(
+            tiled.find_route(1, 25, 5),
+            Err(AStarError::StepLimitExceeded)
+        );
+
+        let node = tiled.get_node(13).unwrap().unwrap();
+        assert_eq!(node, g.get_node(13).unwrap());
+        assert_eq!(tiled.get_node(26).unwrap(), None);
+
+        fs::remove_file(dir.join(tile_file(tiled.manifest.keys[0]))).unwrap();
+        // SAFETY: Test files are not modified while open
+        let reloaded = unsafe { TiledGraph::open(&dir, usize::MAX) }.unwrap();
+        assert_eq!(
+            reloaded.find_route(1, 25, 100),
+            Err(AStarError::TileLoadFailed)
+        );
+
+        fs::remove_dir_all(&dir).unwrap();
+    }
+
+    #[test]
+    fn find_route_keeps_tiles_within_budget() {
+        let g = fixture_graph();
+        let dir = temp_dir("tiles-budget");
+        TiledGraph::save(&g.freeze(), &dir, 1.0).unwrap();
+
+        // SAFETY: Test files are not modified while open
+        let tiled = unsafe { TiledGraph::open(&dir, usize::MAX) }.unwrap();
+        tiled.find_route(1, 25, 100).unwrap();
+        tiled.find_route(25, 1, 100).unwrap();
+        let stats = tiled.stats();
+        fs::remove_dir_all(&dir).unwrap();
+
+        assert_eq!(stats.loaded_tiles, stats.loads);
+        assert_eq!(stats.evictions, 0);
+        assert!(stats.resident_bytes > 0);
+    }
+
+    #[test]
+    fn find_nearest_node() {
+        let g = fixture_graph();
+        let dir = temp_dir("tiles-nearest");
+        TiledGraph::save(&g.freeze(), &dir, 1.0).unwrap();
+        // SAFETY: Test files are not modified while open
+        let tiled = unsafe { TiledGraph::open(&dir, usize::MAX) }.unwrap();
+
+        assert_eq!(tiled.find_nearest_node(9.89, 9.98).unwrap().unwrap().id, 13);
+
+        // Nearest node in a neighboring tile
+        assert_eq!(tiled.find_nearest_node(10.02, 9.9).unwrap().unwrap().id, 13);
+
+        // Queries away from all tiles
+        for (lat, lon) in [(10.15, 12.0), (-60.0, 0.0), (80.0, -170.0)] {
+            let expected = g
+                .iter()
+                .min_by(|a, b| {
+                    let da = earth_distance(lat, lon, a.lat, a.lon);
+                    let db = earth_distance(lat, lon, b.lat, b.lon);
+                    da.total_cmp(&db)
+                })
+                .unwrap();
+            assert_eq!(
+                tiled.find_nearest_node(lat, lon).unwrap().as_ref(),
+                Some(expected)
+            );
+        }
+
+        fs::remove_dir_all(&dir).unwrap();
+
+        let empty = temp_dir("tiles-empty");
+        TiledGraph::save(&Graph::new().freeze(), &empty, 1.0).unwrap();
+        // SAFETY: Test files are not modified while open
+        let tiled = unsafe { TiledGraph::open(&empty, 0) }.unwrap();
+        fs::remove_dir_all(&empty).unwrap();
+        assert!(tiled.is_empty());
+        assert_eq!(tiled.find_nearest_node(10.0, 10.0).unwrap(), None);
+    }
+
+    #[test]
+    fn find_nearest_node_across_antimeridian() {
+        let g = Graph::from_iter(
+            [
+                Node {
+                    id: 1,
+                    osm_id: 1,
+                    lat: 0.0,
+                    lon: 179.9,
+                },
+                Node {
+                    id: 2,
+                    osm_id: 2,
+                    lat: 0.0,
+                    lon: 175.0,
+                },
+            ],
+            [],
+        );
+        let dir = temp_dir("tiles-antimeridian");
+        TiledGraph::save(&g.freeze(), &dir, 1.0).unwrap();
+        // SAFETY: Test files are not modified while open
+        let tiled = unsafe { TiledGraph::open(&dir, usize::MAX) }.unwrap();
+        let nearest = tiled.find_nearest_node(0.0, -179.9);
+        fs::remove_dir_all(&dir).unwrap();
+
+        assert_eq!(nearest.unwrap().unwrap().id, 1);
+    }
+}